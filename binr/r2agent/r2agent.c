@@ -108,6 +108,7 @@ int main(int argc, char **argv) {
 		if (!rs) {
 			continue;
 		}
+		rs->keepalive = false;
 		if (!strcmp (rs->method, "GET")) {
 			if (!strncmp (rs->path, "/proc/kill/", 11)) {
 				// TODO: show page here?
@@ -30,7 +30,7 @@ static char *file2 = NULL;
 static ut32 count = 0;
 static int showcount = 0;
 static int useva = true;
-static int delta = 0;
+static st64 delta = 0;
 static int showbare = false;
 static int json_started = 0;
 static int diffmode = 0;
@@ -159,7 +159,7 @@ static int cb(RDiff *d, void *user, RDiffOp *op) {
 			for (i = 0; i < op->b_len; i++) {
 				printf ("%02x", op->b_buf[i]);
 			}
-			printf (" @ 0x%08"PFMT64x "\n", op->b_off);
+			printf (" @ 0x%08"PFMT64x "\n", op->a_off + delta);
 		} else {
 			if (op->a_len > 0) {
 				printf ("r-%d @ 0x%08"PFMT64x "\n",
@@ -167,14 +167,15 @@ static int cb(RDiff *d, void *user, RDiffOp *op) {
 			}
 			if (op->b_len > 0) {
 				printf ("r+%d @ 0x%08"PFMT64x "\n",
-					op->b_len, op->b_off + delta);
+					op->b_len, op->a_off + delta);
 				printf ("wx ");
 				for (i = 0; i < op->b_len; i++) {
 					printf ("%02x", op->b_buf[i]);
 				}
-				printf (" @ 0x%08"PFMT64x "\n", op->b_off + delta);
+				printf (" @ 0x%08"PFMT64x "\n", op->a_off + delta);
 			}
-			delta += (op->b_off - op->a_off);
+			// following ops are relative to the resized file
+			delta += (st64)op->b_len - (st64)op->a_len;
 		}
 		return 1;
 	case 'j':
@@ -387,7 +388,8 @@ static int bcb(RDiff *d, void *user, RDiffOp *op) {
 		print_bytes(&remain_size, sizeof(remain_size), true);
 	}
 	print_bytes(op->b_buf, op->b_len, false);
-	gdiff_start = op->b_off + op->b_len;
+	// the next COPY resumes after the replaced bytes of the source
+	gdiff_start = op->a_off + op->a_len;
 	return 0;
 }
 
@@ -402,6 +404,7 @@ static int show_help(int v) {
 			"  -c         count of changes\n"
 			"  -C         graphdiff code (columns: off-A, match-ratio, off-B) (see -A)\n"
 			"  -d         use delta diffing\n"
+			"  -dd        use streaming delta diffing (for huge files, implied over 2GB)\n"
 			"  -D         show disasm instead of hexpairs\n"
 			"  -e [k=v]   set eval config var value for all RCore instances\n"
 			"  -g [sym|off1,off2]   graph diff of given symbol, or between two offsets\n"
@@ -545,6 +548,49 @@ static void handle_sha256(const ut8 *block, int len) {
 	r_hash_free (ctx);
 }
 
+static int stream_read(void *user, ut64 off, ut8 *buf, int len) {
+	return r_io_desc_read_at ((RIODesc *)user, off, buf, len);
+}
+
+static bool stream_open(RCore **c, const char *file, RDiffSource *src) {
+	RIODesc *desc;
+	if (!*c) {
+		*c = opencore (NULL);
+	}
+	if (!*c || !(desc = r_io_open_nomap ((*c)->io, file, R_PERM_R, 0))) {
+		return false;
+	}
+	src->read = stream_read;
+	src->user = desc;
+	src->size = r_io_desc_size (desc);
+	return true;
+}
+
+static void stream_sha256(RDiffSource *src) {
+	const int bs = 1024 * 1024;
+	RHash *ctx = r_hash_new (false, R_HASH_SHA256);
+	ut8 *buf = malloc (bs);
+	ut64 off;
+	int i;
+	if (!ctx || !buf) {
+		goto beach;
+	}
+	for (off = 0; off < src->size; off += bs) {
+		int n = (int)R_MIN (bs, src->size - off);
+		if (src->read (src->user, off, buf, n) != n) {
+			goto beach;
+		}
+		r_hash_do_sha256 (ctx, buf, n);
+	}
+	const ut8 *c = r_hash_do_sha256 (ctx, buf, 0);
+	for (i = 0; i < R_HASH_SIZE_SHA256; i++) {
+		printf ("%02x", c[i]);
+	}
+beach:
+	r_hash_free (ctx);
+	free (buf);
+}
+
 static ut8 *slurp(RCore **c, const char *file, int *sz) {
 	RIODesc *d;
 	RIO *io;
@@ -680,6 +726,8 @@ int main(int argc, char **argv) {
 	RCore *c = NULL, *c2 = NULL;
 	RDiff *d;
 	ut8 *bufa = NULL, *bufb = NULL;
+	RDiffSource sa = {0}, sb = {0};
+	bool stream = false;
 	int o, sza, szb, /*diffmode = 0,*/ delta = 0;
 	int mode = MODE_DIFF;
 	int diffops = 0;
@@ -738,7 +786,7 @@ int main(int argc, char **argv) {
 			printf ("%s\n", optarg);
 			break;
 		case 'd':
-			delta = 1;
+			delta++;
 			break;
 		case 'D':
 			if (disasm) {
@@ -894,6 +942,22 @@ int main(int argc, char **argv) {
 		}
 		break;
 	default:
+		if (mode == MODE_DIFF && (delta > 1 || r_file_size (file) >= ST32_MAX || r_file_size (file2) >= ST32_MAX)) {
+			if (!stream_open (&c, file, &sa)) {
+				eprintf ("radiff2: Cannot open %s\n", r_str_get (file));
+				return 1;
+			}
+			if (!stream_open (&c, file2, &sb)) {
+				eprintf ("radiff2: Cannot open: %s\n", r_str_get (file2));
+				r_core_free (c);
+				return 1;
+			}
+			if (sa.size != sb.size) {
+				eprintf ("File size differs %"PFMT64d" vs %"PFMT64d"\n", sa.size, sb.size);
+			}
+			stream = true;
+			break;
+		}
 		bufa = slurp (&c, file, &sza);
 		if (!bufa) {
 			eprintf ("radiff2: Cannot open %s\n", r_str_get (file));
@@ -926,7 +990,14 @@ int main(int argc, char **argv) {
 	case MODE_DIFF_IMPORTS:
 		d = r_diff_new ();
 		r_diff_set_delta (d, delta);
-		if (diffmode == 'j') {
+		if (diffmode == 'j' && stream) {
+			printf ("{\"files\":[{\"filename\":\"%s\", \"size\":%"PFMT64d", \"sha256\":\"", file, sa.size);
+			stream_sha256 (&sa);
+			printf ("\"},\n{\"filename\":\"%s\", \"size\":%"PFMT64d", \"sha256\":\"", file2, sb.size);
+			stream_sha256 (&sb);
+			printf ("\"}],\n");
+			printf ("\"changes\":[");
+		} else if (diffmode == 'j') {
 			printf ("{\"files\":[{\"filename\":\"%s\", \"size\":%d, \"sha256\":\"", file, sza);
 			handle_sha256 (bufa, sza);
 			printf ("\"},\n{\"filename\":\"%s\", \"size\":%d, \"sha256\":\"", file2, szb);
@@ -938,17 +1009,27 @@ int main(int argc, char **argv) {
 			write (1, "\xd1\xff\xd1\xff", 4);
 			write (1, "\x04", 1);
 		}
-		if (diffmode == 'U') {
+		if (diffmode == 'U' && stream) {
+			eprintf ("radiff2: -U can not be used with streaming diffs\n");
+		} else if (diffmode == 'U') {
 			char * res = r_diff_buffers_unified (d, bufa, sza, bufb, szb);
 			printf ("%s", res);
 			free (res);
 		} else if (diffmode == 'B') {
 			r_diff_set_callback (d, &bcb, 0);
-			r_diff_buffers (d, bufa, sza, bufb, szb);
+			if (stream) {
+				r_diff_stream (d, &sa, &sb);
+			} else {
+				r_diff_buffers (d, bufa, sza, bufb, szb);
+			}
 			write (1, "\x00", 1);
 		} else {
 			r_diff_set_callback (d, &cb, 0); // (void *)(size_t)diffmode);
-			r_diff_buffers (d, bufa, sza, bufb, szb);
+			if (stream) {
+				r_diff_stream (d, &sa, &sb);
+			} else {
+				r_diff_buffers (d, bufa, sza, bufb, szb);
+			}
 		}
 		if (diffmode == 'j') {
 			printf ("]\n");
@@ -988,6 +1069,9 @@ int main(int argc, char **argv) {
 	}
 	free (bufa);
 	free (bufb);
+	if (stream) {
+		r_core_free (c);
+	}
 
 	return 0;
 }
@@ -10,11 +10,15 @@
 #include <r_crypto.h>
 #include "../blob/version.c"
 
+#define STREAM_BSIZE (1024 * 1024)
+#define BLOCK_BATCH (4 * 1024 * 1024)
+
 static ut64 from = 0LL;
 static ut64 to = 0LL;
 static int incremental = 1;
 static int iterations = 0;
 static int quiet = 0;
+static RHashPool *pool = NULL;
 static RHashSeed s = {
 	0
 }, *_s = NULL;
@@ -137,13 +141,146 @@ static int do_hash_internal(RHash *ctx, ut64 hash, const ut8 *buf, int len, int
 	return 1;
 }
 
-static int do_hash(const char *file, const char *algo, RIO *io, int bsize, int rad, int ule, const ut8 *compare) {
-	ut64 j, fsize, algobit = r_hash_name_to_bits (algo);
-	RHash *ctx;
-	ut8 *buf;
-	int ret = 0;
+static int hash_algos(ut64 algobit, RHashJob *jobs) {
+	int n = 0;
 	ut64 i;
+	for (i = 1; i < R_HASH_ALL; i <<= 1) {
+		if (algobit & i) {
+			jobs[n].ctx = r_hash_new (true, i);
+			jobs[n].algobit = i;
+			n++;
+		}
+	}
+	return n;
+}
+
+/* feed the same buffer to every algorithm context at once */
+static void hash_update(RHashJob *jobs, int n, const ut8 *buf, int len) {
+	int i;
+	for (i = 0; i < n; i++) {
+		jobs[i].buf = buf;
+		jobs[i].len = len;
+	}
+	r_hash_pool_run (pool, jobs, n);
+}
+
+static void do_hash_incremental(const char *file, RIO *io, RHashJob *jobs, int n, ut8 *buf, int bsize, int rad, int ule) {
+	bool first = true;
+	ut64 j;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		r_hash_do_begin (jobs[i].ctx, jobs[i].algobit);
+	}
+	if (s.buf && s.prefix) {
+		hash_update (jobs, n, s.buf, s.len);
+	}
+	/* every block is read once and hashed by all the algorithms */
+	for (j = from; j < to; j += bsize) {
+		int len = ((j + bsize) > to)? (to - j): bsize;
+		r_io_pread_at (io, j, buf, len);
+		hash_update (jobs, n, buf, len);
+	}
+	if (s.buf && !s.prefix) {
+		hash_update (jobs, n, s.buf, s.len);
+	}
+	for (i = 0; i < n; i++) {
+		RHash *ctx = jobs[i].ctx;
+		ut64 hashbit = jobs[i].algobit;
+		r_hash_do_end (ctx, hashbit);
+		if (iterations > 0) {
+			r_hash_do_spice (ctx, hashbit, iterations, _s);
+		}
+		if (!*r_hash_name (hashbit)) {
+			continue;
+		}
+		if (rad == 'j') {
+			if (first) {
+				first = false;
+			} else {
+				printf (",");
+			}
+		}
+		if (!quiet && rad != 'j') {
+			printf ("%s: ", file);
+		}
+		do_hash_print (ctx, hashbit, r_hash_size (hashbit), quiet? 'n': rad, ule);
+		if (quiet == 1) {
+			printf (" %s\n", file);
+		} else {
+			if (quiet && !rad) {
+				printf ("\n");
+			}
+		}
+	}
+}
+
+/* per-block hashes are computed in batches of blocks by the hashing threads
+ * and printed in file order once the batch is done */
+static int do_hash_blocks(RIO *io, const RHashJob *algos, int n, int bsize, int rad, int ule) {
+	ut64 j, ofrom = from, oto = to;
+	int b, i, nblocks = R_MAX (1, BLOCK_BATCH / bsize);
 	bool first = true;
+
+	if (nblocks > (to - from + bsize - 1) / bsize) {
+		nblocks = (to - from + bsize - 1) / bsize;
+	}
+	ut8 *buf = malloc ((size_t)nblocks * bsize);
+	RHash *ctxs = R_NEWS0 (RHash, nblocks * n);
+	RHashJob *jobs = R_NEWS0 (RHashJob, nblocks * n);
+	if (!buf || !ctxs || !jobs) {
+		free (buf);
+		free (ctxs);
+		free (jobs);
+		return 1;
+	}
+	for (i = 0; i < nblocks * n; i++) {
+		ctxs[i].rst = true;
+		jobs[i].ctx = &ctxs[i];
+		jobs[i].algobit = algos[i % n].algobit;
+	}
+	for (j = ofrom; j < oto; j += (ut64)nblocks * bsize) {
+		for (b = 0; b < nblocks && j + (ut64)b * bsize < oto; b++) {
+			ut64 off = j + (ut64)b * bsize;
+			int len = R_MIN (bsize, oto - off);
+			ut8 *block = buf + (size_t)b * bsize;
+			r_io_pread_at (io, off, block, len);
+			for (i = 0; i < n; i++) {
+				jobs[b * n + i].buf = block;
+				jobs[b * n + i].len = len;
+			}
+		}
+		r_hash_pool_run (pool, jobs, b * n);
+		for (i = 0; i < b * n; i++) {
+			RHashJob *job = &jobs[i];
+			from = job->buf - buf + j;
+			to = from + job->len;
+			if (iterations > 0) {
+				r_hash_do_spice (job->ctx, job->algobit, iterations, _s);
+			}
+			if (rad == 'j') {
+				if (first) {
+					first = false;
+				} else {
+					printf (",");
+				}
+			}
+			do_hash_print (job->ctx, job->algobit, job->dlen, rad, ule);
+		}
+	}
+	from = ofrom;
+	to = oto;
+	free (buf);
+	free (ctxs);
+	free (jobs);
+	return 0;
+}
+
+static int do_hash(const char *file, const char *algo, RIO *io, int bsize, int rad, int ule, const ut8 *compare) {
+	ut64 fsize, algobit = r_hash_name_to_bits (algo);
+	RHashJob jobs[R_HASH_NBITS] = {{0}};
+	ut8 *buf = NULL;
+	int i, n, ret = 0;
 	if (algobit == R_HASH_NONE) {
 		eprintf ("rahash2: Invalid hashing algorithm specified\n");
 		return 1;
@@ -156,6 +293,10 @@ static int do_hash(const char *file, const char *algo, RIO *io, int bsize, int r
 	if (bsize < 0) {
 		bsize = fsize / -bsize;
 	}
+	if (bsize == 0 && incremental && !(algobit & ~R_HASH_STREAMABLE)) {
+		/* no need to load the whole file when all the hashes are streamable */
+		bsize = STREAM_BSIZE;
+	}
 	if (bsize == 0 || bsize > fsize) {
 		bsize = fsize;
 	}
@@ -170,97 +311,41 @@ static int do_hash(const char *file, const char *algo, RIO *io, int bsize, int r
 		eprintf ("rahash2: Unknown file size\n");
 		return 1;
 	}
-	buf = calloc (1, bsize + 1);
-	if (!buf) {
-		return 1;
+	if (incremental) {
+		buf = calloc (1, bsize + 1);
+		if (!buf) {
+			return 1;
+		}
 	}
-	ctx = r_hash_new (true, algobit);
+	n = hash_algos (algobit, jobs);
+	// the incremental hashes of a block are the only jobs of a batch
+	pool = r_hash_pool_new (incremental? R_MIN (n, R_HASH_THREADS): R_HASH_THREADS);
 
 	if (rad == 'j') {
 		printf ("[");
 	}
 	if (incremental) {
-		for (i = 1; i < R_HASH_ALL; i <<= 1) {
-			if (algobit & i) {
-				ut64 hashbit = i & algobit;
-				int dlen = r_hash_size (hashbit);
-				r_hash_do_begin (ctx, i);
-				if (s.buf && s.prefix) {
-					do_hash_internal (ctx, hashbit, s.buf, s.len, rad, 0, ule);
-				}
-				for (j = from; j < to; j += bsize) {
-					int len = ((j + bsize) > to)? (to - j): bsize;
-					r_io_pread_at (io, j, buf, len);
-					do_hash_internal (ctx, hashbit, buf, len, rad, 0, ule);
-				}
-				if (s.buf && !s.prefix) {
-					do_hash_internal (ctx, hashbit, s.buf, s.len, rad, 0, ule);
-				}
-				r_hash_do_end (ctx, i);
-				if (iterations > 0) {
-					r_hash_do_spice (ctx, i, iterations, _s);
-				}
-				if (!*r_hash_name (i)) {
-					continue;
-				}
-				if (rad == 'j') {
-					if (first) {
-						first = false;
-					} else {
-						printf (",");
-					}
-				}
-				if (!quiet && rad != 'j') {
-					printf ("%s: ", file);
-				}
-				do_hash_print (ctx, i, dlen, quiet? 'n': rad, ule);
-				if (quiet == 1) {
-					printf (" %s\n", file);
-				} else {
-					if (quiet && !rad) {
-						printf ("\n");
-					}
-				}
-			}
-		}
+		do_hash_incremental (file, io, jobs, n, buf, bsize, rad, ule);
 		if (_s) {
 			free (_s->buf);
 		}
 	} else {
-		/* iterate over all algorithm bits */
 		if (s.buf) {
 			eprintf ("Warning: Seed ignored on per-block hashing.\n");
 		}
-		for (i = 1; i < R_HASH_ALL; i <<= 1) {
-			ut64 f, t, ofrom, oto;
-			if (algobit & i) {
-				ut64 hashbit = i & algobit;
-				ofrom = from;
-				oto = to;
-				f = from;
-				t = to;
-				for (j = f; j < t; j += bsize) {
-					int nsize = (j + bsize < fsize)? bsize: (fsize - j);
-					r_io_pread_at (io, j, buf, bsize);
-					from = j;
-					to = j + bsize;
-					if (to > fsize) {
-						to = fsize;
-					}
-					do_hash_internal (ctx, hashbit, buf, nsize, rad, 0, ule);
-				}
-				do_hash_internal (ctx, hashbit, NULL, 0, rad, 1, ule);
-				from = ofrom;
-				to = oto;
-			}
-		}
+		ret = do_hash_blocks (io, jobs, n, bsize, rad, ule);
 	}
 	if (rad == 'j') {
 		printf ("]\n");
 	}
-
-	compare_hashes (ctx, compare, r_hash_size (algobit), &ret);
-	r_hash_free (ctx);
+	if (n == 1) {
+		compare_hashes (jobs[0].ctx, compare, r_hash_size (algobit), &ret);
+	}
+	for (i = 0; i < n; i++) {
+		r_hash_free (jobs[i].ctx);
+	}
+	r_hash_pool_free (pool);
+	pool = NULL;
 	free (buf);
 	return ret;
 }
@@ -1,70 +1,70 @@
-/* radare - LGPL - Copyright 2009-2011 pancake<nopcode.org> */
+/* radare - LGPL - Copyright 2009-2018 - pancake, nibble */
 
-#include <stdio.h>
-#include <string.h>
-#include <getopt.h>
-
-#include "r_userconf.h"
-#include "r_sign.h"
+#include "../blob/version.c"
+#include <getopt.c>
+#include <r_anal.h>
+#include <r_sign.h>
+#include <r_util.h>
 
 static int rasign_show_help() {
-	printf ("Usage: rasign2 [options] [file]\n"
-	" -r            show output in radare commands\n"
-	" -j            show output in json\n"
-	" -s [sigfile]  specify one or more signature files\n"
+	printf ("Usage: rasign2 [-hv] [-o db] [file ...]\n"
+	" -h            show this help\n"
+	" -o [db]       write the zignatures in the given sdb files to a binary database\n"
+	" -v            show version information\n"
 	"Examples:\n"
-	"  rasign2 libc.so.6 > libc.sig\n"
-	"  rasign2 -s libc.sig ls.static\n");
+	"  rasign2 -o libc.zdb libc.sdb libc-extra.sdb.gz\n"
+	"  r2 -qc 'zo libc.zdb;aa;z/' ls.static\n");
 	return 0;
 }
 
+static bool load(RAnal *anal, const char *file) {
+	if (r_sign_is_db (file)) {
+		eprintf ("%s is already a zignature database\n", file);
+		return false;
+	}
+	if (r_str_endswith (file, ".gz")) {
+		return r_sign_load_gz (anal, file);
+	}
+	return r_sign_load (anal, file);
+}
+
 int main(int argc, char **argv) {
-	int c;
-	int action = 0;
-	int rad = 0;
-	int json = 0;
-	//RSign *sig = r_sign_new ();
+	const char *output = NULL;
+	int c, ret = 1;
 
-	while ((c=getopt (argc, argv, "o:hrsj:iV")) !=-1) {
+	while ((c = getopt (argc, argv, "o:hv")) != -1) {
 		switch (c) {
 		case 'o':
-			//r_sign_option (&sig, optarg);
+			output = optarg;
 			break;
-		case 's':
-			action = c;
-			//r_sign_load_file (&sig, optarg);
-			break;
-		case 'r':
-			rad = 1;
-			break;
-		case 'j':
-			json = 1;
-			break;
-		case 'V':
-			printf ("rasign2 v"R2_VERSION"\n");
-			return 0;
-		default:
+		case 'v':
+			return blob_version ("rasign2");
+		case 'h':
 			return rasign_show_help ();
+		default:
+			rasign_show_help ();
+			return 1;
 		}
 	}
-
-	if (argv[optind]==NULL)
-		return rasign_show_help ();
-
-	//r_sign_list (sig, rad, json);
-
-	switch (action) {
-	case 's':
-		/* check sigfiles in optarg file */
-	//	r_sign_check (&sig, argv[optind]);
-		break;
-	default:
-		/* generate signature file */
-		//r_sign_generate (&sig, argv[optind], stdout);
-		break;
+	if (!output || optind >= argc) {
+		rasign_show_help ();
+		return 1;
 	}
-
-	//r_sign_free (sig);
-
-	return 0;
+	RAnal *anal = r_anal_new ();
+	if (!anal) {
+		return 1;
+	}
+	for (c = optind; c < argc; c++) {
+		if (!load (anal, argv[c])) {
+			goto beach;
+		}
+	}
+	if (r_sign_db_save (anal, output)) {
+		ret = 0;
+	} else {
+		eprintf ("Cannot write %s\n", output);
+	}
+beach:
+	r_anal_free (anal);
+	return ret;
 }
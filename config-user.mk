@@ -0,0 +1,86 @@
+# This file should be generated by the ./configure script
+CC=gcc
+WITH_GPL=1
+# HOST_CC=@HOST_CC@
+
+DESTDIR=
+PREFIX=/tmp/r2p
+BINDIR=/tmp/r2p/bin
+LIBDIR=/tmp/r2p/lib
+MANDIR=/tmp/r2p/share/man
+DOCDIR=/tmp/r2p/share/doc/radare2
+DATADIR=/tmp/r2p/share
+INCLUDEDIR=/tmp/r2p/include
+
+HAVE_LIB_GMP=0
+USE_RPATH=0
+HAVE_JEMALLOC=1
+HAVE_FORK=1
+WITH_LIBR=0
+
+MKPLUGINS=mk/stat.mk mk/sloc.mk
+
+COMPILER=gcc
+STATIC_DEBUG=0
+RUNTIME_DEBUG=1
+DEBUGGER=1
+
+INSTALL_DIR=/usr/bin/install -d
+INSTALL_DATA=/usr/bin/install -m 644
+INSTALL_PROGRAM=/usr/bin/install -m 755
+INSTALL_SCRIPT=/usr/bin/install -m 755
+INSTALL_MAN=/usr/bin/install -m 444
+INSTALL_LIB=/usr/bin/install -m 755 -c
+
+VERSION=3.1.0-git
+LIBVERSION=3.1.0-git
+
+# ./configure --with-ostype=[linux,osx,solaris,windows] # TODO: rename to w32, w64?
+OSTYPE=gnulinux
+BUILD_OS=linux
+HOST_OS=linux
+# hack: must be fixed in acr
+ifneq ($(OSTYPE),darwin)
+DL_LIBS=-ldl
+endif
+ifeq ($(OSTYPE),qnx)
+DL_LIBS=
+endif
+
+# capstone
+USE_CAPSTONE=0
+ifeq ($(USE_CAPSTONE),1)
+CAPSTONE_CFLAGS=
+CAPSTONE_LDFLAGS=
+else
+CAPSTONE_CFLAGS=
+CAPSTONE_LDFLAGS=
+endif
+
+HAVE_LIB_GMP=0
+HAVE_LIB_SSL=0
+HAVE_LIB_MAGIC=1
+USE_LIB_MAGIC=0
+HAVE_LIB_XXHASH=0
+USE_LIB_XXHASH=0
+USE_LIB_ZIP=0
+LIBMAGIC=
+LIBZIP=
+LIBXXHASH=
+
+SSL_CFLAGS=
+SSL_LDFLAGS=-lssl -lcrypto
+
+HAVE_LIBUV=0
+LIBUV_CFLAGS=
+LIBUV_LDFLAGS=
+
+HAVE_PTRACE=1
+USE_PTRACE_WRAP=1
+
+GIT_TIP:=$(shell (git rev-parse HEAD 2>/dev/null || echo HEAD ))
+GIT_TAP:=$(shell (git describe --tags 2>/dev/null || echo ${VERSION} ))
+
+# cache compiler flags at configure time #
+CFLAGS+=
+LDFLAGS+=
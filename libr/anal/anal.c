@@ -123,9 +123,11 @@ R_API RAnal *r_anal_free(RAnal *a) {
 	R_FREE (a->cpu);
 	R_FREE (a->os);
 	R_FREE (a->zign_path);
+	r_list_free (a->zign_dbs);
 	r_list_free (a->plugins);
 	a->fcns->free = r_anal_fcn_free;
 	r_list_free (a->fcns);
+	r_anal_reflines_sweep_free (a->reflines_sweep);
 	r_space_free (&a->meta_spaces);
 	r_space_free (&a->zign_spaces);
 	r_anal_pin_fini (a);
@@ -394,6 +396,9 @@ R_API int r_anal_purge (RAnal *anal) {
 	sdb_reset (anal->sdb_hints);
 	sdb_reset (anal->sdb_types);
 	sdb_reset (anal->sdb_zigns);
+	if (anal->zign_dbs) {
+		r_list_purge (anal->zign_dbs);
+	}
 	r_list_free (anal->fcns);
 	anal->fcns = r_anal_fcn_list_new ();
 	anal->fcn_tree = NULL;
@@ -5,7 +5,102 @@
 #include <r_list.h>
 #include <limits.h>
 
-#define DFLT_NINSTR 3
+/* the generation of a function is bumped whenever one of its blocks is
+ * added, freed, moved or resized, so the lookup index built over its block
+ * list knows when it went stale. functions can be analyzed from several
+ * threads, hence the atomics */
+R_API ut64 r_anal_fcn_bb_gen(RAnalFunction *fcn) {
+#if defined(__GNUC__)
+	return __atomic_load_n (&fcn->bb_gen, __ATOMIC_ACQUIRE);
+#else
+	return fcn->bb_gen;
+#endif
+}
+
+/* call after reordering the blocks of fcn or resizing them in place */
+R_API void r_anal_fcn_bb_touch(RAnalFunction *fcn) {
+	if (!fcn) {
+		return;
+	}
+#if defined(__GNUC__)
+	__atomic_add_fetch (&fcn->bb_gen, 1, __ATOMIC_ACQ_REL);
+#elif defined(_MSC_VER)
+	InterlockedIncrement64 ((volatile LONG64 *)&fcn->bb_gen);
+#else
+	fcn->bb_gen++;
+#endif
+}
+
+#define BB_CONTAINER(x) container_of ((RBNode*)(x), RAnalBlock, rb)
+
+// blocks are ordered by address, and by pointer among the ones at the same address
+static int bb_tree_cmp(const void *a_, const RBNode *b_) {
+	const RAnalBlock *a = a_, *b = BB_CONTAINER (b_);
+	if (a->addr != b->addr) {
+		return a->addr < b->addr? -1: 1;
+	}
+	return a < b? -1: a > b;
+}
+
+static void bb_tree_calc_max_addr(RBNode *node) {
+	RAnalBlock *bb = BB_CONTAINER (node);
+	int i;
+	bb->rb_max_addr = bb->addr + bb->size;
+	for (i = 0; i < 2; i++) {
+		if (node->child[i]) {
+			RAnalBlock *bb1 = BB_CONTAINER (node->child[i]);
+			if (bb1->rb_max_addr > bb->rb_max_addr) {
+				bb->rb_max_addr = bb1->rb_max_addr;
+			}
+		}
+	}
+}
+
+/* index bb as a block of fcn, or just move it to fcn if it is indexed. all
+ * the functions of an RAnal share its tree, the block reaches it through
+ * the function owning it */
+R_API void r_anal_bb_tree_insert(RBNode **root, RAnalFunction *fcn, RAnalBlock *bb) {
+	RAnalFunction *owner = bb->rb_fcn;
+	if (owner && owner->bb_tree != root) {
+		r_anal_bb_tree_delete (bb);
+	}
+	if (!bb->rb_fcn) {
+		r_rbtree_aug_insert (root, bb, &bb->rb, bb_tree_cmp, bb_tree_calc_max_addr);
+	}
+	if (owner && owner != fcn) {
+		r_anal_fcn_bb_touch (owner);
+	}
+	fcn->bb_tree = root;
+	bb->rb_fcn = fcn;
+}
+
+R_API void r_anal_bb_tree_delete(RAnalBlock *bb) {
+	if (bb->rb_fcn) {
+		r_rbtree_aug_delete (bb->rb_fcn->bb_tree, bb, bb_tree_cmp, NULL, bb_tree_calc_max_addr);
+		bb->rb_fcn = NULL;
+	}
+}
+
+/* the address is the key of the tree, so an indexed block is reinserted */
+R_API void r_anal_bb_set_addr(RAnalBlock *bb, ut64 addr) {
+	RAnalFunction *fcn = bb->rb_fcn;
+	if (fcn) {
+		r_anal_bb_tree_delete (bb);
+		bb->addr = addr;
+		r_anal_bb_tree_insert (fcn->bb_tree, fcn, bb);
+		r_anal_fcn_bb_touch (fcn);
+	} else {
+		bb->addr = addr;
+	}
+}
+
+R_API void r_anal_bb_set_size(RAnalBlock *bb, int size) {
+	bb->size = size;
+	if (bb->rb_fcn) {
+		r_rbtree_aug_update_sum (*bb->rb_fcn->bb_tree, bb, &bb->rb, bb_tree_cmp, bb_tree_calc_max_addr);
+		r_anal_fcn_bb_touch (bb->rb_fcn);
+	}
+}
 
 R_API RAnalBlock *r_anal_bb_new() {
 	RAnalBlock *bb = R_NEW0 (RAnalBlock);
@@ -21,8 +116,8 @@ R_API RAnalBlock *r_anal_bb_new() {
 	bb->fingerprint = NULL;
 	bb->diff = NULL; //r_anal_diff_new ();
 	bb->label = NULL;
-	bb->op_pos = R_NEWS0 (ut16, DFLT_NINSTR);
-	bb->op_pos_size = DFLT_NINSTR;
+	bb->op_pos = NULL;
+	bb->op_pos_size = 0;
 	bb->parent_reg_arena = NULL;
 	bb->stackptr = 0;
 	bb->parent_stackptr = INT_MAX;
@@ -33,6 +128,8 @@ R_API void r_anal_bb_free(RAnalBlock *bb) {
 	if (!bb) {
 		return;
 	}
+	r_anal_fcn_bb_touch (bb->rb_fcn);
+	r_anal_bb_tree_delete (bb);
 	r_anal_cond_free (bb->cond);
 	R_FREE (bb->fingerprint);
 	r_anal_diff_free (bb->diff);
@@ -82,7 +179,7 @@ R_API int r_anal_bb(RAnal *anal, RAnalBlock *bb, ut64 addr, ut8 *buf, ut64 len,
 	int oplen, idx = 0;
 
 	if (bb->addr == -1) {
-		bb->addr = addr;
+		r_anal_bb_set_addr (bb, addr);
 	}
 	len -= 16; // XXX: hack to avoid segfault by x86im
 	while (idx < len) {
@@ -105,7 +202,7 @@ R_API int r_anal_bb(RAnal *anal, RAnalBlock *bb, ut64 addr, ut8 *buf, ut64 len,
 		}
 		r_anal_bb_set_offset (bb, bb->ninstr++, addr + idx - bb->addr);
 		idx += oplen;
-		bb->size += oplen;
+		r_anal_bb_set_size (bb, bb->size + oplen);
 		if (head) {
 			bb->type = R_ANAL_BB_TYPE_HEAD;
 		}
@@ -230,8 +327,9 @@ R_API ut16 r_anal_bb_offset_inst(RAnalBlock *bb, int i) {
 /* set the offset of the i-th instruction in the basicblock bb */
 R_API bool r_anal_bb_set_offset(RAnalBlock *bb, int i, ut16 v) {
 	// the offset 0 of the instruction 0 is not stored because always 0
+	r_anal_fcn_bb_touch (bb->rb_fcn);
 	if (i > 0 && v > 0) {
-		if (i >= bb->op_pos_size) {
+		if (i > bb->op_pos_size) {
 			int new_pos_size = i * 2;
 			ut16 *tmp_op_pos = realloc (bb->op_pos, new_pos_size * sizeof (*bb->op_pos));
 			if (!tmp_op_pos) {
@@ -246,6 +344,24 @@ R_API bool r_anal_bb_set_offset(RAnalBlock *bb, int i, ut16 v) {
 	return true;
 }
 
+/* drop the spare room left in the instruction offsets while the block grew */
+R_API void r_anal_bb_shrink(RAnalBlock *bb) {
+	int size = R_MAX (bb->ninstr - 1, 0);
+	if (size >= bb->op_pos_size) {
+		return;
+	}
+	if (!size) {
+		R_FREE (bb->op_pos);
+	} else {
+		ut16 *op_pos = realloc (bb->op_pos, size * sizeof (*bb->op_pos));
+		if (!op_pos) {
+			return;
+		}
+		bb->op_pos = op_pos;
+	}
+	bb->op_pos_size = size;
+}
+
 /* return the address of the instruction that occupy a given offset.
  * If the offset is not part of the given basicblock, UT64_MAX is returned. */
 R_API ut64 r_anal_bb_opaddr_at(RAnalBlock *bb, ut64 off) {
@@ -287,67 +287,102 @@ R_API void r_anal_data_free(RAnalData *d) {
 	}
 }
 
-R_API RAnalData *r_anal_data(RAnal *anal, ut64 addr, const ut8 *buf, int size, int wordsize) {
+/* the type of the data r_anal_data returns for buf, with the length and
+ * the value it is built with, or -1 when there is none */
+static int data_type(RAnal *anal, const ut8 *buf, int size, int wordsize, int *dlen, ut64 *val) {
 	ut64 dst = 0;
-	int n, nsize = 0;
+	int n, type, nsize = 0;
 	int bits = anal->bits;
 	int word = wordsize? wordsize: R_MIN (8, bits / 8);
 
 	if (size < 4) {
-		return NULL;
+		return -1;
 	}
+	*val = -1;
+	*dlen = word;
 	if (size >= word && is_invalid (buf, word)) {
-		return r_anal_data_new (addr, R_ANAL_DATA_TYPE_INVALID, -1, buf, word);
+		type = R_ANAL_DATA_TYPE_INVALID;
+		goto beach;
 	}
 	{
+		/* both need all the bytes to match, stop at the first that does not */
 		int i, len = R_MIN (size, 64);
-		int is_pattern = 0;
-		int is_sequence = 0;
+		bool is_pattern = true;
+		bool is_sequence = true;
 		char ch = buf[0];
 		char ch2 = ch + 1;
-		for (i = 1; i < len; i++) {
-			if (ch2 == buf[i]) {
-				ch2++;
-				is_sequence++;
-			} else {
-				is_sequence = 0;
+		for (i = 1; i < len && (is_pattern || is_sequence); i++, ch2++) {
+			if (ch2 != buf[i]) {
+				is_sequence = false;
 			}
-			if (ch == buf[i]) {
-				is_pattern++;
+			if (ch != buf[i]) {
+				is_pattern = false;
 			}
 		}
-		if (is_sequence > len - 2) {
-			return r_anal_data_new (addr, R_ANAL_DATA_TYPE_SEQUENCE, -1,
-						buf, is_sequence);
+		if (is_sequence) {
+			*dlen = len - 1;
+			type = R_ANAL_DATA_TYPE_SEQUENCE;
+			goto beach;
 		}
-		if (is_pattern > len - 2) {
-			return r_anal_data_new (addr, R_ANAL_DATA_TYPE_PATTERN, -1,
-						buf, is_pattern);
+		if (is_pattern) {
+			*dlen = len - 1;
+			type = R_ANAL_DATA_TYPE_PATTERN;
+			goto beach;
 		}
 	}
 	if (size >= word && is_null (buf, word)) {
-		return r_anal_data_new (addr, R_ANAL_DATA_TYPE_NULL, -1, buf, word);
+		type = R_ANAL_DATA_TYPE_NULL;
+		goto beach;
 	}
 	if (is_bin (buf, size)) {
-		return r_anal_data_new (addr, R_ANAL_DATA_TYPE_HEADER, -1, buf, word);
+		type = R_ANAL_DATA_TYPE_HEADER;
+		goto beach;
 	}
 	if (size >= word) {
 		dst = is_pointer (anal, buf, word);
 		if (dst) {
-			return r_anal_data_new (addr, R_ANAL_DATA_TYPE_POINTER, dst, buf, word);
+			*val = dst;
+			type = R_ANAL_DATA_TYPE_POINTER;
+			goto beach;
 		}
 	}
 	switch (is_string (buf, size, &nsize)) {
-	case 1: return r_anal_data_new_string (addr, (const char *)buf, nsize, R_ANAL_DATA_TYPE_STRING);
-	case 2: return r_anal_data_new_string (addr, (const char *)buf, nsize, R_ANAL_DATA_TYPE_WIDE_STRING);
+	case 1:
+		*dlen = nsize;
+		return R_ANAL_DATA_TYPE_STRING;
+	case 2:
+		*dlen = nsize;
+		return R_ANAL_DATA_TYPE_WIDE_STRING;
 	}
 	if (size >= word) {
 		n = is_number (buf, word);
 		if (n) {
-			return r_anal_data_new (addr, R_ANAL_DATA_TYPE_NUMBER, n, buf, word);
+			*val = n;
+			type = R_ANAL_DATA_TYPE_NUMBER;
+			goto beach;
 		}
 	}
-	return r_anal_data_new (addr, R_ANAL_DATA_TYPE_UNKNOWN, dst, buf, R_MIN (word, size));
+	*val = dst;
+	*dlen = R_MIN (word, size);
+	type = R_ANAL_DATA_TYPE_UNKNOWN;
+beach:
+	/* r_anal_data_new refuses those */
+	return (R_MIN (*dlen, 8) < 1)? -1: type;
+}
+
+R_API RAnalData *r_anal_data(RAnal *anal, ut64 addr, const ut8 *buf, int size, int wordsize) {
+	ut64 val = 0;
+	int len = 0;
+	int type = data_type (anal, buf, size, wordsize, &len, &val);
+
+	switch (type) {
+	case -1:
+		return NULL;
+	case R_ANAL_DATA_TYPE_STRING:
+	case R_ANAL_DATA_TYPE_WIDE_STRING:
+		return r_anal_data_new_string (addr, (const char *)buf, len, type);
+	}
+	return r_anal_data_new (addr, type, val, buf, len);
 }
 
 R_API const char *r_anal_data_kind(RAnal *a, ut64 addr, const ut8 *buf, int len) {
@@ -355,25 +390,26 @@ R_API const char *r_anal_data_kind(RAnal *a, ut64 addr, const ut8 *buf, int len)
 	int unk = 0;
 	int str = 0;
 	int num = 0;
-	int i, j;
-	RAnalData *data;
+	int i, j, type, dlen;
+	ut64 val;
 	int word = a->bits / 8;
 	for (i = j = 0; i < len; j++) {
 		if (str && !buf[i]) {
 			str++;
 		}
-		data = r_anal_data (a, addr + i, buf + i, len - i, 0);
-		if (!data) {
+		/* same as r_anal_data, without building the data */
+		type = data_type (a, buf + i, len - i, 0, &dlen, &val);
+		if (type == -1) {
 			i += word;
 			continue;
 		}
-		switch (data->type) {
+		switch (type) {
 		case R_ANAL_DATA_TYPE_INVALID:
 			inv++;
 			i += word;
 			break;
 		case R_ANAL_DATA_TYPE_NUMBER:
-			if (data->ptr > 1000) {
+			if (val > 1000) {
 				num++;
 			}
 			i += word;
@@ -383,17 +419,12 @@ R_API const char *r_anal_data_kind(RAnal *a, ut64 addr, const ut8 *buf, int len)
 			i += word;
 			break;
 		case R_ANAL_DATA_TYPE_STRING:
-			if (data->len > 0) {
-				i += data->len;
-			} else {
-				i += word;
-			}
+			i += dlen + 1; // with its terminator
 			str++;
 			break;
 		default:
 			i += word;
 		}
-		r_anal_data_free (data);
 	}
 	if (j < 1) {
 		return "unknown";
@@ -1,4 +1,4 @@
-/* radare - LGPL - Copyright 2010-2017 - nibble, pancake */
+/* radare - LGPL - Copyright 2010-2018 - nibble, pancake */
 
 #include <r_anal.h>
 #include <r_util.h>
@@ -106,6 +106,19 @@ R_API int r_anal_diff_fingerprint_fcn(RAnal *anal, RAnalFunction *fcn) {
 	return len;
 }
 
+static bool same_fingerprint(const ut8 *a, int la, const ut8 *b, int lb) {
+	return a && b && la == lb && !memcmp (a, b, la);
+}
+
+// largest edit distance whose similarity may still be above th
+static ut32 distance_limit(double th, ut32 len) {
+	if (th <= 0) {
+		return UT32_MAX;
+	}
+	double d = (1.0 - th) * len;
+	return (d > 0)? (ut32)d + 1: 1;
+}
+
 R_API bool r_anal_diff_bb(RAnal *anal, RAnalFunction *fcn, RAnalFunction *fcn2) {
 	RAnalBlock *bb, *bb2, *mbb, *mbb2;
 	RListIter *iter, *iter2;
@@ -124,16 +137,31 @@ R_API bool r_anal_diff_bb(RAnal *anal, RAnalFunction *fcn, RAnalFunction *fcn2)
 		}
 		ot = 0;
 		mbb = mbb2 = NULL;
+		/* the first identical block is what the distance loop would pick */
 		r_list_foreach (fcn2->bbs, iter2, bb2) {
-			if (!bb2->diff || bb2->diff->type == R_ANAL_DIFF_TYPE_NULL) {
-				r_diff_buffers_distance (NULL, bb->fingerprint, bb->size,
-						bb2->fingerprint, bb2->size, NULL, &t);
-				if (t > anal->diff_thbb && t > ot) {
-					ot = t;
-					mbb = bb;
-					mbb2 = bb2;
-					if (t == 1) {
-						break;
+			if ((!bb2->diff || bb2->diff->type == R_ANAL_DIFF_TYPE_NULL)
+					&& same_fingerprint (bb->fingerprint, bb->size, bb2->fingerprint, bb2->size)) {
+				ot = t = 1;
+				mbb = bb;
+				mbb2 = bb2;
+				break;
+			}
+		}
+		if (!mbb2) {
+			r_list_foreach (fcn2->bbs, iter2, bb2) {
+				if (!bb2->diff || bb2->diff->type == R_ANAL_DIFF_TYPE_NULL) {
+					/* too distant blocks only need to fail both thresholds */
+					r_diff_buffers_distance_bounded (NULL, bb->fingerprint, bb->size,
+							bb2->fingerprint, bb2->size,
+							distance_limit (R_MIN (anal->diff_thbb, anal->diff_thfcn),
+								R_MAX (bb->size, bb2->size)), NULL, &t);
+					if (t > anal->diff_thbb && t > ot) {
+						ot = t;
+						mbb = bb;
+						mbb2 = bb2;
+						if (t == 1) {
+							break;
+						}
 					}
 				}
 			}
@@ -170,121 +198,570 @@ R_API bool r_anal_diff_bb(RAnal *anal, RAnalFunction *fcn, RAnalFunction *fcn2)
 	return true;
 }
 
-R_API int r_anal_diff_fcn(RAnal *anal, RList *fcns, RList *fcns2) {
-	RAnalFunction *fcn, *fcn2, *mfcn, *mfcn2;
-	RListIter *iter, *iter2;
-	ut64 maxsize, minsize;
-	double t, ot;
+/* Function diffing.
+ *
+ * Functions with the same name are paired through a hash join and byte
+ * identical functions through a hash of their fingerprints. Everything else
+ * is scored exhaustively, like it always was, unless diff.lsh is set: then
+ * big diffs only score the functions sharing a MinHash band (LSH) over the
+ * 4-byte shingles of its fingerprint. The annotations can differ from the
+ * exhaustive ones then. Either way the scores of a window of functions are
+ * computed by a few worker threads before its pairs are assigned in list
+ * order, the window keeps the exhaustive candidate lists small. */
 
-	if (!anal) {
-		return false;
+#define DIFF_THREADS 4
+#define DIFF_SHINGLE 4
+#define DIFF_MINHASH 64
+#define DIFF_BANDS 32
+#define DIFF_ROWS (DIFF_MINHASH / DIFF_BANDS)
+#define DIFF_BUCKET_MAX 512
+#define DIFF_EXHAUSTIVE (128 * 128)
+#define DIFF_WINDOW 256
+
+typedef struct {
+	RAnalFunction *fcn;
+	const ut8 *fp;
+	int size;
+	ut64 hash;
+	bool nosig;
+	ut32 sig[DIFF_MINHASH];
+} DiffFcn;
+
+typedef struct {
+	ut64 key;
+	int idx;
+} DiffKey;
+
+typedef struct {
+	int idx;
+	double t;
+} DiffCand;
+
+typedef struct {
+	RAnalFunction *fcn, *fcn2;
+	double t;
+} DiffPair;
+
+typedef struct {
+	RAnal *anal;
+	DiffFcn *a, *b;
+	int na, nb;
+	DiffKey *exact; // <hash, idx> of b sorted
+	DiffKey *bands; // <band key, idx> of b sorted
+	int nbands;
+	int *nosig; // b entries without minhash signature
+	int nnosig;
+	bool exhaustive;
+	RVector *cands; // <DiffCand> for each a
+	bool *scored;
+	int lo, hi; // window of a scored by step 2
+	DiffPair *pairs;
+	int npairs;
+} DiffCtx;
+
+typedef struct {
+	DiffCtx *ctx;
+	int id, nth;
+	int step;
+} DiffWorker;
+
+static double fcn_distance(const ut8 *a, int la, const ut8 *b, int lb, double th) {
+	double t = 0;
+	if (!r_diff_buffers_distance_bounded (NULL, a, la, b, lb,
+			distance_limit (th, R_MAX (la, lb)), NULL, &t)) {
+		return 0;
 	}
-	if (anal->cur && anal->cur->diff_fcn) {
-		return (anal->cur->diff_fcn (anal, fcns, fcns2));
+	return t;
+}
+
+static inline ut64 diff_mix(ut64 x) {
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+static ut64 fingerprint_hash(const ut8 *buf, int len) {
+	ut64 h = diff_mix (len + 1);
+	int i;
+	for (i = 0; i + 8 <= len; i += 8) {
+		h = diff_mix (h ^ r_read_le64 (buf + i));
 	}
-	/* Compare functions with the same name */
-	if (fcns) {
-		r_list_foreach (fcns, iter, fcn) {
-			r_list_foreach (fcns2, iter2, fcn2) {
-				if (fcn->name && fcn2->name && strcmp (fcn->name, fcn2->name)) {
-					continue;
-				}
-				r_diff_buffers_distance (NULL, fcn->fingerprint, r_anal_fcn_size (fcn),
-						fcn2->fingerprint, r_anal_fcn_size (fcn2),
-						NULL, &t);
-				/* Set flag in matched functions */
-				fcn->diff->type = fcn2->diff->type = (t >= 1)
-					? R_ANAL_DIFF_TYPE_MATCH
-					: R_ANAL_DIFF_TYPE_UNMATCH;
-				fcn->diff->dist = fcn2->diff->dist = t;
-				R_FREE (fcn->fingerprint);
-				R_FREE (fcn2->fingerprint);
-				fcn->diff->addr = fcn2->addr;
-				fcn2->diff->addr = fcn->addr;
-				fcn->diff->size = r_anal_fcn_size (fcn2);
-				fcn2->diff->size = r_anal_fcn_size (fcn);
-				R_FREE (fcn->diff->name);
-				if (fcn2->name) {
-					fcn->diff->name = strdup (fcn2->name);
-				}
-				R_FREE (fcn2->diff->name);
-				if (fcn->name) {
-					fcn2->diff->name = strdup (fcn->name);
-				}
-				r_anal_diff_bb (anal, fcn, fcn2);
-				break;
+	for (; i < len; i++) {
+		h = diff_mix (h ^ buf[i]);
+	}
+	return h;
+}
+
+static void fingerprint_sig(DiffFcn *f) {
+	ut64 mul[DIFF_MINHASH], add[DIFF_MINHASH];
+	int i, j;
+
+	f->nosig = !f->fp || f->size < DIFF_SHINGLE;
+	if (f->nosig) {
+		return;
+	}
+	for (j = 0; j < DIFF_MINHASH; j++) {
+		mul[j] = diff_mix (2 * j + 1) | 1;
+		add[j] = diff_mix (2 * j + 2);
+		f->sig[j] = UT32_MAX;
+	}
+	for (i = 0; i + DIFF_SHINGLE <= f->size; i++) {
+		ut64 h = diff_mix (r_read_le32 (f->fp + i));
+		for (j = 0; j < DIFF_MINHASH; j++) {
+			ut32 v = (h * mul[j] + add[j]) >> 32;
+			if (v < f->sig[j]) {
+				f->sig[j] = v;
 			}
 		}
 	}
-	/* Compare remaining functions */
-	r_list_foreach (fcns, iter, fcn) {
-/*
-		if ((fcn->type != R_ANAL_FCN_TYPE_FCN &&
-			fcn->type != R_ANAL_FCN_TYPE_SYM) ||
-			fcn->diff->type != R_ANAL_DIFF_TYPE_NULL) {
-			continue;
+}
+
+static ut64 band_key(const DiffFcn *f, int band) {
+	ut64 k = band;
+	int i;
+	for (i = 0; i < DIFF_ROWS; i++) {
+		k = diff_mix (k ^ ((ut64)f->sig[band * DIFF_ROWS + i] << 8));
+	}
+	return k;
+}
+
+static int diff_key_cmp(const void *a, const void *b) {
+	const DiffKey *ka = a, *kb = b;
+	if (ka->key != kb->key) {
+		return ka->key < kb->key? -1: 1;
+	}
+	return ka->idx - kb->idx;
+}
+
+static int diff_cand_cmp(const void *a, const void *b) {
+	return ((const DiffCand *)a)->idx - ((const DiffCand *)b)->idx;
+}
+
+static int diff_key_lower(const DiffKey *keys, int n, ut64 key) {
+	int lo = 0, hi = n;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (keys[mid].key < key) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
 		}
-*/
-		if (fcn->diff->type != R_ANAL_DIFF_TYPE_NULL) {
-			continue;
+	}
+	return lo;
+}
+
+static bool size_compatible(RAnal *anal, int s, int s2) {
+	ut64 maxsize = R_MAX (s, s2);
+	ut64 minsize = R_MIN (s, s2);
+	return !(maxsize * anal->diff_thfcn > minsize);
+}
+
+static bool has_twin(DiffCtx *ctx, const DiffFcn *f) {
+	int i;
+	if (!f->fp) {
+		return false;
+	}
+	for (i = diff_key_lower (ctx->exact, ctx->nb, f->hash); i < ctx->nb && ctx->exact[i].key == f->hash; i++) {
+		const DiffFcn *f2 = &ctx->b[ctx->exact[i].idx];
+		if (same_fingerprint (f->fp, f->size, f2->fp, f2->size)) {
+			return true;
 		}
-		ot = 0;
-		mfcn = mfcn2 = NULL;
-		r_list_foreach (fcns2, iter2, fcn2) {
-			int fcn_size = r_anal_fcn_size (fcn);
-			int fcn2_size = r_anal_fcn_size (fcn2);
-			if (fcn_size > fcn2_size) {
-				maxsize = fcn_size;
-				minsize = fcn2_size;
-			} else {
-				maxsize = fcn2_size;
-				minsize = fcn_size;
+	}
+	return false;
+}
+
+// first identical function still available, in list order
+static int find_twin(DiffCtx *ctx, const DiffFcn *f) {
+	int i;
+	if (!f->fp || ctx->anal->diff_thfcn >= 1) {
+		return -1;
+	}
+	for (i = diff_key_lower (ctx->exact, ctx->nb, f->hash); i < ctx->nb && ctx->exact[i].key == f->hash; i++) {
+		const DiffFcn *f2 = &ctx->b[ctx->exact[i].idx];
+		if (f2->fcn->diff->type == R_ANAL_DIFF_TYPE_NULL
+				&& same_fingerprint (f->fp, f->size, f2->fp, f2->size)) {
+			return ctx->exact[i].idx;
+		}
+	}
+	return -1;
+}
+
+static void add_cand(DiffCtx *ctx, RVector *cands, int *stamp, int i, int idx) {
+	if (stamp[idx] == i + 1) {
+		return;
+	}
+	stamp[idx] = i + 1;
+	if (size_compatible (ctx->anal, ctx->a[i].size, ctx->b[idx].size)) {
+		DiffCand c = { idx, 0 };
+		r_vector_push (cands, &c);
+	}
+}
+
+static void score_fcn(DiffCtx *ctx, int *stamp, int i) {
+	DiffFcn *f = &ctx->a[i];
+	RVector *cands = &ctx->cands[i];
+	DiffCand *c;
+	int j, k;
+
+	if (ctx->exhaustive) {
+		for (j = 0; j < ctx->nb; j++) {
+			add_cand (ctx, cands, stamp, i, j);
+		}
+	} else if (f->nosig) {
+		for (j = 0; j < ctx->nnosig; j++) {
+			add_cand (ctx, cands, stamp, i, ctx->nosig[j]);
+		}
+	} else {
+		for (k = 0; k < DIFF_BANDS; k++) {
+			ut64 key = band_key (f, k);
+			int lo = diff_key_lower (ctx->bands, ctx->nbands, key);
+			int hi = lo;
+			while (hi < ctx->nbands && ctx->bands[hi].key == key) {
+				hi++;
 			}
-			if (maxsize * anal->diff_thfcn > minsize) {
-				eprintf ("Exceeded anal threshold while diffing %s and %s\n", fcn->name, fcn2->name);
+			if (hi - lo > DIFF_BUCKET_MAX) {
 				continue;
 			}
-			if (fcn2->diff->type != R_ANAL_DIFF_TYPE_NULL) {
-				eprintf ("Function %s already diffed\n", fcn2->name);
-				continue;
+			for (j = lo; j < hi; j++) {
+				add_cand (ctx, cands, stamp, i, ctx->bands[j].idx);
 			}
-			if ((fcn2->type != R_ANAL_FCN_TYPE_FCN && fcn2->type != R_ANAL_FCN_TYPE_SYM)) {
-				eprintf ("Function %s type not supported\n", fcn2->name);
-				continue;
+		}
+		qsort (cands->a, cands->len, sizeof (DiffCand), diff_cand_cmp);
+	}
+	r_vector_foreach (cands, c) {
+		DiffFcn *f2 = &ctx->b[c->idx];
+		if (f2->fcn->diff->type == R_ANAL_DIFF_TYPE_NULL) {
+			c->t = fcn_distance (f->fp, f->size, f2->fp, f2->size, ctx->anal->diff_thfcn);
+		}
+	}
+	ctx->scored[i] = true;
+}
+
+/* step 0 computes the signatures, step 1 scores the name pairs and
+ * step 2 scores the candidates of a window, each worker taking every nth
+ * item */
+static void diff_work(DiffWorker *w) {
+	DiffCtx *ctx = w->ctx;
+	int i, *stamp;
+
+	switch (w->step) {
+	case 0:
+		for (i = w->id; i < ctx->na + ctx->nb; i += w->nth) {
+			DiffFcn *f = i < ctx->na? &ctx->a[i]: &ctx->b[i - ctx->na];
+			f->hash = f->fp? fingerprint_hash (f->fp, f->size): 0;
+			if (!ctx->exhaustive) {
+				fingerprint_sig (f);
 			}
-			r_diff_buffers_distance (NULL, fcn->fingerprint, fcn_size, fcn2->fingerprint, fcn2_size, NULL, &t);
-			fcn->diff->dist = fcn2->diff->dist = t;
-			if (t > anal->diff_thfcn && t > ot) {
-				ot = t;
-				mfcn = fcn;
-				mfcn2 = fcn2;
-				if (t == 1) {
+		}
+		break;
+	case 1:
+		for (i = w->id; i < ctx->npairs; i += w->nth) {
+			DiffPair *p = &ctx->pairs[i];
+			p->t = fcn_distance (p->fcn->fingerprint, r_anal_fcn_size (p->fcn),
+					p->fcn2->fingerprint, r_anal_fcn_size (p->fcn2), -1);
+		}
+		break;
+	case 2:
+		if (!(stamp = calloc (ctx->nb + 1, sizeof (int)))) {
+			break;
+		}
+		for (i = ctx->lo + w->id; i < ctx->hi; i += w->nth) {
+			if (ctx->a[i].fcn->diff->type == R_ANAL_DIFF_TYPE_NULL
+					&& !has_twin (ctx, &ctx->a[i])) {
+				score_fcn (ctx, stamp, i);
+			}
+		}
+		free (stamp);
+		break;
+	}
+}
+
+static RThreadFunctionRet diff_thread(RThread *th) {
+	diff_work (th->user);
+	return R_TH_STOP;
+}
+
+static void diff_run(DiffCtx *ctx, int step, int count) {
+	DiffWorker w[DIFF_THREADS];
+	RThread *th[DIFF_THREADS] = {0};
+	int i, nth = R_MAX (1, R_MIN (DIFF_THREADS, count / 64));
+
+	for (i = 0; i < nth; i++) {
+		w[i].ctx = ctx;
+		w[i].id = i;
+		w[i].nth = nth;
+		w[i].step = step;
+		if (nth > 1) {
+			th[i] = r_th_new (diff_thread, &w[i], 0);
+		}
+	}
+	for (i = 0; i < nth; i++) {
+		if (th[i]) {
+			r_th_wait (th[i]);
+			r_th_free (th[i]);
+		} else {
+			diff_work (&w[i]);
+		}
+	}
+}
+
+static void diff_set(RAnal *anal, RAnalFunction *fcn, RAnalFunction *fcn2, double t, int type) {
+	fcn->diff->type = fcn2->diff->type = type;
+	fcn->diff->dist = fcn2->diff->dist = t;
+	R_FREE (fcn->fingerprint);
+	R_FREE (fcn2->fingerprint);
+	fcn->diff->addr = fcn2->addr;
+	fcn2->diff->addr = fcn->addr;
+	fcn->diff->size = r_anal_fcn_size (fcn2);
+	fcn2->diff->size = r_anal_fcn_size (fcn);
+	R_FREE (fcn->diff->name);
+	if (fcn2->name) {
+		fcn->diff->name = strdup (fcn2->name);
+	}
+	R_FREE (fcn2->diff->name);
+	if (fcn->name) {
+		fcn2->diff->name = strdup (fcn->name);
+	}
+	r_anal_diff_bb (anal, fcn, fcn2);
+}
+
+static void name_free_kv(HtKv *kv) {
+	free (kv->key);
+}
+
+/* Compare functions with the same name */
+static void diff_names(RAnal *anal, DiffCtx *ctx, RList *fcns, RList *fcns2) {
+	RAnalFunction *fcn, *fcn2, **byidx;
+	RListIter *iter;
+	int i, n2 = r_list_length (fcns2), unnamed = -1;
+	double prev = 0;
+
+	byidx = R_NEWS0 (RAnalFunction *, n2 + 1);
+	SdbHt *names = ht_new_size (n2, NULL, name_free_kv, NULL);
+	ctx->pairs = R_NEWS0 (DiffPair, r_list_length (fcns) + 1);
+	if (!byidx || !names || !ctx->pairs) {
+		goto beach;
+	}
+	i = 0;
+	r_list_foreach (fcns2, iter, fcn2) {
+		byidx[i] = fcn2;
+		if (!fcn2->name) {
+			if (unnamed < 0) {
+				unnamed = i;
+			}
+		} else {
+			ht_insert (names, fcn2->name, (void *)(size_t)(i + 1));
+		}
+		i++;
+	}
+	r_list_foreach (fcns, iter, fcn) {
+		// a missing name on either side matches anything
+		int idx = unnamed;
+		if (!fcn->name) {
+			idx = n2 > 0? 0: -1;
+		} else {
+			int named = (int)(size_t)ht_find (names, fcn->name, NULL) - 1;
+			if (named >= 0 && (idx < 0 || named < idx)) {
+				idx = named;
+			}
+		}
+		if (idx >= 0) {
+			DiffPair *p = &ctx->pairs[ctx->npairs++];
+			p->fcn = fcn;
+			p->fcn2 = byidx[idx];
+		}
+	}
+	diff_run (ctx, 1, ctx->npairs);
+	for (i = 0; i < ctx->npairs; i++) {
+		DiffPair *p = &ctx->pairs[i];
+		/* a function paired again lost its fingerprint to the first pair,
+		 * the distance of the previous pair is kept then */
+		if (!p->fcn->fingerprint || !p->fcn2->fingerprint) {
+			p->t = prev;
+		}
+		prev = p->t;
+		/* Set flag in matched functions */
+		diff_set (anal, p->fcn, p->fcn2, p->t, (p->t >= 1)
+			? R_ANAL_DIFF_TYPE_MATCH
+			: R_ANAL_DIFF_TYPE_UNMATCH);
+	}
+beach:
+	R_FREE (ctx->pairs);
+	ctx->npairs = 0;
+	ht_free (names);
+	free (byidx);
+}
+
+static bool diff_prepare(RAnal *anal, DiffCtx *ctx, RList *fcns, RList *fcns2) {
+	RAnalFunction *fcn;
+	RListIter *iter;
+	int i, j;
+
+	ctx->a = R_NEWS0 (DiffFcn, r_list_length (fcns) + 1);
+	ctx->b = R_NEWS0 (DiffFcn, r_list_length (fcns2) + 1);
+	if (!ctx->a || !ctx->b) {
+		return false;
+	}
+	r_list_foreach (fcns, iter, fcn) {
+		if (fcn->diff->type == R_ANAL_DIFF_TYPE_NULL) {
+			DiffFcn *f = &ctx->a[ctx->na++];
+			f->fcn = fcn;
+			f->fp = fcn->fingerprint;
+			f->size = r_anal_fcn_size (fcn);
+		}
+	}
+	r_list_foreach (fcns2, iter, fcn) {
+		if (fcn->diff->type == R_ANAL_DIFF_TYPE_NULL
+				&& (fcn->type == R_ANAL_FCN_TYPE_FCN || fcn->type == R_ANAL_FCN_TYPE_SYM)) {
+			DiffFcn *f = &ctx->b[ctx->nb++];
+			f->fcn = fcn;
+			f->fp = fcn->fingerprint;
+			f->size = r_anal_fcn_size (fcn);
+		}
+	}
+	ctx->exhaustive = !anal->diff_lsh || (st64)ctx->na * ctx->nb <= DIFF_EXHAUSTIVE;
+	diff_run (ctx, 0, ctx->na + ctx->nb);
+
+	ctx->exact = R_NEWS0 (DiffKey, ctx->nb + 1);
+	ctx->bands = R_NEWS0 (DiffKey, (st64)ctx->nb * DIFF_BANDS + 1);
+	ctx->nosig = R_NEWS0 (int, ctx->nb + 1);
+	ctx->cands = R_NEWS0 (RVector, ctx->na + 1);
+	ctx->scored = R_NEWS0 (bool, ctx->na + 1);
+	if (!ctx->exact || !ctx->bands || !ctx->nosig || !ctx->cands || !ctx->scored) {
+		return false;
+	}
+	for (i = 0; i < ctx->nb; i++) {
+		DiffFcn *f = &ctx->b[i];
+		ctx->exact[i].key = f->hash;
+		ctx->exact[i].idx = i;
+		if (ctx->exhaustive) {
+			continue;
+		}
+		if (f->nosig) {
+			ctx->nosig[ctx->nnosig++] = i;
+			continue;
+		}
+		for (j = 0; j < DIFF_BANDS; j++) {
+			DiffKey *k = &ctx->bands[ctx->nbands++];
+			k->key = band_key (f, j);
+			k->idx = i;
+		}
+	}
+	qsort (ctx->exact, ctx->nb, sizeof (DiffKey), diff_key_cmp);
+	qsort (ctx->bands, ctx->nbands, sizeof (DiffKey), diff_key_cmp);
+	for (i = 0; i < ctx->na; i++) {
+		r_vector_init (&ctx->cands[i], sizeof (DiffCand), NULL, NULL);
+	}
+	return true;
+}
+
+static void diff_fini(DiffCtx *ctx) {
+	int i;
+	if (ctx->cands) {
+		for (i = 0; i < ctx->na; i++) {
+			r_vector_clear (&ctx->cands[i]);
+		}
+	}
+	free (ctx->cands);
+	free (ctx->scored);
+	free (ctx->nosig);
+	free (ctx->bands);
+	free (ctx->exact);
+	free (ctx->pairs);
+	free (ctx->a);
+	free (ctx->b);
+}
+
+/* Compare remaining functions */
+static void diff_remaining(RAnal *anal, DiffCtx *ctx) {
+	DiffCand *c;
+	int i, *stamp = NULL;
+
+	for (i = 0; i < ctx->na; i++) {
+		RAnalFunction *fcn = ctx->a[i].fcn;
+		RAnalFunction *mfcn2 = NULL;
+		DiffCand *last = NULL;
+		double ot = 0, dist = 1;
+		int twin;
+		if (i == ctx->hi) {
+			/* the scores only depend on the fingerprints, so scoring
+			 * ahead gives the same pairs as scoring each function when
+			 * it is assigned */
+			ctx->lo = i;
+			ctx->hi = R_MIN (i + DIFF_WINDOW, ctx->na);
+			diff_run (ctx, 2, ctx->hi - ctx->lo);
+		}
+		if (fcn->diff->type != R_ANAL_DIFF_TYPE_NULL) {
+			continue;
+		}
+		twin = find_twin (ctx, &ctx->a[i]);
+		if (twin >= 0) {
+			mfcn2 = ctx->b[twin].fcn;
+			ot = 1;
+		} else {
+			if (!ctx->scored[i]) {
+				// small diffs, or all its twins were taken by earlier functions
+				if (!stamp && !(stamp = calloc (ctx->nb + 1, sizeof (int)))) {
 					break;
 				}
+				score_fcn (ctx, stamp, i);
+			}
+			r_vector_foreach (&ctx->cands[i], c) {
+				RAnalFunction *fcn2 = ctx->b[c->idx].fcn;
+				if (fcn2->diff->type != R_ANAL_DIFF_TYPE_NULL) {
+					continue;
+				}
+				last = c;
+				if (c->t > anal->diff_thfcn && c->t > ot) {
+					ot = c->t;
+					mfcn2 = fcn2;
+					if (c->t == 1) {
+						break;
+					}
+				}
+			}
+			/* fcn keeps the distance of the last function compared, like
+			 * the old loop did, and r_anal_diff_bb checks it when no block
+			 * matches. Pruned candidates have no such order. */
+			dist = ot;
+			if (last && ctx->exhaustive) {
+				DiffFcn *f2 = &ctx->b[last->idx];
+				dist = (last->t > anal->diff_thfcn)? last->t
+					: fcn_distance (ctx->a[i].fp, ctx->a[i].size, f2->fp, f2->size, -1);
 			}
 		}
-		if (mfcn && mfcn2) {
+		if (mfcn2) {
 			/* Set flag in matched functions */
-			mfcn->diff->type = mfcn2->diff->type = (ot == 1)
+			diff_set (anal, fcn, mfcn2, dist, (ot == 1)
 				? R_ANAL_DIFF_TYPE_MATCH
-				: R_ANAL_DIFF_TYPE_UNMATCH;
-			R_FREE (mfcn->fingerprint);
-			R_FREE (mfcn2->fingerprint);
-			mfcn->diff->addr = mfcn2->addr;
-			mfcn2->diff->addr = mfcn->addr;
-			mfcn->diff->size = r_anal_fcn_size (mfcn2);
-			mfcn2->diff->size = r_anal_fcn_size (mfcn);
-			R_FREE (mfcn->diff->name);
-			if (mfcn2->name) {
-				mfcn->diff->name = strdup (mfcn2->name);
-			}
-			R_FREE (mfcn2->diff->name);
-			if (mfcn->name) {
-				mfcn2->diff->name = strdup (mfcn->name);
-			}
-			r_anal_diff_bb (anal, mfcn, mfcn2);
+				: R_ANAL_DIFF_TYPE_UNMATCH);
+			mfcn2->diff->dist = ot;
 		}
+		r_vector_clear (&ctx->cands[i]);
+	}
+	free (stamp);
+}
+
+R_API int r_anal_diff_fcn(RAnal *anal, RList *fcns, RList *fcns2) {
+	DiffCtx ctx = {0};
+
+	if (!anal) {
+		return false;
+	}
+	if (anal->cur && anal->cur->diff_fcn) {
+		return (anal->cur->diff_fcn (anal, fcns, fcns2));
+	}
+	ctx.anal = anal;
+	if (fcns && fcns2) {
+		diff_names (anal, &ctx, fcns, fcns2);
+	}
+	if (fcns && fcns2 && diff_prepare (anal, &ctx, fcns, fcns2)) {
+		diff_remaining (anal, &ctx);
 	}
+	diff_fini (&ctx);
 	return true;
 }
 
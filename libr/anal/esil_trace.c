@@ -2,10 +2,7 @@
 
 #include <r_anal.h>
 
-#define DB esil->db_trace
-#define KEY(x) sdb_fmt ("%d."x, esil->trace_idx)
-#define KEYAT(x,y) sdb_fmt ("%d."x".0x%"PFMT64x, esil->trace_idx, y)
-#define KEYREG(x,y) sdb_fmt ("%d."x".%s", esil->trace_idx, y)
+#define LOG esil->trace_log
 
 static int ocbs_set = false;
 static RAnalEsilCallbacks ocbs = {0};
@@ -26,10 +23,8 @@ static int trace_hook_reg_read(RAnalEsil *esil, const char *name, ut64 *res, int
 		ret = esil->cb.reg_read (esil, name, res, size);
 	}
 	if (ret) {
-		ut64 val = *res;
-		//eprintf ("[ESIL] REG READ %s 0x%08"PFMT64x"\n", name, val);
-		sdb_array_add (DB, KEY ("reg.read"), name, 0);
-		sdb_num_set (DB, KEYREG ("reg.read", name), val, 0);
+		//eprintf ("[ESIL] REG READ %s 0x%08"PFMT64x"\n", name, *res);
+		r_tracelog_reg (LOG, R_TRACELOG_REG_READ, name, *res);
 	} //else {
 		//eprintf ("[ESIL] REG READ %s FAILED\n", name);
 	//}
@@ -39,8 +34,7 @@ static int trace_hook_reg_read(RAnalEsil *esil, const char *name, ut64 *res, int
 static int trace_hook_reg_write(RAnalEsil *esil, const char *name, ut64 *val) {
 	int ret = 0;
 	//eprintf ("[ESIL] REG WRITE %s 0x%08"PFMT64x"\n", name, *val);
-	sdb_array_add (DB, KEY ("reg.write"), name, 0);
-	sdb_num_set (DB, KEYREG ("reg.write", name), *val, 0);
+	r_tracelog_reg (LOG, R_TRACELOG_REG_WRITE, name, *val);
 	if (ocbs.hook_reg_write) {
 		RAnalEsilCallbacks cbs = esil->cb;
 		esil->cb = ocbs;
@@ -51,16 +45,11 @@ static int trace_hook_reg_write(RAnalEsil *esil, const char *name, ut64 *val) {
 }
 
 static int trace_hook_mem_read(RAnalEsil *esil, ut64 addr, ut8 *buf, int len) {
-	char *hexbuf = calloc ((1 + len), 4);
 	int ret = 0;
 	if (esil->cb.mem_read) {
 		ret = esil->cb.mem_read (esil, addr, buf, len);
 	}
-	sdb_array_add_num (DB, KEY ("mem.read"), addr, 0);
-	r_hex_bin2str (buf, len, hexbuf);
-	sdb_set (DB, KEYAT ("mem.read.data", addr), hexbuf, 0);
-	//eprintf ("[ESIL] MEM READ 0x%08"PFMT64x" %s\n", addr, hexbuf);
-	free (hexbuf);
+	r_tracelog_mem (LOG, R_TRACELOG_MEM_READ, addr, buf, len);
 
 	if (ocbs.hook_mem_read) {
 		RAnalEsilCallbacks cbs = esil->cb;
@@ -73,12 +62,7 @@ static int trace_hook_mem_read(RAnalEsil *esil, ut64 addr, ut8 *buf, int len) {
 
 static int trace_hook_mem_write(RAnalEsil *esil, ut64 addr, const ut8 *buf, int len) {
 	int ret = 0;
-	char *hexbuf = malloc ((1+len)*3);
-	sdb_array_add_num (DB, KEY ("mem.write"), addr, 0);
-	r_hex_bin2str (buf, len, hexbuf);
-	sdb_set (DB, KEYAT ("mem.write.data", addr), hexbuf, 0);
-	//eprintf ("[ESIL] MEM WRITE 0x%08"PFMT64x" %s\n", addr, hexbuf);
-	free (hexbuf);
+	r_tracelog_mem (LOG, R_TRACELOG_MEM_WRITE, addr, buf, len);
 
 	if (ocbs.hook_mem_write) {
 		RAnalEsilCallbacks cbs = esil->cb;
@@ -97,11 +81,11 @@ R_API void r_anal_esil_trace (RAnalEsil *esil, RAnalOp *op) {
 	}
 	ocbs = esil->cb;
 	ocbs_set = true;
-	if (!DB) {
-		DB = sdb_new0 ();
+	if (!LOG && !(LOG = r_tracelog_new ())) {
+		ocbs_set = false;
+		return;
 	}
-	sdb_num_set (DB, "idx", esil->trace_idx, 0);
-	sdb_num_set (DB, KEY ("addr"), op->addr, 0);
+	r_tracelog_step (LOG, op->addr);
 //	sdb_set (DB, KEY ("opcode"), op->mnemonic, 0);
 //	sdb_set (DB, KEY ("addr"), expr, 0);
 
@@ -121,74 +105,142 @@ R_API void r_anal_esil_trace (RAnalEsil *esil, RAnalOp *op) {
 	esil->cb = ocbs;
 	ocbs_set = false;
 	esil->verbose = esil_verbose;
-	esil->trace_idx ++;
+	esil->trace_idx = r_tracelog_count (LOG);
+}
+
+R_API void r_anal_esil_trace_reset(RAnalEsil *esil) {
+	if (LOG) {
+		r_tracelog_reset (LOG);
+	}
+	esil->trace_idx = 0;
+}
+
+typedef void (*TraceKvCallback)(void *user, const char *k, const char *v);
+
+/* registers are listed once per step, like the old sdb arrays did */
+static bool reg_seen(RTraceLogStep *st, int i) {
+	const RTraceLogEvent *ev = &st->events[i];
+	int j;
+	for (j = 0; j < i; j++) {
+		if (st->events[j].type == ev->type && !strcmp (st->events[j].reg, ev->reg)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool list_has(const char *list, const char *item) {
+	size_t len = strlen (item);
+	while (*list) {
+		const char *comma = strchr (list, ',');
+		size_t n = comma? (size_t)(comma - list): strlen (list);
+		if (n == len && !strncmp (list, item, len)) {
+			return true;
+		}
+		if (!comma) {
+			break;
+		}
+		list = comma + 1;
+	}
+	return false;
+}
+
+/* expand a step into the old key=value layout */
+static bool trace_step_kv(RAnalEsil *esil, int idx, TraceKvCallback cb, void *user) {
+	static const char *names[] = { NULL, "reg.read", "reg.write", "mem.read", "mem.write" };
+	RTraceLogStep st;
+	int i, type;
+	if (!LOG || idx < 0 || !r_tracelog_get (LOG, idx, &st)) {
+		return false;
+	}
+	cb (user, sdb_fmt ("%d.addr", idx), sdb_fmt ("0x%"PFMT64x, st.pc));
+	for (type = R_TRACELOG_REG_READ; type <= R_TRACELOG_MEM_WRITE; type++) {
+		RStrBuf *list = r_strbuf_new ("");
+		for (i = 0; i < st.count; i++) {
+			const RTraceLogEvent *ev = &st.events[i];
+			if (ev->type != type || (ev->reg && reg_seen (&st, i))) {
+				continue;
+			}
+			const char *item = ev->reg? ev->reg: sdb_fmt ("0x%"PFMT64x, ev->addr);
+			const char *cur = r_strbuf_get (list);
+			if (ev->reg || !list_has (cur, item)) {
+				r_strbuf_appendf (list, "%s%s", *cur? ",": "", item);
+			}
+			if (ev->reg) {
+				cb (user, sdb_fmt ("%d.%s.%s", idx, names[type], ev->reg),
+					sdb_fmt ("0x%"PFMT64x, ev->value));
+			} else {
+				char *hex = malloc (ev->len * 2 + 1);
+				if (hex) {
+					r_hex_bin2str (ev->data, ev->len, hex);
+					cb (user, sdb_fmt ("%d.%s.data.0x%"PFMT64x, idx, names[type], ev->addr), hex);
+					free (hex);
+				}
+			}
+		}
+		if (*r_strbuf_get (list)) {
+			cb (user, sdb_fmt ("%d.%s", idx, names[type]), r_strbuf_get (list));
+		}
+		r_strbuf_free (list);
+	}
+	return true;
+}
+
+static void trace_kv_print(void *user, const char *k, const char *v) {
+	RAnalEsil *esil = user;
+	esil->anal->cb_printf ("%s=%s\n", k, v);
+}
+
+static void trace_kv_set(void *user, const char *k, const char *v) {
+	sdb_set ((Sdb *)user, k, v, 0);
+}
+
+/* build an sdb with the whole trace for queries, use with care */
+R_API Sdb *r_anal_esil_trace_sdb(RAnalEsil *esil) {
+	Sdb *db = sdb_new0 ();
+	int i;
+	if (db && LOG) {
+		int count = r_tracelog_count (LOG);
+		sdb_num_set (db, "idx", count - 1, 0);
+		for (i = 0; i < count; i++) {
+			trace_step_kv (esil, i, trace_kv_set, db);
+		}
+	}
+	return db;
 }
 
 R_API void r_anal_esil_trace_list (RAnalEsil *esil) {
-	SdbKv *kv;
-	SdbListIter *iter;
-	SdbList *list = sdb_foreach_list (esil->db_trace, true);
-	ls_foreach (list, iter, kv) {
-		eprintf ("%s=%s\n", sdbkv_key (kv), sdbkv_value (kv));
+	int i, count = LOG? r_tracelog_count (LOG): 0;
+	for (i = 0; i < count; i++) {
+		trace_step_kv (esil, i, trace_kv_print, esil);
 	}
-	ls_free (list);
 }
 
 R_API void r_anal_esil_trace_show(RAnalEsil *esil, int idx) {
 	PrintfCallback p = esil->anal->cb_printf;
-	const char *str2;
-	const char *str;
-	int trace_idx = esil->trace_idx;
-	esil->trace_idx = idx;
-
-	str2 = sdb_const_get (DB, KEY ("addr"), 0);
-	if (!str2) {
+	RTraceLogStep st;
+	int i;
+	if (!LOG || idx < 0 || !r_tracelog_get (LOG, idx, &st)) {
 		return;
 	}
-	p ("dr pc = %s\n", str2);
+	p ("dr pc = 0x%"PFMT64x"\n", st.pc);
 	/* registers */
-	str = sdb_const_get (DB, KEY ("reg.read"), 0);
-	if (str) {
-		char regname[32];
-		const char *next, *ptr = str;
-		if (ptr && *ptr) {
-			do {
-				next = sdb_const_anext (ptr);
-				int len = next? (int)(size_t)(next-ptr)-1 : strlen (ptr);
-				if (len <sizeof(regname)) {
-					memcpy (regname, ptr, len);
-					regname[len] = 0;
-					str2 = sdb_const_get (DB, KEYREG ("reg.read", regname), 0);
-					p ("dr %s = %s\n", regname, str2);
-				} else {
-					eprintf ("Invalid entry in reg.read\n");
-				}
-				ptr = next;
-			} while (next);
+	for (i = 0; i < st.count; i++) {
+		const RTraceLogEvent *ev = &st.events[i];
+		if (ev->type == R_TRACELOG_REG_READ && !reg_seen (&st, i)) {
+			p ("dr %s = 0x%"PFMT64x"\n", ev->reg, ev->value);
 		}
 	}
 	/* memory */
-	str = sdb_const_get (DB, KEY ("mem.read"), 0);
-	if (str) {
-		char addr[64];
-		const char *next, *ptr = str;
-		if (ptr && *ptr) {
-			do {
-				next = sdb_const_anext (ptr);
-				int len = next? (int)(size_t)(next-ptr)-1 : strlen (ptr);
-				if (len <sizeof(addr)) {
-					memcpy (addr, ptr, len);
-					addr[len] = 0;
-					str2 = sdb_const_get (DB, KEYAT ("mem.read.data",
-						r_num_get (NULL, addr)), 0);
-					p ("wx %s @ %s\n", str2, addr);
-				} else {
-					eprintf ("Invalid entry in reg.read\n");
-				}
-				ptr = next;
-			} while (next);
+	for (i = 0; i < st.count; i++) {
+		const RTraceLogEvent *ev = &st.events[i];
+		if (ev->type == R_TRACELOG_MEM_READ) {
+			char *hex = malloc (ev->len * 2 + 1);
+			if (hex) {
+				r_hex_bin2str (ev->data, ev->len, hex);
+				p ("wx %s @ 0x%"PFMT64x"\n", hex, ev->addr);
+				free (hex);
+			}
 		}
 	}
-
-	esil->trace_idx = trace_idx;
 }
@@ -37,6 +37,9 @@
 
 #define VERBOSE_DELAY if (0)
 
+// functions with fewer blocks are looked up linearly
+#define BB_INDEX_MIN 16
+
 #define FCN_CONTAINER(x) container_of ((RBNode*)(x), RAnalFunction, rb)
 #define fcn_tree_foreach_intersect(root, it, data, from, to)										\
 	for ((it) = _fcn_tree_iter_first (root, from, to); (it).cur && ((data) = FCN_CONTAINER ((it).cur), 1); _fcn_tree_iter_next (&(it), from, to))
@@ -47,6 +50,25 @@ typedef struct fcn_tree_iter_t {
 	RBNode *path[R_RBTREE_MAX_HEIGHT];
 } FcnTreeIter;
 
+typedef struct {
+	RAnalBlock *bb;
+	ut64 addr;
+	ut64 maxend; // highest end address up to this entry
+	int pos; // position in the lists the index was built from
+} BBIndexEntry;
+
+/* blocks of a function sorted by address */
+struct r_anal_bb_index_t {
+	BBIndexEntry *entries;
+	int count;
+	RList *list; // fcn->bbs
+	int list_len;
+	ut64 gen; // r_anal_fcn_bb_gen () when the entries were built
+	ut64 seen; // r_anal_fcn_bb_gen () at the previous lookup
+	bool valid;
+	bool unowned; // some block is not in this function's tree
+};
+
 #if USE_SDB_CACHE
 static Sdb *HB = NULL;
 #endif
@@ -69,10 +91,130 @@ static int cmpaddr(const void *_a, const void *_b) {
 	return (a->addr - b->addr);
 }
 
+static int bb_index_cmp(const void *_a, const void *_b) {
+	const BBIndexEntry *a = _a, *b = _b;
+	if (a->addr != b->addr) {
+		return a->addr < b->addr? -1: 1;
+	}
+	return a->pos - b->pos;
+}
+
+R_API void r_anal_bb_index_free(struct r_anal_bb_index_t *idx) {
+	if (idx) {
+		free (idx->entries);
+		free (idx);
+	}
+}
+
+/* Whether the index is up to date. While blocks are being created, grown
+ * or freed it is not rebuilt: that only happens once they stay the same
+ * between two lookups, so the analysis loops don't pay for it. */
+static bool bb_index_check(RAnalFunction *fcn, struct r_anal_bb_index_t *idx, RList *list, bool *rebuild) {
+	ut64 gen = r_anal_fcn_bb_gen (fcn);
+	int len = r_list_length (list);
+	*rebuild = false;
+	if (idx->gen == gen && idx->list == list && idx->list_len == len) {
+		if (idx->valid) {
+			return true;
+		}
+		if (idx->unowned) {
+			return false;
+		}
+	}
+	idx->valid = false;
+	idx->unowned = false;
+	if (idx->seen != gen) {
+		idx->seen = gen;
+		return false;
+	}
+	idx->list = list;
+	idx->list_len = len;
+	idx->gen = gen;
+	*rebuild = true;
+	return true;
+}
+
+static bool bb_index_push(struct r_anal_bb_index_t *idx, int *size, RAnalBlock *bb) {
+	if (idx->count >= *size) {
+		int n = R_MAX (*size * 2, 64);
+		BBIndexEntry *entries = realloc (idx->entries, n * sizeof (BBIndexEntry));
+		if (!entries) {
+			return false;
+		}
+		idx->entries = entries;
+		*size = n;
+	}
+	BBIndexEntry *e = &idx->entries[idx->count];
+	e->bb = bb;
+	e->addr = bb->addr;
+	e->pos = idx->count++;
+	return true;
+}
+
+static void bb_index_sort(struct r_anal_bb_index_t *idx) {
+	ut64 maxend = 0;
+	int i;
+	qsort (idx->entries, idx->count, sizeof (BBIndexEntry), bb_index_cmp);
+	for (i = 0; i < idx->count; i++) {
+		maxend = R_MAX (maxend, idx->entries[i].addr + idx->entries[i].bb->size);
+		idx->entries[i].maxend = maxend;
+	}
+	idx->valid = true;
+}
+
+/* Returns the sorted view of fcn->bbs, or NULL if it must be scanned linearly */
+static struct r_anal_bb_index_t *bb_index_get(RAnalFunction *fcn) {
+	struct r_anal_bb_index_t *idx = fcn->bbs_index;
+	RListIter *iter;
+	RAnalBlock *bb;
+	bool rebuild;
+	int size = 0;
+
+	if (!fcn->bbs || r_list_length (fcn->bbs) < BB_INDEX_MIN) {
+		return NULL;
+	}
+	if (!idx && !(idx = fcn->bbs_index = R_NEW0 (struct r_anal_bb_index_t))) {
+		return NULL;
+	}
+	if (!bb_index_check (fcn, idx, fcn->bbs, &rebuild)) {
+		return NULL;
+	}
+	if (rebuild) {
+		idx->count = 0;
+		r_list_foreach (fcn->bbs, iter, bb) {
+			if (bb->rb_fcn != fcn) {
+				// its moves would not bump this function's generation
+				idx->unowned = true;
+				return NULL;
+			}
+			if (!bb_index_push (idx, &size, bb)) {
+				return NULL;
+			}
+		}
+		bb_index_sort (idx);
+	}
+	return idx;
+}
+
+/* first entry starting after addr */
+static int bb_index_upper(struct r_anal_bb_index_t *idx, ut64 addr) {
+	int lo = 0, hi = idx->count;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (idx->entries[mid].addr <= addr) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
 R_API void r_anal_fcn_update_tinyrange_bbs(RAnalFunction *fcn) {
 	RAnalBlock *bb;
 	RListIter *iter;
 	r_list_sort (fcn->bbs, &cmpaddr);
+	r_anal_fcn_bb_touch (fcn);
 	r_tinyrange_fini (&fcn->bbr);
 	r_list_foreach (fcn->bbs, iter, bb) {
 		r_tinyrange_add (&fcn->bbr, bb->addr, bb->addr + bb->size);
@@ -268,7 +410,7 @@ R_API int r_anal_fcn_resize(const RAnal *anal, RAnalFunction *fcn, int newsize)
 			continue;
 		}
 		if (bb->addr + bb->size >= eof) {
-			bb->size = eof - bb->addr;
+			r_anal_bb_set_size (bb, eof - bb->addr);
 		}
 		if (bb->jump != UT64_MAX && bb->jump >= eof) {
 			bb->jump = UT64_MAX;
@@ -316,6 +458,7 @@ R_API void r_anal_fcn_free(void *_fcn) {
 	free (fcn->name);
 	free (fcn->attr);
 	r_tinyrange_fini (&fcn->bbr);
+	r_anal_bb_index_free (fcn->bbs_index);
 	r_list_free (fcn->fcn_locs);
 	if (fcn->bbs) {
 		fcn->bbs->free = (RListFree)r_anal_bb_free;
@@ -352,7 +495,7 @@ static RAnalBlock *appendBasicBlock(RAnal *anal, RAnalFunction *fcn, ut64 addr)
 	bb->jump = UT64_MAX;
 	bb->fail = UT64_MAX;
 	bb->type = 0; // TODO
-	r_anal_fcn_bbadd (fcn, bb);
+	r_anal_fcn_bbadd_in (anal, fcn, bb);
 	if (anal->cb.on_fcn_bb_new) {
 		anal->cb.on_fcn_bb_new (anal, anal->user, fcn, bb);
 	}
@@ -802,8 +945,8 @@ static int skip_hp(RAnal *anal, RAnalFunction *fcn, RAnalOp *op, RAnalBlock *bb,
 			snprintf (tmp_buf + 5, MAX_FLG_NAME_SIZE - 6, "%"PFMT64u, op->addr);
 			anal->flb.set (anal->flb.f, tmp_buf, op->addr, oplen);
 			fcn->addr += oplen;
-			bb->size -= oplen;
-			bb->addr += oplen;
+			r_anal_bb_set_size (bb, bb->size - oplen);
+			r_anal_bb_set_addr (bb, bb->addr + oplen);
 			*idx = un_idx;
 			return 1;
 		}
@@ -985,7 +1128,7 @@ repeat:
 		}
 		if (!overlapped) {
 			r_anal_bb_set_offset (bb, bb->ninstr++, addr + idx - bb->addr);
-			bb->size += oplen;
+			r_anal_bb_set_size (bb, bb->size + oplen);
 			fcn->ninstr++;
 			// FITFCNSZ(); // defer this, in case this instruction is a branch delay entry
 			// fcn->size += oplen; /// XXX. must be the sum of all the bblocks
@@ -1026,7 +1169,7 @@ repeat:
 			// But we also already counted this instruction in the
 			// size of the current basic block, so we need to fix that
 			if (delay.adjust) {
-				bb->size -= oplen;
+				r_anal_bb_set_size (bb, bb->size - oplen);
 				fcn->ninstr--;
 				VERBOSE_DELAY eprintf("Correct for branch delay @ %08"PFMT64x " bb.addr=%08"PFMT64x " corrected.bb=%d f.uncorr=%d\n",
 				addr + idx - oplen, bb->addr, bb->size, r_anal_fcn_size (fcn));
@@ -1116,7 +1259,7 @@ repeat:
 		case R_ANAL_OP_TYPE_ADD:
 			if (anal->opt.ijmp) {
 				if (((op.size + 4) <= len) && !memcmp (buf + op.size, "\x00\x00\x00\x00", 4)) {
-					bb->size -= oplen;
+					r_anal_bb_set_size (bb, bb->size - oplen);
 					op.type = R_ANAL_OP_TYPE_RET;
 					FITFCNSZ ();
 					r_anal_op_fini (&op);
@@ -1128,13 +1271,13 @@ repeat:
 			if (anal->opt.nopskip && len > 3 && !memcmp (buf, "\x00\x00\x00\x00", 4)) {
 				if ((addr + delay.un_idx - oplen) == fcn->addr) {
 					fcn->addr += oplen;
-					bb->size -= oplen;
-					bb->addr += oplen;
+					r_anal_bb_set_size (bb, bb->size - oplen);
+					r_anal_bb_set_addr (bb, bb->addr + oplen);
 					idx = delay.un_idx;
 					goto repeat;
 				} else {
 					// sa
-					bb->size -= oplen;
+					r_anal_bb_set_size (bb, bb->size - oplen);
 					op.type = R_ANAL_OP_TYPE_RET;
 				}
 			}
@@ -1146,8 +1289,8 @@ repeat:
 			if (anal->opt.nopskip && buf[0] == 0xcc) {
 				if ((addr + delay.un_idx - oplen) == fcn->addr) {
 					fcn->addr += oplen;
-					bb->size -= oplen;
-					bb->addr += oplen;
+					r_anal_bb_set_size (bb, bb->size - oplen);
+					r_anal_bb_set_addr (bb, bb->addr + oplen);
 					idx = delay.un_idx;
 					goto repeat;
 				}
@@ -1164,8 +1307,8 @@ repeat:
 					if (!fi || strncmp (fi->name, "sym.", 4)) {
 						if ((addr + delay.un_idx - oplen) == fcn->addr) {
 							fcn->addr += oplen;
-							bb->size -= oplen;
-							bb->addr += oplen;
+							r_anal_bb_set_size (bb, bb->size - oplen);
+							r_anal_bb_set_addr (bb, bb->addr + oplen);
 							idx = delay.un_idx;
 							goto repeat;
 						}
@@ -1601,6 +1744,13 @@ R_API int r_anal_fcn(RAnal *anal, RAnalFunction *fcn, ut64 addr, ut8 *buf, ut64
 	ret = fcn_recurse (anal, fcn, addr, buf, len, anal->opt.depth);
 	// update tinyrange for the function
 	r_anal_fcn_update_tinyrange_bbs (fcn);
+	{
+		RListIter *iter;
+		RAnalBlock *bb;
+		r_list_foreach (fcn->bbs, iter, bb) {
+			r_anal_bb_shrink (bb);
+		}
+	}
 
 	if (anal->opt.endsize && ret == R_ANAL_RET_END && r_anal_fcn_size (fcn)) {   // cfg analysis completed
 		RListIter *iter;
@@ -1718,6 +1868,68 @@ R_API int r_anal_fcn_del(RAnal *a, ut64 addr) {
 	return true;
 }
 
+#define BB_CONTAINER(x) container_of ((RBNode*)(x), RAnalBlock, rb)
+
+typedef bool (*BBTreeCallback)(RAnalBlock *bb, void *user);
+
+// the tree also holds the blocks of functions still being analyzed
+static bool fcn_listed(RAnal *anal, RAnalFunction *fcn) {
+	return fcn && _fcn_tree_find_addr (anal->fcn_tree, fcn->addr) == fcn;
+}
+
+/* calls cb for every block containing addr of the functions in anal->fcns */
+static bool bb_tree_foreach_in(RAnal *anal, RBNode *node, ut64 addr, BBTreeCallback cb, void *user) {
+	while (node) {
+		RAnalBlock *bb = BB_CONTAINER (node);
+		if (bb->rb_max_addr <= addr) {
+			return true;
+		}
+		if (!bb_tree_foreach_in (anal, node->child[0], addr, cb, user)) {
+			return false;
+		}
+		if (bb->addr > addr) {
+			return true;
+		}
+		if (addr < bb->addr + bb->size && fcn_listed (anal, bb->rb_fcn) && !cb (bb, user)) {
+			return false;
+		}
+		node = node->child[1];
+	}
+	return true;
+}
+
+typedef struct {
+	int type;
+	RAnalFunction *fcn;
+} FcnInCtx;
+
+// among overlapping functions the one with the lowest address wins
+static bool fcn_in_cb(RAnalBlock *bb, void *user) {
+	FcnInCtx *ctx = user;
+	RAnalFunction *fcn = bb->rb_fcn;
+	if ((!ctx->type || fcn->type & ctx->type) && (!ctx->fcn || fcn->addr < ctx->fcn->addr)) {
+		ctx->fcn = fcn;
+	}
+	return true;
+}
+
+static bool functions_in_cb(RAnalBlock *bb, void *user) {
+	RList *list = user;
+	if (!r_list_contains (list, bb->rb_fcn)) {
+		r_list_append (list, bb->rb_fcn);
+	}
+	return true;
+}
+
+/* every function having a block that contains addr */
+R_API RList *r_anal_get_functions_in(RAnal *anal, ut64 addr) {
+	RList *list = r_list_new ();
+	if (list) {
+		bb_tree_foreach_in (anal, anal->bb_tree, addr, functions_in_cb, list);
+	}
+	return list;
+}
+
 R_API RAnalFunction *r_anal_get_fcn_in(RAnal *anal, ut64 addr, int type) {
 #if 0
   // Linear scan
@@ -1742,20 +1954,19 @@ R_API RAnalFunction *r_anal_get_fcn_in(RAnal *anal, ut64 addr, int type) {
 	return ret;
 
 #else
-	// Interval tree query
+	// Block tree query
+	FcnInCtx ctx = { type, NULL };
 	RAnalFunction *fcn;
-	FcnTreeIter it;
 	if (type == R_ANAL_FCN_TYPE_ROOT) {
 		return _fcn_tree_find_addr (anal->fcn_tree, addr);
 	}
-	fcn_tree_foreach_intersect (anal->fcn_tree, it, fcn, addr, addr + 1) {
-		if (!type || (fcn && fcn->type & type)) {
-			if (r_tinyrange_in (&fcn->bbr, addr) || fcn->addr == addr) {
-				return fcn;
-			}
-		}
+	bb_tree_foreach_in (anal, anal->bb_tree, addr, fcn_in_cb, &ctx);
+	// functions without blocks yet
+	fcn = _fcn_tree_find_addr (anal->fcn_tree, addr);
+	if (fcn && (!type || fcn->type & type) && (!ctx.fcn || fcn->addr < ctx.fcn->addr)) {
+		return fcn;
 	}
-	return NULL;
+	return ctx.fcn;
 #endif
 }
 
@@ -1764,7 +1975,8 @@ R_API bool r_anal_fcn_in(RAnalFunction *fcn, ut64 addr) {
 }
 
 R_API RAnalFunction *r_anal_get_fcn_in_bounds(RAnal *anal, ut64 addr, int type) {
-	RAnalFunction *fcn, *ret = NULL;
+	FcnInCtx ctx = { type, NULL };
+	RAnalFunction *fcn;
 	RListIter *iter;
 	if (type == R_ANAL_FCN_TYPE_ROOT) {
 		r_list_foreach (anal->fcns, iter, fcn) {
@@ -1774,14 +1986,8 @@ R_API RAnalFunction *r_anal_get_fcn_in_bounds(RAnal *anal, ut64 addr, int type)
 		}
 		return NULL;
 	}
-	r_list_foreach (anal->fcns, iter, fcn) {
-		if (!type || (fcn && fcn->type & type)) {
-			if (r_anal_fcn_in (fcn, addr)) {
-				return fcn;
-			}
-		}
-	}
-	return ret;
+	bb_tree_foreach_in (anal, anal->bb_tree, addr, fcn_in_cb, &ctx);
+	return ctx.fcn;
 }
 
 R_API RAnalFunction *r_anal_fcn_find_name(RAnal *anal, const char *name) {
@@ -1816,7 +2022,7 @@ R_API int r_anal_fcn_add_bb(RAnal *anal, RAnalFunction *fcn, ut64 addr, ut64 siz
 		// eprintf ("Basic Block overlaps another one that should be shrinked\n");
 		if (bbi) {
 			/* shrink overlapped basic block */
-			bbi->size = addr - (bbi->addr);
+			r_anal_bb_set_size (bbi, addr - bbi->addr);
 			r_anal_fcn_update_tinyrange_bbs (fcn);
 		}
 	}
@@ -1846,9 +2052,9 @@ R_API int r_anal_fcn_add_bb(RAnal *anal, RAnalFunction *fcn, ut64 addr, ut64 siz
 				return false;
 			}
 		}
-		bb->addr = addr;
+		r_anal_bb_set_addr (bb, addr);
 	}
-	bb->size = size;
+	r_anal_bb_set_size (bb, size);
 	bb->jump = jump;
 	bb->fail = fail;
 	bb->type = type;
@@ -1891,12 +2097,12 @@ R_API int r_anal_fcn_split_bb(RAnal *anal, RAnalFunction *fcn, RAnalBlock *bb, u
 		    && (!anal->opt.jmpmid || !x86 || r_anal_bb_op_starts_at (bbi, addr))) {
 			int new_bbi_instr, i;
 			bb = appendBasicBlock (anal, fcn, addr);
-			bb->size = bbi->addr + bbi->size - addr;
+			r_anal_bb_set_size (bb, bbi->addr + bbi->size - addr);
 			bb->jump = bbi->jump;
 			bb->fail = bbi->fail;
 			bb->conditional = bbi->conditional;
 			FITFCNSZ ();
-			bbi->size = addr - bbi->addr;
+			r_anal_bb_set_size (bbi, addr - bbi->addr);
 			bbi->jump = addr;
 			bbi->fail = -1;
 			bbi->conditional = false;
@@ -1938,7 +2144,7 @@ R_API int r_anal_fcn_bb_overlaps(RAnalFunction *fcn, RAnalBlock *bb) {
 	RListIter *iter;
 	r_list_foreach (fcn->bbs, iter, bbi) {
 		if (bb->addr + bb->size > bbi->addr && bb->addr + bb->size <= bbi->addr + bbi->size) {
-			bb->size = bbi->addr - bb->addr;
+			r_anal_bb_set_size (bb, bbi->addr - bb->addr);
 			bb->jump = bbi->addr;
 			bb->fail = -1;
 			bb->conditional = false;
@@ -2126,8 +2332,23 @@ R_API RAnalBlock *r_anal_fcn_bbget_in(const RAnal *anal, RAnalFunction *fcn, ut6
 		return NULL;
 	}
 	const bool x86 = anal->cur->arch && !strcmp (anal->cur->arch, "x86");
+	struct r_anal_bb_index_t *idx = bb_index_get (fcn);
 	RListIter *iter;
 	RAnalBlock *bb;
+	if (idx) {
+		// walk back until no block can reach addr, keeping the list order
+		BBIndexEntry *found = NULL;
+		int i = bb_index_upper (idx, addr);
+		while (i-- > 0 && idx->entries[i].maxend > addr) {
+			bb = idx->entries[i].bb;
+			if ((!found || idx->entries[i].pos < found->pos)
+			    && addr >= bb->addr && addr < (bb->addr + bb->size)
+			    && (!anal->opt.jmpmid || !x86 || r_anal_bb_op_starts_at (bb, addr))) {
+				found = &idx->entries[i];
+			}
+		}
+		return found? found->bb: NULL;
+	}
 	r_list_foreach (fcn->bbs, iter, bb) {
 		if (addr >= bb->addr && addr < (bb->addr + bb->size)
 		    && (!anal->opt.jmpmid || !x86 || r_anal_bb_op_starts_at (bb, addr))) {
@@ -2144,8 +2365,20 @@ R_API RAnalBlock *r_anal_fcn_bbget_at(RAnalFunction *fcn, ut64 addr) {
 #if USE_SDB_CACHE
 	return sdb_ptr_get (HB, sdb_fmt (SDB_KEY_BB, fcn->addr, addr), NULL);
 #else
+	struct r_anal_bb_index_t *idx = bb_index_get (fcn);
 	RListIter *iter;
 	RAnalBlock *bb;
+	if (idx) {
+		int i = bb_index_upper (idx, addr);
+		if (i > 0 && idx->entries[i - 1].addr == addr) {
+			// the first of the blocks at addr in list order
+			while (i > 1 && idx->entries[i - 2].addr == addr) {
+				i--;
+			}
+			return idx->entries[i - 1].bb;
+		}
+		return NULL;
+	}
 	r_list_foreach (fcn->bbs, iter, bb) {
 		if (addr == bb->addr) {
 			return bb;
@@ -2156,14 +2389,26 @@ R_API RAnalBlock *r_anal_fcn_bbget_at(RAnalFunction *fcn, ut64 addr) {
 }
 
 
-R_API bool r_anal_fcn_bbadd(RAnalFunction *fcn, RAnalBlock *bb) {
+/* appends bb to fcn, and indexes it in anal->bb_tree if anal is given,
+ * or in the tree the function's blocks already live in otherwise */
+R_API bool r_anal_fcn_bbadd_in(RAnal *anal, RAnalFunction *fcn, RAnalBlock *bb) {
 #if USE_SDB_CACHE
 	return sdb_ptr_set (HB, sdb_fmt (SDB_KEY_BB, fcn->addr, bb->addr), bb, NULL);
 #endif
 	r_list_append (fcn->bbs, bb);
+	if (anal) {
+		r_anal_bb_tree_insert (&anal->bb_tree, fcn, bb);
+	} else if (fcn->bb_tree) {
+		r_anal_bb_tree_insert (fcn->bb_tree, fcn, bb);
+	}
+	r_anal_fcn_bb_touch (fcn);
 	return true;
 }
 
+R_API bool r_anal_fcn_bbadd(RAnalFunction *fcn, RAnalBlock *bb) {
+	return r_anal_fcn_bbadd_in (NULL, fcn, bb);
+}
+
 
 /* directly set the size of the function
  * if fcn is in ana RAnal's fcn_tree, the anal MUST be passed,
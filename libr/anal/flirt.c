@@ -528,14 +528,11 @@ static void print_node(const RAnal *anal, const RFlirtNode *node, int indent) {
 	}
 }
 
-static int module_match_buffer(const RAnal *anal, const RFlirtModule *module,
-                               ut8 *b, ut64 address, ut32 buf_size) {
+static bool module_check_buffer(const RFlirtModule *module, const ut8 *b, ut32 buf_size) {
 	/* Returns true if module matches b, according to the signatures infos.
 	* Return false otherwise.
 	* The buffer starts from the first byte after the pattern */
-	RFlirtFunction *flirt_func;
-	RAnalFunction *next_module_function;
-	RListIter *tail_byte_it, *flirt_func_it;
+	RListIter *tail_byte_it;
 	RFlirtTailByte *tail_byte;
 
 	if (32 + module->crc_length < buf_size &&
@@ -552,6 +549,14 @@ static int module_match_buffer(const RAnal *anal, const RFlirtModule *module,
 	}
 
 	// TODO referenced functions
+	return true;
+}
+
+static void module_apply(const RAnal *anal, const RFlirtModule *module, ut64 address) {
+	/* Names the functions of a matched module. */
+	RFlirtFunction *flirt_func;
+	RAnalFunction *next_module_function;
+	RListIter *flirt_func_it;
 
 	r_list_foreach (module->public_functions, flirt_func_it, flirt_func) {
 		// Once the first module function is found, we need to go through the module->public_functions
@@ -581,10 +586,13 @@ static int module_match_buffer(const RAnal *anal, const RFlirtModule *module,
 				RListIter *iter;
 				RListIter *iter_tmp;
 				RAnalFunction *fcn;
+				RAnalBlock *bb;
 				r_list_foreach_safe (anal->fcns, iter, iter_tmp, fcn) {
 					if (fcn->addr >= next_module_function->addr + next_module_function_size &&
 					fcn->addr < next_module_function->addr + flirt_fcn_size) {
-						r_list_join (next_module_function->bbs, fcn->bbs);
+						while ((bb = r_list_pop_head (fcn->bbs))) {
+							r_anal_fcn_bbadd_in ((RAnal *) anal, next_module_function, bb);
+						}
 						r_list_join (next_module_function->locs, fcn->locs);
 						// r_list_join (next_module_function->vars, r_anal_var_all_list (anal, fcn);
 						next_module_function->ninstr += fcn->ninstr;
@@ -612,45 +620,195 @@ static int module_match_buffer(const RAnal *anal, const RFlirtModule *module,
 			free (name);
 		}
 	}
-	return true;
 }
 
-/* Returns true if b matches the pattern in node. */
-/* Returns false otherwise. */
-static int node_pattern_match(const RFlirtNode *node, ut8 *b, int buf_size) {
+/*
+ * The parsed tree is compiled into a flat array of states before matching.
+ * The children of a state are contiguous, the fixed bytes of a pattern are
+ * a bitset (patterns are at most 64 bytes) and the children of the root are
+ * dispatched on the first byte of the function.
+ */
+typedef struct {
+	ut64 fixed; // bit i set when pattern byte i is not a variant byte
+	ut32 length;
+	ut32 pattern; // offset of the pattern in RFlirtAutomaton.bytes
+	ut32 child; // index of the first child state
+	ut32 nchild;
+	RList *modules; // borrowed from the parsed tree, set on leaves
+} RFlirtState;
+
+typedef struct {
+	RFlirtState *states;
+	ut32 nstates;
+	ut8 *bytes;
+	ut32 nbytes;
+	ut32 depth; // longest pattern from the root
+	ut32 *first[256]; // root children that can match a given first byte
+	ut32 nfirst[256];
+} RFlirtAutomaton;
+
+#define R_FLIRT_THREADS 4
+#define R_FLIRT_MIN_JOBS 64
+
+static void automaton_count(const RFlirtNode *node, ut32 depth, RFlirtAutomaton *fa) {
+	RListIter *it;
+	RFlirtNode *child;
+	fa->depth = R_MAX (fa->depth, depth);
+	r_list_foreach (node->child_list, it, child) {
+		fa->nstates++;
+		fa->nbytes += child->length;
+		automaton_count (child, depth + child->length, fa);
+	}
+}
+
+static void automaton_fill(RFlirtAutomaton *fa, const RFlirtNode *node, ut32 first, ut32 *next, ut32 *nbytes) {
+	RListIter *it;
+	RFlirtNode *child;
+	ut32 i = first;
+	r_list_foreach (node->child_list, it, child) {
+		RFlirtState *st = &fa->states[i++];
+		ut32 j;
+		st->length = child->length;
+		st->pattern = *nbytes;
+		for (j = 0; j < child->length && j < 64; j++) {
+			if (!child->variant_bool_array[j]) {
+				st->fixed |= 1ULL << j;
+			}
+		}
+		memcpy (fa->bytes + st->pattern, child->pattern_bytes, child->length);
+		*nbytes += child->length;
+		st->modules = child->module_list;
+	}
+	i = first;
+	r_list_foreach (node->child_list, it, child) {
+		RFlirtState *st = &fa->states[i++];
+		st->nchild = r_list_length (child->child_list);
+		if (st->nchild) {
+			st->child = *next;
+			*next += st->nchild;
+			automaton_fill (fa, child, st->child, next, nbytes);
+		}
+	}
+}
+
+static void automaton_free(RFlirtAutomaton *fa) {
 	int i;
-	for (i = 0; i < node->length; i++) {
-		if (!node->variant_bool_array[i]) {
-			if (i < node->length && node->pattern_bytes[i] != b[i]) {
-				return false;
+	if (!fa) {
+		return;
+	}
+	for (i = 0; i < 256; i++) {
+		free (fa->first[i]);
+	}
+	free (fa->states);
+	free (fa->bytes);
+	free (fa);
+}
+
+static RFlirtAutomaton *automaton_new(const RFlirtNode *root) {
+	ut32 i, next, nbytes = 0, nroot = r_list_length (root->child_list);
+	int c;
+	RFlirtAutomaton *fa = R_NEW0 (RFlirtAutomaton);
+	if (!fa) {
+		return NULL;
+	}
+	automaton_count (root, 0, fa);
+	fa->states = R_NEWS0 (RFlirtState, fa->nstates + 1);
+	fa->bytes = malloc (fa->nbytes + 1);
+	if (!fa->states || !fa->bytes) {
+		automaton_free (fa);
+		return NULL;
+	}
+	next = nroot;
+	automaton_fill (fa, root, 0, &next, &nbytes);
+	for (c = 0; c < 256; c++) {
+		fa->first[c] = R_NEWS (ut32, nroot + 1);
+		if (!fa->first[c]) {
+			automaton_free (fa);
+			return NULL;
+		}
+		for (i = 0; i < nroot; i++) {
+			const RFlirtState *st = &fa->states[i];
+			if (!st->length || !(st->fixed & 1) || fa->bytes[st->pattern] == c) {
+				fa->first[c][fa->nfirst[c]++] = i;
 			}
 		}
 	}
+	return fa;
+}
+
+static bool state_pattern_match(const RFlirtAutomaton *fa, const RFlirtState *st, const ut8 *b) {
+	const ut8 *p = fa->bytes + st->pattern;
+	ut64 fixed = st->fixed;
+	ut32 i;
+	for (i = 0; fixed; i++, fixed >>= 1) {
+		if ((fixed & 1) && p[i] != b[i]) {
+			return false;
+		}
+	}
 	return true;
 }
 
-static int node_match_buffer(const RAnal *anal, const RFlirtNode *node, ut8 *b, ut64 address, ut32 buf_size, ut32 buf_idx) {
-	RListIter *node_child_it, *module_it;
-	RFlirtNode *child;
+static const RFlirtModule *state_match(const RFlirtAutomaton *fa, ut32 idx, const ut8 *b, ut32 avail, ut32 buf_size, ut32 buf_idx) {
+	const RFlirtState *st = &fa->states[idx];
+	RListIter *it;
 	RFlirtModule *module;
+	ut32 i;
 
-	if (node_pattern_match (node, b + buf_idx, buf_size - buf_idx)) {
-		if (node->child_list) {
-			r_list_foreach (node->child_list, node_child_it, child) {
-				if (node_match_buffer (anal, child, b, address, buf_size, buf_idx + node->length)) {
-					return true;
-				}
+	if (buf_idx + st->length > avail || !state_pattern_match (fa, st, b + buf_idx)) {
+		return NULL;
+	}
+	if (st->nchild) {
+		for (i = 0; i < st->nchild; i++) {
+			const RFlirtModule *m = state_match (fa, st->child + i, b, avail, buf_size, buf_idx + st->length);
+			if (m) {
+				return m;
 			}
-		} else if (node->module_list) {
-			r_list_foreach (node->module_list, module_it, module) {
-				if (module_match_buffer (anal, module, b, address, buf_size)) {
-					return true;
-				}
+		}
+	} else if (st->modules) {
+		r_list_foreach (st->modules, it, module) {
+			if (module_check_buffer (module, b, buf_size)) {
+				return module;
 			}
 		}
 	}
+	return NULL;
+}
 
-	return false;
+typedef struct {
+	ut64 addr;
+	ut32 size; // function size
+	ut32 avail; // bytes read, at least the longest pattern
+	ut8 *buf;
+	const RFlirtModule *module; // first matching module
+} RFlirtJob;
+
+typedef struct {
+	const RFlirtAutomaton *fa;
+	RFlirtJob *jobs;
+	int njobs;
+	int start;
+	int step;
+} RFlirtWorker;
+
+static void match_jobs(const RFlirtAutomaton *fa, RFlirtJob *jobs, int njobs, int start, int step) {
+	int i;
+	ut32 j;
+	for (i = start; i < njobs; i += step) {
+		RFlirtJob *job = &jobs[i];
+		if (!job->avail) {
+			continue;
+		}
+		ut8 c = job->buf[0];
+		for (j = 0; j < fa->nfirst[c] && !job->module; j++) {
+			job->module = state_match (fa, fa->first[c][j], job->buf, job->avail, job->size, 0);
+		}
+	}
+}
+
+static RThreadFunctionRet match_thread(RThread *th) {
+	RFlirtWorker *w = th->user;
+	match_jobs (w->fa, w->jobs, w->njobs, w->start, w->step);
+	return R_TH_STOP;
 }
 
 static int node_match_functions(const RAnal *anal, const RFlirtNode *root_node) {
@@ -658,40 +816,82 @@ static int node_match_functions(const RAnal *anal, const RFlirtNode *root_node)
 	* and the analyzed functions in anal
 	* Returns false on error. */
 
-	RListIter *it_func, *node_child_it;
-	ut8 *func_buf = NULL;
+	RListIter *it_func;
 	RAnalFunction *func;
-	RFlirtNode *child;
-	int ret = true;
+	RFlirtAutomaton *fa = NULL;
+	RFlirtJob *jobs = NULL;
+	ut8 *bytes = NULL;
+	ut64 total = 0;
+	int i, njobs = 0, ret = true;
 
 	if (r_list_length (anal->fcns) == 0) {
 		anal->cb_printf ("There is no analyzed functions. Have you run 'aa'?\n");
 		return true;
 	}
-
-	anal->flb.set_fs (anal->flb.f, "flirt");
+	if (!(fa = automaton_new (root_node))) {
+		return false;
+	}
+	if (!(jobs = R_NEWS0 (RFlirtJob, r_list_length (anal->fcns)))) {
+		ret = false;
+		goto exit;
+	}
 	r_list_foreach (anal->fcns, it_func, func) {
 		if (func->type != R_ANAL_FCN_TYPE_FCN && func->type != R_ANAL_FCN_TYPE_LOC) { // scan only for unknown functions
 			continue;
 		}
-
-		int func_size = r_anal_fcn_size (func);
-		func_buf = malloc (func_size);
-		if (!anal->iob.read_at (anal->iob.io, func->addr, func_buf, func_size)) {
+		RFlirtJob *job = &jobs[njobs++];
+		job->addr = func->addr;
+		job->size = r_anal_fcn_size (func);
+		job->avail = R_MAX (job->size, fa->depth);
+		total += job->avail;
+	}
+	// the io is not thread safe, so read all the functions up front
+	if (!(bytes = malloc (total + 1))) {
+		ret = false;
+		goto exit;
+	}
+	for (i = 0, total = 0; i < njobs; i++) {
+		RFlirtJob *job = &jobs[i];
+		job->buf = bytes + total;
+		if (!anal->iob.read_at (anal->iob.io, job->addr, job->buf, job->avail)) {
 			eprintf ("Couldn't read function\n");
 			ret = false;
 			goto exit;
 		}
-		r_list_foreach (root_node->child_list, node_child_it, child) {
-			if (node_match_buffer (anal, child, func_buf, func->addr, func_size, 0)) {
-				break;
+		total += job->avail;
+	}
+
+	if (njobs < R_FLIRT_MIN_JOBS) {
+		match_jobs (fa, jobs, njobs, 0, 1);
+	} else {
+		RFlirtWorker workers[R_FLIRT_THREADS];
+		RThread *th[R_FLIRT_THREADS];
+		for (i = 0; i < R_FLIRT_THREADS; i++) {
+			workers[i] = (RFlirtWorker){ fa, jobs, njobs, i, R_FLIRT_THREADS };
+			th[i] = r_th_new (match_thread, &workers[i], 0);
+		}
+		for (i = 0; i < R_FLIRT_THREADS; i++) {
+			if (th[i]) {
+				r_th_wait (th[i]);
+				r_th_free (th[i]);
+			} else {
+				match_jobs (fa, jobs, njobs, i, R_FLIRT_THREADS);
 			}
 		}
-		R_FREE (func_buf);
+	}
+
+	// apply in function order, a match may merge or delete later functions
+	anal->flb.set_fs (anal->flb.f, "flirt");
+	for (i = 0; i < njobs; i++) {
+		if (jobs[i].module && r_anal_get_fcn_at ((RAnal *) anal, jobs[i].addr, 0)) {
+			module_apply (anal, jobs[i].module, jobs[i].addr);
+		}
 	}
 
 exit:
-	free (func_buf);
+	free (bytes);
+	free (jobs);
+	automaton_free (fa);
 	return ret;
 }
 
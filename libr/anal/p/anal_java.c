@@ -590,6 +590,15 @@ static int functionCmp(const void *a, const void *b) {
 	return strcmp (fa->name, fb->name);
 }
 
+// the blocks are built by the anal_ex state, which has no RAnal to index them
+static void java_index_bbs(RAnal *anal, RAnalFunction *fcn) {
+	RListIter *iter;
+	RAnalBlock *bb;
+	r_list_foreach (fcn->bbs, iter, bb) {
+		r_anal_bb_tree_insert (&anal->bb_tree, fcn, bb);
+	}
+}
+
 static int java_analyze_fns_from_buffer( RAnal *anal, ut64 start, ut64 end, int reftype, int depth) {
 	int result = R_ANAL_RET_ERROR;
 	ut64 addr = start;
@@ -628,6 +637,7 @@ static int java_analyze_fns_from_buffer( RAnal *anal, ut64 start, ut64 end, int
 			break;
 		}
 		//r_listrange_add (anal->fcnstore, fcn);
+		java_index_bbs (anal, fcn);
 		r_anal_fcn_tree_insert (&anal->fcn_tree, fcn);
 		r_list_append (anal->fcns, fcn);
 		offset += r_anal_fcn_size (fcn);
@@ -680,6 +690,7 @@ static int java_analyze_fns( RAnal *anal, ut64 start, ut64 end, int reftype, int
 				}
 				//r_listrange_add (anal->fcnstore, fcn);
 				r_anal_fcn_update_tinyrange_bbs (fcn);
+				java_index_bbs (anal, fcn);
 				r_anal_fcn_tree_insert (&anal->fcn_tree, fcn);
 				r_list_append (anal->fcns, fcn);
 			}
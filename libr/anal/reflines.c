@@ -4,37 +4,58 @@
 #include <r_util.h>
 #include <r_cons.h>
 
-#define mid_down_refline(a, r) ((r)->from > (r)->to && (a) < (r)->from && (a) > (r)->to)
-#define mid_up_refline(a, r) ((r)->from < (r)->to && (a) > (r)->from && (a) < (r)->to)
-#define mid_refline(a, r) (mid_down_refline (a, r) || mid_up_refline (a, r))
-#define in_refline(a, r) (mid_refline (a, r) || (a) == (r)->from || (a) == (r)->to)
-
 typedef struct refline_end {
 	int val;
 	bool is_from;
+	int seq;
 	RAnalRefline *r;
 } ReflineEnd;
 
-static int cmp_asc(const struct refline_end *a, const struct refline_end *b) {
-	return a->val > b->val;
+/* r_anal_reflines_str is called with increasing addresses, so the reflines
+ * are visited once in order of their lowest address and only the ones
+ * crossing the current address are kept around */
+typedef struct {
+	RAnalRefline *r;
+	ut64 lo, hi;
+	int ord; // position in anal->reflines
+} ReflineSpan;
+
+struct r_anal_refline_sweep_t {
+	RList *reflines; // the list the spans were taken from
+	ReflineSpan *spans; // sorted by lo
+	int count, next;
+	RList *live; // <ReflineSpan> crossing the last address, in drawing order
+	ut64 at;
+	char *line; // scratch for the line being drawn
+	int len, size;
+};
+
+/* ends are sorted by address, the ones at the same address in the reverse
+ * order they were found */
+static int cmp_asc(const void *a, const void *b) {
+	const ReflineEnd *ea = a, *eb = b;
+	if (ea->val != eb->val) {
+		return ea->val < eb->val? -1: 1;
+	}
+	return eb->seq - ea->seq;
 }
-static int cmp_by_ref_lvl(const RAnalRefline *a, const RAnalRefline *b) {
-	return a->level < b->level;
+static int cmp_span_lo(const void *a, const void *b) {
+	const ReflineSpan *sa = a, *sb = b;
+	if (sa->lo != sb->lo) {
+		return sa->lo < sb->lo? -1: 1;
+	}
+	return sa->ord - sb->ord;
 }
 
-static ReflineEnd *refline_end_new(ut64 val, bool is_from, RAnalRefline *ref) {
-	ReflineEnd *re = R_NEW0 (struct refline_end);
-	if (!re) {
-		return NULL;
+/* outer levels first, the last found first among the same level */
+static int cmp_span_lvl(const ReflineSpan *a, const ReflineSpan *b) {
+	if (a->r->level != b->r->level) {
+		return a->r->level < b->r->level;
 	}
-	re->val = val;
-	re->is_from = is_from;
-	re->r = ref;
-	return re;
+	return a->ord < b->ord;
 }
 
-static bool add_refline(RList *list, RList *sten, ut64 addr, ut64 to, int *idx) {
-	ReflineEnd *re1, *re2;
+static bool add_refline(RList *list, ut64 addr, ut64 to, int *idx) {
 	RAnalRefline *item = R_NEW0 (RAnalRefline);
 	if (!item) {
 		return false;
@@ -46,28 +67,123 @@ static bool add_refline(RList *list, RList *sten, ut64 addr, ut64 to, int *idx)
 	item->direction = (to > addr)? 1: -1;
 	*idx += 1;
 	r_list_append (list, item);
+	return true;
+}
 
-	re1 = refline_end_new (item->from, true, item);
-	if (!re1) {
-		free (item);
-		return false;
+R_API void r_anal_reflines_sweep_free(struct r_anal_refline_sweep_t *sw) {
+	if (sw) {
+		free (sw->spans);
+		r_list_free (sw->live);
+		free (sw->line);
+		free (sw);
 	}
-	r_list_add_sorted (sten, re1, (RListComparator)cmp_asc);
+}
 
-	re2 = refline_end_new (item->to, false, item);
-	if (!re2) {
-		free (re1);
-		free (item);
-		return false;
+static void reflines_sweep_reset(RAnal *anal) {
+	r_anal_reflines_sweep_free (anal->reflines_sweep);
+	anal->reflines_sweep = NULL;
+}
+
+static struct r_anal_refline_sweep_t *reflines_sweep_new(RList *reflines) {
+	struct r_anal_refline_sweep_t *sw = R_NEW0 (struct r_anal_refline_sweep_t);
+	RAnalRefline *ref;
+	RListIter *iter;
+
+	if (!sw) {
+		return NULL;
 	}
-	r_list_add_sorted (sten, re2, (RListComparator)cmp_asc);
-	return true;
+	sw->spans = R_NEWS (ReflineSpan, R_MAX (r_list_length (reflines), 1));
+	sw->live = r_list_new ();
+	if (!sw->spans || !sw->live) {
+		r_anal_reflines_sweep_free (sw);
+		return NULL;
+	}
+	r_list_foreach (reflines, iter, ref) {
+		ReflineSpan *s = &sw->spans[sw->count];
+		s->r = ref;
+		s->lo = R_MIN (ref->from, ref->to);
+		s->hi = R_MAX (ref->from, ref->to);
+		s->ord = sw->count++;
+	}
+	qsort (sw->spans, sw->count, sizeof (ReflineSpan), cmp_span_lo);
+	sw->reflines = reflines;
+	return sw;
+}
+
+/* the reflines crossing addr, in the order they are drawn */
+static RList *reflines_at(RAnal *anal, ut64 addr) {
+	struct r_anal_refline_sweep_t *sw = anal->reflines_sweep;
+	RListIter *iter, *iter2;
+	ReflineSpan *s;
+
+	if (sw && (sw->reflines != anal->reflines || addr < sw->at)) {
+		reflines_sweep_reset (anal);
+		sw = NULL;
+	}
+	if (!sw) {
+		sw = anal->reflines_sweep = reflines_sweep_new (anal->reflines);
+		if (!sw) {
+			return NULL;
+		}
+	}
+	r_list_foreach_safe (sw->live, iter, iter2, s) {
+		if (s->hi < addr) {
+			r_list_delete (sw->live, iter);
+		}
+	}
+	for (; sw->next < sw->count && sw->spans[sw->next].lo <= addr; sw->next++) {
+		s = &sw->spans[sw->next];
+		if (s->hi >= addr) {
+			r_list_add_sorted (sw->live, s, (RListComparator)cmp_span_lvl);
+		}
+	}
+	sw->at = addr;
+	return sw->live;
 }
 
 R_API void r_anal_reflines_free (RAnalRefline *rl) {
 	free (rl);
 }
 
+/* instructions closer than this to the end of the buffer may be truncated */
+#define REFLINE_OP_MAXSZ 32
+
+typedef struct {
+	int size;
+	int type;
+	ut64 jump;
+} ReflineOp;
+
+/* decode the instruction at addr, or take its flow from anal->reflines_ops
+ * when a previous call already did on an overlapping window. Switch ops
+ * keep their cases in the op, so they are always decoded again */
+static int refline_op(RAnal *anal, RAnalOp *op, ut64 addr, const ut8 *ptr, int len, bool memo) {
+	ReflineOp *ro = NULL;
+	char key[32];
+	int sz;
+
+	if (memo) {
+		snprintf (key, sizeof (key), "%"PFMT64x, addr);
+		ro = ht_find (anal->reflines_ops, key, NULL);
+		if (ro) {
+			op->type = ro->type;
+			op->jump = ro->jump;
+			return ro->size;
+		}
+	}
+	sz = r_anal_op (anal, op, addr, ptr, len, R_ANAL_OP_MASK_BASIC);
+	if (memo && len >= REFLINE_OP_MAXSZ && op->type != R_ANAL_OP_TYPE_SWITCH) {
+		ro = R_NEW0 (ReflineOp);
+		if (ro) {
+			ro->size = sz;
+			ro->type = op->type;
+			ro->jump = op->jump;
+			ht_update (anal->reflines_ops, key, ro);
+		}
+	}
+	return sz;
+}
+
 /* returns a list of RAnalRefline for the code present in the buffer buf, of
  * length len. A RAnalRefline exists from address A to address B if a jmp,
  * conditional jmp or call instruction exists at address A and it targets
@@ -77,14 +193,15 @@ R_API void r_anal_reflines_free (RAnalRefline *rl) {
  * linesout - true if you want to display lines that go outside of the scope [addr;addr+len)
  * linescall - true if you want to display call lines */
 R_API RList *r_anal_reflines_get(RAnal *anal, ut64 addr, const ut8 *buf, ut64 len, int nlines, int linesout, int linescall) {
-	RList *list, *sten;
+	RList *list;
 	RListIter *iter;
+	RAnalRefline *ref;
 	RAnalOp op;
-	struct refline_end *el;
+	ReflineEnd *ends, *el;
 	const ut8 *ptr = buf;
 	const ut8 *end = buf + len;
 	ut8 *free_levels;
-	int res, sz = 0, count = 0;
+	int i, nends = 0, sz = 0, count = 0;
 	ut64 opc = addr;
 
 	memset (&op, 0, sizeof (op));
@@ -103,10 +220,6 @@ R_API RList *r_anal_reflines_get(RAnal *anal, ut64 addr, const ut8 *buf, ut64 le
 	if (!list) {
 		return NULL;
 	}
-	sten = r_list_newf ((RListFree)free);
-	if (!sten) {
-		goto list_err;
-	}
 	r_cons_break_push (NULL, NULL);
 	/* analyze code block */
 	while (ptr < end && !r_cons_is_breaked ()) {
@@ -132,7 +245,8 @@ R_API RList *r_anal_reflines_get(RAnal *anal, ut64 addr, const ut8 *buf, ut64 le
 		addr += sz;
 		// This can segfault if opcode length and buffer check fails
 		r_anal_op_fini (&op);
-		sz = r_anal_op (anal, &op, addr, ptr, (int)(end - ptr), R_ANAL_OP_MASK_BASIC);
+		sz = refline_op (anal, &op, addr, ptr, (int)(end - ptr),
+			anal->reflines_ops && addr == opc + (ptr - buf));
 		if (sz <= 0) {
 			sz = 1;
 			goto __next;
@@ -149,9 +263,9 @@ R_API RList *r_anal_reflines_get(RAnal *anal, ut64 addr, const ut8 *buf, ut64 le
 			if ((!linesout && (op.jump > opc + len || op.jump < opc)) || !op.jump) {
 				break;
 			}
-			if (!(res = add_refline (list, sten, addr, op.jump, &count))) {
+			if (!add_refline (list, addr, op.jump, &count)) {
 				r_anal_op_fini (&op);
-				goto sten_err;
+				goto list_err;
 			}
 			break;
 		case R_ANAL_OP_TYPE_SWITCH:
@@ -167,9 +281,9 @@ R_API RList *r_anal_reflines_get(RAnal *anal, ut64 addr, const ut8 *buf, ut64 le
 				if (!linesout && (op.jump > opc + len || op.jump < opc)) {
 					continue;
 				}
-				if (!(res = add_refline (list, sten, op.switch_op->addr, caseop->jump, &count))) {
+				if (!add_refline (list, op.switch_op->addr, caseop->jump, &count)) {
 					r_anal_op_fini (&op);
-					goto sten_err;
+					goto list_err;
 				}
 			}
 			break;
@@ -181,13 +295,24 @@ R_API RList *r_anal_reflines_get(RAnal *anal, ut64 addr, const ut8 *buf, ut64 le
 	r_anal_op_fini (&op);
 	r_cons_break_pop ();
 
+	ends = R_NEWS (ReflineEnd, r_list_length (list) * 2 + 1);
 	free_levels = R_NEWS0 (ut8, r_list_length (list) + 1);
-	if (!free_levels) {
-		goto sten_err;
+	if (!ends || !free_levels) {
+		free (ends);
+		free (free_levels);
+		goto list_err;
 	}
+	r_list_foreach (list, iter, ref) {
+		ends[nends] = (ReflineEnd){ .val = ref->from, .is_from = true, .seq = nends, .r = ref };
+		nends++;
+		ends[nends] = (ReflineEnd){ .val = ref->to, .is_from = false, .seq = nends, .r = ref };
+		nends++;
+	}
+	qsort (ends, nends, sizeof (ReflineEnd), cmp_asc);
 	int min = 0;
 
-	r_list_foreach (sten, iter, el) {
+	for (i = 0; i < nends; i++) {
+		el = &ends[i];
 		if ((el->is_from && el->r->level == -1) || (!el->is_from && el->r->level == -1)) {
 			el->r->level = min + 1;
 			free_levels[min] = 1;
@@ -204,24 +329,12 @@ R_API RList *r_anal_reflines_get(RAnal *anal, ut64 addr, const ut8 *buf, ut64 le
 			}
 		}
 	}
-
-	/* XXX: the algorithm can be improved. We can calculate the set of
-	 * reflines used in each interval of addresses and store them.
-	 * Considering r_anal_reflines_str is always called with increasing
-	 * addresses, we can just traverse linearly the list of intervals to
-	 * know which reflines need to be drawn for each address. In this way,
-	 * we don't need to traverse again and again the reflines for each call
-	 * to r_anal_reflines_str, but we can reuse the data already
-	 * calculated. Those data will be quickly available because the
-	 * intervals will be sorted and the addresses to consider are always
-	 * increasing. */
 	free (free_levels);
-	r_list_free (sten);
+	free (ends);
+	reflines_sweep_reset (anal);
 	return list;
 
-sten_err:
 list_err:
-	r_list_free (sten);
 	r_list_free (list);
 	return NULL;
 }
@@ -237,6 +350,7 @@ R_API RList* r_anal_reflines_fcn_get(RAnal *anal, RAnalFunction *fcn, int nlines
 	if (!list) {
 		return NULL;
 	}
+	reflines_sweep_reset (anal);
 
 	/* analyze code block */
 	r_list_foreach (fcn->bbs, bb_iter, bb) {
@@ -347,43 +461,63 @@ static const char* get_corner_char(RAnalRefline *ref, ut64 addr, int is_middle)
 	return "";
 }
 
-static void add_spaces(RBuffer *b, int level, int pos, int wide) {
+/* appends n times ch, or overwrites the line from pos on without growing it.
+ * runs are capped at 1023 chars, as r_str_pad does */
+static bool line_fill(struct r_anal_refline_sweep_t *sw, int pos, char ch, int n) {
+	n = R_MIN (n, 1023);
+	if (n < 1) {
+		return true;
+	}
+	if (pos != -1) {
+		if (pos >= 0 && pos < sw->len) {
+			memset (sw->line + pos, ch, R_MIN (n, sw->len - pos));
+		}
+		return true;
+	}
+	if (sw->len + n >= sw->size) {
+		int size = R_MAX (sw->size * 2, sw->len + n + 64);
+		char *line = realloc (sw->line, size);
+		if (!line) {
+			return false;
+		}
+		sw->line = line;
+		sw->size = size;
+	}
+	memset (sw->line + sw->len, ch, n);
+	sw->len += n;
+	return true;
+}
+
+static void add_spaces(struct r_anal_refline_sweep_t *sw, int level, int pos, int wide) {
 	if (pos != -1) {
 		if (wide) {
 			pos *= 2;
 			level *= 2;
 		}
 		if (pos > level + 1) {
-			const char *pd = r_str_pad (' ', pos - level - 1);
-			r_buf_append_string (b, pd);
+			line_fill (sw, -1, ' ', pos - level - 1);
 		}
 	}
 }
 
-static void fill_level(RBuffer *b, int pos, char ch, RAnalRefline *r, int wide) {
-	const char *pd;
+static void fill_level(struct r_anal_refline_sweep_t *sw, int pos, char ch, RAnalRefline *r, int wide) {
 	int sz = r->level;
 	if (wide) {
 		sz *= 2;
 	}
-	pd = r_str_pad (ch, sz - 1);
-	if (pos == -1) {
-		r_buf_append_string (b, pd);
-	} else {
-		r_buf_write_at (b, pos, (ut8 *)pd, strlen (pd));
-	}
+	line_fill (sw, pos, ch, sz - 1);
 }
 
 // TODO: move into another file
-// TODO: this is TOO SLOW. do not iterate over all reflines or gtfo
 R_API char* r_anal_reflines_str(void *_core, ut64 addr, int opts) {
 	RCore *core = _core;
 	RCons *c = core->cons;
 	RAnal *anal = core->anal;
-	RBuffer *b;
+	struct r_anal_refline_sweep_t *sw;
 	RListIter *iter;
 	RAnalRefline *ref;
-	int l;
+	ReflineSpan *span;
+	int l, from = 0, pfx = 0;
 	int dir = 0, wide = opts & R_ANAL_REFLINE_TYPE_WIDE;
 	int pos = -1, max_level = -1;
 	int middle = opts & R_ANAL_REFLINE_TYPE_MIDDLE;
@@ -393,27 +527,18 @@ R_API char* r_anal_reflines_str(void *_core, ut64 addr, int opts) {
 		return NULL;
 	}
 
-	RList *lvls = r_list_new ();
+	RList *lvls = reflines_at (anal, addr);
 	if (!lvls) {
 		return NULL;
 	}
-	r_list_foreach (anal->reflines, iter, ref) {
+	sw = anal->reflines_sweep;
+	sw->len = 0;
+	line_fill (sw, -1, ' ', 1);
+	r_list_foreach (lvls, iter, span) {
 		if (core->cons && core->cons->context->breaked) {
-			r_list_free (lvls);
-			return NULL;
-		}
-		if (in_refline (addr, ref)) {
-			r_list_add_sorted (lvls, (void *)ref, (RListComparator)cmp_by_ref_lvl);
-		}
-	}
-	b = r_buf_new ();
-	r_buf_append_string (b, " ");
-	r_list_foreach (lvls, iter, ref) {
-		if (core->cons && core->cons->context->breaked) {
-			r_list_free (lvls);
-			r_buf_free (b);
 			return NULL;
 		}
+		ref = span->r;
 		if (ref->from == addr || ref->to == addr) {
 			const char *corner = get_corner_char (ref, addr, middle);
 			const char ch = ref->from == addr ? '=' : '-';
@@ -423,13 +548,13 @@ R_API char* r_anal_reflines_str(void *_core, ut64 addr, int opts) {
 				if (wide) {
 					ch_pos = ch_pos * 2 - 1;
 				}
-				r_buf_write_at (b, ch_pos, (ut8 *)corner, 1);
-				fill_level (b, ch_pos + 1, ch, ref, wide);
+				line_fill (sw, ch_pos, *corner, 1);
+				fill_level (sw, ch_pos + 1, ch, ref, wide);
 			} else {
-				add_spaces (b, ref->level, pos, wide);
-				r_buf_append_string (b, corner);
+				add_spaces (sw, ref->level, pos, wide);
+				line_fill (sw, -1, *corner, 1);
 				if (!middle) {
-					fill_level (b, -1, ch, ref, wide);
+					fill_level (sw, -1, ch, ref, wide);
 				}
 			}
 			if (!middle) {
@@ -440,48 +565,32 @@ R_API char* r_anal_reflines_str(void *_core, ut64 addr, int opts) {
 			if (!pos) {
 				continue;
 			}
-			add_spaces (b, ref->level, pos, wide);
-			if (ref->direction < 0) {
-				r_buf_append_string (b, ":");
-			} else {
-				r_buf_append_string (b, "|");
-			}
+			add_spaces (sw, ref->level, pos, wide);
+			line_fill (sw, -1, (ref->direction < 0)? ':': '|', 1);
 			pos = ref->level;
 		}
 		if (max_level == -1) {
 			max_level = ref->level;
 		}
 	}
-	add_spaces (b, 0, pos, wide);
-	str = r_buf_free_to_string (b);
-	b = NULL;
-	if (!str) {
-		r_list_free (lvls);
-		//r_buf_free_to_string already free b and if that is the case
-		//b will be NULL and r_buf_free will return but if there was
-		//an error we free b here so in other words is safe
-		r_buf_free (b);
-		return NULL;
-	}
+	add_spaces (sw, 0, pos, wide);
+	l = sw->len;
 	if (core->anal->lineswidth > 0) {
 		int lw = core->anal->lineswidth;
-		l = strlen (str);
 		if (l > lw) {
-			r_str_cpy (str, str + l - lw);
+			from = l - lw;
+			l = lw;
 		} else {
-			char pfx[128];
-			lw -= l;
-			memset (pfx, ' ', sizeof (pfx));
-			if (lw >= sizeof (pfx)) {
-				lw = sizeof (pfx)-1;
-			}
-			if (lw > 0) {
-				pfx[lw] = 0;
-				str = r_str_prefix (str, pfx);
-			}
+			pfx = R_MIN (lw - l, 127);
 		}
 	}
-	str = r_str_append (str, (dir == 1) ? "-> "
+	str = malloc (pfx + l + 4);
+	if (!str) {
+		return NULL;
+	}
+	memset (str, ' ', pfx);
+	memcpy (str + pfx, sw->line + from, l);
+	strcpy (str + pfx + l, (dir == 1) ? "-> "
 		: (dir == 2) ? "=< " : "   ");
 
 	if (core->cons->use_utf8 || opts & R_ANAL_REFLINE_TYPE_UTF8) {
@@ -495,6 +604,5 @@ R_API char* r_anal_reflines_str(void *_core, ut64 addr, int opts) {
 		str = r_str_replace (str, ".", c->vline[CORNER_TR], 1);
 		str = r_str_replace (str, "`", c->vline[CORNER_BL], 1);
 	}
-	r_list_free (lvls);
 	return str;
 }
@@ -561,6 +561,11 @@ static int deleteBySpaceCB(void *user, const char *k, const char *v) {
 	return 1;
 }
 
+// mapped zignature databases, see r_sign_db_open
+static bool dbForeach(RAnal *a, RSignForeachCallback cb, void *user);
+static int dbCount(RAnal *a, int idx);
+static bool dbDelete(RAnal *a, const char *name);
+
 R_API bool r_sign_delete(RAnal *a, const char *name) {
 	struct ctxDeleteCB ctx = {0};
 	char k[R_SIGN_KEY_MAXSZ];
@@ -572,16 +577,21 @@ R_API bool r_sign_delete(RAnal *a, const char *name) {
 	if (*name == '*') {
 		if (a->zign_spaces.space_idx == -1) {
 			sdb_reset (a->sdb_zigns);
+			if (a->zign_dbs) {
+				r_list_purge (a->zign_dbs);
+			}
 			return true;
 		}
 		ctx.anal = a;
 		serializeKey (a, a->zign_spaces.space_idx, "", ctx.buf);
 		sdb_foreach (a->sdb_zigns, deleteBySpaceCB, &ctx);
+		dbDelete (a, name);
 		return true;
 	}
 	// Remove specific zign
 	serializeKey (a, a->zign_spaces.space_idx, name, k);
-	return sdb_remove (a->sdb_zigns, k, 0);
+	bool ret = sdb_remove (a->sdb_zigns, k, 0);
+	return dbDelete (a, name) || ret;
 }
 
 struct ctxListCB {
@@ -703,20 +713,10 @@ static void listHash(RAnal *a, RSignItem *it, int format) {
 	}
 }
 
-static int listCB(void *user, const char *k, const char *v) {
+static int listCB(RSignItem *it, void *user) {
 	struct ctxListCB *ctx = (struct ctxListCB *) user;
-	RSignItem *it = r_sign_item_new ();
 	RAnal *a = ctx->anal;
 
-	if (!deserialize (a, it, k, v)) {
-		eprintf ("error: cannot deserialize zign\n");
-		goto out;
-	}
-
-	if (a->zign_spaces.space_idx != it->space && a->zign_spaces.space_idx != -1) {
-		goto out;
-	}
-
 	// Start item
 	if (ctx->format == 'j') {
 		if (ctx->idx > 0) {
@@ -786,9 +786,6 @@ static int listCB(void *user, const char *k, const char *v) {
 
 	ctx->idx++;
 
-out:
-	r_sign_item_free (it);
-
 	return 1;
 }
 
@@ -803,7 +800,7 @@ R_API void r_sign_list(RAnal *a, int format) {
 		a->cb_printf ("[");
 	}
 
-	sdb_foreach (a->sdb_zigns, listCB, &ctx);
+	r_sign_foreach (a, listCB, &ctx);
 
 	if (format == 'j') {
 		a->cb_printf ("]\n");
@@ -881,7 +878,7 @@ R_API int r_sign_space_count_for(RAnal *a, int idx) {
 
 	sdb_foreach (a->sdb_zigns, countForCB, &ctx);
 
-	return ctx.count;
+	return ctx.count + dbCount (a, idx);
 }
 
 struct ctxUnsetForCB {
@@ -996,14 +993,375 @@ out:
 	return retval;
 }
 
-R_API bool r_sign_foreach(RAnal *a, RSignForeachCallback cb, void *user) {
+static bool foreachSdb(RAnal *a, RSignForeachCallback cb, void *user) {
 	struct ctxForeachCB ctx = { a, cb, user };
 
+	return sdb_foreach (a->sdb_zigns, foreachCB, &ctx);
+}
+
+R_API bool r_sign_foreach(RAnal *a, RSignForeachCallback cb, void *user) {
 	if (!a || !cb) {
 		return false;
 	}
 
-	return sdb_foreach (a->sdb_zigns, foreachCB, &ctx);
+	return foreachSdb (a, cb, user) && dbForeach (a, cb, user);
+}
+
+/*
+ * Bytes zignatures are matched all at once: each pattern is anchored on
+ * its most selective run of fully defined bytes (4, 2 or 1 long), the
+ * buffer is scanned once looking up the anchors and only the candidates
+ * are compared against the whole masked pattern. Big buffers are split
+ * between threads and the hits reported in address order.
+ */
+#define MATCH_THREADS 4
+#define MATCH_MIN_SLICE (256 * 1024)
+#define MATCH_TABLES 3
+
+/* data of the bytes keywords, database items are read when first hit */
+typedef struct {
+	RSignItem *it;
+	RAnal *anal;
+	RSignDb *db;
+	ut32 idx;
+	int anchor;
+	int k; // anchor length, -1 until it is picked
+} SignKw;
+
+typedef struct {
+	RSearchKeyword *kw;
+	const ut8 *bytes;
+	const ut8 *mask;
+	int size;
+	int anchor; // offset of the anchor in the pattern
+	int k; // anchor length, 0 if all the bytes are masked
+} MatchPattern;
+
+typedef struct {
+	int k;
+	int bits;
+	ut32 *start; // (1 << bits) + 1 offsets in idx
+	ut32 *idx; // patterns sorted by anchor key
+} MatchTable;
+
+struct r_sign_matcher_t {
+	MatchPattern *pats;
+	ut32 npats;
+	ut8 *masks;
+	MatchTable tables[MATCH_TABLES]; // anchors of 4, 2 and 1 bytes
+	ut32 *any; // patterns without defined bytes, tried everywhere
+	ut32 nany;
+	int maxlen;
+	ut8 *win; // tail of the previous block followed by the current one
+	int win_size;
+	int left;
+	ut64 left_end;
+};
+
+typedef struct {
+	ut32 pat;
+	ut32 pos;
+} MatchHit;
+
+typedef struct {
+	const RSignMatcher *m;
+	const ut8 *win;
+	int len;
+	int left;
+	int from;
+	int to;
+	int align;
+	ut64 addr;
+	RVector hits; // <MatchHit>
+} MatchSlice;
+
+static inline ut32 matchKey(const MatchTable *t, const ut8 *p) {
+	switch (t->k) {
+	case 4:
+		return (r_read_le32 (p) * 0x9e3779b1U) >> (32 - t->bits);
+	case 2:
+		return r_read_le16 (p);
+	default:
+		return *p;
+	}
+}
+
+static int matchAnchor(const ut8 *bytes, const ut8 *mask, int size, int k) {
+	int i, j, best = -1, best_score = -1;
+	for (i = 0; i + k <= size; i++) {
+		int score = 0;
+		for (j = 0; j < k && score >= 0; j++) {
+			ut8 c = bytes[i + j];
+			if (mask[i + j] != 0xff) {
+				score = -1;
+			} else if (c && c != 0xff) {
+				// zeros and ones are everywhere in code, avoid them
+				score += (j && c == bytes[i + j - 1])? 1: 2;
+			}
+		}
+		if (score > best_score) {
+			best = i;
+			best_score = score;
+		}
+	}
+	return best;
+}
+
+/* the longest anchor found wins, k is 0 when every byte is masked */
+static void matchPick(const ut8 *bytes, const ut8 *mask, int size, int *anchor, int *k) {
+	static const int anchors[MATCH_TABLES] = { 4, 2, 1 };
+	int t;
+	*anchor = 0;
+	*k = 0;
+	for (t = 0; t < MATCH_TABLES; t++) {
+		int at = matchAnchor (bytes, mask, size, anchors[t]);
+		if (at >= 0) {
+			*anchor = at;
+			*k = anchors[t];
+			return;
+		}
+	}
+}
+
+static bool matchTableBuild(MatchTable *t, const MatchPattern *pats, ut32 npats, int k) {
+	ut32 i, n = 0, b;
+	for (i = 0; i < npats; i++) {
+		n += pats[i].k == k;
+	}
+	t->k = k;
+	if (!n) {
+		return true;
+	}
+	if (k == 4) {
+		for (t->bits = 8; (1U << t->bits) < n * 2 && t->bits < 24; t->bits++) {
+			;
+		}
+	} else {
+		t->bits = k * 8;
+	}
+	ut32 nb = 1U << t->bits;
+	t->start = calloc (nb + 1, sizeof (ut32));
+	t->idx = R_NEWS (ut32, n);
+	if (!t->start || !t->idx) {
+		return false;
+	}
+	for (i = 0; i < npats; i++) {
+		if (pats[i].k == k) {
+			t->start[matchKey (t, pats[i].bytes + pats[i].anchor) + 1]++;
+		}
+	}
+	for (b = 0; b < nb; b++) {
+		t->start[b + 1] += t->start[b];
+	}
+	for (i = 0; i < npats; i++) {
+		if (pats[i].k == k) {
+			t->idx[t->start[matchKey (t, pats[i].bytes + pats[i].anchor)]++] = i;
+		}
+	}
+	for (b = nb; b > 0; b--) {
+		t->start[b] = t->start[b - 1];
+	}
+	t->start[0] = 0;
+	return true;
+}
+
+static void matcherFree(RSignMatcher *m) {
+	int i;
+	if (!m) {
+		return;
+	}
+	for (i = 0; i < MATCH_TABLES; i++) {
+		free (m->tables[i].start);
+		free (m->tables[i].idx);
+	}
+	free (m->pats);
+	free (m->masks);
+	free (m->any);
+	free (m->win);
+	free (m);
+}
+
+static RSignMatcher *matcherNew(RSearch *search) {
+	static const int anchors[MATCH_TABLES] = { 4, 2, 1 };
+	RSearchKeyword *kw;
+	RListIter *iter;
+	ut64 total = 0;
+	ut32 i = 0;
+	int j, t;
+
+	RSignMatcher *m = R_NEW0 (RSignMatcher);
+	if (!m) {
+		return NULL;
+	}
+	r_list_foreach (search->kws, iter, kw) {
+		total += kw->keyword_length;
+	}
+	m->npats = r_list_length (search->kws);
+	if (!m->npats) {
+		return m;
+	}
+	m->pats = R_NEWS0 (MatchPattern, m->npats);
+	m->masks = malloc (total);
+	m->any = R_NEWS (ut32, m->npats);
+	if (!m->pats || !m->masks || !m->any) {
+		goto fail;
+	}
+	total = 0;
+	r_list_foreach (search->kws, iter, kw) {
+		MatchPattern *p = &m->pats[i++];
+		ut8 *mask = m->masks + total;
+		for (j = 0; j < kw->keyword_length; j++) {
+			mask[j] = kw->binmask_length > 0? kw->bin_binmask[j % kw->binmask_length]: 0xff;
+		}
+		total += kw->keyword_length;
+		p->kw = kw;
+		p->bytes = kw->bin_keyword;
+		p->mask = mask;
+		p->size = kw->keyword_length;
+		m->maxlen = R_MAX (m->maxlen, p->size);
+		SignKw *sk = kw->data;
+		if (sk && sk->k >= 0) {
+			// picked when the database was saved
+			p->anchor = sk->anchor;
+			p->k = sk->k;
+		} else {
+			matchPick (p->bytes, p->mask, p->size, &p->anchor, &p->k);
+		}
+		if (!p->k) {
+			m->any[m->nany++] = i - 1;
+		}
+	}
+	for (t = 0; t < MATCH_TABLES; t++) {
+		if (!matchTableBuild (&m->tables[t], m->pats, m->npats, anchors[t])) {
+			goto fail;
+		}
+	}
+	return m;
+fail:
+	matcherFree (m);
+	return NULL;
+}
+
+static inline void matchTry(const MatchSlice *sl, ut32 pat, int q, RVector *hits) {
+	const MatchPattern *p = &sl->m->pats[pat];
+	int j, s = q - p->anchor;
+	// patterns ending in the previous tail were already tried
+	if (s < 0 || s + p->size > sl->len || s + p->size <= sl->left) {
+		return;
+	}
+	if (sl->align && (sl->addr + s) % sl->align) {
+		return;
+	}
+	for (j = 0; j < p->size; j++) {
+		if ((sl->win[s + j] ^ p->bytes[j]) & p->mask[j]) {
+			return;
+		}
+	}
+	MatchHit hit = { pat, s };
+	r_vector_push (hits, &hit);
+}
+
+static void matchSlice(MatchSlice *sl) {
+	const RSignMatcher *m = sl->m;
+	ut32 i;
+	int q, t;
+	for (q = sl->from; q < sl->to; q++) {
+		for (t = 0; t < MATCH_TABLES; t++) {
+			const MatchTable *tb = &m->tables[t];
+			if (!tb->start || q + tb->k > sl->len) {
+				continue;
+			}
+			ut32 key = matchKey (tb, sl->win + q);
+			for (i = tb->start[key]; i < tb->start[key + 1]; i++) {
+				matchTry (sl, tb->idx[i], q, &sl->hits);
+			}
+		}
+		for (i = 0; i < m->nany; i++) {
+			matchTry (sl, m->any[i], q, &sl->hits);
+		}
+	}
+}
+
+static RThreadFunctionRet matchThread(RThread *th) {
+	matchSlice (th->user);
+	return R_TH_STOP;
+}
+
+static int matcherUpdate(RSignMatcher *m, RSearch *search, ut64 from, const ut8 *buf, int len) {
+	MatchSlice slices[MATCH_THREADS];
+	RThread *th[MATCH_THREADS] = {0};
+	int i, nslices, nhits = 0;
+	ut32 j;
+
+	if (m->left && m->left_end != from) {
+		m->left = 0;
+	}
+	int wlen = m->left + len;
+	if (wlen > m->win_size) {
+		ut8 *win = realloc (m->win, wlen);
+		if (!win) {
+			return -1;
+		}
+		m->win = win;
+		m->win_size = wlen;
+	}
+	memcpy (m->win + m->left, buf, len);
+
+	nslices = R_MAX (1, R_MIN (MATCH_THREADS, wlen / MATCH_MIN_SLICE));
+	for (i = 0; i < nslices; i++) {
+		MatchSlice *sl = &slices[i];
+		sl->m = m;
+		sl->win = m->win;
+		sl->len = wlen;
+		sl->left = m->left;
+		sl->from = (st64)wlen * i / nslices;
+		sl->to = (st64)wlen * (i + 1) / nslices;
+		sl->align = search->align;
+		sl->addr = from - m->left;
+		r_vector_init (&sl->hits, sizeof (MatchHit), NULL, NULL);
+		if (nslices > 1) {
+			th[i] = r_th_new (matchThread, sl, 0);
+		}
+	}
+	for (i = 0; i < nslices; i++) {
+		if (th[i]) {
+			r_th_wait (th[i]);
+			r_th_free (th[i]);
+		} else {
+			matchSlice (&slices[i]);
+		}
+	}
+
+	// report sequentially, honoring the keyword counters like r_search does
+	for (i = 0; i < nslices && nhits >= 0; i++) {
+		MatchSlice *sl = &slices[i];
+		for (j = 0; j < sl->hits.len; j++) {
+			MatchHit *hit = r_vector_index_ptr (&sl->hits, j);
+			RSearchKeyword *kw = m->pats[hit->pat].kw;
+			ut64 addr = sl->addr + hit->pos;
+			if (!search->overlap && kw->count && addr < kw->last) {
+				continue;
+			}
+			int t = r_search_hit_new (search, kw, addr);
+			if (!t) {
+				nhits = -1;
+				break;
+			}
+			nhits++;
+			if (t > 1) {
+				i = nslices;
+				break;
+			}
+		}
+	}
+	for (i = 0; i < nslices; i++) {
+		r_vector_clear (&slices[i].hits);
+	}
+
+	m->left = R_MIN (m->maxlen - 1, wlen);
+	memmove (m->win, m->win + wlen - m->left, m->left);
+	m->left_end = from + len;
+	return nhits;
 }
 
 R_API RSignSearch *r_sign_search_new() {
@@ -1011,6 +1369,7 @@ R_API RSignSearch *r_sign_search_new() {
 
 	ret->search = r_search_new (R_SEARCH_KEYWORD);
 	ret->items = r_list_newf ((RListFree) r_sign_item_free);
+	ret->kws = r_list_newf (free);
 
 	return ret;
 }
@@ -1022,19 +1381,391 @@ R_API void r_sign_search_free(RSignSearch *ss) {
 
 	r_search_free (ss->search);
 	r_list_free (ss->items);
+	r_list_free (ss->kws);
+	matcherFree (ss->matcher);
 	free (ss);
 }
 
+static RSignItem *dbItem(RAnal *a, RSignDb *db, ut32 idx);
+
 static int searchHitCB(RSearchKeyword *kw, void *user, ut64 addr) {
 	RSignSearch *ss = (RSignSearch *) user;
+	SignKw *sk = (SignKw *) kw->data;
 
+	if (!sk->it) {
+		sk->it = dbItem (sk->anal, sk->db, sk->idx);
+		if (!sk->it) {
+			return 1;
+		}
+		r_list_append (ss->items, sk->it);
+	}
 	if (ss->cb) {
-		return ss->cb ((RSignItem *) kw->data, kw, addr, ss->user);
+		return ss->cb (sk->it, kw, addr, ss->user);
 	}
 
 	return 1;
 }
 
+/*
+ * Binary zignature databases: a header, fixed size item records, sorted
+ * index tables and a data blob with the strings, bytes and masks. All the
+ * fields are little endian offsets from the start of the file, so it can
+ * be mapped read-only and shared between processes.
+ */
+#define DB_MAGIC "R2ZB"
+#define DB_VERSION 2
+#define DB_HDR_SIZE 80
+#define DB_HDR_V1_SIZE 64 // without the space and bytes tables
+#define DB_ITEM_SIZE 56
+#define DB_GRAPH_SIZE 20
+#define DB_STR_SIZE 8
+#define DB_OFFSET_SIZE 12
+#define DB_BYTES_SIZE 16
+
+enum {
+	DB_ITEM_GRAPH = 1,
+	DB_ITEM_REFS = 2,
+	DB_ITEM_HASH = 4,
+};
+
+typedef int (*DbCmp)(RSignDb *db, const ut8 *entry, const void *key);
+
+static bool dbRange(RSignDb *db, ut32 off, ut32 n, ut32 esize) {
+	return (ut64)off + (ut64)n * esize <= db->size;
+}
+
+static const char *dbStr(RSignDb *db, ut32 off) {
+	// the data blob is known to end with a null byte
+	return off < db->data_size? (const char *) db->buf + db->data + off: "";
+}
+
+static const ut8 *dbRecord(RSignDb *db, ut32 idx) {
+	return idx < db->nitems? db->buf + db->items + idx * DB_ITEM_SIZE: NULL;
+}
+
+static bool dbDeleted(RSignDb *db, ut32 idx) {
+	return db->deleted && db->deleted[idx];
+}
+
+static bool dbSpaceMatch(RAnal *a, RSignDb *db, const ut8 *rec) {
+	if (a->zign_spaces.space_idx == -1) {
+		return true;
+	}
+	const char *space = a->zign_spaces.spaces[a->zign_spaces.space_idx];
+	return space && !strcmp (space, dbStr (db, r_read_le32 (rec + 4)));
+}
+
+static void dbGraph(const ut8 *rec, RSignGraph *g) {
+	g->cc = (st32) r_read_le32 (rec + 20);
+	g->nbbs = (st32) r_read_le32 (rec + 24);
+	g->edges = (st32) r_read_le32 (rec + 28);
+	g->ebbs = (st32) r_read_le32 (rec + 32);
+}
+
+/* returns a new item, or NULL if it is out of the selected zign space */
+static RSignItem *dbItem(RAnal *a, RSignDb *db, ut32 idx) {
+	const ut8 *rec = dbRecord (db, idx);
+	if (!rec || dbDeleted (db, idx) || !dbSpaceMatch (a, db, rec)) {
+		return NULL;
+	}
+	RSignItem *it = r_sign_item_new ();
+	if (!it) {
+		return NULL;
+	}
+	ut32 flags = r_read_le32 (rec + 8);
+	ut32 size = r_read_le32 (rec + 12);
+	ut32 bytes = r_read_le32 (rec + 16);
+	it->name = strdup (dbStr (db, r_read_le32 (rec)));
+	it->space = r_space_add (&a->zign_spaces, dbStr (db, r_read_le32 (rec + 4)));
+	if (size > 0 && (ut64)bytes + 2 * (ut64)size <= db->data_size) {
+		it->bytes = R_NEW0 (RSignBytes);
+		if (it->bytes) {
+			it->bytes->size = size;
+			it->bytes->bytes = r_mem_dup ((void *)(db->buf + db->data + bytes), size);
+			it->bytes->mask = r_mem_dup ((void *)(db->buf + db->data + bytes + size), size);
+		}
+	}
+	if (flags & DB_ITEM_GRAPH) {
+		it->graph = R_NEW0 (RSignGraph);
+		if (it->graph) {
+			dbGraph (rec, it->graph);
+		}
+	}
+	if (flags & DB_ITEM_REFS) {
+		char *refs = strdup (dbStr (db, r_read_le32 (rec + 36)));
+		int i, nrefs = refs? r_str_split (refs, ','): 0;
+		if (nrefs > 0) {
+			it->refs = r_list_newf ((RListFree) free);
+			for (i = 0; i < nrefs; i++) {
+				r_list_append (it->refs, strdup (r_str_word_get0 (refs, i)));
+			}
+		}
+		free (refs);
+	}
+	if (flags & DB_ITEM_HASH) {
+		it->hash = R_NEW0 (RSignHash);
+		if (it->hash) {
+			it->hash->bbhash = strdup (dbStr (db, r_read_le32 (rec + 40)));
+		}
+	}
+	it->offset = r_read_le64 (rec + 48);
+	return it;
+}
+
+static int dbCmpGraph(RSignDb *db, const ut8 *e, const void *key) {
+	const RSignGraph *g = key;
+	int v[4] = { g->cc, g->nbbs, g->edges, g->ebbs };
+	int i;
+	for (i = 0; i < 4; i++) {
+		st32 x = (st32) r_read_le32 (e + i * 4);
+		if (x != v[i]) {
+			return x < v[i]? -1: 1;
+		}
+	}
+	return 0;
+}
+
+static int dbCmpStr(RSignDb *db, const ut8 *e, const void *key) {
+	return strcmp (dbStr (db, r_read_le32 (e)), (const char *) key);
+}
+
+static int dbCmpOffset(RSignDb *db, const ut8 *e, const void *key) {
+	ut64 a = r_read_le64 (e), b = *(const ut64 *) key;
+	return a < b? -1: a > b? 1: 0;
+}
+
+/* calls cb for every entry equal to key, returns false when cb stops */
+static bool dbMatch(RAnal *a, RSignDb *db, ut32 base, ut32 n, ut32 esize, DbCmp cmp, const void *key, RAnalFunction *fcn, RSignGraphMatchCallback cb, void *user) {
+	ut32 lo = 0, hi = n;
+	while (lo < hi) {
+		ut32 mid = lo + (hi - lo) / 2;
+		if (cmp (db, db->buf + base + mid * esize, key) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	for (; lo < n; lo++) {
+		const ut8 *e = db->buf + base + lo * esize;
+		if (cmp (db, e, key)) {
+			break;
+		}
+		RSignItem *it = dbItem (a, db, r_read_le32 (e + esize - 4));
+		if (it) {
+			int ret = cb (it, fcn, user);
+			r_sign_item_free (it);
+			if (!ret) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static bool dbMatchGraph(RAnal *a, RSignDb *db, RAnalFunction *fcn, const RSignGraph *g, int mincc, RSignGraphMatchCallback cb, void *user) {
+	ut32 i;
+	if (g->cc >= mincc && !dbMatch (a, db, db->graph, db->ngraph, DB_GRAPH_SIZE, dbCmpGraph, g, fcn, cb, user)) {
+		return false;
+	}
+	for (i = 0; i < db->ngraph_any; i++) {
+		ut32 idx = r_read_le32 (db->buf + db->graph_any + i * 4);
+		const ut8 *rec = dbRecord (db, idx);
+		RSignGraph graph;
+		if (!rec) {
+			continue;
+		}
+		dbGraph (rec, &graph);
+		if (graph.cc < mincc ||
+		    (graph.cc != -1 && graph.cc != g->cc) ||
+		    (graph.nbbs != -1 && graph.nbbs != g->nbbs) ||
+		    (graph.edges != -1 && graph.edges != g->edges) ||
+		    (graph.ebbs != -1 && graph.ebbs != g->ebbs)) {
+			continue;
+		}
+		RSignItem *it = dbItem (a, db, idx);
+		if (it) {
+			int ret = cb (it, fcn, user);
+			r_sign_item_free (it);
+			if (!ret) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static bool dbForeach(RAnal *a, RSignForeachCallback cb, void *user) {
+	RListIter *iter;
+	RSignDb *db;
+	ut32 i;
+	r_list_foreach (a->zign_dbs, iter, db) {
+		for (i = 0; i < db->nitems; i++) {
+			RSignItem *it = dbItem (a, db, i);
+			if (it) {
+				int ret = cb (it, user);
+				r_sign_item_free (it);
+				if (!ret) {
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static int dbCount(RAnal *a, int idx) {
+	const char *space = idx >= 0? a->zign_spaces.spaces[idx]: "*";
+	RListIter *iter;
+	RSignDb *db;
+	int count = 0;
+	ut32 i;
+	r_list_foreach (a->zign_dbs, iter, db) {
+		for (i = 0; i < db->nitems; i++) {
+			const ut8 *rec = dbRecord (db, i);
+			if (!dbDeleted (db, i) && space && !strcmp (space, dbStr (db, r_read_le32 (rec + 4)))) {
+				count++;
+			}
+		}
+	}
+	return count;
+}
+
+/* the mapping is read-only, so deleted items are only hidden */
+static bool dbDelete(RAnal *a, const char *name) {
+	int sidx = a->zign_spaces.space_idx;
+	const char *space = sidx >= 0? a->zign_spaces.spaces[sidx]: "*";
+	RListIter *iter;
+	RSignDb *db;
+	bool ret = false;
+	ut32 i;
+	r_list_foreach (a->zign_dbs, iter, db) {
+		for (i = 0; i < db->nitems; i++) {
+			const ut8 *rec = dbRecord (db, i);
+			if (dbDeleted (db, i) || !space || strcmp (space, dbStr (db, r_read_le32 (rec + 4)))) {
+				continue;
+			}
+			if (*name != '*' && strcmp (name, dbStr (db, r_read_le32 (rec)))) {
+				continue;
+			}
+			if (!db->deleted && !(db->deleted = calloc (db->nitems, 1))) {
+				return ret;
+			}
+			db->deleted[i] = 1;
+			ret = true;
+		}
+	}
+	return ret;
+}
+
+R_API RSignDb *r_sign_db_open(const char *file) {
+	RMmap *map = r_file_mmap (file, false, 0);
+	if (!map) {
+		return NULL;
+	}
+	ut32 version = map->len >= DB_HDR_V1_SIZE? r_read_le32 (map->buf + 4): 0;
+	if (map->len < (version > 1? DB_HDR_SIZE: DB_HDR_V1_SIZE) || memcmp (map->buf, DB_MAGIC, 4) ||
+	    version < 1 || version > DB_VERSION) {
+		r_file_mmap_free (map);
+		return NULL;
+	}
+	RSignDb *db = R_NEW0 (RSignDb);
+	if (!db) {
+		r_file_mmap_free (map);
+		return NULL;
+	}
+	const ut8 *h = map->buf;
+	db->file = strdup (file);
+	db->map = map;
+	db->buf = map->buf;
+	db->size = map->len;
+	db->nitems = r_read_le32 (h + 8);
+	db->items = r_read_le32 (h + 12);
+	db->data = r_read_le32 (h + 16);
+	db->data_size = r_read_le32 (h + 20);
+	db->graph = r_read_le32 (h + 24);
+	db->ngraph = r_read_le32 (h + 28);
+	db->graph_any = r_read_le32 (h + 32);
+	db->ngraph_any = r_read_le32 (h + 36);
+	db->bbhash = r_read_le32 (h + 40);
+	db->nbbhash = r_read_le32 (h + 44);
+	db->refs = r_read_le32 (h + 48);
+	db->nrefs = r_read_le32 (h + 52);
+	db->offset = r_read_le32 (h + 56);
+	db->noffset = r_read_le32 (h + 60);
+	db->version = version;
+	if (version > 1) {
+		db->spaces = r_read_le32 (h + 64);
+		db->nspaces = r_read_le32 (h + 68);
+		db->bytes = r_read_le32 (h + 72);
+		db->nbytes = r_read_le32 (h + 76);
+	}
+	if (!dbRange (db, db->items, db->nitems, DB_ITEM_SIZE) ||
+	    !dbRange (db, db->data, db->data_size, 1) || !db->data_size ||
+	    db->buf[db->data + db->data_size - 1] ||
+	    !dbRange (db, db->graph, db->ngraph, DB_GRAPH_SIZE) ||
+	    !dbRange (db, db->graph_any, db->ngraph_any, 4) ||
+	    !dbRange (db, db->bbhash, db->nbbhash, DB_STR_SIZE) ||
+	    !dbRange (db, db->refs, db->nrefs, DB_STR_SIZE) ||
+	    !dbRange (db, db->offset, db->noffset, DB_OFFSET_SIZE) ||
+	    !dbRange (db, db->spaces, db->nspaces, 4) ||
+	    !dbRange (db, db->bytes, db->nbytes, DB_BYTES_SIZE)) {
+		eprintf ("error: corrupted zignature database %s\n", file);
+		r_sign_db_close (db);
+		return NULL;
+	}
+	return db;
+}
+
+R_API void r_sign_db_close(RSignDb *db) {
+	if (!db) {
+		return;
+	}
+	r_file_mmap_free (db->map);
+	free (db->deleted);
+	free (db->file);
+	free (db);
+}
+
+R_API bool r_sign_is_db(const char *file) {
+	char magic[4];
+	bool ret = false;
+	FILE *fd = r_sandbox_fopen (file, "rb");
+	if (fd) {
+		ret = fread (magic, 1, sizeof (magic), fd) == sizeof (magic) && !memcmp (magic, DB_MAGIC, 4);
+		fclose (fd);
+	}
+	return ret;
+}
+
+R_API bool r_sign_db_load(RAnal *a, const char *file) {
+	ut32 i;
+	if (!a || !file) {
+		return false;
+	}
+	char *path = r_sign_path (a, file);
+	RSignDb *db = path? r_sign_db_open (path): NULL;
+	free (path);
+	if (!db) {
+		eprintf ("error: cannot open zignature database %s\n", file);
+		return false;
+	}
+	if (!a->zign_dbs) {
+		a->zign_dbs = r_list_newf ((RListFree) r_sign_db_close);
+	}
+	r_list_append (a->zign_dbs, db);
+	// make the zignspaces of the database known to zs
+	if (db->version > 1) {
+		for (i = 0; i < db->nspaces; i++) {
+			r_space_add (&a->zign_spaces, dbStr (db, r_read_le32 (db->buf + db->spaces + i * 4)));
+		}
+		return true;
+	}
+	for (i = 0; i < db->nitems; i++) {
+		r_space_add (&a->zign_spaces, dbStr (db, r_read_le32 (dbRecord (db, i) + 4)));
+	}
+	return true;
+}
+
 struct ctxAddSearchKwCB {
 	RSignSearch *ss;
 	int minsz;
@@ -1046,6 +1777,7 @@ static int addSearchKwCB(RSignItem *it, void *user) {
 	RSignBytes *bytes = it->bytes;
 	RSearchKeyword *kw = NULL;
 	RSignItem *it2 = NULL;
+	SignKw *sk = NULL;
 
 	if (!bytes) {
 		return 1;
@@ -1057,16 +1789,53 @@ static int addSearchKwCB(RSignItem *it, void *user) {
 
 	it2 = r_sign_item_dup (it);
 	r_list_append (ss->items, it2);
+	sk = R_NEW0 (SignKw);
+	if (!sk) {
+		return 1;
+	}
+	sk->it = it2;
+	sk->k = -1;
+	r_list_append (ss->kws, sk);
 
 	// TODO(nibble): change arg data in r_search_keyword_new to void*
-	kw = r_search_keyword_new (bytes->bytes, bytes->size, bytes->mask, bytes->size, (const char *) it2);
+	kw = r_search_keyword_new (bytes->bytes, bytes->size, bytes->mask, bytes->size, (const char *) sk);
 	r_search_kw_add (ss->search, kw);
 
 	return 1;
 }
 
+/* the keyword is built from the mapped bytes and mask, the item itself is
+ * only read if it hits */
+static void dbAddSearchKw(RAnal *a, RSignSearch *ss, RSignDb *db, ut32 idx, int minsz, int anchor, int k) {
+	const ut8 *rec = dbRecord (db, idx);
+	if (!rec || dbDeleted (db, idx) || !dbSpaceMatch (a, db, rec)) {
+		return;
+	}
+	ut32 size = r_read_le32 (rec + 12);
+	ut32 bytes = r_read_le32 (rec + 16);
+	if (!size || size < minsz || (ut64)bytes + 2 * (ut64)size > db->data_size) {
+		return;
+	}
+	SignKw *sk = R_NEW0 (SignKw);
+	if (!sk) {
+		return;
+	}
+	const ut8 *data = db->buf + db->data + bytes;
+	sk->anal = a;
+	sk->db = db;
+	sk->idx = idx;
+	sk->anchor = anchor;
+	sk->k = (k >= 0 && k <= 4 && anchor >= 0 && (ut64)anchor + k <= size)? k: -1;
+	r_list_append (ss->kws, sk);
+	RSearchKeyword *kw = r_search_keyword_new (data, size, data + size, size, (const char *) sk);
+	r_search_kw_add (ss->search, kw);
+}
+
 R_API void r_sign_search_init(RAnal *a, RSignSearch *ss, int minsz, RSignSearchCallback cb, void *user) {
 	struct ctxAddSearchKwCB ctx = { ss, minsz };
+	RListIter *iter;
+	RSignDb *db;
+	ut32 i;
 
 	if (!a || !ss || !cb) {
 		return;
@@ -1076,18 +1845,44 @@ R_API void r_sign_search_init(RAnal *a, RSignSearch *ss, int minsz, RSignSearchC
 	ss->user = user;
 
 	r_list_purge (ss->items);
+	r_list_purge (ss->kws);
 	r_search_reset (ss->search, R_SEARCH_KEYWORD);
 
-	r_sign_foreach (a, addSearchKwCB, &ctx);
+	foreachSdb (a, addSearchKwCB, &ctx);
+	r_list_foreach (a->zign_dbs, iter, db) {
+		if (db->version < 2) {
+			for (i = 0; i < db->nitems; i++) {
+				dbAddSearchKw (a, ss, db, i, minsz, 0, -1);
+			}
+			continue;
+		}
+		// only the items with bytes, in item order
+		for (i = 0; i < db->nbytes; i++) {
+			const ut8 *e = db->buf + db->bytes + i * DB_BYTES_SIZE;
+			if (r_read_le32 (e) < minsz) {
+				continue;
+			}
+			dbAddSearchKw (a, ss, db, r_read_le32 (e + 12), minsz,
+				(st32) r_read_le32 (e + 4), (st32) r_read_le32 (e + 8));
+		}
+	}
 	r_search_begin (ss->search);
 	r_search_set_callback (ss->search, searchHitCB, ss);
+	matcherFree (ss->matcher);
+	ss->matcher = matcherNew (ss->search);
 }
 
 R_API int r_sign_search_update(RAnal *a, RSignSearch *ss, ut64 *at, const ut8 *buf, int len) {
 	if (!a || !ss || !buf || len <= 0) {
 		return 0;
 	}
-	return r_search_update (ss->search, *at, buf, len);
+	if (!ss->matcher) {
+		return r_search_update (ss->search, *at, buf, len);
+	}
+	if (!ss->matcher->npats || (ss->search->maxhits && ss->search->nhits >= ss->search->maxhits)) {
+		return 0;
+	}
+	return matcherUpdate (ss->matcher, ss->search, *at, buf, len);
 }
 
 static bool fcnMetricsCmp(RSignItem *it, RAnalFunction *fcn) {
@@ -1109,6 +1904,28 @@ static bool fcnMetricsCmp(RSignItem *it, RAnalFunction *fcn) {
 	return true;
 }
 
+static char *refsKey(RList *refs) {
+	RListIter *iter;
+	char *ref;
+	RStrBuf *sb = r_strbuf_new ("");
+	if (!sb) {
+		return NULL;
+	}
+	r_strbuf_appendf (sb, "%d:", r_list_length (refs));
+	r_list_foreach (refs, iter, ref) {
+		r_strbuf_appendf (sb, "%s%s", iter == refs->head? "": ",", ref);
+	}
+	return r_strbuf_drain (sb);
+}
+
+static void fcnGraph(RAnalFunction *fcn, RSignGraph *g) {
+	int ebbs = -1;
+	g->cc = r_anal_fcn_cc (fcn);
+	g->nbbs = r_list_length (fcn->bbs);
+	g->edges = r_anal_fcn_count_edges (fcn, &ebbs);
+	g->ebbs = ebbs;
+}
+
 struct ctxFcnMatchCB {
 	RAnal *anal;
 	RAnalFunction *fcn;
@@ -1142,12 +1959,26 @@ static int graphMatchCB(RSignItem *it, void *user) {
 
 R_API bool r_sign_match_graph(RAnal *a, RAnalFunction *fcn, int mincc, RSignGraphMatchCallback cb, void *user) {
 	struct ctxFcnMatchCB ctx = { a, fcn, cb, user, mincc };
+	RListIter *iter;
+	RSignDb *db;
+	RSignGraph g;
 
 	if (!a || !fcn || !cb) {
 		return false;
 	}
 
-	return r_sign_foreach (a, graphMatchCB, &ctx);
+	if (!foreachSdb (a, graphMatchCB, &ctx)) {
+		return false;
+	}
+	if (!r_list_empty (a->zign_dbs)) {
+		fcnGraph (fcn, &g);
+	}
+	r_list_foreach (a->zign_dbs, iter, db) {
+		if (!dbMatchGraph (a, db, fcn, &g, mincc, cb, user)) {
+			return false;
+		}
+	}
+	return true;
 }
 
 static int offsetMatchCB(RSignItem *it, void *user) {
@@ -1170,12 +2001,22 @@ static int offsetMatchCB(RSignItem *it, void *user) {
 
 R_API bool r_sign_match_offset(RAnal *a, RAnalFunction *fcn, RSignOffsetMatchCallback cb, void *user) {
 	struct ctxFcnMatchCB ctx = { a, fcn, cb, user, 0 };
+	RListIter *iter;
+	RSignDb *db;
 
 	if (!a || !fcn || !cb) {
 		return false;
 	}
 
-	return r_sign_foreach (a, offsetMatchCB, &ctx);
+	if (!foreachSdb (a, offsetMatchCB, &ctx)) {
+		return false;
+	}
+	r_list_foreach (a->zign_dbs, iter, db) {
+		if (!dbMatch (a, db, db->offset, db->noffset, DB_OFFSET_SIZE, dbCmpOffset, &fcn->addr, fcn, cb, user)) {
+			return false;
+		}
+	}
+	return true;
 }
 
 static int hashMatchCB(RSignItem *it, void *user) {
@@ -1191,9 +2032,9 @@ static int hashMatchCB(RSignItem *it, void *user) {
 	}
 
 	char *digest_hex = NULL;
-	bool retval = false;
+	int retval = 1;
 	digest_hex = r_sign_calc_bbhash (ctx->anal, ctx->fcn);
-	if (strcmp (hash->bbhash, digest_hex)) {
+	if (!digest_hex || strcmp (hash->bbhash, digest_hex)) {
 		goto beach;
 	}
 
@@ -1207,12 +2048,32 @@ beach:
 
 R_API bool r_sign_match_hash(RAnal *a, RAnalFunction *fcn, RSignHashMatchCallback cb, void *user) {
 	struct ctxFcnMatchCB ctx = { a, fcn, cb, user, 0 };
+	RListIter *iter;
+	RSignDb *db;
+	bool retval = true;
 
 	if (!a || !fcn || !cb) {
 		return false;
 	}
 
-	return r_sign_foreach (a, hashMatchCB, &ctx);
+	if (!foreachSdb (a, hashMatchCB, &ctx)) {
+		return false;
+	}
+	if (r_list_empty (a->zign_dbs)) {
+		return true;
+	}
+	char *digest_hex = r_sign_calc_bbhash (a, fcn);
+	if (!digest_hex) {
+		return false;
+	}
+	r_list_foreach (a->zign_dbs, iter, db) {
+		if (!dbMatch (a, db, db->bbhash, db->nbbhash, DB_STR_SIZE, dbCmpStr, digest_hex, fcn, cb, user)) {
+			retval = false;
+			break;
+		}
+	}
+	free (digest_hex);
+	return retval;
 }
 
 
@@ -1262,14 +2123,537 @@ out:
 
 R_API bool r_sign_match_refs(RAnal *a, RAnalFunction *fcn, RSignRefsMatchCallback cb, void *user) {
 	struct ctxFcnMatchCB ctx = { a, fcn, cb, user, 0 };
+	RListIter *iter;
+	RSignDb *db;
+	bool retval = true;
 
 	if (!a || !fcn || !cb) {
 		return false;
 	}
 
-	return r_sign_foreach (a, refsMatchCB, &ctx);
+	if (!foreachSdb (a, refsMatchCB, &ctx)) {
+		return false;
+	}
+	if (r_list_empty (a->zign_dbs)) {
+		return true;
+	}
+	RList *refs = r_sign_fcn_refs (a, fcn);
+	char *key = refs? refsKey (refs): NULL;
+	r_list_foreach (a->zign_dbs, iter, db) {
+		if (key && !dbMatch (a, db, db->refs, db->nrefs, DB_STR_SIZE, dbCmpStr, key, fcn, cb, user)) {
+			retval = false;
+			break;
+		}
+	}
+	free (key);
+	r_list_free (refs);
+	return retval;
+}
+
+
+static void indexFreeKv(HtKv *kv) {
+	free (kv->key);
+	r_list_free (kv->value);
+}
+
+static void indexAdd(SdbHt *ht, const char *key, RSignItem *it) {
+	RList *list = ht_find (ht, key, NULL);
+	if (!list) {
+		list = r_list_new ();
+		if (!list) {
+			return;
+		}
+		ht_insert (ht, key, list);
+	}
+	r_list_append (list, it);
+}
+
+static char *graphKey(int cc, int nbbs, int edges, int ebbs) {
+	return r_str_newf ("%d:%d:%d:%d", cc, nbbs, edges, ebbs);
 }
 
+static int indexCB(RSignItem *it, void *user) {
+	RSignIndex *idx = (RSignIndex *) user;
+	RSignItem *copy = r_sign_item_new ();
+	if (!copy) {
+		return 0;
+	}
+	// the foreach item is freed after the callback, keep its contents
+	*copy = *it;
+	memset (it, 0, sizeof (RSignItem));
+	r_list_append (idx->items, copy);
+
+	if (copy->hash && copy->hash->bbhash && *copy->hash->bbhash) {
+		indexAdd (idx->bbhash, copy->hash->bbhash, copy);
+	}
+	if (copy->graph) {
+		RSignGraph *g = copy->graph;
+		if (g->cc == -1 || g->nbbs == -1 || g->edges == -1 || g->ebbs == -1) {
+			r_list_append (idx->graph_any, copy);
+		} else {
+			char *key = graphKey (g->cc, g->nbbs, g->edges, g->ebbs);
+			if (key) {
+				indexAdd (idx->graph, key, copy);
+				free (key);
+			}
+		}
+	}
+	if (copy->refs && !r_list_empty (copy->refs)) {
+		char *key = refsKey (copy->refs);
+		if (key) {
+			indexAdd (idx->refs, key, copy);
+			free (key);
+		}
+	}
+	if (copy->offset != UT64_MAX) {
+		indexAdd (idx->offset, sdb_fmt ("0x%"PFMT64x, copy->offset), copy);
+	}
+	return 1;
+}
+
+/*
+ * Deserialize the zignatures of the selected space once, so matching a
+ * function is a few lookups instead of a pass over the whole database.
+ * The index is a snapshot: rebuild it after adding or removing zignatures.
+ */
+R_API RSignIndex *r_sign_index_new(RAnal *a) {
+	r_return_val_if_fail (a, NULL);
+	RSignIndex *idx = R_NEW0 (RSignIndex);
+	if (!idx) {
+		return NULL;
+	}
+	idx->items = r_list_newf ((RListFree) r_sign_item_free);
+	idx->graph_any = r_list_new ();
+	idx->bbhash = ht_new (NULL, indexFreeKv, NULL);
+	idx->graph = ht_new (NULL, indexFreeKv, NULL);
+	idx->refs = ht_new (NULL, indexFreeKv, NULL);
+	idx->offset = ht_new (NULL, indexFreeKv, NULL);
+	if (!idx->items || !idx->graph_any || !idx->bbhash || !idx->graph || !idx->refs || !idx->offset) {
+		r_sign_index_free (idx);
+		return NULL;
+	}
+	foreachSdb (a, indexCB, idx);
+	return idx;
+}
+
+R_API void r_sign_index_free(RSignIndex *idx) {
+	if (!idx) {
+		return;
+	}
+	ht_free (idx->bbhash);
+	ht_free (idx->graph);
+	ht_free (idx->refs);
+	ht_free (idx->offset);
+	r_list_free (idx->graph_any);
+	r_list_free (idx->items);
+	free (idx);
+}
+
+static bool indexMatchList(RList *list, RAnalFunction *fcn, RSignGraphMatchCallback cb, void *user) {
+	RListIter *iter;
+	RSignItem *it;
+	r_list_foreach (list, iter, it) {
+		if (!cb (it, fcn, user)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+R_API bool r_sign_index_match_graph(RAnal *a, RSignIndex *idx, RAnalFunction *fcn, int mincc, RSignGraphMatchCallback cb, void *user) {
+	RListIter *iter;
+	RSignItem *it;
+	RSignDb *db;
+	RSignGraph g;
+
+	if (!a || !idx || !fcn || !cb) {
+		return false;
+	}
+	fcnGraph (fcn, &g);
+
+	if (g.cc >= mincc) {
+		char *key = graphKey (g.cc, g.nbbs, g.edges, g.ebbs);
+		RList *list = key? ht_find (idx->graph, key, NULL): NULL;
+		free (key);
+		if (list && !indexMatchList (list, fcn, cb, user)) {
+			return true;
+		}
+	}
+	r_list_foreach (idx->graph_any, iter, it) {
+		RSignGraph *graph = it->graph;
+		if (graph->cc < mincc) {
+			continue;
+		}
+		if ((graph->cc != -1 && graph->cc != g.cc) ||
+		    (graph->nbbs != -1 && graph->nbbs != g.nbbs) ||
+		    (graph->edges != -1 && graph->edges != g.edges) ||
+		    (graph->ebbs != -1 && graph->ebbs != g.ebbs)) {
+			continue;
+		}
+		if (!cb (it, fcn, user)) {
+			return true;
+		}
+	}
+	r_list_foreach (a->zign_dbs, iter, db) {
+		if (!dbMatchGraph (a, db, fcn, &g, mincc, cb, user)) {
+			break;
+		}
+	}
+	return true;
+}
+
+R_API bool r_sign_index_match_offset(RAnal *a, RSignIndex *idx, RAnalFunction *fcn, RSignOffsetMatchCallback cb, void *user) {
+	if (!a || !idx || !fcn || !cb) {
+		return false;
+	}
+	RListIter *iter;
+	RSignDb *db;
+	RList *list = ht_find (idx->offset, sdb_fmt ("0x%"PFMT64x, fcn->addr), NULL);
+	if (list && !indexMatchList (list, fcn, cb, user)) {
+		return true;
+	}
+	r_list_foreach (a->zign_dbs, iter, db) {
+		if (!dbMatch (a, db, db->offset, db->noffset, DB_OFFSET_SIZE, dbCmpOffset, &fcn->addr, fcn, cb, user)) {
+			break;
+		}
+	}
+	return true;
+}
+
+R_API bool r_sign_index_match_hash(RAnal *a, RSignIndex *idx, RAnalFunction *fcn, RSignHashMatchCallback cb, void *user) {
+	if (!a || !idx || !fcn || !cb) {
+		return false;
+	}
+	RListIter *iter;
+	RSignDb *db;
+	if (!idx->bbhash->count && r_list_empty (a->zign_dbs)) {
+		return true;
+	}
+	char *digest_hex = r_sign_calc_bbhash (a, fcn);
+	if (!digest_hex) {
+		return false;
+	}
+	RList *list = ht_find (idx->bbhash, digest_hex, NULL);
+	if (!list || indexMatchList (list, fcn, cb, user)) {
+		r_list_foreach (a->zign_dbs, iter, db) {
+			if (!dbMatch (a, db, db->bbhash, db->nbbhash, DB_STR_SIZE, dbCmpStr, digest_hex, fcn, cb, user)) {
+				break;
+			}
+		}
+	}
+	free (digest_hex);
+	return true;
+}
+
+R_API bool r_sign_index_match_refs(RAnal *a, RSignIndex *idx, RAnalFunction *fcn, RSignRefsMatchCallback cb, void *user) {
+	if (!a || !idx || !fcn || !cb) {
+		return false;
+	}
+	RListIter *iter;
+	RSignDb *db;
+	if (!idx->refs->count && r_list_empty (a->zign_dbs)) {
+		return true;
+	}
+	RList *refs = r_sign_fcn_refs (a, fcn);
+	if (!refs) {
+		return false;
+	}
+	char *key = refsKey (refs);
+	RList *list = key? ht_find (idx->refs, key, NULL): NULL;
+	if (key && (!list || indexMatchList (list, fcn, cb, user))) {
+		r_list_foreach (a->zign_dbs, iter, db) {
+			if (!dbMatch (a, db, db->refs, db->nrefs, DB_STR_SIZE, dbCmpStr, key, fcn, cb, user)) {
+				break;
+			}
+		}
+	}
+	free (key);
+	r_list_free (refs);
+	return true;
+}
+
+typedef struct {
+	ut8 *buf;
+	ut32 len;
+	ut32 size;
+	bool err;
+} DbBuf;
+
+typedef struct {
+	const char *key;
+	ut32 str;
+	RSignGraph graph;
+	ut64 offset;
+	ut32 item;
+} DbEntry;
+
+static ut32 dbBufAppend(DbBuf *b, const void *data, ut32 len) {
+	ut32 at = b->len;
+	if ((ut64)b->len + len > b->size) {
+		ut64 size = R_MAX ((ut64)b->size * 2, (ut64)b->len + len + 4096);
+		ut8 *buf = size < UT32_MAX? realloc (b->buf, size): NULL;
+		if (!buf) {
+			b->err = true;
+			return 0;
+		}
+		b->buf = buf;
+		b->size = size;
+	}
+	memcpy (b->buf + at, data, len);
+	b->len += len;
+	return at;
+}
+
+static void dbFreeKv(HtKv *kv) {
+	free (kv->key);
+}
+
+static ut32 dbBufStr(DbBuf *b, SdbHt *strs, const char *str) {
+	bool found = false;
+	void *off = ht_find (strs, str, &found);
+	if (found) {
+		return (ut32)(size_t) off;
+	}
+	ut32 at = dbBufAppend (b, str, strlen (str) + 1);
+	ht_insert (strs, str, (void *)(size_t) at);
+	return at;
+}
+
+static int dbEntryGraphCmp(const void *_a, const void *_b) {
+	const DbEntry *a = _a, *b = _b;
+	const RSignGraph *x = &a->graph, *y = &b->graph;
+	if (x->cc != y->cc) {
+		return x->cc < y->cc? -1: 1;
+	}
+	if (x->nbbs != y->nbbs) {
+		return x->nbbs < y->nbbs? -1: 1;
+	}
+	if (x->edges != y->edges) {
+		return x->edges < y->edges? -1: 1;
+	}
+	if (x->ebbs != y->ebbs) {
+		return x->ebbs < y->ebbs? -1: 1;
+	}
+	return a->item < b->item? -1: a->item > b->item;
+}
+
+static int dbEntryStrCmp(const void *_a, const void *_b) {
+	const DbEntry *a = _a, *b = _b;
+	int ret = strcmp (a->key, b->key);
+	return ret? ret: a->item < b->item? -1: a->item > b->item;
+}
+
+static int dbEntryOffsetCmp(const void *_a, const void *_b) {
+	const DbEntry *a = _a, *b = _b;
+	if (a->offset != b->offset) {
+		return a->offset < b->offset? -1: 1;
+	}
+	return a->item < b->item? -1: a->item > b->item;
+}
+
+/*
+ * Write every zignature, whatever the selected space, as a binary database
+ * that r_sign_db_load maps without parsing.
+ */
+R_API bool r_sign_db_save(RAnal *a, const char *file) {
+	DbBuf data = {0}, out = {0};
+	DbEntry *graph = NULL, *bbhash = NULL, *refs = NULL, *offset = NULL;
+	ut32 *graph_any = NULL, *items_rec = NULL, *spaces = NULL;
+	ut8 *bytes_rec = NULL;
+	ut32 n, i = 0, ngraph = 0, ngraph_any = 0, nbbhash = 0, nrefs = 0, noffset = 0;
+	ut32 nspaces = 0, nbytes = 0;
+	SdbHt *strs = NULL, *seen = NULL;
+	RListIter *iter;
+	RSignItem *it;
+	bool retval = false;
+
+	if (!a || !file) {
+		return false;
+	}
+	int space_idx = a->zign_spaces.space_idx;
+	a->zign_spaces.space_idx = -1;
+	RSignIndex *idx = r_sign_index_new (a);
+	a->zign_spaces.space_idx = space_idx;
+	if (!idx) {
+		return false;
+	}
+	n = r_list_length (idx->items);
+	if (!n) {
+		eprintf ("WARNING: no zignatures to save\n");
+		goto out;
+	}
+	strs = ht_new (NULL, dbFreeKv, NULL);
+	graph = R_NEWS0 (DbEntry, n);
+	bbhash = R_NEWS0 (DbEntry, n);
+	refs = R_NEWS0 (DbEntry, n);
+	offset = R_NEWS0 (DbEntry, n);
+	graph_any = R_NEWS0 (ut32, n);
+	items_rec = calloc (n, DB_ITEM_SIZE);
+	seen = ht_new (NULL, dbFreeKv, NULL);
+	spaces = R_NEWS0 (ut32, n);
+	bytes_rec = calloc (n, DB_BYTES_SIZE);
+	if (!strs || !graph || !bbhash || !refs || !offset || !graph_any || !items_rec || !seen || !spaces || !bytes_rec) {
+		goto out;
+	}
+	dbBufAppend (&data, "", 1); // offset 0 is the empty string
+	r_list_foreach (idx->items, iter, it) {
+		ut8 *rec = (ut8 *) items_rec + i * DB_ITEM_SIZE;
+		ut32 flags = 0;
+		const char *space = it->space >= 0? a->zign_spaces.spaces[it->space]: "*";
+		r_write_le32 (rec, dbBufStr (&data, strs, it->name? it->name: ""));
+		r_write_le32 (rec + 4, dbBufStr (&data, strs, space));
+		if (!ht_find (seen, space, NULL)) {
+			ht_insert (seen, space, (void *)(size_t) 1);
+			spaces[nspaces++] = r_read_le32 (rec + 4);
+		}
+		if (it->bytes && it->bytes->size > 0) {
+			ut8 *e = bytes_rec + nbytes++ * DB_BYTES_SIZE;
+			int anchor, k;
+			matchPick (it->bytes->bytes, it->bytes->mask, it->bytes->size, &anchor, &k);
+			r_write_le32 (e, it->bytes->size);
+			r_write_le32 (e + 4, anchor);
+			r_write_le32 (e + 8, k);
+			r_write_le32 (e + 12, i);
+			r_write_le32 (rec + 12, it->bytes->size);
+			r_write_le32 (rec + 16, dbBufAppend (&data, it->bytes->bytes, it->bytes->size));
+			dbBufAppend (&data, it->bytes->mask, it->bytes->size);
+		}
+		if (it->graph) {
+			RSignGraph *g = it->graph;
+			flags |= DB_ITEM_GRAPH;
+			r_write_le32 (rec + 20, g->cc);
+			r_write_le32 (rec + 24, g->nbbs);
+			r_write_le32 (rec + 28, g->edges);
+			r_write_le32 (rec + 32, g->ebbs);
+			if (g->cc == -1 || g->nbbs == -1 || g->edges == -1 || g->ebbs == -1) {
+				graph_any[ngraph_any++] = i;
+			} else {
+				graph[ngraph].graph = *g;
+				graph[ngraph++].item = i;
+			}
+		}
+		if (it->refs && !r_list_empty (it->refs)) {
+			char *key = refsKey (it->refs);
+			if (key) {
+				flags |= DB_ITEM_REFS;
+				r_write_le32 (rec + 36, dbBufStr (&data, strs, strchr (key, ':') + 1));
+				refs[nrefs].str = dbBufStr (&data, strs, key);
+				refs[nrefs].key = key; // freed below
+				refs[nrefs++].item = i;
+			}
+		}
+		if (it->hash && it->hash->bbhash && *it->hash->bbhash) {
+			flags |= DB_ITEM_HASH;
+			bbhash[nbbhash].str = dbBufStr (&data, strs, it->hash->bbhash);
+			bbhash[nbbhash].key = it->hash->bbhash;
+			bbhash[nbbhash++].item = i;
+			r_write_le32 (rec + 40, bbhash[nbbhash - 1].str);
+		}
+		r_write_le64 (rec + 48, it->offset);
+		if (it->offset != UT64_MAX) {
+			offset[noffset].offset = it->offset;
+			offset[noffset++].item = i;
+		}
+		r_write_le32 (rec + 8, flags);
+		i++;
+	}
+	dbBufAppend (&data, "", 1); // the blob always ends with a null byte
+	if (data.err) {
+		goto out;
+	}
+	qsort (graph, ngraph, sizeof (DbEntry), dbEntryGraphCmp);
+	qsort (bbhash, nbbhash, sizeof (DbEntry), dbEntryStrCmp);
+	qsort (refs, nrefs, sizeof (DbEntry), dbEntryStrCmp);
+	qsort (offset, noffset, sizeof (DbEntry), dbEntryOffsetCmp);
+
+	ut8 hdr[DB_HDR_SIZE] = {0}, e[DB_GRAPH_SIZE];
+	ut32 at = DB_HDR_SIZE;
+	memcpy (hdr, DB_MAGIC, 4);
+	r_write_le32 (hdr + 4, DB_VERSION);
+	r_write_le32 (hdr + 8, n);
+	r_write_le32 (hdr + 12, at);
+	at += n * DB_ITEM_SIZE;
+	r_write_le32 (hdr + 24, at);
+	r_write_le32 (hdr + 28, ngraph);
+	at += ngraph * DB_GRAPH_SIZE;
+	r_write_le32 (hdr + 32, at);
+	r_write_le32 (hdr + 36, ngraph_any);
+	at += ngraph_any * 4;
+	r_write_le32 (hdr + 40, at);
+	r_write_le32 (hdr + 44, nbbhash);
+	at += nbbhash * DB_STR_SIZE;
+	r_write_le32 (hdr + 48, at);
+	r_write_le32 (hdr + 52, nrefs);
+	at += nrefs * DB_STR_SIZE;
+	r_write_le32 (hdr + 56, at);
+	r_write_le32 (hdr + 60, noffset);
+	at += noffset * DB_OFFSET_SIZE;
+	r_write_le32 (hdr + 64, at);
+	r_write_le32 (hdr + 68, nspaces);
+	at += nspaces * 4;
+	r_write_le32 (hdr + 72, at);
+	r_write_le32 (hdr + 76, nbytes);
+	at += nbytes * DB_BYTES_SIZE;
+	r_write_le32 (hdr + 16, at);
+	r_write_le32 (hdr + 20, data.len);
+
+	dbBufAppend (&out, hdr, sizeof (hdr));
+	dbBufAppend (&out, items_rec, n * DB_ITEM_SIZE);
+	for (i = 0; i < ngraph; i++) {
+		r_write_le32 (e, graph[i].graph.cc);
+		r_write_le32 (e + 4, graph[i].graph.nbbs);
+		r_write_le32 (e + 8, graph[i].graph.edges);
+		r_write_le32 (e + 12, graph[i].graph.ebbs);
+		r_write_le32 (e + 16, graph[i].item);
+		dbBufAppend (&out, e, DB_GRAPH_SIZE);
+	}
+	for (i = 0; i < ngraph_any; i++) {
+		r_write_le32 (e, graph_any[i]);
+		dbBufAppend (&out, e, 4);
+	}
+	for (i = 0; i < nbbhash; i++) {
+		r_write_le32 (e, bbhash[i].str);
+		r_write_le32 (e + 4, bbhash[i].item);
+		dbBufAppend (&out, e, DB_STR_SIZE);
+	}
+	for (i = 0; i < nrefs; i++) {
+		r_write_le32 (e, refs[i].str);
+		r_write_le32 (e + 4, refs[i].item);
+		dbBufAppend (&out, e, DB_STR_SIZE);
+	}
+	for (i = 0; i < noffset; i++) {
+		r_write_le64 (e, offset[i].offset);
+		r_write_le32 (e + 8, offset[i].item);
+		dbBufAppend (&out, e, DB_OFFSET_SIZE);
+	}
+	for (i = 0; i < nspaces; i++) {
+		r_write_le32 (e, spaces[i]);
+		dbBufAppend (&out, e, 4);
+	}
+	dbBufAppend (&out, bytes_rec, nbytes * DB_BYTES_SIZE);
+	dbBufAppend (&out, data.buf, data.len);
+	if (!out.err && out.len == at + data.len) {
+		retval = r_file_dump (file, out.buf, out.len, false);
+	}
+out:
+	for (i = 0; i < nrefs; i++) {
+		free ((char *)refs[i].key);
+	}
+	ht_free (strs);
+	ht_free (seen);
+	free (spaces);
+	free (bytes_rec);
+	free (graph);
+	free (bbhash);
+	free (refs);
+	free (offset);
+	free (graph_any);
+	free (items_rec);
+	free (data.buf);
+	free (out.buf);
+	r_sign_index_free (idx);
+	return retval;
+}
 
 R_API RSignItem *r_sign_item_new() {
 	RSignItem *ret = R_NEW0 (RSignItem);
@@ -1406,6 +2790,11 @@ R_API bool r_sign_load(RAnal *a, const char *file) {
 		free (path);
 		return false;
 	}
+	if (r_sign_is_db (path)) {
+		bool ret = r_sign_db_load (a, path);
+		free (path);
+		return ret;
+	}
 	Sdb *db = sdb_new (NULL, path, 0);
 	if (!db) {
 		free (path);
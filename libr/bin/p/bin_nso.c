@@ -10,7 +10,8 @@
 #ifdef R_MESON_VERSION
 #include <lz4.h>
 #else
-#include "../../../shlr/lz4/lz4.c"
+/* lz4 is linked into r_util */
+#include "../../../shlr/lz4/lz4.h"
 #endif
 
 #define NSO_OFF(x) r_offsetof (NSOHeader, x)
@@ -489,6 +489,9 @@ free (ov);
 			return NULL;
 		}
 	}
+	if (node && (!ov || strcmp (ov, node->value))) {
+		cfg->rev++;
+	}
 beach:
 	free (ov);
 	return node;
@@ -590,6 +593,9 @@ R_API RConfigNode* r_config_set_i(RConfig *cfg, const char *name, const ut64 i)
 			node->value = strdup (ov? ov: "");
 		}
 	}
+	if (node && (!ov || strcmp (ov, node->value))) {
+		cfg->rev++;
+	}
 beach:
 	free (ov);
 	return node;
@@ -702,6 +708,7 @@ R_API RConfig* r_config_clone(RConfig *cfg) {
 	}
 	c->lock = cfg->lock;
 	c->cb_printf = cfg->cb_printf;
+	c->rev = cfg->rev; // clones only share revisions with the same contents
 	return c;
 }
 
@@ -13,6 +13,7 @@
 
 #define COUNT_LINES 1
 #define CTX(x) I.context->x
+#define STREAM_TAIL 1024
 
 R_LIB_VERSION (r_cons);
 
@@ -110,6 +111,9 @@ static void cons_context_init(RConsContext *context) {
 	context->event_interrupt = NULL;
 	context->event_interrupt_data = NULL;
 	context->pageable = true;
+	context->streamed = false;
+	context->grep_stream = 0;
+	context->grep_stop = false;
 	context->log_callback = NULL;
 }
 
@@ -122,7 +126,13 @@ static void break_signal(int sig) {
 	r_cons_context_break (&r_cons_context_default);
 }
 
+static RStrBuf *screen_capture = NULL; // frame output to diff, see visual_flush
+
 static inline void r_cons_write(const char *buf, int len) {
+	if (screen_capture) {
+		r_strbuf_append_n (screen_capture, buf, len);
+		return;
+	}
 #if __WINDOWS__ && !__CYGWIN__
 	if (I.ansicon) {
 		(void) write (I.fdout, buf, len);
@@ -392,6 +402,7 @@ R_API RCons *r_cons_new() {
 	I.event_data = NULL;
 	I.is_interactive = true;
 	I.noflush = false;
+	I.stream = 0;
 	I.linesleep = 0;
 	I.fdin = stdin;
 	I.fdout = 1;
@@ -456,6 +467,8 @@ R_API RCons *r_cons_free() {
 	R_FREE (I.context->lastOutput);
 	I.context->lastLength = 0;
 	R_FREE (I.pager);
+	r_cons_screen_free (I.screen);
+	I.screen = NULL;
 	return NULL;
 }
 
@@ -526,6 +539,7 @@ R_API void r_cons_fill_line() {
 }
 
 R_API void r_cons_clear_line(int std_err) {
+	r_cons_screen_invalidate (I.screen);
 #if __WINDOWS__
 	if (I.ansicon) {
 		fprintf (std_err? stderr: stdout,"%s", R_CONS_CLEAR_LINE);
@@ -581,6 +595,12 @@ R_API void r_cons_reset() {
 	I.lastline = I.context->buffer;
 	cons_grep_reset (&I.context->grep);
 	CTX (pageable) = true;
+	CTX (streamed) = false;
+	CTX (grep_stream) = 0;
+	if (CTX (grep_stop)) {
+		CTX (grep_stop) = false;
+		CTX (breaked) = false;
+	}
 }
 
 R_API const char *r_cons_get_buffer() {
@@ -588,6 +608,10 @@ R_API const char *r_cons_get_buffer() {
 	return I.context->buffer_len? I.context->buffer : NULL;
 }
 
+R_API int r_cons_get_buffer_len() {
+	return I.context->buffer_len;
+}
+
 R_API void r_cons_filter() {
 	/* grep */
 	if (I.filter || I.context->grep.nstrings > 0 || I.context->grep.tokens_used || I.context->grep.less || I.context->grep.json) {
@@ -709,7 +733,80 @@ static bool lastMatters() {
 	return (I.context->buffer_len > 0) \
 		&& (CTX (lastEnabled) && !I.filter && I.context->grep.nstrings < 1 && \
 		!I.context->grep.tokens_used && !I.context->grep.less && \
-		!I.context->grep.json && !I.is_html);
+		!I.context->grep.json && !I.is_html && !CTX (streamed));
+}
+
+/* streaming is only safe when nothing needs to see the whole buffer at flush time */
+static int stream_size() {
+	return CTX (grep_stream)? CTX (grep_stream): I.stream;
+}
+
+static bool stream_enabled() {
+	if (stream_size () < 1 || I.is_interactive || I.noflush || I.null || I.is_html || I.filter) {
+		return false;
+	}
+	if (I.use_tts || I.linesleep > 0 || (I.highlight && *I.highlight) || (I.teefile && *I.teefile)) {
+		return false;
+	}
+	if (!CTX (grep_stream) && (CTX (grep.nstrings) > 0 || CTX (grep.tokens_used) || CTX (grep.less) || CTX (grep.json))) {
+		return false;
+	}
+	// r_cons_push() is used to capture the output of commands as strings
+	return r_cons_context_is_main () && r_stack_is_empty (CTX (cons_stack));
+}
+
+/* write out the complete lines of the buffer once it grows over the stream size.
+ * the last line is kept so r_cons_lastline(), r_cons_chop() and r_cons_drop() still work */
+static void stream_flush() {
+	int len = CTX (buffer_len);
+	if (len < stream_size () || !stream_enabled ()) {
+		return;
+	}
+	char *buf = CTX (buffer);
+	int cut = len;
+	while (cut > 0 && IS_WHITECHAR (buf[cut - 1])) {
+		cut--;
+	}
+	while (cut > 0 && buf[cut - 1] != '\n') {
+		cut--;
+	}
+	if (len - cut > STREAM_TAIL && !CTX (grep_stream)) {
+		// long lines (like json) are split to keep the memory usage bounded
+		cut = len - STREAM_TAIL;
+	}
+	if (cut < 1) {
+		return;
+	}
+	if (CTX (grep_stream)) {
+		bool done = false;
+		int n = r_cons_grep_stream (buf, cut, &done);
+		if (n > 0) {
+			r_cons_write (buf, n);
+		}
+		if (done && !CTX (grep_stop)) {
+			// nothing else can pass the grep, let the command stop early
+			CTX (grep_stop) = true;
+			CTX (breaked) = true;
+		}
+	} else {
+		r_cons_write (buf, cut);
+	}
+	memmove (buf, buf + cut, len - cut);
+	CTX (buffer_len) = len - cut;
+	buf[CTX (buffer_len)] = 0;
+	CTX (streamed) = true;
+}
+
+/* whether r_cons_write sends the output to the terminal */
+static bool flush_to_tty(void) {
+	if (screen_capture) {
+		return false;
+	}
+#if __UNIX__ || __CYGWIN__
+	return isatty (I.fdout > 0? I.fdout: 1);
+#else
+	return I.fdout <= 1;
+#endif
 }
 
 R_API void r_cons_flush(void) {
@@ -730,12 +827,17 @@ R_API void r_cons_flush(void) {
 		CTX (lastLength) = CTX (buffer_len);
 		memcpy (CTX (lastOutput), CTX (buffer), CTX (buffer_len));
 	} else {
+		if (CTX (streamed) && !CTX (lastMode)) {
+			// the snapshot would be partial
+			CTX (lastLength) = 0;
+		}
 		CTX (lastMode) = false;
 	}
 	r_cons_filter ();
 	if (I.is_interactive && I.fdout == 1) {
 		/* Use a pager if the output doesn't fit on the terminal window. */
 		if (CTX (pageable) && CTX (buffer) && I.pager && *I.pager && CTX (buffer_len) > 0 && r_str_char_count (CTX (buffer), '\n') >= I.rows) {
+			r_cons_screen_invalidate (I.screen);
 			I.context->buffer[I.context->buffer_len - 1] = 0;
 			if (!strcmp (I.pager, "..")) {
 				char *str = r_str_ndup (CTX (buffer), CTX (buffer_len));
@@ -757,6 +859,7 @@ R_API void r_cons_flush(void) {
 				}
 			}
 			if (lines > 0 && !r_cons_yesno ('n',"Do you want to print %d lines? (y/N)", lines)) {
+				r_cons_screen_invalidate (I.screen);
 				r_cons_reset ();
 				return;
 			}
@@ -764,6 +867,7 @@ R_API void r_cons_flush(void) {
 			char buf[64];
 			char *buflen = r_num_units (buf, I.context->buffer_len);
 			if (buflen && !r_cons_yesno ('n',"Do you want to print %s chars? (y/N)", buflen)) {
+				r_cons_screen_invalidate (I.screen);
 				r_cons_reset ();
 				return;
 			}
@@ -813,6 +917,14 @@ R_API void r_cons_flush(void) {
 		r_cons_write (I.context->buffer, I.context->buffer_len);
 	}
 
+	if (I.screen && I.context->buffer_len > 0) {
+		/* the screen can only follow what reached the terminal */
+		if (flush_to_tty ()) {
+			r_cons_screen_feed (I.screen, I.context->buffer, I.context->buffer_len);
+		} else {
+			r_cons_screen_invalidate (I.screen);
+		}
+	}
 	r_cons_reset ();
 	if (I.newline) {
 		eprintf ("\n");
@@ -820,6 +932,33 @@ R_API void r_cons_flush(void) {
 	}
 }
 
+/* write the frame through the screen, so only the cells that changed
+ * since the last frame are sent to the terminal */
+static void visual_write_damage(void) {
+	RConsScreen *s = I.screen;
+	RStrBuf *frame = r_strbuf_new (NULL);
+	int len, w, h;
+	char *diff;
+
+	if (!frame) {
+		r_cons_screen_invalidate (s);
+		r_cons_visual_write (I.context->buffer);
+		return;
+	}
+	screen_capture = frame;
+	r_cons_visual_write (I.context->buffer);
+	screen_capture = NULL;
+	w = r_cons_get_size (&h);
+	diff = r_cons_screen_diff (s, r_strbuf_get (frame), r_strbuf_length (frame), w, h, &len);
+	if (diff) {
+		r_cons_write (diff, len);
+		free (diff);
+	} else {
+		r_cons_write (r_strbuf_get (frame), r_strbuf_length (frame));
+	}
+	r_strbuf_free (frame);
+}
+
 R_API void r_cons_visual_flush() {
 	if (I.noflush) {
 		return;
@@ -829,12 +968,20 @@ R_API void r_cons_visual_flush() {
 /* TODO: this ifdef must go in the function body */
 #if __WINDOWS__ && !__CYGWIN__
 		if (I.ansicon) {
-			r_cons_visual_write (I.context->buffer);
+			if (I.screen) {
+				visual_write_damage ();
+			} else {
+				r_cons_visual_write (I.context->buffer);
+			}
 		} else {
 			r_cons_w32_print ((const ut8*)I.context->buffer, I.context->buffer_len, 1);
 		}
 #else
-		r_cons_visual_write (I.context->buffer);
+		if (I.screen) {
+			visual_write_damage ();
+		} else {
+			r_cons_visual_write (I.context->buffer);
+		}
 #endif
 	}
 	r_cons_reset ();
@@ -854,7 +1001,13 @@ R_API void r_cons_visual_flush() {
 		} else {
 			prev = r_sys_now ();
 		}
-		eprintf ("\x1b[0;%dH[%d FPS] \n", w-10, fps);
+		if (I.screen) {
+			/* the counter is not part of the frame, draw it again next time */
+			eprintf ("\x1b[0;%dH[%d FPS %d B] \n", w - 22, fps, I.screen->last_bytes);
+			r_cons_screen_damage (I.screen, w - 23, 0, 23, 2);
+		} else {
+			eprintf ("\x1b[0;%dH[%d FPS] \n", w-10, fps);
+		}
 	}
 }
 
@@ -965,6 +1118,7 @@ club:
 		}
 		I.context->buffer_len += written;
 		I.context->buffer[I.context->buffer_len] = 0;
+		stream_flush ();
 	} else {
 		r_cons_strcat (format);
 	}
@@ -1010,6 +1164,8 @@ R_API int r_cons_memcat(const char *str, int len) {
 	}
 	if (I.flush) {
 		r_cons_flush ();
+	} else {
+		stream_flush ();
 	}
 	if (I.break_word && str && len > 0) {
 		if (r_mem_mem ((const ut8*)str, len, (const ut8*)I.break_word, I.break_word_len)) {
@@ -1025,6 +1181,7 @@ R_API void r_cons_memset(char ch, int len) {
 		memset (I.context->buffer + I.context->buffer_len, ch, len);
 		I.context->buffer_len += len;
 		I.context->buffer[I.context->buffer_len] = 0;
+		stream_flush ();
 	}
 }
 
@@ -1262,6 +1419,7 @@ R_API void r_cons_invert(int set, int color) {
   rmcup: enable terminal scrolling (normal mode)
 */
 R_API void r_cons_set_cup(int enable) {
+	r_cons_screen_invalidate (I.screen);
 #if __UNIX__ || __CYGWIN__
 	const char *code = enable
 		? "\x1b[?1049h" "\x1b" "7\x1b[?47h"
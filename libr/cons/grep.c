@@ -445,12 +445,97 @@ static int cmp(const void *a, const void *b) {
 	return strcmp (a, b);
 }
 
+/* whether the nth matching line must be shown, according to the :n and :s..e ranges */
+static bool grep_show_line(RConsGrep *grep, int n) {
+	switch (grep->range_line) {
+	case 0:
+		return grep->line == n;
+	case 1:
+		return n >= grep->f_line && (grep->l_line < grep->f_line || n < grep->l_line);
+	}
+	return true;
+}
+
+/* parse the grep expression before running the command, so the streaming
+ * flush can filter the output in chunks of stream bytes while it is produced.
+ * returns false and leaves the grep unset when it needs the whole output */
+R_API bool r_cons_grep_stream_begin(const char *str, int stream) {
+	RCons *cons = r_cons_singleton ();
+	RConsGrep *grep = &cons->context->grep;
+	bool ok;
+	if (!str || !*str || stream < 1) {
+		return false;
+	}
+	parse_grep_expression (str);
+	ok = !cons->filter && !grep->json && !grep->less && grep->sort == -1 && !grep->charCounter;
+	if (ok && grep->range_line == 0) {
+		ok = grep->line >= 0;
+	} else if (ok && grep->range_line == 1) {
+		ok = grep->f_line >= 0 && grep->l_line >= 0;
+	}
+	if (!ok) {
+		R_FREE (grep->str);
+		R_FREE (grep->json_path);
+		memset (grep, 0, sizeof (RConsGrep));
+		grep->line = -1;
+		grep->sort = -1;
+		return false;
+	}
+	cons->lines = 0;
+	cons->context->grep_stream = stream;
+	return true;
+}
+
+/* filter the complete lines of buf in place and return the new length.
+ * done is set when no more lines can be shown and the producer may stop */
+R_API int r_cons_grep_stream(char *buf, int len, bool *done) {
+	RCons *cons = r_cons_singleton ();
+	RConsGrep *grep = &cons->context->grep;
+	char *in = buf, *out = buf, *end = buf + len, *p;
+	char *tline = malloc (len + 1);
+	if (!tline) {
+		return 0;
+	}
+	while (in < end && (p = memchr (in, '\n', end - in))) {
+		int l = p - in;
+		if (l > 0) {
+			memcpy (tline, in, l);
+			int tl = cons->grep_color? l: r_str_ansi_filter (tline, NULL, NULL, l);
+			int ret = (tl < 0)? 0: r_cons_grep_line (tline, tl);
+			if (ret > 0) {
+				// out never goes past in, tline holds a copy of the line
+				if (!grep->counter && grep_show_line (grep, cons->lines)) {
+					memcpy (out, tline, ret);
+					out[ret] = '\n';
+					out += ret + 1;
+				}
+				cons->lines++;
+			}
+		}
+		in = p + 1;
+	}
+	free (tline);
+	if (done) {
+		switch (grep->range_line) {
+		case 0:
+			*done = cons->lines > grep->line;
+			break;
+		case 1:
+			*done = grep->l_line >= grep->f_line && cons->lines >= grep->l_line;
+			break;
+		default:
+			*done = false;
+			break;
+		}
+	}
+	return out - buf;
+}
+
 R_API int r_cons_grepbuf(char *buf, int len) {
 	RCons *cons = r_cons_singleton ();
 	RConsGrep *grep = &cons->context->grep;
 	char *tline, *tbuf, *p, *out, *in = buf;
 	int ret, total_lines = 0, buffer_len = 0, l = 0, tl = 0;
-	bool show = false;
 	if (cons->filter) {
 		cons->context->buffer_len = 0;
 		R_FREE (cons->context->buffer);
@@ -531,7 +616,9 @@ R_API int r_cons_grepbuf(char *buf, int len) {
 		free (out);
 		return 0;
 	}
-	cons->lines = 0;
+	if (!cons->context->grep_stream) {
+		cons->lines = 0;
+	}
 	// used to count lines and change negative grep.line values
 	while ((int) (size_t) (in - buf) < len) {
 		p = strchr (in, '\n');
@@ -577,31 +664,14 @@ R_API int r_cons_grepbuf(char *buf, int len) {
 				ret = -1;
 			} else {
 				ret = r_cons_grep_line (tline, tl);
-				if (!grep->range_line) {
-					if (grep->line == cons->lines) {
-						show = true;
-					}
-				} else if (grep->range_line == 1) {
-					if (grep->f_line == cons->lines) {
-						show = true;
-					}
-					if (grep->l_line == cons->lines) {
-						show = false;
-					}
-				} else {
-					show = true;
-				}
 			}
 			if (ret > 0) {
-				if (show) {
+				if (grep_show_line (grep, cons->lines)) {
 					memcpy (out, tline, ret);
 					memcpy (out + ret, "\n", 1);
 					out += ret + 1;
 					buffer_len += ret + 1;
 				}
-				if (!grep->range_line) {
-					show = false;
-				}
 				cons->lines++;
 			} else if (ret < 0) {
 				free (tbuf);
@@ -235,6 +235,8 @@ R_API int r_cons_fgets(char *buf, int len, int argc, const char **argv) {
 #define RETURN(x) { ret=x; goto beach; }
 	RCons *cons = r_cons_singleton ();
 	int ret = 0, color = cons->pal.input && *cons->pal.input;
+	/* the line editor writes on the terminal by itself */
+	r_cons_screen_invalidate (cons->screen);
 	if (cons->echo) {
 		r_cons_set_raw (false);
 		r_cons_show_cursor (true);
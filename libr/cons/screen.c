@@ -0,0 +1,622 @@
+/* radare - LGPL - Copyright 2018 - pancake */
+
+#include <r_cons.h>
+
+/* Damage tracking for the visual modes.
+ *
+ * Every frame is run through a small terminal emulator that draws it in a
+ * grid of cells (the back buffer). The grid is compared with the one the
+ * terminal is known to show (the front buffer), and only the runs of cells
+ * that changed are written, moving the cursor as little as possible and
+ * scrolling the terminal when the contents moved up or down. When
+ * the emulator finds something it does not understand, the frame is
+ * written as is and every cell is drawn again by the next frame. */
+
+#define SCREEN_GAP 6 // unchanged cells rewritten instead of moving the cursor
+#define SCROLL_MIN 4 // lines to save to scroll the terminal instead of drawing
+#define SCREEN_MAX_PARAMS 32
+#define SCREEN_TAB 8
+#define SCREEN_UNKNOWN UT32_MAX // never matches a drawn character
+
+#define COLOR_16 (1 << 24)
+#define COLOR_256 (2 << 24)
+#define COLOR_RGB (3 << 24)
+
+typedef struct {
+	RConsScreen *s;
+	RConsCell attr; // current attributes, ch unused
+	int x, y;
+	bool pending; // the last column was written, the next char wraps
+	bool known; // the cursor position is known
+	RStrBuf *extra; // sequences that draw nothing, like cursor visibility
+} Term;
+
+typedef struct {
+	RStrBuf *sb;
+	RConsCell attr;
+	bool attr_known;
+	int x, y; // -1 when unknown
+	int w;
+} Out;
+
+static inline bool cell_eq(const RConsCell *a, const RConsCell *b) {
+	return a->ch == b->ch && a->fg == b->fg && a->bg == b->bg && a->flags == b->flags;
+}
+
+static inline bool attr_eq(const RConsCell *a, const RConsCell *b) {
+	return a->fg == b->fg && a->bg == b->bg && a->flags == b->flags;
+}
+
+R_API RConsScreen *r_cons_screen_new(void) {
+	return R_NEW0 (RConsScreen);
+}
+
+R_API void r_cons_screen_free(RConsScreen *s) {
+	if (s) {
+		free (s->front);
+		free (s->back);
+		free (s);
+	}
+}
+
+/* forget what the terminal shows in the given region, so the next frame
+ * draws it again. Used when something else wrote on the screen */
+R_API void r_cons_screen_damage(RConsScreen *s, int x, int y, int w, int h) {
+	int i, j;
+	if (!s || !s->front) {
+		return;
+	}
+	for (j = R_MAX (y, 0); j < s->h && j < y + h; j++) {
+		for (i = R_MAX (x, 0); i < s->w && i < x + w; i++) {
+			s->front[j * s->w + i].ch = SCREEN_UNKNOWN;
+		}
+	}
+}
+
+R_API void r_cons_screen_invalidate(RConsScreen *s) {
+	if (s) {
+		r_cons_screen_damage (s, 0, 0, s->w, s->h);
+	}
+}
+
+static bool screen_resize(RConsScreen *s, int w, int h) {
+	if (s->front && s->w == w && s->h == h) {
+		return true;
+	}
+	free (s->front);
+	free (s->back);
+	s->front = R_NEWS0 (RConsCell, w * h);
+	s->back = R_NEWS0 (RConsCell, w * h);
+	s->w = w;
+	s->h = h;
+	r_cons_screen_invalidate (s);
+	return s->front && s->back;
+}
+
+static void term_blank(Term *t, int from, int to) {
+	RConsCell blank = t->attr;
+	blank.ch = ' ';
+	/* only the background color is used to erase */
+	blank.fg = 0;
+	blank.flags = 0;
+	for (; from < to; from++) {
+		t->s->back[from] = blank;
+	}
+}
+
+static void term_newline(Term *t) {
+	RConsScreen *s = t->s;
+	t->pending = false;
+	t->x = 0;
+	if (++t->y >= s->h) {
+		const int n = s->w * (s->h - 1);
+		memmove (s->back, s->back + s->w, sizeof (RConsCell) * n);
+		term_blank (t, n, s->w * s->h);
+		t->y = s->h - 1;
+	}
+}
+
+static void term_put(Term *t, ut32 ch, int width) {
+	RConsScreen *s = t->s;
+	if (t->pending || t->x + width > s->w) {
+		term_newline (t);
+	}
+	RConsCell *row = s->back + t->y * s->w;
+	/* overwriting half of a wide char erases the other half */
+	if (!row[t->x].ch && t->x > 0) {
+		row[t->x - 1].ch = ' ';
+	}
+	if (t->x + width < s->w && !row[t->x + width].ch) {
+		row[t->x + width].ch = ' ';
+	}
+	row[t->x] = t->attr;
+	row[t->x].ch = ch;
+	if (width > 1) {
+		row[t->x + 1] = t->attr;
+		row[t->x + 1].ch = 0;
+	}
+	t->x += width;
+	if (t->x >= s->w) {
+		t->x = s->w - 1;
+		t->pending = true;
+	}
+}
+
+static ut32 term_color(const int *p, int n, int *i) {
+	if (*i + 2 < n && p[*i + 1] == 5) {
+		*i += 2;
+		return COLOR_256 | (p[*i] & 0xff);
+	}
+	if (*i + 4 < n && p[*i + 1] == 2) {
+		ut32 rgb = ((p[*i + 2] & 0xff) << 16) | ((p[*i + 3] & 0xff) << 8) | (p[*i + 4] & 0xff);
+		*i += 4;
+		return COLOR_RGB | rgb;
+	}
+	*i = n;
+	return 0;
+}
+
+static void term_sgr(Term *t, const int *p, int n) {
+	RConsCell *a = &t->attr;
+	int i;
+	if (!n) {
+		a->fg = a->bg = a->flags = 0;
+	}
+	for (i = 0; i < n; i++) {
+		int v = p[i];
+		if (v == 0) {
+			a->fg = a->bg = a->flags = 0;
+		} else if (v < 10) {
+			a->flags |= 1 << v;
+		} else if (v == 22) {
+			a->flags &= ~((1 << 1) | (1 << 2));
+		} else if (v > 22 && v < 30) {
+			a->flags &= ~(1 << (v - 20));
+		} else if (v >= 30 && v <= 37) {
+			a->fg = COLOR_16 | (v - 30);
+		} else if (v == 38) {
+			a->fg = term_color (p, n, &i);
+		} else if (v == 39) {
+			a->fg = 0;
+		} else if (v >= 40 && v <= 47) {
+			a->bg = COLOR_16 | (v - 40);
+		} else if (v == 48) {
+			a->bg = term_color (p, n, &i);
+		} else if (v == 49) {
+			a->bg = 0;
+		} else if (v >= 90 && v <= 97) {
+			a->fg = COLOR_16 | (v - 90 + 8);
+		} else if (v >= 100 && v <= 107) {
+			a->bg = COLOR_16 | (v - 100 + 8);
+		}
+	}
+}
+
+static void term_goto(Term *t, int x, int y) {
+	t->x = R_MAX (0, R_MIN (x, t->s->w - 1));
+	t->y = R_MAX (0, R_MIN (y, t->s->h - 1));
+	t->pending = false;
+	t->known = true;
+}
+
+/* parse the CSI sequence at p, past the "\x1b[". Returns the length of the
+ * sequence or 0 if it is not supported */
+static int term_csi(Term *t, const char *p, const char *end) {
+	RConsScreen *s = t->s;
+	int params[SCREEN_MAX_PARAMS] = {0};
+	int n = 0, v;
+	const char *q = p;
+	char private = 0;
+
+	if (q < end && strchr ("?<=>", *q)) {
+		private = *q++;
+	}
+	while (q < end && (IS_DIGIT (*q) || *q == ';' || *q == ':')) {
+		if (IS_DIGIT (*q)) {
+			if (!n) {
+				n = 1;
+			}
+			if (params[n - 1] < 100000) {
+				params[n - 1] = params[n - 1] * 10 + (*q - '0');
+			}
+		} else if (n < SCREEN_MAX_PARAMS) {
+			n = n? n + 1: 2;
+		}
+		q++;
+	}
+	while (q < end && *q >= 0x20 && *q <= 0x2f) {
+		q++;
+	}
+	if (q >= end || *q < 0x40 || *q > 0x7e) {
+		return 0;
+	}
+	const int len = q + 1 - p;
+	if (private) {
+		/* modes like the cursor visibility or the mouse, drawing nothing */
+		if (!strchr ("hlrs", *q)) {
+			return 0;
+		}
+		r_strbuf_append (t->extra, "\x1b[");
+		r_strbuf_append_n (t->extra, p, len);
+		return len;
+	}
+	v = n? params[0]: 0;
+	if (strchr ("ABCDEFGd", *q) && !t->known) {
+		return 0;
+	}
+	switch (*q) {
+	case 'm':
+		term_sgr (t, params, n);
+		break;
+	case 'H':
+	case 'f':
+		term_goto (t, (n > 1 && params[1])? params[1] - 1: 0, v? v - 1: 0);
+		break;
+	case 'A':
+		term_goto (t, t->x, t->y - R_MAX (v, 1));
+		break;
+	case 'B':
+		term_goto (t, t->x, t->y + R_MAX (v, 1));
+		break;
+	case 'C':
+		term_goto (t, t->x + R_MAX (v, 1), t->y);
+		break;
+	case 'D':
+		term_goto (t, t->x - R_MAX (v, 1), t->y);
+		break;
+	case 'E':
+		term_goto (t, 0, t->y + R_MAX (v, 1));
+		break;
+	case 'F':
+		term_goto (t, 0, t->y - R_MAX (v, 1));
+		break;
+	case 'G':
+		term_goto (t, v? v - 1: 0, t->y);
+		break;
+	case 'd':
+		term_goto (t, t->x, v? v - 1: 0);
+		break;
+	case 'J':
+		if (v == 2 || v == 3) {
+			term_blank (t, 0, s->w * s->h);
+		} else if (!t->known) {
+			return 0;
+		} else if (v == 1) {
+			term_blank (t, 0, t->y * s->w + t->x + 1);
+		} else {
+			term_blank (t, t->y * s->w + t->x, s->w * s->h);
+		}
+		break;
+	case 'K':
+		if (!t->known) {
+			return 0;
+		}
+		if (v == 1) {
+			term_blank (t, t->y * s->w, t->y * s->w + t->x + 1);
+		} else {
+			term_blank (t, t->y * s->w + (v? 0: t->x), (t->y + 1) * s->w);
+		}
+		break;
+	default:
+		return 0;
+	}
+	return len;
+}
+
+/* draw the frame in the back buffer, false if it can't be emulated */
+static bool term_run(Term *t, const char *buf, int len) {
+	const char *p = buf, *end = buf + len;
+	while (p < end) {
+		const ut8 c = *p;
+		if (c == 0x1b) {
+			if (p + 1 < end && p[1] == '[') {
+				int n = term_csi (t, p + 2, end);
+				if (!n) {
+					return false;
+				}
+				p += 2 + n;
+			} else if (p + 1 < end && p[1] == ']') {
+				/* titles and other OSC strings end with BEL or ST */
+				const char *q = p + 2;
+				while (q < end && *q != 7 && !(*q == 0x1b && q + 1 < end && q[1] == '\\')) {
+					q++;
+				}
+				if (q >= end) {
+					return false;
+				}
+				q += (*q == 7)? 1: 2;
+				r_strbuf_append_n (t->extra, p, q - p);
+				p = q;
+			} else {
+				return false;
+			}
+			continue;
+		}
+		if (c < 0x20 || c == 0x7f) {
+			switch (c) {
+			case '\n':
+				if (!t->known) {
+					return false;
+				}
+				term_newline (t);
+				break;
+			case '\r':
+				t->x = 0;
+				t->pending = false;
+				break;
+			case '\t':
+				t->x = R_MIN ((t->x / SCREEN_TAB + 1) * SCREEN_TAB, t->s->w - 1);
+				break;
+			case '\b':
+				if (t->x > 0 && !t->pending) {
+					t->x--;
+				}
+				t->pending = false;
+				break;
+			}
+			p++;
+			continue;
+		}
+		if (!t->known) {
+			return false;
+		}
+		int i, n = 1;
+		if (c >= 0xc0) {
+			n = (c >= 0xf0)? 4: (c >= 0xe0)? 3: 2;
+			for (i = 1; i < n; i++) {
+				if (p + i >= end || (p[i] & 0xc0) != 0x80) {
+					n = 1;
+					break;
+				}
+			}
+		}
+		ut32 ch = 0;
+		for (i = 0; i < n; i++) {
+			ch |= (ut32)(ut8)p[i] << (i * 8);
+		}
+		term_put (t, ch, (n > 1 && r_str_char_fullwidth (p, end - p))? 2: 1);
+		p += n;
+	}
+	return true;
+}
+
+static void out_attr(Out *o, const RConsCell *a) {
+	static const int colors[2][3] = {{ 30, 90, 38 }, { 40, 100, 48 }};
+	int i;
+	if (o->attr_known && attr_eq (&o->attr, a)) {
+		return;
+	}
+	r_strbuf_append (o->sb, "\x1b[0");
+	for (i = 1; i < 10; i++) {
+		if (a->flags & (1 << i)) {
+			r_strbuf_appendf (o->sb, ";%d", i);
+		}
+	}
+	for (i = 0; i < 2; i++) {
+		const ut32 col = i? a->bg: a->fg;
+		const ut32 v = col & 0xffffff;
+		switch (col & 0xff000000) {
+		case COLOR_16:
+			r_strbuf_appendf (o->sb, ";%d", (v < 8)? colors[i][0] + v: colors[i][1] + v - 8);
+			break;
+		case COLOR_256:
+			r_strbuf_appendf (o->sb, ";%d;5;%d", colors[i][2], v);
+			break;
+		case COLOR_RGB:
+			r_strbuf_appendf (o->sb, ";%d;2;%d;%d;%d", colors[i][2], v >> 16, (v >> 8) & 0xff, v & 0xff);
+			break;
+		}
+	}
+	r_strbuf_append (o->sb, "m");
+	o->attr = *a;
+	o->attr_known = true;
+}
+
+/* use the shortest way to get the cursor there */
+static void out_goto(Out *o, int x, int y) {
+	if (o->y == y && o->x == x) {
+		return;
+	}
+	if (o->y == y && o->x >= 0) {
+		if (x) {
+			r_strbuf_appendf (o->sb, "\x1b[%dG", x + 1);
+		} else {
+			r_strbuf_append (o->sb, "\r");
+		}
+	} else {
+		r_strbuf_appendf (o->sb, "\x1b[%d;%dH", y + 1, x + 1);
+	}
+	o->x = x;
+	o->y = y;
+}
+
+static void out_cell(Out *o, const RConsCell *c, int w) {
+	char ch[4];
+	int i;
+	out_attr (o, c);
+	for (i = 0; i < 4 && (c->ch >> (i * 8)) & 0xff; i++) {
+		ch[i] = (c->ch >> (i * 8)) & 0xff;
+	}
+	r_strbuf_append_n (o->sb, ch, i);
+	o->x += w;
+	if (o->x >= o->w) {
+		/* the cursor stays in the last column until the next char */
+		o->x = -1;
+	}
+}
+
+static ut64 row_hash(const RConsCell *row, int w) {
+	ut64 h = 0xcbf29ce484222325ULL;
+	int i;
+	for (i = 0; i < w; i++) {
+		h = (h ^ row[i].ch) * 0x100000001b3ULL;
+		h = (h ^ row[i].fg ^ ((ut64)row[i].bg << 32) ^ row[i].flags) * 0x100000001b3ULL;
+	}
+	return h;
+}
+
+static int shift_matches(const RConsScreen *s, const ut64 *hb, const ut64 *hf, int k) {
+	int y, n = 0;
+	for (y = R_MAX (0, -k); y < s->h && y + k < s->h; y++) {
+		if (hb[y] == hf[y + k] && !memcmp (s->back + y * s->w, s->front + (y + k) * s->w, sizeof (RConsCell) * s->w)) {
+			n++;
+		}
+	}
+	return n;
+}
+
+/* when the frame is the last one moved up or down some lines, scroll the
+ * terminal and the front buffer, so only the new lines are written */
+static void out_scroll(Out *o, RConsScreen *s) {
+	RConsCell blank = { .ch = ' ' };
+	ut64 *hb = R_NEWS (ut64, s->h);
+	ut64 *hf = R_NEWS (ut64, s->h);
+	int i, k, best = 0, best_n;
+
+	if (!hb || !hf) {
+		goto beach;
+	}
+	for (i = 0; i < s->h; i++) {
+		hb[i] = row_hash (s->back + i * s->w, s->w);
+		hf[i] = row_hash (s->front + i * s->w, s->w);
+	}
+	best_n = shift_matches (s, hb, hf, 0) + SCROLL_MIN;
+	for (k = 1; k < s->h / 2; k++) {
+		int up = shift_matches (s, hb, hf, k);
+		int down = shift_matches (s, hb, hf, -k);
+		if (up > best_n) {
+			best = k;
+			best_n = up;
+		}
+		if (down > best_n) {
+			best = -k;
+			best_n = down;
+		}
+	}
+	if (!best) {
+		goto beach;
+	}
+	/* the lines scrolled in are blanked with the current background */
+	out_attr (o, &blank);
+	k = R_ABS (best);
+	r_strbuf_appendf (o->sb, "\x1b[%d%c", k, (best > 0)? 'S': 'T');
+	if (best > 0) {
+		memmove (s->front, s->front + k * s->w, sizeof (RConsCell) * s->w * (s->h - k));
+		i = s->h - k;
+	} else {
+		memmove (s->front + k * s->w, s->front, sizeof (RConsCell) * s->w * (s->h - k));
+		i = 0;
+	}
+	for (k = i * s->w; k < (i + R_ABS (best)) * s->w; k++) {
+		s->front[k] = blank;
+	}
+beach:
+	free (hb);
+	free (hf);
+}
+
+static void out_row(Out *o, const RConsScreen *s, int y) {
+	const RConsCell *back = s->back + y * s->w;
+	const RConsCell *front = s->front + y * s->w;
+	int x = 0;
+	while (x < s->w) {
+		if (cell_eq (&back[x], &front[x])) {
+			x++;
+			continue;
+		}
+		int start = x, end = x + 1, gap = 0, j;
+		if (!back[start].ch && start > 0) {
+			start--;
+		}
+		for (j = x + 1; j < s->w && gap <= SCREEN_GAP && back[j].ch != SCREEN_UNKNOWN; j++) {
+			if (cell_eq (&back[j], &front[j])) {
+				gap++;
+			} else {
+				end = j + 1;
+				gap = 0;
+			}
+		}
+		out_goto (o, start, y);
+		for (j = start; j < end; j++) {
+			if (back[j].ch) {
+				const int w = (j + 1 < s->w && !back[j + 1].ch)? 2: 1;
+				out_cell (o, &back[j], w);
+			}
+		}
+		x = end;
+	}
+}
+
+/* follow the output written to the terminal without going through the
+ * screen, so the next frame only draws what it changed */
+R_API void r_cons_screen_feed(RConsScreen *s, const char *buf, int len) {
+	r_return_if_fail (s && buf);
+	Term t = { .s = s };
+	if (!s->front) {
+		return;
+	}
+	t.extra = r_strbuf_new (NULL);
+	memcpy (s->back, s->front, sizeof (RConsCell) * s->w * s->h);
+	if (t.extra && term_run (&t, buf, len)) {
+		memcpy (s->front, s->back, sizeof (RConsCell) * s->w * s->h);
+	} else {
+		r_cons_screen_invalidate (s);
+	}
+	r_strbuf_free (t.extra);
+}
+
+/* returns the sequence to update the terminal to show the frame in buf,
+ * which is what r_cons_visual_write would have written, or NULL when the
+ * frame must be written as is. olen is set to the length to write. Cells
+ * the frame leaves untouched and the terminal state is unknown for are
+ * never written */
+R_API char *r_cons_screen_diff(RConsScreen *s, const char *buf, int len, int w, int h, int *olen) {
+	r_return_val_if_fail (s && buf && olen, NULL);
+	Term t = { .s = s };
+	Out o = { .x = -1, .y = -1 };
+	char *res = NULL;
+	int y;
+
+	*olen = len;
+	s->frames++;
+	if (w < 1 || h < 1 || !screen_resize (s, w, h)) {
+		goto beach;
+	}
+	t.extra = r_strbuf_new (NULL);
+	o.sb = r_strbuf_new (NULL);
+	o.w = w;
+	if (!t.extra || !o.sb) {
+		r_cons_screen_invalidate (s);
+		goto beach;
+	}
+	memcpy (s->back, s->front, sizeof (RConsCell) * w * h);
+	if (!term_run (&t, buf, len)) {
+		r_cons_screen_invalidate (s);
+		goto beach;
+	}
+	r_strbuf_append (o.sb, r_strbuf_get (t.extra));
+	out_scroll (&o, s);
+	for (y = 0; y < h; y++) {
+		out_row (&o, s, y);
+	}
+	/* leave the cursor and the attributes like the frame does, writing
+	 * the last column again if the next char wraps */
+	if (t.pending) {
+		const int x = (!s->back[t.y * w + t.x].ch && t.x > 0)? t.x - 1: t.x;
+		out_goto (&o, x, t.y);
+		out_cell (&o, &s->back[t.y * w + x], t.x - x + 1);
+	} else {
+		out_goto (&o, t.x, t.y);
+	}
+	out_attr (&o, &t.attr);
+	memcpy (s->front, s->back, sizeof (RConsCell) * w * h);
+	*olen = r_strbuf_length (o.sb);
+	res = r_strbuf_drain (o.sb);
+	o.sb = NULL;
+beach:
+	r_strbuf_free (t.extra);
+	r_strbuf_free (o.sb);
+	s->last_bytes = *olen;
+	s->bytes += *olen;
+	return res;
+}
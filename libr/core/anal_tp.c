@@ -37,16 +37,73 @@ static void r_anal_emul_restore(RCore *core, RConfigHold *hc) {
 	r_config_hold_free (hc);
 }
 
-#define SDB_CONTAINS(i,s) sdb_array_contains (trace, sdb_fmt ("%d.reg.write", i), s, 0)
+/* first event of the given type (and register) recorded at step idx,
+ * only valid until the next query */
+static const RTraceLogEvent *trace_event(RTraceLog *trace, int idx, int type, const char *reg) {
+	RTraceLogStep st;
+	int i;
+	if (!trace || idx < 0 || !r_tracelog_get (trace, idx, &st)) {
+		return NULL;
+	}
+	for (i = 0; i < st.count; i++) {
+		const RTraceLogEvent *ev = &st.events[i];
+		if (ev->type == type && (!reg || (ev->reg && !strcmp (ev->reg, reg)))) {
+			return ev;
+		}
+	}
+	return NULL;
+}
+
+static ut64 trace_addr(RTraceLog *trace, int idx) {
+	RTraceLogStep st;
+	if (!trace || idx < 0 || !r_tracelog_get (trace, idx, &st)) {
+		return 0;
+	}
+	return st.pc;
+}
+
+static int trace_last(RTraceLog *trace) {
+	return trace? (int)r_tracelog_count (trace) - 1: -1;
+}
 
-static bool type_pos_hit(RAnal *anal, Sdb *trace, bool in_stack, int idx, int size, const char *place) {
+/* comma separated list of the registers written at step idx */
+static const char *trace_dest(RTraceLog *trace, int idx, char *buf, size_t len) {
+	RTraceLogStep st;
+	int i;
+	*buf = 0;
+	if (!trace || idx < 0 || !r_tracelog_get (trace, idx, &st)) {
+		return NULL;
+	}
+	for (i = 0; i < st.count; i++) {
+		const RTraceLogEvent *ev = &st.events[i];
+		int j;
+		if (ev->type != R_TRACELOG_REG_WRITE) {
+			continue;
+		}
+		for (j = 0; j < i; j++) {
+			if (st.events[j].type == R_TRACELOG_REG_WRITE && !strcmp (st.events[j].reg, ev->reg)) {
+				break;
+			}
+		}
+		if (j == i) {
+			size_t cur = strlen (buf);
+			snprintf (buf + cur, len - cur, "%s%s", cur? ",": "", ev->reg);
+		}
+	}
+	return *buf? buf: NULL;
+}
+
+#define TRACE_CONTAINS(i,s) (trace_event (trace, i, R_TRACELOG_REG_WRITE, s) != NULL)
+
+static bool type_pos_hit(RAnal *anal, RTraceLog *trace, bool in_stack, int idx, int size, const char *place) {
 	if (in_stack) {
 		const char *sp_name = r_reg_get_name (anal->reg, R_REG_NAME_SP);
 		ut64 sp = r_reg_getv (anal->reg, sp_name);
-		ut64 write_addr = sdb_num_get (trace, sdb_fmt ("%d.mem.write", idx), 0);
+		const RTraceLogEvent *ev = trace_event (trace, idx, R_TRACELOG_MEM_WRITE, NULL);
+		ut64 write_addr = ev? ev->addr: 0;
 		return (write_addr == sp + size);
 	} else {
-		return SDB_CONTAINS (idx, place);
+		return TRACE_CONTAINS (idx, place);
 	}
 }
 
@@ -151,12 +208,12 @@ static void get_src_regname(RCore *core, ut64 addr, char *regname, int size) {
 	r_anal_op_free (op);
 }
 
-static ut64 get_addr(Sdb *trace, const char *regname, int idx) {
+static ut64 get_addr(RTraceLog *trace, const char *regname, int idx) {
 	if (!regname || !*regname) {
 		return UT64_MAX;
 	}
-	const char *query = sdb_fmt ("%d.reg.read.%s", idx, regname);
-	return r_num_math (NULL, sdb_const_get (trace, query, 0));
+	const RTraceLogEvent *ev = trace_event (trace, idx, R_TRACELOG_REG_READ, regname);
+	return ev? ev->value: 0;
 }
 
 static int cond_invert (int cond) {
@@ -265,11 +322,11 @@ static RList *parse_format(RCore *core, char *fmt) {
 
 static void type_match(RCore *core, ut64 addr, char *fcn_name, ut64 baddr, const char* cc,
 		int prev_idx, bool userfnc, ut64 caddr) {
-	Sdb *trace = core->anal->esil->db_trace;
+	RTraceLog *trace = core->anal->esil->trace_log;
 	Sdb *TDB = core->anal->sdb_types;
 	RAnal *anal = core->anal;
 	RList *types = NULL;
-	int idx = sdb_num_get (trace, "idx", 0);
+	int idx = trace_last (trace);
 	bool verbose = r_config_get_i (core->config, "anal.types.verbose");
 	bool stack_rev = false, in_stack = false, format = false;
 
@@ -323,7 +380,7 @@ static void type_match(RCore *core, ut64 addr, char *fcn_name, ut64 baddr, const
 		bool res = false;
 		// Backtrace instruction from source sink to prev source sink
 		for (j = idx; j >= prev_idx; j--) {
-			ut64 instr_addr = sdb_num_get (trace, sdb_fmt ("%d.addr", j), 0);
+			ut64 instr_addr = trace_addr (trace, j);
 			if (instr_addr < baddr) {
 				break;
 			}
@@ -346,8 +403,7 @@ static void type_match(RCore *core, ut64 addr, char *fcn_name, ut64 baddr, const
 			} else {
 				key = sdb_fmt ("fcn.0x%08"PFMT64x".arg.%d", caddr, size);
 			}
-			const char *query = sdb_fmt ("%d.mem.read", j);
-			if (op->type == R_ANAL_OP_TYPE_MOV && sdb_const_get (trace, query, 0)) {
+			if (op->type == R_ANAL_OP_TYPE_MOV && trace_event (trace, j, R_TRACELOG_MEM_READ, NULL)) {
 				memref = (!memref && var && (var->kind != R_ANAL_VAR_KIND_REG))? false: true;
 			}
 			// Match type from function param to instr
@@ -380,7 +436,7 @@ static void type_match(RCore *core, ut64 addr, char *fcn_name, ut64 baddr, const
 				}
 			}
 			// Type propagate by following source reg
-			if (!res && *regname && SDB_CONTAINS (j, regname)) {
+			if (!res && *regname && TRACE_CONTAINS (j, regname)) {
 				if (var) {
 					if (!userfnc) {
 						var_retype (anal, var, name, type, addr, memref, false);
@@ -459,8 +515,10 @@ R_API void r_core_anal_type_match(RCore *core, RAnalFunction *fcn) {
 	bool prop = false;
 	bool prev_var = false;
 	char prev_type[256] = {0};
+	char prev_dest_buf[64], ret_reg_buf[64];
 	const char *prev_dest = NULL;
 	const char *ret_reg = NULL;
+	Sdb *loops = sdb_new0 ();
 	const char *pc = r_reg_get_name (core->dbg->reg, R_REG_NAME_PC);
 	RRegItem *r = r_reg_get (core->dbg->reg, pc, -1);
 	r_cons_break_push (NULL, NULL);
@@ -489,20 +547,20 @@ R_API void r_core_anal_type_match(RCore *core, RAnalFunction *fcn) {
 				r_anal_op_fini (&aop);
 				continue;
 			}
-			int loop_count = sdb_num_get (anal->esil->db_trace, sdb_fmt ("0x%"PFMT64x".count", addr), 0);
+			int loop_count = sdb_num_get (loops, sdb_fmt ("0x%"PFMT64x".count", addr), 0);
 			if (loop_count > LOOP_MAX || aop.type == R_ANAL_OP_TYPE_RET) {
 				r_anal_op_fini (&aop);
 				break;
 			}
-			sdb_num_set (anal->esil->db_trace, sdb_fmt ("0x%"PFMT64x".count", addr), loop_count + 1, 0);
+			sdb_num_set (loops, sdb_fmt ("0x%"PFMT64x".count", addr), loop_count + 1, 0);
 			if (r_anal_op_nonlinear (aop.type)) {   // skip the instr
 				r_reg_set_value (core->dbg->reg, r, addr + ret);
 			} else {
 				r_core_esil_step (core, UT64_MAX, NULL, NULL);
 			}
 			bool userfnc = false;
-			Sdb *trace = anal->esil->db_trace;
-			cur_idx = sdb_num_get (trace, "idx", 0);
+			RTraceLog *trace = anal->esil->trace_log;
+			cur_idx = trace_last (trace);
 			RAnalVar *var = aop.var;
 			RAnalOp *next_op = r_core_anal_op (core, addr + ret, R_ANAL_OP_MASK_BASIC);
 			ut32 type = aop.type & R_ANAL_OP_TYPE_MASK;
@@ -528,8 +586,7 @@ R_API void r_core_anal_type_match(RCore *core, RAnalFunction *fcn) {
 						resolved = false;
 					}
 					if (!strcmp (fcn_name, "__stack_chk_fail")) {
-						const char *query = sdb_fmt ("%d.addr", cur_idx - 1);
-						ut64 mov_addr = sdb_num_get (trace, query, 0);
+						ut64 mov_addr = trace_addr (trace, cur_idx - 1);
 						RAnalOp *mop = r_core_anal_op (core, mov_addr, R_ANAL_OP_MASK_BASIC);
 						if (mop && mop->var) {
 							ut32 type = mop->type & R_ANAL_OP_TYPE_MASK;
@@ -544,15 +601,19 @@ R_API void r_core_anal_type_match(RCore *core, RAnalFunction *fcn) {
 			} else if (!resolved && ret_type && ret_reg) {
 				// Forward propgation of function return type
 				char src[REG_SZ] = {0};
-				const char *query = sdb_fmt ("%d.reg.write", cur_idx);
-				const char *cur_dest = sdb_const_get (trace, query, 0);
+				char dest_buf[64];
+				const char *cur_dest = trace_dest (trace, cur_idx, dest_buf, sizeof (dest_buf));
 				get_src_regname (core, aop.addr, src, sizeof (src));
 				if (ret_reg && *src && strstr (ret_reg, src)) {
 					if (var && aop.direction == R_ANAL_OP_DIR_WRITE) {
 						var_retype (anal, var, NULL, ret_type, addr, false, false);
 						resolved = true;
 					} else if (type == R_ANAL_OP_TYPE_MOV) {
-						ret_reg = cur_dest;
+						ret_reg = NULL;
+						if (cur_dest) {
+							r_str_ncpy (ret_reg_buf, cur_dest, sizeof (ret_reg_buf));
+							ret_reg = ret_reg_buf;
+						}
 					}
 				} else if (cur_dest) {
 					char *foo = r_str_new (cur_dest);
@@ -655,8 +716,7 @@ R_API void r_core_anal_type_match(RCore *core, RAnalFunction *fcn) {
 				if (var && str_flag) {
 					var_retype (anal, var, NULL, "const char *", addr, false, false);
 				}
-				const char *query = sdb_fmt ("%d.reg.write", cur_idx);
-				prev_dest = sdb_const_get (trace, query, 0);
+				prev_dest = trace_dest (trace, cur_idx, prev_dest_buf, sizeof (prev_dest_buf));
 				if (var) {
 					strncpy (prev_type, var->type, sizeof (prev_type) - 1);
 					prop = true;
@@ -726,5 +786,6 @@ out_function:
 	free (buf);
 	r_cons_break_pop();
 	r_anal_emul_restore (core, hc);
-	sdb_reset (anal->esil->db_trace);
+	r_anal_esil_trace_reset (anal->esil);
+	sdb_free (loops);
 }
@@ -1480,7 +1480,7 @@ R_API int r_core_anal_bb(RCore *core, RAnalFunction *fcn, ut64 at, int head) {
 			if (bblen == R_ANAL_RET_END) { /* bb analysis complete */
 				ret = r_anal_fcn_bb_overlaps (fcn, bb);
 				if (ret == R_ANAL_RET_NEW) {
-					r_anal_fcn_bbadd (fcn, bb);
+					r_anal_fcn_bbadd_in (core->anal, fcn, bb);
 					fail = bb->fail;
 					jump = bb->jump;
 					if (fail != -1) {
@@ -3736,12 +3736,14 @@ R_API void r_core_anal_fcn_merge(RCore *core, ut64 addr, ut64 addr2) {
 				max = bb->addr + bb->size;
 			}
 		}
-		r_anal_fcn_bbadd (f1, bb);
+		r_anal_fcn_bbadd_in (core->anal, f1, bb);
 	}
 	// TODO: import data/code/refs
-	// update size
+	// update size, the fcn_tree is keyed by the address too
+	r_anal_fcn_tree_delete (&core->anal->fcn_tree, f1);
 	f1->addr = R_MIN (addr, addr2);
-	r_anal_fcn_set_size (core->anal, f1, max - min);
+	r_anal_fcn_set_size (NULL, f1, max - min);
+	r_anal_fcn_tree_insert (&core->anal->fcn_tree, f1);
 	// resize
 	f2->bbs = NULL;
 	r_anal_fcn_tree_delete (&core->anal->fcn_tree, f2);
@@ -68,6 +68,13 @@ static int compareDist(const RAnalFunction *a, const RAnalFunction *b) {
 	return a && b && a->diff->dist && b->diff->dist && a->diff->dist > b->diff->dist;
 }
 
+static int cb_diff_lsh(void *user, void *data) {
+	RCore *core = (RCore*) user;
+	RConfigNode *node = (RConfigNode*) data;
+	core->anal->diff_lsh = node->i_value;
+	return true;
+}
+
 static int cb_diff_sort(void *_core, void *_node) {
 	RConfigNode *node = _node;
 	const char *column = node->value;
@@ -1671,6 +1678,18 @@ static int cb_fps(void *user, void *data) {
 	return true;
 }
 
+static int cb_scrdamage(void *user, void *data) {
+	RConfigNode *node = (RConfigNode *) data;
+	RCons *cons = r_cons_singleton ();
+	if (node->i_value && !cons->screen) {
+		cons->screen = r_cons_screen_new ();
+	} else if (!node->i_value && cons->screen) {
+		r_cons_screen_free (cons->screen);
+		cons->screen = NULL;
+	}
+	return true;
+}
+
 static int cb_scrbreakword(void* user, void* data) {
 	RConfigNode *node = (RConfigNode*) data;
 	if (*node->value) {
@@ -1731,6 +1750,12 @@ static int cb_scrlinesleep(void *user, void *data) {
 	return true;
 }
 
+static int cb_scrstream(void *user, void *data) {
+	RConfigNode *node = (RConfigNode *) data;
+	r_cons_singleton ()->stream = node->i_value;
+	return true;
+}
+
 static int cb_scrpagesize(void *user, void *data) {
 	RConfigNode *node = (RConfigNode *) data;
 	r_cons_singleton ()->pagesize= node->i_value;
@@ -2740,6 +2765,7 @@ R_API int r_core_config_init(RCore *core) {
 	SETI ("diff.to", 0, "Set destination diffing address for px (uses cc command)");
 	SETPREF ("diff.bare", "false", "Never show function names in diff output");
 	SETPREF ("diff.levenstein", "false", "Use faster (and buggy) levenstein algorithm for buffer distance diffing");
+	SETCB ("diff.lsh", "false", &cb_diff_lsh, "Only score functions sharing a MinHash band on big diffs (faster, results may differ)");
 
 	/* dir */
 	SETI ("dir.depth", 10,  "Maximum depth when searching recursively for files");
@@ -2906,6 +2932,7 @@ R_API int r_core_config_init(RCore *core) {
 	SETPREF ("http.ui", "m", "Default webui (enyo, m, p, t)");
 	SETPREF ("http.sandbox", "true", "Sandbox the HTTP server");
 	SETI ("http.timeout", 3, "Disconnect clients after N seconds of inactivity");
+	SETI ("http.workers", 4, "Number of threads accepting and parsing requests (0 = serve one client at a time)");
 	SETI ("http.dietime", 0, "Kill server after N seconds with no client");
 	SETPREF ("http.verbose", "true", "Output server logs to stdout");
 	SETPREF ("http.upget", "false", "/up/ answers GET requests, in addition to POST");
@@ -2934,6 +2961,7 @@ R_API int r_core_config_init(RCore *core) {
 	SETI ("graph.from", UT64_MAX, "Lower bound address when drawing global graphs");
 	SETI ("graph.to", UT64_MAX, "Upper bound address when drawing global graphs");
 	SETI ("graph.scroll", 5, "Scroll speed in ascii-art graph");
+	SETI ("graph.lazy", 512, "Render the nodes of graphs with more basic blocks than this only when they get in view (0 to disable)");
 	SETPREF ("graph.invscroll", "false", "Invert scroll direction in ascii-art graph");
 	SETPREF ("graph.title", "", "Title of the graph");
 	SETPREF ("graph.gv.node", "", "Graphviz node style. (color=gray, style=filled shape=box)");
@@ -2966,6 +2994,7 @@ R_API int r_core_config_init(RCore *core) {
 	SETICB ("scr.linesleep", 0, &cb_scrlinesleep, "Flush sleeping some ms in every line");
 	SETICB ("scr.pagesize", 1, &cb_scrpagesize, "Flush in pages when scr.linesleep is != 0");
 	SETCB ("scr.flush", "false", &cb_scrflush, "Force flush to console in realtime (breaks scripting)");
+	SETICB ("scr.stream", 65536, &cb_scrstream, "Flush non-interactive output in chunks of N bytes (0 = buffer everything)");
 	/* TODO: rename to asm.color.ops ? */
 	SETPREF ("scr.zoneflags", "true", "Show zoneflags in visual mode before the title (see fz?)");
 	SETPREF ("scr.slow", "true", "Do slow stuff on visual mode like RFlag.get_at(true)");
@@ -2992,6 +3021,8 @@ R_API int r_core_config_init(RCore *core) {
 	SETCB ("scr.rows", "0", &cb_scrrows, "Force console row count (height) ");
 	SETICB ("scr.rows", 0, &cb_rows, "Force console row count (height) (duplicate?)");
 	SETCB ("scr.fps", "false", &cb_fps, "Show FPS in Visual");
+	SETCB ("scr.damage", "false", &cb_scrdamage, "Only write the screen cells that changed between frames in Visual");
+	SETPREF ("scr.cache", "true", "Reuse the disassembly lines printed by previous frames in Visual");
 	SETICB ("scr.fix.rows", 0, &cb_fixrows, "Workaround for Linux TTY");
 	SETICB ("scr.fix.columns", 0, &cb_fixcolumns, "Workaround for Prompt iOS SSH client");
 	SETCB ("scr.highlight", "", &cb_scrhighlight, "Highlight that word at RCons level");
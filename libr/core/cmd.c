@@ -2020,6 +2020,20 @@ static bool set_tmp_bits(RCore *core, int bits, char **tmpbits) {
 	return true;
 }
 
+/* filter the output of the command while it is streamed instead of grepping
+ * the whole buffer at the end. only for the first command of a toplevel line,
+ * because the grep also applies to the output of the previous ones */
+static void cmd_grep_stream(RCore *core, const char *grep) {
+	RConsContext *ctx = core->cons->context;
+	if (!grep || core->cons->is_interactive || core->max_cmd_depth - core->cmd_depth != 1) {
+		return;
+	}
+	if (ctx->buffer_len > 0 || ctx->streamed || ctx->grep_stream || !r_stack_is_empty (ctx->cons_stack)) {
+		return;
+	}
+	r_cons_grep_stream_begin (grep, r_config_get_i (core->config, "scr.stream"));
+}
+
 static int r_core_cmd_subst_i(RCore *core, char *cmd, char *colon, bool *tmpseek) {
 	RList *tmpenvs = r_list_newf (tmpenvs_free);
 	const char *quotestr = "`";
@@ -2869,6 +2883,7 @@ next_arroba:
 				}
 				tmpseek = true;
 			}
+			cmd_grep_stream (core, grep);
 			if (usemyblock) {
 				if (addr_is_set) {
 					core->offset = addr;
@@ -2925,6 +2940,7 @@ next_arroba:
 		goto beach;
 	}
 fuji:
+	cmd_grep_stream (core, grep);
 	rc = cmd? r_cmd_call (core->rcmd, r_str_trim_head (cmd)): false;
 beach:
 	r_cons_grep_process (grep);
@@ -3646,7 +3662,13 @@ R_API int r_core_cmd(RCore *core, const char *cstr, int log) {
 		if (ptr) {
 			*ptr = '\0';
 		}
+		// grep is applied to the whole output of the line, see cmd_grep_stream()
+		int ostream = core->cons->stream;
+		if (strchr (rcmd, '~')) {
+			core->cons->stream = 0;
+		}
 		ret = r_core_cmd_subst (core, rcmd);
+		core->cons->stream = ostream;
 		if (ret == -1) {
 			eprintf ("|ERROR| Invalid command '%s' (0x%02x)\n", rcmd, *rcmd);
 			break;
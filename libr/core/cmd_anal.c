@@ -290,6 +290,7 @@ static const char *help_msg_afl[] = {
 	"Usage:", "afl", " List all functions",
 	"afl", "", "list functions",
 	"afl+", "", "display sum all function sizes",
+	"afl.", "", "list functions owning the current offset",
 	"aflc", "", "count of functions",
 	"aflj", "", "list functions in json",
 	"afll", "", "list functions in verbose mode",
@@ -2373,6 +2374,17 @@ static int cmd_anal_fcn(RCore *core, const char *input) {
 		case 'c': // "aflc"
 			r_cons_printf ("%d\n", r_list_length (core->anal->fcns));
 			break;
+		case '.': // "afl."
+			{
+			RList *fcns = r_anal_get_functions_in (core->anal, core->offset);
+			RListIter *iter;
+			RAnalFunction *f;
+			r_list_foreach (fcns, iter, f) {
+				r_cons_printf ("0x%08"PFMT64x"  %s\n", f->addr, f->name);
+			}
+			r_list_free (fcns);
+			}
+			break;
 		default: // "afl "
 			r_core_anal_fcn_list (core, NULL, "o");
 			break;
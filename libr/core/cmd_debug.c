@@ -420,18 +420,27 @@ static const char *help_msg_dt[] = {
 	"dt-", "", "Reset traces (instruction/calls)",
 	"dtD", "", "Show dwarf trace (at*|rsc dwarf-traces $FILE)",
 	"dta", " 0x804020 ...", "Only trace given addresses",
+	"dtb", " [addr]", "Trace by basic blocks until addr and fill the step log",
 	"dtc[?][addr]|([from] [to] [addr])", "", "Trace call/ret",
 	"dtd", "", "List all traced disassembled",
 	"dte", "[?]", "Show esil trace logs",
 	"dtg", "", "Graph call/ret trace",
 	"dtg*", "", "Graph in agn/age commands. use .dtg*;aggi for visual",
 	"dtgi", "", "Interactive debug trace",
+	"dtl", "[?]", "Step log of the traced instructions",
 	"dtr", "", "Show traces as range commands (ar+)",
 	"dts", "[?]", "Trace sessions",
 	"dtt", " [tag]", "Select trace tag (no arg unsets)",
 	NULL
 };
 
+static const char *help_msg_dtb[] = {
+	"Usage:", "dtb", " Trace by basic blocks",
+	"dtb", "", "Trace by basic blocks until the process stops",
+	"dtb", " [addr]", "Trace by basic blocks until addr and fill the step log",
+	NULL
+};
+
 static const char *help_msg_dte[] = {
 	"Usage:", "dte", " Show esil trace logs",
 	"dte", "", "Esil trace log for a single instruction",
@@ -442,6 +451,16 @@ static const char *help_msg_dte[] = {
 	NULL
 };
 
+static const char *help_msg_dtl[] = {
+	"Usage:", "dtl", " Step log of the traced instructions",
+	"dtl", "", "Show number of steps and size of the log",
+	"dtl", " [step]", "Show the address executed at the given step",
+	"dtla", " [addr]", "List the steps that executed the given address",
+	"dtlo", " [file]", "Load the step log from a file",
+	"dtlw", " [file]", "Save the step log to a file",
+	NULL
+};
+
 static const char *help_msg_dts[] = {
 	"Usage:", "dts[*]", "",
 	"dts", "", "List all trace sessions",
@@ -513,6 +532,7 @@ static void cmd_debug_init(RCore *core) {
 	DEFINE_CMD_DESCRIPTOR (core, ds);
 	DEFINE_CMD_DESCRIPTOR (core, dt);
 	DEFINE_CMD_DESCRIPTOR (core, dte);
+	DEFINE_CMD_DESCRIPTOR (core, dtl);
 	DEFINE_CMD_DESCRIPTOR (core, dts);
 	DEFINE_CMD_DESCRIPTOR (core, dx);
 }
@@ -3563,7 +3583,7 @@ static void debug_trace_calls(RCore *core, const char *input) {
 	ut64 from = 0, to = UT64_MAX, final_addr = UT64_MAX;
 
 	if (r_debug_is_dead (core->dbg)) {
-		eprintf ("No process to debug.");
+		eprintf ("No process to debug.\n");
 		return;
 	}
 	if (*input == ' ') {
@@ -3603,6 +3623,22 @@ static void debug_trace_calls(RCore *core, const char *input) {
 	r_cons_break_pop ();
 }
 
+static void debug_trace_blocks(RCore *core, const char *input) {
+	ut64 until = UT64_MAX;
+	if (r_debug_is_dead (core->dbg)) {
+		eprintf ("No process to debug.\n");
+		return;
+	}
+	if (*input == ' ') {
+		until = r_num_math (core->num, input + 1);
+	}
+	r_cons_break_push (static_debug_stop, core->dbg);
+	int blocks = r_debug_trace_blocks (core->dbg, until);
+	r_cons_break_pop ();
+	ut64 steps = r_debug_trace_blocks_expand (core->dbg);
+	eprintf ("%d blocks, %"PFMT64d" instructions\n", blocks, steps);
+}
+
 static void r_core_debug_esil (RCore *core, const char *input) {
 	switch (input[0]) {
 	case '\0': // "de"
@@ -4286,6 +4322,55 @@ static void consumeBuffer(RBuffer *buf, const char *cmd, const char *errmsg) {
 	r_cons_printf ("\n");
 }
 
+static void debug_trace_log(RCore *core, const char *input) {
+	RTraceLog *log = core->dbg->trace->log;
+	RTraceLogStep st;
+	ut64 step, addr;
+	switch (*input) {
+	case '\0': // "dtl"
+		r_cons_printf ("steps %"PFMT64d"\nchunks %d\nsize %"PFMT64d"\n",
+			r_tracelog_count (log), (int)log->chunks.len, r_tracelog_size (log));
+		break;
+	case ' ': // "dtl [step]"
+		step = r_num_math (core->num, input + 1);
+		if (r_tracelog_get (log, step, &st)) {
+			r_cons_printf ("%"PFMT64d" 0x%08"PFMT64x"\n", st.step, st.pc);
+		}
+		break;
+	case 'a': // "dtla"
+		addr = input[1]? r_num_math (core->num, input + 1): core->offset;
+		for (step = 0; (step = r_tracelog_find (log, addr, step)) != UT64_MAX; step++) {
+			r_cons_printf ("%"PFMT64d"\n", step);
+		}
+		break;
+	case 'o': // "dtlo"
+		if (input[1] == ' ') {
+			RTraceLog *nlog = r_tracelog_load (r_str_trim_ro (input + 2));
+			if (nlog) {
+				r_tracelog_free (core->dbg->trace->log);
+				core->dbg->trace->log = nlog;
+			} else {
+				eprintf ("Cannot load the trace log\n");
+			}
+		} else {
+			eprintf ("Usage: dtlo [file]\n");
+		}
+		break;
+	case 'w': // "dtlw"
+		if (input[1] == ' ') {
+			if (!r_tracelog_save (log, r_str_trim_ro (input + 2))) {
+				eprintf ("Cannot save the trace log\n");
+			}
+		} else {
+			eprintf ("Usage: dtlw [file]\n");
+		}
+		break;
+	default:
+		r_core_cmd_help (core, help_msg_dtl);
+		break;
+	}
+}
+
 static int cmd_debug(void *data, const char *input) {
 	RCore *core = (RCore *)data;
 	RDebugTracepoint *t;
@@ -4349,6 +4434,16 @@ static int cmd_debug(void *data, const char *input) {
 		case 'g': // "dtg"
 			dot_trace_traverse (core, core->dbg->tree, input[2]);
 			break;
+		case 'b': // "dtb"
+			if (input[2] == '?') {
+				r_core_cmd_help (core, help_msg_dtb);
+			} else {
+				debug_trace_blocks (core, input + 2);
+			}
+			break;
+		case 'l': // "dtl"
+			debug_trace_log (core, input + 2);
+			break;
 		case '-': // "dt-"
 			r_tree_reset (core->dbg->tree);
 			r_debug_trace_free (core->dbg->trace);
@@ -4412,8 +4507,7 @@ static int cmd_debug(void *data, const char *input) {
 			case '-': // "dte-"
 				if (!strcmp (input + 3, "*")) {
 					if (core->anal->esil) {
-						sdb_free (core->anal->esil->db_trace);
-						core->anal->esil->db_trace = sdb_new0 ();
+						r_anal_esil_trace_reset (core->anal->esil);
 					}
 				} else {
 					eprintf ("TODO: dte- cannot delete specific logs. Use dte-*\n");
@@ -4426,10 +4520,11 @@ static int cmd_debug(void *data, const char *input) {
 			} break;
 			case 'k': // "dtek"
 				if (input[3] == ' ') {
-					char *s = sdb_querys (core->anal->esil->db_trace,
-							NULL, 0, input + 4);
+					Sdb *db = r_anal_esil_trace_sdb (core->anal->esil);
+					char *s = sdb_querys (db, NULL, 0, input + 4);
 					r_cons_println (s);
 					free (s);
+					sdb_free (db);
 				} else {
 					eprintf ("Usage: dtek [query]\n");
 				}
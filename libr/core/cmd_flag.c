@@ -719,7 +719,7 @@ rep:
 			}
 			f = r_flag_get_i (core->flags, off);
 			if (f) {
-				f->space = core->flags->space_idx;
+				r_flag_item_set_space (core->flags, f, core->flags->space_idx);
 			} else {
 				eprintf ("Cannot find any flag at 0x%"PFMT64x".\n", off);
 			}
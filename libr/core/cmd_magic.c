@@ -194,6 +194,122 @@ seek_exit:
 	return ret;
 }
 
+#define MAGIC_SCAN_CHUNK (1024 * 1024)
+#define MAGIC_SCAN_THREADS 4
+
+typedef struct {
+	RMagicIndex *mi;
+	RMagic *ms; // scratch for the tests without literal
+	const ut8 *buf;
+	size_t len;
+	size_t size;
+	ut8 *hits;
+} MagicScan;
+
+static RThreadFunctionRet magic_scan_th(RThread *th) {
+	MagicScan *w = th->user;
+	r_magic_index_scan (w->mi, w->ms, w->buf, w->len, w->size, w->hits);
+	return R_TH_STOP;
+}
+
+/* prefilter for the database r_core_magic_at loads, NULL if unavailable */
+static RMagicIndex *r_core_magic_index(RCore *core, const char *file) {
+	RMagicIndex *mi = NULL;
+	if (file) {
+		while (*file == ' ') {
+			file++;
+		}
+	}
+	if (!file || !*file) {
+		file = r_config_get (core->config, "dir.magic");
+	}
+	RMagic *ms = r_magic_new (0);
+	if (ms && r_magic_load (ms, file) != -1) {
+		mi = r_magic_index_new (ms);
+	}
+	r_magic_free (ms);
+	return mi;
+}
+
+/* /m over [from, to): the ranges are scanned in parallel for offsets where
+ * a magic test may match and only those go through r_core_magic_at */
+static int r_core_magic_scan(RCore *core, RMagicIndex *mi, const char *file, ut64 from, ut64 to, bool json, int *hits) {
+	MagicScan w[MAGIC_SCAN_THREADS] = {{0}};
+	RThread *th[MAGIC_SCAN_THREADS] = {0};
+	int maxhits = r_config_get_i (core->config, "search.maxhits");
+	int i, nth, ret = 0, align = core->search->align;
+	size_t j, bs = core->blocksize;
+	ut64 at, curoffset = core->offset;
+	ut8 *buf = malloc (MAGIC_SCAN_CHUNK * MAGIC_SCAN_THREADS + bs);
+
+	if (!buf) {
+		return -1;
+	}
+	for (i = 0; i < MAGIC_SCAN_THREADS; i++) {
+		w[i].mi = mi;
+		w[i].ms = r_magic_new (0);
+		w[i].size = bs;
+		w[i].hits = malloc (MAGIC_SCAN_CHUNK + bs);
+		if (!w[i].ms || !w[i].hits) {
+			ret = -1;
+			goto beach;
+		}
+	}
+	for (at = from; at < to && ret != -1; at += MAGIC_SCAN_CHUNK * MAGIC_SCAN_THREADS) {
+		ut64 len = R_MIN (to - at, MAGIC_SCAN_CHUNK * MAGIC_SCAN_THREADS);
+		if (r_cons_is_breaked ()) {
+			break;
+		}
+		if (!json) {
+			eprintf ("0x%08"PFMT64x"\r", at);
+		}
+		/* every range also sees the first bytes of the next one */
+		r_io_read_at (core->io, at, buf, len + bs);
+		nth = (len + MAGIC_SCAN_CHUNK - 1) / MAGIC_SCAN_CHUNK;
+		for (i = 0; i < nth; i++) {
+			w[i].buf = buf + (size_t)i * MAGIC_SCAN_CHUNK;
+			w[i].len = len - (size_t)i * MAGIC_SCAN_CHUNK + bs;
+			w[i].len = R_MIN (w[i].len, MAGIC_SCAN_CHUNK + bs);
+			th[i] = (i > 0)? r_th_new (magic_scan_th, &w[i], 0): NULL;
+		}
+		r_magic_index_scan (w[0].mi, w[0].ms, w[0].buf, w[0].len, w[0].size, w[0].hits);
+		for (i = 1; i < nth; i++) {
+			if (th[i]) {
+				r_th_wait (th[i]);
+				r_th_free (th[i]);
+			} else {
+				r_magic_index_scan (w[i].mi, w[i].ms, w[i].buf, w[i].len, w[i].size, w[i].hits);
+			}
+		}
+		/* candidates are checked in order, one at a time */
+		for (i = 0; i < nth && ret != -1; i++) {
+			for (j = 0; j + bs < w[i].len; j++) {
+				ut64 addr = at + (ut64)i * MAGIC_SCAN_CHUNK + j;
+				if (!w[i].hits[j] || (align && addr % align)) {
+					continue;
+				}
+				if (r_cons_is_breaked () || (maxhits && *hits >= maxhits)) {
+					ret = -1;
+					break;
+				}
+				r_core_seek (core, addr, true);
+				if (r_core_magic_at (core, file, addr, 99, false, json, hits) == -1) {
+					ret = -1;
+					break;
+				}
+			}
+		}
+	}
+beach:
+	for (i = 0; i < MAGIC_SCAN_THREADS; i++) {
+		r_magic_free (w[i].ms);
+		free (w[i].hits);
+	}
+	free (buf);
+	r_core_seek (core, curoffset, true);
+	return ret;
+}
+
 static void r_core_magic(RCore *core, const char *file, int v) {
 	ut64 addr = core->offset;
 	int hits = 0;
@@ -2280,6 +2280,38 @@ static void algolist(int mode) {
 	}
 }
 
+/* "ph md5,sha1,entropy": every algorithm hashes the block in parallel */
+static bool cmd_print_ph_multi(RCore *core, const char *algo, const ut8 *block, int len) {
+	RHashJob jobs[R_HASH_NBITS] = {{0}};
+	ut64 i, algobits = r_hash_name_to_bits (algo);
+	int j, n = 0;
+
+	for (i = 1; i < R_HASH_ALL; i <<= 1) {
+		if (algobits & i) {
+			jobs[n].ctx = r_hash_new (true, i);
+			jobs[n].algobit = i;
+			jobs[n].buf = block;
+			jobs[n].len = len;
+			n++;
+		}
+	}
+	r_hash_calculate_jobs (jobs, n, R_HASH_THREADS);
+	for (j = 0; j < n; j++) {
+		RHash *ctx = jobs[j].ctx;
+		r_cons_printf ("%s: ", r_hash_name (jobs[j].algobit));
+		if (jobs[j].algobit == R_HASH_ENTROPY) {
+			r_cons_printf ("%f\n", ctx->entropy);
+		} else {
+			for (i = 0; i < jobs[j].dlen; i++) {
+				r_cons_printf ("%02x", ctx->digest[i]);
+			}
+			r_cons_newline ();
+		}
+		r_hash_free (ctx);
+	}
+	return n > 0;
+}
+
 static bool cmd_print_ph(RCore *core, const char *input) {
 	char algo[128];
 	ut32 osize = 0, len = core->blocksize;
@@ -2315,8 +2347,11 @@ static bool cmd_print_ph(RCore *core, const char *input) {
 	} else if (!ptr || !*(ptr + 1)) {
 		osize = len;
 	}
+	if (osize > 0 && strchr (algo, ',')) {
+		handled_cmd = cmd_print_ph_multi (core, algo, core->block, len);
+	}
 	/* TODO: Simplify this spaguetti monster */
-	while (osize > 0 && hash_handlers[pos].name) {
+	while (osize > 0 && !handled_cmd && hash_handlers[pos].name) {
 		if (!r_str_ccmp (hash_handlers[pos].name, input, ' ')) {
 			hash_handlers[pos].handler (core->block, len);
 			handled_cmd = true;
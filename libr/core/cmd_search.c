@@ -3043,11 +3043,18 @@ reread:
 			r_core_magic_reset (core);
 			int maxHits = r_config_get_i (core->config, "search.maxhits");
 			int hits = 0;
+			RMagicIndex *mi = r_core_magic_index (core, file);
 			r_list_foreach (param.boundaries, iter, map) {
 				if (!json) {
 					eprintf ("-- %llx %llx\n", map->itv.addr, r_itv_end (map->itv));
 				}
 				r_cons_break_push (NULL, NULL);
+				if (mi) {
+					r_core_magic_scan (core, mi, file, map->itv.addr, r_itv_end (map->itv), json, &hits);
+					r_cons_clear_line (1);
+					r_cons_break_pop ();
+					continue;
+				}
 				for (addr = map->itv.addr; addr < r_itv_end (map->itv); addr++) {
 					if (r_cons_is_breaked ()) {
 						break;
@@ -3065,6 +3072,7 @@ reread:
 				r_cons_clear_line (1);
 				r_cons_break_pop ();
 			}
+			r_magic_index_free (mi);
 			if (json) {
 				r_cons_printf ("]");
 			}
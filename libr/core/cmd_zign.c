@@ -51,10 +51,12 @@ static const char *help_msg_zf[] = {
 };
 
 static const char *help_msg_zo[] = {
-	"Usage:", "zo[zs] filename ", "# Manage zignature files (see dir.zigns)",
-	"zo ", "filename", "load zinatures from sdb file",
+	"Usage:", "zo[bzs] filename ", "# Manage zignature files (see dir.zigns)",
+	"zo", "", "list mapped zignature databases",
+	"zo ", "filename", "load zinatures from sdb file or map a zignature database",
 	"zoz ", "filename", "load zinatures from gzipped sdb file",
 	"zos ", "filename", "save zignatures to sdb file (merge if file exists)",
+	"zob ", "filename", "save zignatures to a binary database",
 	NULL
 };
 
@@ -432,8 +434,15 @@ out_case_fcn:
 
 static int cmdOpen(void *data, const char *input) {
 	RCore *core = (RCore *) data;
+	RListIter *iter;
+	RSignDb *db;
 
 	switch (*input) {
+	case '\0':
+		r_list_foreach (core->anal->zign_dbs, iter, db) {
+			r_cons_printf ("%s %d\n", db->file, db->nitems);
+		}
+		break;
 	case ' ':
 		if (input[1]) {
 			return r_sign_load (core->anal, input + 1);
@@ -446,6 +455,12 @@ static int cmdOpen(void *data, const char *input) {
 		}
 		eprintf ("usage: zos filename\n");
 		return false;
+	case 'b':
+		if (input[1] == ' ' && input[2]) {
+			return r_sign_db_save (core->anal, input + 2);
+		}
+		eprintf ("usage: zob filename\n");
+		return false;
 	case 'z':
 		if (input[1] == ' ' && input[2]) {
 			return r_sign_load_gz (core->anal, input + 2);
@@ -456,7 +471,7 @@ static int cmdOpen(void *data, const char *input) {
 		r_core_cmd_help (core, help_msg_zo);
 		break;
 	default:
-		eprintf ("usage: zo[zs] filename\n");
+		eprintf ("usage: zo[bzs] filename\n");
 		return false;
 	}
 
@@ -591,7 +606,9 @@ static int fcnMatchCB(RSignItem *it, RAnalFunction *fcn, void *user) {
 }
 
 static bool searchRange(RCore *core, ut64 from, ut64 to, bool rad, struct ctxSearchCB *ctx) {
-	ut8 *buf = malloc (core->blocksize);
+	// all the bytes zignatures are matched at once, so feed big blocks
+	int bsize = R_MAX (core->blocksize, R_MIN (R_SIGN_SEARCH_BLOCK, to - from));
+	ut8 *buf = malloc (bsize);
 	ut64 at;
 	int rlen;
 	bool retval = true;
@@ -605,12 +622,12 @@ static bool searchRange(RCore *core, ut64 from, ut64 to, bool rad, struct ctxSea
 	r_sign_search_init (core->anal, ss, minsz, searchHitCB, ctx);
 
 	r_cons_break_push (NULL, NULL);
-	for (at = from; at < to; at += core->blocksize) {
+	for (at = from; at < to; at += bsize) {
 		if (r_cons_is_breaked ()) {
 			retval = false;
 			break;
 		}
-		rlen = R_MIN (core->blocksize, to - at);
+		rlen = R_MIN (bsize, to - at);
 		if (!r_io_is_valid_offset (core->io, at, 0)) {
 			retval = false;
 			break;
@@ -674,25 +691,31 @@ static bool search(RCore *core, bool rad) {
 	// Function search
 	if (useGraph || useOffset || useRefs || useHash) {
 		eprintf ("[+] searching function metrics\n");
+		RSignIndex *idx = r_sign_index_new (core->anal);
+		if (!idx) {
+			eprintf ("error: cannot index zignatures\n");
+			return false;
+		}
 		r_cons_break_push (NULL, NULL);
 		r_list_foreach (core->anal->fcns, iter, fcni) {
 			if (r_cons_is_breaked ()) {
 				break;
 			}
 			if (useGraph) {
-				r_sign_match_graph (core->anal, fcni, mincc, fcnMatchCB, &graph_match_ctx);
+				r_sign_index_match_graph (core->anal, idx, fcni, mincc, fcnMatchCB, &graph_match_ctx);
 			}
 			if (useOffset) {
-				r_sign_match_offset (core->anal, fcni, fcnMatchCB, &offset_match_ctx);
+				r_sign_index_match_offset (core->anal, idx, fcni, fcnMatchCB, &offset_match_ctx);
 			}
 			if (useRefs) {
-				r_sign_match_refs (core->anal, fcni, fcnMatchCB, &refs_match_ctx);
+				r_sign_index_match_refs (core->anal, idx, fcni, fcnMatchCB, &refs_match_ctx);
 			}
 			if (useHash) {
-				r_sign_match_hash (core->anal, fcni, fcnMatchCB, &hash_match_ctx);
+				r_sign_index_match_hash (core->anal, idx, fcni, fcnMatchCB, &hash_match_ctx);
 			}
 		}
 		r_cons_break_pop ();
+		r_sign_index_free (idx);
 	}
 
 	if (rad) {
@@ -2198,6 +2198,122 @@ static char *get_comments_cb(void *user, ut64 addr) {
 	return r_core_anal_get_comments ((RCore *)user, addr);
 }
 
+static ut8 *frame_append(ut8 *buf, int *len, const void *data, int n) {
+	ut8 *res = realloc (buf, *len + n + 1);
+	if (!res) {
+		free (buf);
+		return NULL;
+	}
+	memcpy (res + *len, data, n);
+	*len += n;
+	return res;
+}
+
+static ut8 *frame_append_ut32(ut8 *buf, int *len, ut32 n) {
+	ut8 word[4];
+	r_write_le32 (word, n);
+	return frame_append (buf, len, word, sizeof (word));
+}
+
+static ut8 *frame_append_ut64(ut8 *buf, int *len, ut64 n) {
+	ut8 word[8];
+	r_write_le64 (word, n);
+	return frame_append (buf, len, word, sizeof (word));
+}
+
+static int frame_fcn_cmp(const void *a, const void *b) {
+	const RAnalFunction *fa = a, *fb = b;
+	return (fa->addr > fb->addr) - (fa->addr < fb->addr);
+}
+
+/* replies to r2pipe frames, the compact ones are built from RAnal and RIO */
+static ut8 *core_frame_reply(void *user, R2PipeFrame *frame, int *len) {
+	RCore *core = (RCore *)user;
+	RAnalFunction *fcn;
+	RAnalRef *ref;
+	RListIter *iter;
+	RList *list;
+	char *res, *line, *next;
+	ut8 *buf = NULL;
+	*len = 0;
+	switch (frame->type) {
+	case R2P_FRAME_CMD:
+		res = r_core_cmd_str (core, (const char *)frame->data);
+		if (res) {
+			*len = strlen (res);
+		}
+		return (ut8 *)res;
+	case R2P_FRAME_BATCH:
+		buf = malloc (1);
+		for (line = (char *)frame->data; buf && *line; line = next) {
+			next = strchr (line, '\n');
+			if (next) {
+				*next++ = 0;
+			} else {
+				next = line + strlen (line);
+			}
+			res = r_core_cmd_str (core, line);
+			int n = res? strlen (res): 0;
+			buf = frame_append_ut32 (buf, len, n);
+			if (buf) {
+				buf = frame_append (buf, len, res, n);
+			}
+			free (res);
+		}
+		return buf;
+	case R2P_FRAME_BYTES:
+		if (frame->len == 12) {
+			ut64 addr = r_read_le64 (frame->data);
+			ut32 n = r_read_le32 (frame->data + 8);
+			if (n > ST32_MAX - R2P_FRAME_HDRSZ) {
+				return NULL;
+			}
+			buf = malloc (n + 1);
+			if (buf) {
+				r_io_read_at (core->io, addr, buf, n);
+				*len = n;
+			}
+		}
+		return buf;
+	case R2P_FRAME_FCNS:
+		// sorted by address like afl
+		list = r_list_clone (core->anal->fcns);
+		buf = malloc (1);
+		if (list) {
+			r_list_sort (list, frame_fcn_cmp);
+		}
+		r_list_foreach (list, iter, fcn) {
+			if (!buf) {
+				break;
+			}
+			char *name = r_core_anal_fcn_name (core, fcn);
+			int n = name? strlen (name): 0;
+			buf = frame_append_ut64 (buf, len, fcn->addr);
+			buf = buf? frame_append_ut32 (buf, len, r_anal_fcn_size (fcn)): NULL;
+			buf = buf? frame_append_ut32 (buf, len, r_list_length (fcn->bbs)): NULL;
+			buf = buf? frame_append_ut32 (buf, len, n): NULL;
+			buf = buf? frame_append (buf, len, name, n): NULL;
+			free (name);
+		}
+		r_list_free (list);
+		return buf;
+	case R2P_FRAME_XREFS:
+		if (frame->len == 8) {
+			list = r_anal_xrefs_get (core->anal, r_read_le64 (frame->data));
+			buf = malloc (1);
+			r_list_foreach (list, iter, ref) {
+				if (!buf) {
+					break;
+				}
+				buf = frame_append_ut64 (buf, len, ref->addr);
+			}
+			r_list_free (list);
+		}
+		return buf;
+	}
+	return NULL;
+}
+
 R_API bool r_core_init(RCore *core) {
 	core->blocksize = R_CORE_BLOCKSIZE;
 	core->block = (ut8 *)calloc (R_CORE_BLOCKSIZE + 1, 1);
@@ -2295,6 +2411,7 @@ R_API bool r_core_init(RCore *core) {
 	core->lang = r_lang_new ();
 	core->lang->cmd_str = (char *(*)(void *, const char *))r_core_cmd_str;
 	core->lang->cmdf = (int (*)(void *, const char *, ...))r_core_cmdf;
+	core->lang->frame_reply = (RCoreFrameReplyCallback)core_frame_reply;
 	r_core_bind_cons (core);
 	core->lang->cb_printf = r_cons_printf;
 	r_lang_define (core->lang, "RCore", "core", core);
@@ -2437,6 +2554,8 @@ R_API RCore *r_core_fini(RCore *c) {
 	R_FREE (c->cmdqueue);
 	R_FREE (c->lastcmd);
 	r_list_free (c->visual.tabs);
+	r_core_print_disasm_flush (c);
+	R_FREE (c->ds_config);
 	R_FREE (c->block);
 	r_core_autocomplete_free (c->autocomplete);
 
@@ -2647,7 +2766,31 @@ R_API int r_core_prompt(RCore *r, int sync) {
 	return true;
 }
 
+/* write the ack in full, retrying short writes */
+static bool frame_ack(int fd) {
+	const char *ack = R2P_FRAME_ACK;
+	int left = strlen (R2P_FRAME_ACK) + 1;
+	while (left > 0) {
+		int rv = write (fd, ack, left);
+		if (rv < 1) {
+			eprintf ("r2pipe: cannot write the frames ack\n");
+			return false;
+		}
+		ack += rv;
+		left -= rv;
+	}
+	return true;
+}
+
 R_API int r_core_prompt_exec(RCore *r) {
+	if (r->cons && r->cons->line && r->cons->line->zerosep && r->cmdqueue
+			&& !strcmp (r->cmdqueue, R2P_FRAME_HELLO)) {
+		/* r2pipe clients asking for frames keep them until they close stdin */
+		if (frame_ack (1)) {
+			r2p_frame_serve (0, 1, NULL, 0, core_frame_reply, r);
+		}
+		return R_CORE_CMD_EXIT;
+	}
 	int ret = r_core_cmd (r, r->cmdqueue, true);
 	//int ret = r_core_cmd (r, r->cmdqueue, true);
 	if (r->cons && r->cons->use_tts) {
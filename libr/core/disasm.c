@@ -73,7 +73,7 @@ static const char* r_vline_uc[] = {
 
 // TODO: what about using bit shifting and enum for keys? see libr/util/bitmap.c
 // the problem of this is that the fields will be more opaque to bindings, but we will earn some bits
-typedef struct {
+typedef struct r_disasm_state_t {
 	RCore *core;
 	char str[1024], strsub[1024];
 	bool immtrim;
@@ -134,6 +134,7 @@ typedef struct {
 	bool show_symbols;
 	int show_symbols_col;
 	bool show_offseg;
+	unsigned int seggrn;
 	bool show_flags;
 	bool bblined;
 	bool show_bytes;
@@ -178,6 +179,11 @@ typedef struct {
 	bool show_vars;
 	int show_varsum;
 	int midflags;
+	bool relsub;
+	bool varsub_only;
+	int bytespace;
+	bool demangle;
+	const char *lang;
 	bool midbb;
 	bool midcursor;
 	bool show_noisy_comments;
@@ -274,6 +280,18 @@ typedef struct {
 	bool use_json;
 	bool first_line;
 	const char *strip;
+
+	// lines kept between visual frames, see ds_cache_setup
+	bool cache;
+	int cache_start; // where the line begins in the cons buffer, -1 if it is not kept
+	int cache_bounds;
+	int cache_hole, cache_hole_len;
+	int cache_type;
+	ut64 cache_jump, cache_ptr;
+	bool cache_addr;
+	ut64 cache_lfcn, cache_lfcn_at;
+	char *cache_line, *cache_line2;
+	int cache_rows, cache_nl, cache_nl_len;
 } RDisasmState;
 
 static void ds_setup_print_pre(RDisasmState *ds, bool tail, bool middle);
@@ -285,7 +303,6 @@ static void ds_newline(RDisasmState *ds);
 static void ds_print_esil_anal(RDisasmState *ds);
 static void ds_reflines_init(RDisasmState *ds);
 static void ds_align_comment(RDisasmState *ds);
-static RDisasmState * ds_init(RCore * core);
 static void ds_build_op_str(RDisasmState *ds, bool print_color);
 static void ds_pre_xrefs(RDisasmState *ds, bool no_fcnlines);
 static void ds_show_xrefs(RDisasmState *ds);
@@ -519,63 +536,16 @@ static void ds_print_esil_anal_fini(RDisasmState *ds) {
 	}
 }
 
-static RDisasmState * ds_init(RCore *core) {
-	RDisasmState *ds = R_NEW0 (RDisasmState);
-	if (!ds) {
-		return NULL;
-	}
+/* everything ds_init takes from the config, core->ds_config keeps a copy
+ * until the config changes */
+static void ds_config(RDisasmState *ds, RCore *core) {
 	ds->shortcut_pos = r_config_get_i (core->config, "asm.shortcut");
-	ds->core = core;
-	ds->strip = r_config_get (core->config, "asm.strip");
-	ds->pal_comment = core->cons->pal.comment;
-	#define P(x) (core->cons && core->cons->pal.x)? core->cons->pal.x
-	ds->color_comment = P(comment): Color_CYAN;
-	ds->color_usrcmt = P(usercomment): Color_CYAN;
-	ds->color_fname = P(fname): Color_RED;
-	ds->color_floc = P(floc): Color_MAGENTA;
-	ds->color_fline = P(fline): Color_CYAN;
-	ds->color_flow = P(flow): Color_CYAN;
-	ds->color_flow2 = P(flow2): Color_CYAN;
-	ds->color_flag = P(flag): Color_CYAN;
-	ds->color_label = P(label): Color_CYAN;
-	ds->color_other = P(other): Color_WHITE;
-	ds->color_nop = P(nop): Color_BLUE;
-	ds->color_bin = P(bin): Color_YELLOW;
-	ds->color_math = P(math): Color_YELLOW;
-	ds->color_btext = P(btext): Color_YELLOW;
-	ds->color_jmp = P(jmp): Color_GREEN;
-	ds->color_cjmp = P(cjmp): Color_GREEN;
-	ds->color_call = P(call): Color_BGREEN;
-	ds->color_cmp = P(cmp): Color_MAGENTA;
-	ds->color_swi = P(swi): Color_MAGENTA;
-	ds->color_trap = P(trap): Color_BRED;
-	ds->color_ret = P(ret): Color_RED;
-	ds->color_push = P(push): Color_YELLOW;
-	ds->color_pop = P(pop): Color_BYELLOW;
-	ds->color_reg = P(reg): Color_YELLOW;
-	ds->color_num = P(num): Color_CYAN;
-	ds->color_mov = P(mov): Color_WHITE;
-	ds->color_invalid = P(invalid): Color_BRED;
-	ds->color_gui_cflow = P(gui_cflow): Color_YELLOW;
-	ds->color_gui_dataoffset = P(gui_dataoffset): Color_YELLOW;
-	ds->color_gui_background = P(gui_background): Color_BLACK;
-	ds->color_gui_alt_background = P(gui_alt_background): Color_GRAY;
-	ds->color_gui_border = P(gui_border): Color_BGGRAY;
-	ds->color_linehl = P(linehl): Color_BGBLUE;
-	ds->color_func_var = P(func_var): Color_WHITE;
-	ds->color_func_var_type = P(func_var_type): Color_BLUE;
-	ds->color_func_var_addr = P(func_var_addr): Color_CYAN;
-
 	ds->immstr = r_config_get_i (core->config, "asm.imm.str");
 	ds->immtrim = r_config_get_i (core->config, "asm.imm.trim");
 	ds->use_esil = r_config_get_i (core->config, "asm.esil");
 	ds->pre_emu = r_config_get_i (core->config, "emu.pre");
 	ds->show_flgoff = r_config_get_i (core->config, "asm.flags.offset");
 	ds->show_nodup = r_config_get_i (core->config, "asm.nodup");
-	{
-		const char *ah = r_config_get (core->config, "asm.highlight");
-		ds->asm_highlight = (ah && *ah)? r_num_math (core->num, ah): UT64_MAX;
-	}
 	ds->asm_anal = r_config_get_i (core->config, "asm.anal");
 	ds->show_color = r_config_get_i (core->config, "scr.color");
 	ds->show_color_bytes = r_config_get_i (core->config, "scr.color.bytes"); // maybe rename to asm.color.bytes
@@ -591,7 +561,7 @@ static RDisasmState * ds_init(RCore *core) {
 	ds->midbb = r_config_get_i (core->config, "asm.bb.middle");
 	ds->midcursor = r_config_get_i (core->config, "asm.midcursor");
 	ds->decode = r_config_get_i (core->config, "asm.decode");
-	core->parser->pseudo = ds->pseudo = r_config_get_i (core->config, "asm.pseudo");
+	ds->pseudo = r_config_get_i (core->config, "asm.pseudo");
 	if (ds->pseudo) {
 		ds->atabs = 0;
 	}
@@ -599,9 +569,8 @@ static RDisasmState * ds_init(RCore *core) {
 	ds->interactive = r_config_get_i (core->config, "scr.interactive");
 	ds->jmpsub = r_config_get_i (core->config, "asm.jmpsub");
 	ds->varsub = r_config_get_i (core->config, "asm.var.sub");
-	core->parser->relsub = r_config_get_i (core->config, "asm.relsub");
-	core->parser->localvar_only = r_config_get_i (core->config, "asm.var.subonly");
-	core->parser->retleave_asm = NULL;
+	ds->relsub = r_config_get_i (core->config, "asm.relsub");
+	ds->varsub_only = r_config_get_i (core->config, "asm.var.subonly");
 	ds->show_vars = r_config_get_i (core->config, "asm.var");
 	ds->show_varsum = r_config_get_i (core->config, "asm.var.summary");
 	ds->show_varaccess = r_config_get_i (core->config, "asm.var.access");
@@ -641,26 +610,8 @@ static RDisasmState * ds_init(RCore *core) {
 	ds->show_emu_strflag = r_config_get_i (core->config, "emu.strflag");
 	ds->show_emu_write = r_config_get_i (core->config, "emu.write");
 	ds->show_emu_stack = r_config_get_i (core->config, "emu.stack");
-	ds->stackFd = -1;
-	if (ds->show_emu_stack) {
-		// TODO: initialize fake stack in here
-		const char *uri = "malloc://32K";
-		ut64 size = r_num_get (core->num, "32K");
-		ut64 addr = r_reg_getv (core->anal->reg, "SP") - (size / 2);
-		emustack_min = addr;
-		emustack_max = addr + size;
-		ds->stackFd = r_io_fd_open (core->io, uri, R_PERM_RW, 0);
-		RIOMap *map = r_io_map_add (core->io, ds->stackFd, R_PERM_RW, 0LL, addr, size);
-		if (!map) {
-			r_io_fd_close (core->io, ds->stackFd);
-			eprintf ("Cannot create map for tha stack, fd %d got closed again\n", ds->stackFd);
-			ds->stackFd = -1;
-		} else {
-			r_io_map_set_name (map, "fake.stack");
-		}
-	}
-	ds->stackptr = core->anal->stackptr;
 	ds->show_offseg = r_config_get_i (core->config, "asm.segoff");
+	ds->seggrn = r_config_get_i (core->config, "asm.seggrn");
 	ds->show_flags = r_config_get_i (core->config, "asm.flags");
 	ds->show_bytes = r_config_get_i (core->config, "asm.bytes");
 	ds->asm_meta = r_config_get_i (core->config, "asm.meta");
@@ -681,10 +632,9 @@ static RDisasmState * ds_init(RCore *core) {
 	ds->show_xrefs = r_config_get_i (core->config, "asm.xrefs");
 	ds->show_cmtrefs = r_config_get_i (core->config, "asm.cmt.refs");
 	ds->cmtfold = r_config_get_i (core->config, "asm.cmt.fold");
-	ds->show_cmtoff = r_config_get (core->config, "asm.cmt.off");
 	ds->show_functions = r_config_get_i (core->config, "asm.functions");
 	ds->nbytes = r_config_get_i (core->config, "asm.nbytes");
-	ds->show_asciidot = !strcmp (core->print->strconv_mode, "asciidot");
+	ds->demangle = r_config_get_i (core->config, "bin.demangle");
 	const char *strenc_str = r_config_get (core->config, "asm.strenc");
 	if (!strcmp (strenc_str, "latin1")) {
 		ds->strenc = R_STRING_ENC_LATIN1;
@@ -697,10 +647,7 @@ static RDisasmState * ds_init(RCore *core) {
 	} else {
 		ds->strenc = R_STRING_ENC_GUESS;
 	}
-	core->print->bytespace = r_config_get_i (core->config, "asm.bytespace");
-	ds->cursor = 0;
-	ds->nb = 0;
-	ds->flagspace_ports = r_flag_space_get (core->flags, "ports");
+	ds->bytespace = r_config_get_i (core->config, "asm.bytespace");
 	ds->lbytes = r_config_get_i (core->config, "asm.lbytes");
 	ds->show_comment_right_default = r_config_get_i (core->config, "asm.cmt.right");
 	ds->show_comment_right = ds->show_comment_right_default;
@@ -708,19 +655,6 @@ static RDisasmState * ds_init(RCore *core) {
 	ds->show_hints = r_config_get_i (core->config, "asm.hints");
 	ds->show_marks = r_config_get_i (core->config, "asm.marks");
 	ds->show_noisy_comments = r_config_get_i (core->config, "asm.noisy");
-	ds->pre = DS_PRE_NONE;
-	ds->ocomment = NULL;
-	ds->linesopts = 0;
-	ds->lastfail = 0;
-	ds->ocols = 0;
-	ds->lcols = 0;
-	ds->printed_str_addr = UT64_MAX;
-	ds->printed_flag_addr = UT64_MAX;
-
-	ds->esil_old_pc = UT64_MAX;
-	ds->esil_regstate = NULL;
-	ds->esil_likely = false;
-
 	ds->showpayloads = r_config_get_i (ds->core->config, "asm.payloads");
 	ds->showrelocs = r_config_get_i (core->config, "bin.relocs");
 	ds->min_ref_addr = r_config_get_i (core->config, "asm.var.submin");
@@ -731,11 +665,6 @@ static RDisasmState * ds_init(RCore *core) {
 	if (r_config_get_i (core->config, "asm.lines.wide")) {
 		ds->linesopts |= R_ANAL_REFLINE_TYPE_WIDE;
 	}
-	if (core->cons->vline) {
-		if (ds->show_utf8) {
-			ds->linesopts |= R_ANAL_REFLINE_TYPE_UTF8;
-		}
-	}
 	if (ds->show_lines_bb) {
 		ds->ocols += 10; // XXX
 	}
@@ -754,6 +683,112 @@ static RDisasmState * ds_init(RCore *core) {
 	}
 	/* disasm */ ds->ocols += 20;
 	ds->nb = ds->nbytes? (1 + ds->nbytes * 2): 0;
+}
+
+static RDisasmState * ds_init(RCore *core) {
+	RDisasmState *ds = R_NEW0 (RDisasmState);
+	if (!ds) {
+		return NULL;
+	}
+	ds->core = core;
+	if (core->ds_config && core->ds_config_of == core->config
+			&& core->ds_config_rev == core->config->rev) {
+		memcpy (ds, core->ds_config, sizeof (RDisasmState));
+	} else {
+		ds_config (ds, core);
+		if (!core->ds_config) {
+			core->ds_config = R_NEW (RDisasmState);
+		}
+		if (core->ds_config) {
+			memcpy (core->ds_config, ds, sizeof (RDisasmState));
+			core->ds_config_of = core->config;
+			core->ds_config_rev = core->config->rev;
+		}
+	}
+	/* the strings point into the config nodes */
+	ds->strip = r_config_get (core->config, "asm.strip");
+	ds->show_cmtoff = r_config_get (core->config, "asm.cmt.off");
+	ds->lang = ds->demangle? r_config_get (core->config, "bin.lang"): NULL;
+	ds->pal_comment = core->cons->pal.comment;
+	#define P(x) (core->cons && core->cons->pal.x)? core->cons->pal.x
+	ds->color_comment = P(comment): Color_CYAN;
+	ds->color_usrcmt = P(usercomment): Color_CYAN;
+	ds->color_fname = P(fname): Color_RED;
+	ds->color_floc = P(floc): Color_MAGENTA;
+	ds->color_fline = P(fline): Color_CYAN;
+	ds->color_flow = P(flow): Color_CYAN;
+	ds->color_flow2 = P(flow2): Color_CYAN;
+	ds->color_flag = P(flag): Color_CYAN;
+	ds->color_label = P(label): Color_CYAN;
+	ds->color_other = P(other): Color_WHITE;
+	ds->color_nop = P(nop): Color_BLUE;
+	ds->color_bin = P(bin): Color_YELLOW;
+	ds->color_math = P(math): Color_YELLOW;
+	ds->color_btext = P(btext): Color_YELLOW;
+	ds->color_jmp = P(jmp): Color_GREEN;
+	ds->color_cjmp = P(cjmp): Color_GREEN;
+	ds->color_call = P(call): Color_BGREEN;
+	ds->color_cmp = P(cmp): Color_MAGENTA;
+	ds->color_swi = P(swi): Color_MAGENTA;
+	ds->color_trap = P(trap): Color_BRED;
+	ds->color_ret = P(ret): Color_RED;
+	ds->color_push = P(push): Color_YELLOW;
+	ds->color_pop = P(pop): Color_BYELLOW;
+	ds->color_reg = P(reg): Color_YELLOW;
+	ds->color_num = P(num): Color_CYAN;
+	ds->color_mov = P(mov): Color_WHITE;
+	ds->color_invalid = P(invalid): Color_BRED;
+	ds->color_gui_cflow = P(gui_cflow): Color_YELLOW;
+	ds->color_gui_dataoffset = P(gui_dataoffset): Color_YELLOW;
+	ds->color_gui_background = P(gui_background): Color_BLACK;
+	ds->color_gui_alt_background = P(gui_alt_background): Color_GRAY;
+	ds->color_gui_border = P(gui_border): Color_BGGRAY;
+	ds->color_linehl = P(linehl): Color_BGBLUE;
+	ds->color_func_var = P(func_var): Color_WHITE;
+	ds->color_func_var_type = P(func_var_type): Color_BLUE;
+	ds->color_func_var_addr = P(func_var_addr): Color_CYAN;
+
+	{
+		const char *ah = r_config_get (core->config, "asm.highlight");
+		ds->asm_highlight = (ah && *ah)? r_num_math (core->num, ah): UT64_MAX;
+	}
+	core->parser->pseudo = ds->pseudo;
+	core->parser->relsub = ds->relsub;
+	core->parser->localvar_only = ds->varsub_only;
+	core->parser->retleave_asm = NULL;
+	ds->stackFd = -1;
+	if (ds->show_emu_stack) {
+		// TODO: initialize fake stack in here
+		const char *uri = "malloc://32K";
+		ut64 size = r_num_get (core->num, "32K");
+		ut64 addr = r_reg_getv (core->anal->reg, "SP") - (size / 2);
+		emustack_min = addr;
+		emustack_max = addr + size;
+		ds->stackFd = r_io_fd_open (core->io, uri, R_PERM_RW, 0);
+		RIOMap *map = r_io_map_add (core->io, ds->stackFd, R_PERM_RW, 0LL, addr, size);
+		if (!map) {
+			r_io_fd_close (core->io, ds->stackFd);
+			eprintf ("Cannot create map for tha stack, fd %d got closed again\n", ds->stackFd);
+			ds->stackFd = -1;
+		} else {
+			r_io_map_set_name (map, "fake.stack");
+		}
+	}
+	ds->stackptr = core->anal->stackptr;
+	ds->show_asciidot = !strcmp (core->print->strconv_mode, "asciidot");
+	core->print->bytespace = ds->bytespace;
+	ds->cursor = 0;
+	ds->flagspace_ports = r_flag_space_get (core->flags, "ports");
+	ds->pre = DS_PRE_NONE;
+	ds->ocomment = NULL;
+	ds->lastfail = 0;
+	ds->printed_str_addr = UT64_MAX;
+	ds->printed_flag_addr = UT64_MAX;
+
+	ds->esil_old_pc = UT64_MAX;
+	ds->esil_regstate = NULL;
+	ds->esil_likely = false;
+
 	ds->tries = 3;
 	if (core->print->cur_enabled) {
 		if (core->print->cur < 0) {
@@ -763,9 +798,6 @@ static RDisasmState * ds_init(RCore *core) {
 	} else {
 		ds->cursor = -1;
 	}
-	if (r_config_get_i (core->config, "asm.lines.wide")) {
-		ds->linesopts |= R_ANAL_REFLINE_TYPE_WIDE;
-	}
 	if (core->cons->vline) {
 		if (ds->show_utf8) {
 			ds->linesopts |= R_ANAL_REFLINE_TYPE_UTF8;
@@ -793,12 +825,12 @@ static void ds_reflines_init(RDisasmState *ds) {
 
 	if (ds->show_lines_bb) {
 		ds_reflines_fini (ds);
+		/* reflines2 is never drawn, the middle lines also come from reflines */
+		anal->reflines_ops = ds->cache? ds->core->visual.ops: NULL;
 		anal->reflines = r_anal_reflines_get (anal,
 			ds->addr, ds->buf, ds->len, ds->l,
 			ds->linesout, ds->show_lines_call);
-		anal->reflines2 = r_anal_reflines_get (anal,
-			ds->addr, ds->buf, ds->len, ds->l,
-			ds->linesout, 1);
+		anal->reflines_ops = NULL;
 	} else {
 		r_list_free (anal->reflines);
 		r_list_free (anal->reflines2);
@@ -849,6 +881,8 @@ static void ds_free(RDisasmState *ds) {
 	free (ds->osl);
 	free (ds->sl);
 	free (ds->_tabsbuf);
+	free (ds->cache_line);
+	free (ds->cache_line2);
 	R_FREE (ds);
 }
 
@@ -930,7 +964,7 @@ static void ds_build_op_str(RDisasmState *ds, bool print_color) {
 	/* initialize */
 	core->parser->hint = ds->hint;
 	ds->hint = NULL;
-	core->parser->relsub = r_config_get_i (core->config, "asm.relsub");
+	core->parser->relsub = ds->relsub;
 	core->parser->relsub_addr = 0;
 	if (ds->varsub && ds->opstr) {
 		ut64 at = ds->vat;
@@ -1158,8 +1192,8 @@ static void ds_show_xrefs(RDisasmState *ds) {
 	RAnalRef *refi;
 	RListIter *iter, *it;
 	RCore *core = ds->core;
-	bool demangle = r_config_get_i (core->config, "bin.demangle");
-	const char *lang = demangle ? r_config_get (core->config, "bin.lang") : NULL;
+	bool demangle = ds->demangle;
+	const char *lang = ds->lang;
 	char *name, *tmp;
 	int count = 0;
 	if (!ds->show_xrefs || !ds->show_comments) {
@@ -1593,9 +1627,9 @@ static void ds_show_functions(RDisasmState *ds) {
 	if (!ds->show_functions) {
 		return;
 	}
-	bool demangle = r_config_get_i (core->config, "bin.demangle");
-	bool call = r_config_get_i (core->config, "asm.calls");
-	const char *lang = demangle ? r_config_get (core->config, "bin.lang") : NULL;
+	bool demangle = ds->demangle;
+	bool call = ds->show_calls;
+	const char *lang = ds->lang;
 	f = r_anal_get_fcn_in (core->anal, ds->at, R_ANAL_FCN_TYPE_NULL);
 	if (!f || (f->addr != ds->at)) {
 		return;
@@ -2476,6 +2510,27 @@ static void ds_print_stackptr(RDisasmState *ds) {
 	}
 }
 
+/* r_print_set_screenbounds counts the rows of the whole cons buffer, there
+ * is no need to ask before it has enough newlines to fill the screen */
+static void ds_set_screenbounds(RDisasmState *ds, ut64 at) {
+	RPrint *p = ds->core->print;
+	if (ds->cache && p->screen_bounds == 1) {
+		const char *buf = r_cons_get_buffer ();
+		int i, len = r_cons_get_buffer_len ();
+		if (len < ds->cache_nl_len) {
+			ds->cache_nl = ds->cache_nl_len = 0;
+		}
+		for (i = ds->cache_nl_len; i < len; i++) {
+			ds->cache_nl += buf[i] == '\n';
+		}
+		ds->cache_nl_len = len;
+		if (ds->cache_nl < ds->cache_rows) {
+			return;
+		}
+	}
+	r_print_set_screenbounds (p, at);
+}
+
 static void ds_print_offset(RDisasmState *ds) {
 	RCore *core = ds->core;
 	ut64 at = ds->vat;
@@ -2497,14 +2552,16 @@ static void ds_print_offset(RDisasmState *ds) {
 			}
 		}
 	}
-	r_print_set_screenbounds (core->print, at);
+	if (ds->cache_start >= 0) {
+		ds->cache_bounds = r_cons_get_buffer_len () - ds->cache_start;
+	}
+	ds_set_screenbounds (ds, at);
 	if (ds->show_offset) {
 		static RFlagItem sfi = R_EMPTY;
 		const char *label = NULL;
 		RFlagItem *fi;
 		int delta = -1;
 		bool show_trace = false;
-		unsigned int seggrn = r_config_get_i (core->config, "asm.seggrn");
 
 		if (ds->show_reloff) {
 			RAnalFunction *f = r_anal_get_fcn_at (core->anal, at, R_ANAL_FCN_TYPE_NULL);
@@ -2553,12 +2610,12 @@ static void ds_print_offset(RDisasmState *ds) {
 			int of = core->print->flags;
 			core->print->flags = 0;
 			r_print_offset_sg (core->print, at, (at == ds->dest) || show_trace,
-					ds->show_offseg, seggrn, ds->show_offdec, delta, label);
+					ds->show_offseg, ds->seggrn, ds->show_offdec, delta, label);
 			core->print->flags = of;
 			r_cons_strcat (Color_RESET);
 		} else {
 			r_print_offset_sg (core->print, at, (at == ds->dest) || show_trace,
-					ds->show_offseg, seggrn, ds->show_offdec, delta, label);
+					ds->show_offseg, ds->seggrn, ds->show_offdec, delta, label);
 		}
 	}
 	if (ds->atabsoff > 0 && ds->show_offset) {
@@ -2854,6 +2911,7 @@ static void ds_instruction_mov_lea(RDisasmState *ds, int idx) {
 					ut8 b[8];
 					ut64 ptr = addrbytes * idx + ds->addr + src->delta + ds->analop.size;
 					ut64 off = 0LL;
+					ds->cache_addr = true;
 					r_io_read_at (core->io, ptr, b, src->memref);
 					off = r_mem_get_num (b, src->memref);
 					item = r_flag_get_i (core->flags, off);
@@ -2882,6 +2940,7 @@ static void ds_instruction_mov_lea(RDisasmState *ds, int idx) {
 				ut8 b[64];
 				ut64 ptr = index + ds->addr + src->delta + ds->analop.size;
 				ut64 off = 0LL;
+				ds->cache_addr = true;
 				r_io_read_at (core->io, ptr, b, sizeof (b)); //memref);
 				off = r_mem_get_num (b, memref);
 				item = r_flag_get_i (core->flags, off);
@@ -3300,6 +3359,7 @@ static void ds_print_core_vmode(RDisasmState *ds, int pos) {
 	if (!core->vmode) {
 		return;
 	}
+	const int hole = r_cons_get_buffer_len ();
 	switch (ds->analop.type) {
 	case R_ANAL_OP_TYPE_UJMP:
 	case R_ANAL_OP_TYPE_UJMP | R_ANAL_OP_TYPE_IND:
@@ -3372,6 +3432,14 @@ static void ds_print_core_vmode(RDisasmState *ds, int pos) {
 		}
 	}
 	r_cons_strcat ("  ");
+	if (ds->cache_start >= 0) {
+		/* the shortcut numbers depend on the lines printed before */
+		ds->cache_hole = hole - ds->cache_start;
+		ds->cache_hole_len = r_cons_get_buffer_len () - hole;
+		ds->cache_type = ds->analop.type;
+		ds->cache_jump = ds->analop.jump;
+		ds->cache_ptr = ds->analop.ptr;
+	}
 }
 
 // align for comment
@@ -3416,6 +3484,8 @@ static void ds_print_dwarf(RDisasmState *ds) {
 		free (ds->sl);
 		ds->sl = r_bin_addr2text (ds->core->bin, ds->at, dwarfFile);
 		if (ds->sl) {
+			/* shown depending on the previous source line, never kept */
+			ds->cache_start = -1;
 			if ((!ds->osl || (ds->osl && strcmp (ds->sl, ds->osl)))) {
 				char *chopstr, *line = strdup (ds->sl);
 				if (!line) {
@@ -4423,8 +4493,8 @@ beach:
 }
 
 static void ds_print_calls_hints(RDisasmState *ds) {
-	int emu = r_config_get_i (ds->core->config, "asm.emu");
-	int emuwrite = r_config_get_i (ds->core->config, "emu.write");
+	int emu = ds->show_emu;
+	int emuwrite = ds->show_emu_write;
 	if (emu && emuwrite) {
 		// this is done by ESIL
 		return;
@@ -4663,6 +4733,238 @@ static void ds_end_line_highlight(RDisasmState *ds) {
 	}
 }
 
+#define DS_CACHE_SIZE 4096
+
+/* an instruction printed by a previous visual frame */
+typedef struct {
+	char *text; // everything printed for it
+	int len;
+	int bounds; // where the offset begins in text, -1 if not printed
+	int hole, hole_len; // the jump shortcut, -1 if not printed
+	int type;
+	ut64 jump, ptr; // what the shortcut was taken for
+	int oplen, inc;
+	char *line, *line2; // reflines it was drawn with
+	ut64 lfcn; // function its labels were looked up in
+	ut64 addr; // start of the disassembly when the hints show it, or UT64_MAX
+} DisasmLine;
+
+static void ds_cache_line_free(DisasmLine *dl) {
+	if (dl) {
+		free (dl->text);
+		free (dl->line);
+		free (dl->line2);
+		free (dl);
+	}
+}
+
+static void ds_cache_free_kv(HtKv *kv) {
+	free (kv->key);
+	ds_cache_line_free (kv->value);
+}
+
+static void ds_cache_ops_free_kv(HtKv *kv) {
+	free (kv->key);
+	free (kv->value);
+}
+
+R_API void r_core_print_disasm_flush(RCore *core) {
+	ht_free (core->visual.lines);
+	ht_free (core->visual.ops);
+	core->visual.lines = NULL;
+	core->visual.ops = NULL;
+}
+
+/* the main visual view keeps the lines it prints for the next frames,
+ * unless they depend on the lines printed before them or on a live
+ * process. Lines are forgotten when the config or the terminal width
+ * change, visual drops them on any key other than the movement ones */
+static bool ds_cache_setup(RDisasmState *ds) {
+	RCore *core = ds->core;
+	RCoreVisual *v = &core->visual;
+
+	if (!v->cache_lines || !core->vmode || core->cons->flush || core->cons->null
+			|| ds->use_json || ds->pdf || ds->show_emu || ds->pre_emu
+			|| ds->show_stackptr || ds->show_symbols || ds->show_reloff
+			|| ds->show_nodup || ds->show_indent || ds->show_trace || ds->asm_anal
+			|| r_config_get_i (core->config, "cfg.debug")) {
+		return false;
+	}
+	if (v->lines && (v->lines_rev != core->config->rev
+			|| v->lines_cols != core->cons->columns
+			|| v->lines->count >= DS_CACHE_SIZE
+			|| v->ops->count >= DS_CACHE_SIZE * 4)) {
+		r_core_print_disasm_flush (core);
+	}
+	if (!v->lines) {
+		v->lines = ht_new (NULL, ds_cache_free_kv, NULL);
+		v->ops = ht_new (NULL, ds_cache_ops_free_kv, NULL);
+		v->lines_rev = core->config->rev;
+		v->lines_cols = core->cons->columns;
+	}
+	if (!v->lines || !v->ops) {
+		r_core_print_disasm_flush (core);
+		return false;
+	}
+	ds->cache_rows = 0;
+	if (core->print->consbind.get_size) {
+		(void)core->print->consbind.get_size (&ds->cache_rows);
+	}
+	return true;
+}
+
+/* lines showing the cursor, the selection or a highlighted address */
+static bool ds_cache_special(RDisasmState *ds, int size) {
+	RPrint *p = ds->core->print;
+	if (ds->at == ds->dest || line_highlighted (ds)) {
+		return true;
+	}
+	if (p->cur_enabled) {
+		int from = (p->ocur == -1)? p->cur: R_MIN (p->cur, p->ocur);
+		int to = (p->ocur == -1)? p->cur: R_MAX (p->cur, p->ocur);
+		return from < ds->index + size && to >= ds->index;
+	}
+	return false;
+}
+
+/* labels are looked up in the function where the disassembly starts */
+static ut64 ds_cache_lfcn(RDisasmState *ds) {
+	if (ds->cache_lfcn_at != ds->addr) {
+		RAnalFunction *f = fcnIn (ds, ds->addr, 0);
+		ds->cache_lfcn = f? f->addr: UT64_MAX;
+		ds->cache_lfcn_at = ds->addr;
+	}
+	return ds->cache_lfcn;
+}
+
+/* the text is kept from the beginning of a line */
+static bool ds_cache_linestart(void) {
+	const char *buf = r_cons_get_buffer ();
+	return !buf || buf[r_cons_get_buffer_len () - 1] == '\n';
+}
+
+static bool ds_cache_streq(const char *a, const char *b) {
+	return (a && b)? !strcmp (a, b): a == b;
+}
+
+/* print the instruction at ds->at the way a previous frame did. Only the
+ * jump shortcut is printed again, if its number changed the instruction
+ * is dropped and printed from scratch */
+static bool ds_cache_replay(RDisasmState *ds, ut64 addr, bool calc_row_offsets, int *inc) {
+	RCore *core = ds->core;
+	DisasmLine *dl;
+	char key[32];
+	int start, pos = 0;
+
+	snprintf (key, sizeof (key), "%"PFMT64x, ds->at);
+	dl = ht_find (core->visual.lines, key, NULL);
+	if (!dl || (dl->addr != UT64_MAX && dl->addr != ds->addr)
+			|| dl->lfcn != ds_cache_lfcn (ds)
+			|| !ds_cache_streq (dl->line, ds->line)
+			|| !ds_cache_streq (dl->line2, ds->refline2)
+			|| ds_cache_special (ds, dl->inc) || !ds_cache_linestart ()) {
+		return false;
+	}
+	start = r_cons_get_buffer_len ();
+	const ut64 bounds = core->print->screen_bounds;
+	const int jmps = core->asmqjmps_count;
+	if (ds->at >= addr) {
+		r_print_set_rowoff (core->print, ds->lines, ds->at - addr, calc_row_offsets);
+	}
+	if (dl->bounds >= 0) {
+		r_cons_memcat (dl->text, dl->bounds);
+		ds_set_screenbounds (ds, ds->vat);
+		pos = dl->bounds;
+	}
+	if (dl->hole >= 0) {
+		r_cons_memcat (dl->text + pos, dl->hole - pos);
+		r_anal_op_fini (&ds->analop);
+		ds->analop.type = dl->type;
+		ds->analop.jump = dl->jump;
+		ds->analop.ptr = dl->ptr;
+		core->print->resetbg = (ds->asm_highlight == UT64_MAX);
+		int hole = r_cons_get_buffer_len ();
+		ds_print_core_vmode (ds, ds->shortcut_pos);
+		core->print->resetbg = true;
+		if (r_cons_get_buffer_len () - hole != dl->hole_len
+				|| memcmp (r_cons_get_buffer () + hole, dl->text + dl->hole, dl->hole_len)) {
+			r_cons_drop (r_cons_get_buffer_len () - start);
+			core->print->screen_bounds = bounds;
+			core->asmqjmps_count = jmps;
+			return false;
+		}
+		pos = dl->hole + dl->hole_len;
+	}
+	r_cons_memcat (dl->text + pos, dl->len - pos);
+	if (!core->inc) {
+		core->inc = dl->oplen;
+	}
+	*inc = dl->inc;
+	return true;
+}
+
+static void ds_cache_begin(RDisasmState *ds) {
+	ds->cache_start = -1;
+	R_FREE (ds->cache_line);
+	R_FREE (ds->cache_line2);
+	if (ds->cache && ds_cache_linestart ()) {
+		ds->cache_start = r_cons_get_buffer_len ();
+		ds->cache_bounds = ds->cache_hole = -1;
+		ds->cache_addr = false;
+		/* the reflines are changed while printing the line */
+		ds->cache_line = ds->line? strdup (ds->line): NULL;
+		ds->cache_line2 = ds->refline2? strdup (ds->refline2): NULL;
+	}
+}
+
+static void ds_cache_store(RDisasmState *ds, int inc) {
+	RCore *core = ds->core;
+	DisasmLine *dl;
+	char key[32];
+	const int start = ds->cache_start;
+	const int len = r_cons_get_buffer_len () - start;
+
+	if (start < 0) {
+		return;
+	}
+	ds->cache_start = -1;
+	dl = R_NEW0 (DisasmLine);
+	if (!dl) {
+		R_FREE (ds->cache_line);
+		R_FREE (ds->cache_line2);
+		return;
+	}
+	dl->line = ds->cache_line;
+	dl->line2 = ds->cache_line2;
+	ds->cache_line = ds->cache_line2 = NULL;
+	if (len <= 0 || ds_cache_special (ds, inc)
+			|| (ds->cache_hole >= 0 && ds->cache_bounds > ds->cache_hole)) {
+		ds_cache_line_free (dl);
+		return;
+	}
+	dl->text = malloc (len);
+	if (dl->text) {
+		memcpy (dl->text, r_cons_get_buffer () + start, len);
+	}
+	dl->len = len;
+	dl->bounds = ds->cache_bounds;
+	dl->hole = ds->cache_hole;
+	dl->hole_len = ds->cache_hole_len;
+	dl->type = ds->cache_type;
+	dl->jump = ds->cache_jump;
+	dl->ptr = ds->cache_ptr;
+	dl->oplen = ds->oplen;
+	dl->inc = inc;
+	dl->lfcn = ds_cache_lfcn (ds);
+	dl->addr = ds->cache_addr? ds->addr: UT64_MAX;
+	if (!dl->text) {
+		ds_cache_line_free (dl);
+		return;
+	}
+	snprintf (key, sizeof (key), "%"PFMT64x, ds->at);
+	ht_update (core->visual.lines, key, dl);
+}
+
 // int l is for lines
 R_API int r_core_print_disasm(RPrint *p, RCore *core, ut64 addr, ut8 *buf, int len, int l, int invbreak, int cbytes, bool json, RAnalFunction *pdf) {
 	int continueoninvbreak = (len == l) && invbreak;
@@ -4686,6 +4988,9 @@ R_API int r_core_print_disasm(RPrint *p, RCore *core, ut64 addr, ut8 *buf, int l
 	ds->use_json = json;
 	ds->first_line = true;
 	ds->pdf = pdf;
+	ds->cache = ds_cache_setup (ds);
+	ds->cache_start = -1;
+	ds->cache_lfcn_at = UT64_MAX;
 
 	// disable row_offsets to prevent other commands to overwrite computed info
 	p->calc_row_offsets = false;
@@ -4771,6 +5076,13 @@ toro:
 		// ds_update_pc (ds, ds->at);
 			r_asm_set_pc (core->assembler, ds->at);
 			ds_update_ref_lines (ds);
+		if (ds->cache && ds_cache_replay (ds, addr, calc_row_offsets, &inc)) {
+			R_FREE (ds->line);
+			R_FREE (ds->refline);
+			R_FREE (ds->refline2);
+			continue;
+		}
+		ds_cache_begin (ds);
 			r_anal_op_fini (&ds->analop);
 			r_anal_op (core->anal, &ds->analop, ds->at, buf + addrbytes * idx, (int)(len - addrbytes * idx), R_ANAL_OP_MASK_ALL);
 		if (ds_must_strip (ds)) {
@@ -5075,6 +5387,7 @@ toro:
 			inc = 1;
 		}
 		inc += ds->asmop.payload + (ds->asmop.payload % ds->core->assembler->dataalign);
+		ds_cache_store (ds, inc);
 	}
 	r_anal_op_fini (&ds->analop);
 
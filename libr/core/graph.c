@@ -46,11 +46,11 @@ static const char *mousemodes[] = {
 
 #define NORMALIZE_MOV(x) ((x) < 0 ? -1 : ((x) > 0 ? 1 : 0))
 
-#define hash_set(sdb, k, v) (sdb_num_set (sdb, sdb_fmt ("%"PFMT64u, (ut64) (size_t) (k)), (ut64) (size_t) (v), 0))
-#define hash_get(sdb, k) (sdb_num_get (sdb, sdb_fmt ("%"PFMT64u, (ut64) (size_t) (k)), NULL))
-#define hash_get_rnode(sdb, k) ((RGraphNode *) (size_t) hash_get (sdb, k))
-#define hash_get_rlist(sdb, k) ((RList *) (size_t) hash_get (sdb, k))
-#define hash_get_int(sdb, k) ((int) hash_get (sdb, k))
+#define LAYOUT_CACHE_SIZE 32
+#define BODY_CACHE_SIZE 8192
+#define LAZY_BODY_WIDTH 40
+#define LAZY_PASSES 4
+
 /* dont use macros for this */
 #define get_anode(gn) ((gn)? (RANode *) (gn)->data: NULL)
 
@@ -91,6 +91,20 @@ struct layer_t {
 	int gap;
 };
 
+/* order of the nodes in the layers, keyed by layout_node_keys () */
+typedef struct layout_pos_t {
+	ut64 key;
+	int layer;
+	int pos;
+} LayoutPos;
+
+typedef struct layout_cache_t {
+	ut64 hash; // layout_graph_hash ()
+	int n_layers;
+	int n_nodes;
+	LayoutPos *pos; // sorted by key and layer
+} LayoutCache;
+
 struct agraph_refresh_data {
 	RCore *core;
 	RAGraph *g;
@@ -653,6 +667,23 @@ static int is_reversed(const RAGraph *g, const RGraphEdge *e) {
 	return r_list_find (g->back_edges, e, (RListComparator) find_edge)? true: false;
 }
 
+/* dummy nodes are not part of the graph as seen by the user, so they are
+ * not listed in the sdb */
+static RANode *agraph_add_dummy(const RAGraph *g) {
+	RANode *res = R_NEW0 (RANode);
+	if (!res) {
+		return NULL;
+	}
+	res->title = strdup ("");
+	res->body = strdup ("");
+	res->layer = -1;
+	res->pos_in_layer = -1;
+	res->is_dummy = true;
+	res->klass = -1;
+	res->gnode = r_graph_add_node (g->graph, res);
+	return res;
+}
+
 /* add dummy nodes when there are edges that span multiple layers */
 static void create_dummy_nodes(RAGraph *g) {
 	RGraphVisitor dummy_vis = {
@@ -676,7 +707,7 @@ static void create_dummy_nodes(RAGraph *g) {
 
 		r_agraph_del_edge (g, from, to);
 		for (i = 1; i < diff_layer; ++i) {
-			RANode *dummy = r_agraph_add_node (g, NULL, NULL);
+			RANode *dummy = agraph_add_dummy (g);
 			if (!dummy) {
 				return;
 			}
@@ -761,27 +792,15 @@ static void minimize_crossings(const RAGraph *g) {
 	} while (cross_changed && max_changes);
 }
 
-static int find_dist(const struct dist_t *a, const struct dist_t *b) {
-	return a->from == b->from && a->to == b->to? 0: 1;
-}
-
 /* returns the distance between two nodes */
 /* if the distance between two nodes were explicitly set, returns that;
  * otherwise calculate the distance of two nodes on the same layer */
 static int dist_nodes(const RAGraph *g, const RGraphNode *a, const RGraphNode *b) {
-	struct dist_t d;
 	const RANode *aa, *ab;
-	RListIter *it;
 	int res = 0;
 
-	if (g->dists) {
-		d.from = a;
-		d.to = b;
-		it = r_list_find (g->dists, &d, (RListComparator) find_dist);
-		if (it) {
-			struct dist_t *old = (struct dist_t *) r_list_iter_get_data (it);
-			return old->dist;
-		}
+	if (g->dists && g->dists[a->idx].to == b) {
+		return g->dists[a->idx].dist;
 	}
 
 	aa = get_anode (a);
@@ -797,15 +816,9 @@ static int dist_nodes(const RAGraph *g, const RGraphNode *a, const RGraphNode *b
 			const RANode *acur = get_anode (cur);
 			int found = false;
 
-			if (g->dists) {
-				d.from = cur;
-				d.to = next;
-				it = r_list_find (g->dists, &d, (RListComparator) find_dist);
-				if (it) {
-					struct dist_t *old = (struct dist_t *) r_list_iter_get_data (it);
-					res += old->dist;
-					found = true;
-				}
+			if (g->dists && g->dists[cur->idx].to == next) {
+				res += g->dists[cur->idx].dist;
+				found = true;
 			}
 
 			if (acur && anext && !found) {
@@ -828,11 +841,12 @@ static int dist_nodes(const RAGraph *g, const RGraphNode *a, const RGraphNode *b
 }
 
 /* explictly set the distance between two nodes on the same layer */
+/* distances are only set between neighbours of a layer, so there is at most
+ * one for each node */
 static void set_dist_nodes(const RAGraph *g, int l, int cur, int next) {
-	struct dist_t *d, find_el;
 	const RGraphNode *vi, *vip;
 	const RANode *avi, *avip;
-	RListIter *it;
+	struct dist_t *d;
 
 	if (!g->dists) {
 		return;
@@ -842,17 +856,10 @@ static void set_dist_nodes(const RAGraph *g, int l, int cur, int next) {
 	avi = get_anode (vi);
 	avip = get_anode (vip);
 
-	find_el.from = vi;
-	find_el.to = vip;
-	it = r_list_find (g->dists, &find_el, (RListComparator) find_dist);
-	d = it? (struct dist_t *) r_list_iter_get_data (it): R_NEW0 (struct dist_t);
-
+	d = &g->dists[vi->idx];
 	d->from = vi;
 	d->to = vip;
 	d->dist = (avip && avi)? avip->x - avi->x: 0;
-	if (!it) {
-		r_list_push (g->dists, d);
-	}
 }
 
 static int is_valid_pos(const RAGraph *g, int l, int pos) {
@@ -863,19 +870,21 @@ static int is_valid_pos(const RAGraph *g, int l, int pos) {
 /* if v is an original node, L(v) = { v }
  * if v is a dummy node, L(v) is the set of all the dummies node that belongs
  *      to the same long edge */
-static Sdb *compute_vertical_nodes(const RAGraph *g) {
-	Sdb *res = sdb_new0 ();
+static RList **compute_vertical_nodes(const RAGraph *g) {
+	RList **res = R_NEWS0 (RList *, g->graph->last_index);
 	int i, j;
 
+	if (!res) {
+		return NULL;
+	}
 	for (i = 0; i < g->n_layers; ++i) {
 		for (j = 0; j < g->layers[i].n_nodes; ++j) {
 			RGraphNode *gn = g->layers[i].nodes[j];
-			const RList *Ln = hash_get_rlist (res, gn);
 			const RANode *an = get_anode (gn);
 
-			if (!Ln) {
+			if (!res[gn->idx]) {
 				RList *vert = r_list_new ();
-				hash_set (res, gn, vert);
+				res[gn->idx] = vert;
 				if (an->is_dummy) {
 					RGraphNode *next = gn;
 					const RANode *anext = get_anode (next);
@@ -898,12 +907,20 @@ static Sdb *compute_vertical_nodes(const RAGraph *g) {
 	return res;
 }
 
+static void free_vertical_nodes(const RAGraph *g, RList **v_nodes) {
+	int i;
+	for (i = 0; i < g->graph->last_index; i++) {
+		r_list_free (v_nodes[i]);
+	}
+	free (v_nodes);
+}
+
 /* computes left or right classes, used to place dummies node */
 /* classes respect three properties:
  * - v E C
  * - w E C => L(v) is a subset of C
  * - w E C, the s+(w) exists and is not in any class yet => s+(w) E C */
-static RList **compute_classes(const RAGraph *g, Sdb *v_nodes, int is_left, int *n_classes) {
+static RList **compute_classes(const RAGraph *g, RList **v_nodes, int is_left, int *n_classes) {
 	int i, j, c;
 	RList **res = R_NEWS0 (RList *, g->n_layers);
 	RGraphNode *gn;
@@ -924,7 +941,7 @@ static RList **compute_classes(const RAGraph *g, Sdb *v_nodes, int is_left, int
 			const RANode *aj = get_anode (gj);
 
 			if (aj->klass == -1) {
-				const RList *laj = hash_get_rlist (v_nodes, gj);
+				const RList *laj = v_nodes[gj->idx];
 
 				if (!res[c]) {
 					res[c] = r_list_new ();
@@ -965,16 +982,16 @@ static RGraphNode *get_sibling(const RAGraph *g, const RANode *n, int is_left, i
 	return res;
 }
 
-static int adjust_class_val(const RAGraph *g, const RGraphNode *gn, const RGraphNode *sibl, Sdb *res, int is_left) {
+static int adjust_class_val(const RAGraph *g, const RGraphNode *gn, const RGraphNode *sibl, const int *res, int is_left) {
 	if (is_left) {
-		return hash_get_int (res, sibl) - hash_get_int (res, gn) - dist_nodes (g, gn, sibl);
+		return res[sibl->idx] - res[gn->idx] - dist_nodes (g, gn, sibl);
 	}
-	return hash_get_int (res, gn) - hash_get_int (res, sibl) - dist_nodes (g, sibl, gn);
+	return res[gn->idx] - res[sibl->idx] - dist_nodes (g, sibl, gn);
 }
 
 /* adjusts the position of previously placed left/right classes */
 /* tries to place classes as close as possible */
-static void adjust_class(const RAGraph *g, int is_left, RList **classes, Sdb *res, int c) {
+static void adjust_class(const RAGraph *g, int is_left, RList **classes, int *res, int c) {
 	const RGraphNode *gn;
 	const RListIter *it;
 	const RANode *an;
@@ -1029,17 +1046,16 @@ static void adjust_class(const RAGraph *g, int is_left, RList **classes, Sdb *re
 	}
 
 	graph_foreach_anode (classes[c], it, gn, an) {
-		const int old_val = hash_get_int (res, gn);
-		const int new_val = is_left? old_val + dist: old_val - dist;
-		hash_set (res, gn, new_val);
+		const int old_val = res[gn->idx];
+		res[gn->idx] = is_left? old_val + dist: old_val - dist;
 	}
 }
 
-static int place_nodes_val(const RAGraph *g, const RGraphNode *gn, const RGraphNode *sibl, Sdb *res, int is_left) {
+static int place_nodes_val(const RAGraph *g, const RGraphNode *gn, const RGraphNode *sibl, const int *res, int is_left) {
 	if (is_left) {
-		return hash_get_int (res, sibl) + dist_nodes (g, sibl, gn);
+		return res[sibl->idx] + dist_nodes (g, sibl, gn);
 	}
-	return hash_get_int (res, sibl) - dist_nodes (g, gn, sibl);
+	return res[sibl->idx] - dist_nodes (g, gn, sibl);
 }
 
 static int place_nodes_sel_p(int newval, int oldval, int is_first, int is_left) {
@@ -1053,8 +1069,8 @@ static int place_nodes_sel_p(int newval, int oldval, int is_first, int is_left)
 }
 
 /* places left/right the nodes of a class */
-static void place_nodes(const RAGraph *g, const RGraphNode *gn, int is_left, Sdb *v_nodes, RList **classes, Sdb *res, Sdb *placed) {
-	const RList *lv = hash_get_rlist (v_nodes, gn);
+static void place_nodes(const RAGraph *g, const RGraphNode *gn, int is_left, RList **v_nodes, RList **classes, int *res, bool *placed) {
+	const RList *lv = v_nodes[gn->idx];
 	int p = 0, v, is_first = true;
 	const RGraphNode *gk;
 	const RListIter *itk;
@@ -1070,7 +1086,7 @@ static void place_nodes(const RAGraph *g, const RGraphNode *gn, int is_left, Sdb
 		}
 		sibl_anode = get_anode (sibling);
 		if (ak->klass == sibl_anode->klass) {
-			if (!hash_get (placed, sibling)) {
+			if (!placed[sibling->idx]) {
 				place_nodes (g, sibling, is_left, v_nodes, classes, res, placed);
 			}
 
@@ -1085,38 +1101,42 @@ static void place_nodes(const RAGraph *g, const RGraphNode *gn, int is_left, Sdb
 	}
 
 	graph_foreach_anode (lv, itk, gk, ak) {
-		hash_set (res, gk, p);
-		hash_set (placed, gk, true);
+		res[gk->idx] = p;
+		placed[gk->idx] = true;
 	}
 }
 
 /* computes the position to the left/right of all the nodes */
-static Sdb *compute_pos(const RAGraph *g, int is_left, Sdb *v_nodes) {
-	Sdb *res, *placed;
+static int *compute_pos(const RAGraph *g, int is_left, RList **v_nodes) {
 	RList **classes;
-	int n_classes, i;
+	bool *placed;
+	int *res, n_classes, i;
 
 	classes = compute_classes (g, v_nodes, is_left, &n_classes);
 	if (!classes) {
 		return NULL;
 	}
 
-	res = sdb_new0 ();
-	placed = sdb_new0 ();
-	for (i = 0; i < n_classes; ++i) {
-		const RGraphNode *gn;
-		const RListIter *it;
+	res = R_NEWS0 (int, g->graph->last_index);
+	placed = R_NEWS0 (bool, g->graph->last_index);
+	if (res && placed) {
+		for (i = 0; i < n_classes; ++i) {
+			const RGraphNode *gn;
+			const RListIter *it;
 
-		r_list_foreach (classes[i], it, gn) {
-			if (!hash_get_rnode (placed, gn)) {
-				place_nodes (g, gn, is_left, v_nodes, classes, res, placed);
+			r_list_foreach (classes[i], it, gn) {
+				if (!placed[gn->idx]) {
+					place_nodes (g, gn, is_left, v_nodes, classes, res, placed);
+				}
 			}
-		}
 
-		adjust_class (g, is_left, classes, res, i);
+			adjust_class (g, is_left, classes, res, i);
+		}
+	} else {
+		R_FREE (res);
 	}
 
-	sdb_free (placed);
+	free (placed);
 	for (i = 0; i < n_classes; ++i) {
 		if (classes[i]) {
 			r_list_free (classes[i]);
@@ -1126,17 +1146,13 @@ static Sdb *compute_pos(const RAGraph *g, int is_left, Sdb *v_nodes) {
 	return res;
 }
 
-static int free_vertical_nodes_cb(void *user UNUSED, const char *k UNUSED, const char *v) {
-	r_list_free ((RList *) (size_t) sdb_atoi (v));
-	return 1;
-}
-
 /* calculates position of all nodes, but in particular dummies nodes */
 /* computes two different placements (called "left"/"right") and set the final
  * position of each node to the average of the values in the two placements */
 static void place_dummies(const RAGraph *g) {
 	const RList *nodes;
-	Sdb *xminus, *xplus, *vertical_nodes;
+	RList **vertical_nodes;
+	int *xminus, *xplus;
 	const RGraphNode *gn;
 	const RListIter *it;
 	RANode *n;
@@ -1156,15 +1172,14 @@ static void place_dummies(const RAGraph *g) {
 
 	nodes = r_graph_get_nodes (g->graph);
 	graph_foreach_anode (nodes, it, gn, n) {
-		n->x = (hash_get_int (xminus, gn) + hash_get_int (xplus, gn)) / 2;
+		n->x = (xminus[gn->idx] + xplus[gn->idx]) / 2;
 	}
 
-	sdb_free (xplus);
+	free (xplus);
 xplus_err:
-	sdb_free (xminus);
+	free (xminus);
 xminus_err:
-	sdb_foreach (vertical_nodes, (SdbForeachCallback)free_vertical_nodes_cb, NULL);
-	sdb_free (vertical_nodes);
+	free_vertical_nodes (g, vertical_nodes);
 }
 
 static RGraphNode *get_right_dummy(const RAGraph *g, const RGraphNode *n) {
@@ -1188,7 +1203,7 @@ static RGraphNode *get_right_dummy(const RAGraph *g, const RGraphNode *n) {
 	return NULL;
 }
 
-static void adjust_directions(const RAGraph *g, int i, int from_up, Sdb *D, Sdb *P) {
+static void adjust_directions(const RAGraph *g, int i, int from_up, int *D, int *P) {
 	const RGraphNode *vm = NULL, *wm = NULL;
 	const RANode *vma = NULL, *wma = NULL;
 	int j, d = from_up? 1: -1;
@@ -1213,23 +1228,23 @@ static void adjust_directions(const RAGraph *g, int i, int from_up, Sdb *D, Sdb
 			continue;
 		}
 		if (vm) {
-			int p = hash_get_int (P, wm);
+			int p = P[wm->idx];
 			int k;
 
 			for (k = wma->pos_in_layer + 1; k < wpa->pos_in_layer; ++k) {
 				const RGraphNode *w = g->layers[wma->layer].nodes[k];
 				const RANode *aw = get_anode (w);
 				if (aw && aw->is_dummy) {
-					p &= hash_get_int (P, w);
+					p &= P[w->idx];
 				}
 			}
 			if (p) {
-				hash_set (D, vm, from_up);
+				D[vm->idx] = from_up;
 				for (k = vma->pos_in_layer + 1; k < vpa->pos_in_layer; ++k) {
 					const RGraphNode *v = g->layers[vma->layer].nodes[k];
 					const RANode *av = get_anode (v);
 					if (av && av->is_dummy) {
-						hash_set (D, v, from_up);
+						D[v->idx] = from_up;
 					}
 				}
 			}
@@ -1447,7 +1462,7 @@ static void place_sequence(const RAGraph *g, int l, const RGraphNode *bm, const
 /* finds the placements of nodes while traversing the graph in the given
  * direction */
 /* places all the sequences of consecutive original nodes in each layer. */
-static void original_traverse_l(const RAGraph *g, Sdb *D, Sdb *P, int from_up) {
+static void original_traverse_l(const RAGraph *g, int *D, int *P, int from_up) {
 	int i, k, va, vr;
 
 	for (i = from_up? 0: g->n_layers - 1;
@@ -1496,12 +1511,12 @@ static void original_traverse_l(const RAGraph *g, Sdb *D, Sdb *P, int from_up) {
 				if (is_valid_pos (g, i, va)) {
 					set_dist_nodes (g, i, bma->pos_in_layer, va);
 				}
-			} else if (hash_get_int (D, bm) == from_up) {
+			} else if (D[bm->idx] == from_up) {
 				bpa = get_anode (bp);
 				va = bma->pos_in_layer + 1;
 				vr = bpa->pos_in_layer;
 				place_sequence (g, i, bm, bp, from_up, va, vr);
-				hash_set (P, bm, true);
+				P[bm->idx] = true;
 			}
 			bm = bp;
 		}
@@ -1514,25 +1529,16 @@ static void original_traverse_l(const RAGraph *g, Sdb *D, Sdb *P, int from_up) {
 /* set the node placements traversing the graph downward and then upward */
 static void place_original(RAGraph *g) {
 	const RList *nodes = r_graph_get_nodes (g->graph);
-	Sdb *D, *P;
 	const RGraphNode *gn;
 	const RListIter *itn;
 	const RANode *an;
+	int *D, *P;
 
-	D = sdb_new0 ();
-	if (!D) {
-		return;
-	}
-	P = sdb_new0 ();
-	if (!P) {
-		sdb_free (D);
-		return;
-	}
-	g->dists = r_list_newf ((RListFree) free);
-	if (!g->dists) {
-		sdb_free (D);
-		sdb_free (P);
-		return;
+	D = R_NEWS0 (int, g->graph->last_index);
+	P = R_NEWS0 (int, g->graph->last_index);
+	g->dists = R_NEWS0 (struct dist_t, g->graph->last_index);
+	if (!D || !P || !g->dists) {
+		goto beach;
 	}
 
 	graph_foreach_anode (nodes, itn, gn, an) {
@@ -1542,19 +1548,18 @@ static void place_original(RAGraph *g) {
 		const RGraphNode *right_v = get_right_dummy (g, gn);
 		const RANode *right = get_anode (right_v);
 		if (right_v && right) {
-			hash_set (D, gn, 0);
-			int dt_eq = right->x - an->x == dist_nodes (g, gn, right_v);
-			hash_set (P, gn, dt_eq);
+			D[gn->idx] = 0;
+			P[gn->idx] = right->x - an->x == dist_nodes (g, gn, right_v);
 		}
 	}
 
 	original_traverse_l (g, D, P, true);
 	original_traverse_l (g, D, P, false);
 
-	r_list_free (g->dists);
-	g->dists = NULL;
-	sdb_free (P);
-	sdb_free (D);
+beach:
+	R_FREE (g->dists);
+	free (P);
+	free (D);
 }
 
 #if 0
@@ -1829,13 +1834,242 @@ void backedge_info (RAGraph *g) {
 	return;
 }
 
+static inline ut64 layout_mix(ut64 x) {
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	return x;
+}
+
+static ut64 layout_title_key(const RANode *n) {
+	return layout_mix (r_str_hash64 (n->title));
+}
+
+/* follows the dummy nodes of a long edge to the node it ends in */
+static const RANode *layout_edge_end(const RAGraph *g, const RANode *n) {
+	int i;
+	for (i = 0; n && n->is_dummy && i < g->graph->n_nodes; i++) {
+		n = get_anode ((RGraphNode *) r_list_first (n->gnode->out_nodes));
+	}
+	return n;
+}
+
+/* identifies a graph by its original nodes and edges. The dummy nodes left
+ * by a previous layout are skipped and the edges of a node are not hashed
+ * in order, since restoring the reversed edges may have moved them, so that
+ * the graph hashes the same when it is reloaded and when it is only laid out
+ * again. Node titles are block addresses, so this also tells apart the
+ * different functions */
+static ut64 layout_graph_hash(const RAGraph *g) {
+	const RList *nodes = r_graph_get_nodes (g->graph);
+	const RGraphNode *gn, *gk;
+	const RListIter *it, *itk;
+	const RANode *n, *k;
+	ut64 h = 0;
+
+	graph_foreach_anode (nodes, it, gn, n) {
+		ut64 edges = 0;
+		if (n->is_dummy) {
+			continue;
+		}
+		graph_foreach_anode (gn->out_nodes, itk, gk, k) {
+			const RANode *end = layout_edge_end (g, k);
+			edges += layout_mix ((end? layout_title_key (end): 0) + 1);
+		}
+		h = layout_mix (h ^ layout_title_key (n));
+		h = layout_mix (h + edges);
+	}
+	return h;
+}
+
+/* keys of all the nodes in the layers: original nodes are known by their
+ * title and dummy nodes by the ends of their long edge and their layer */
+static ut64 *layout_node_keys(const RAGraph *g) {
+	ut64 *src, *dst, *keys;
+	int i, j;
+
+	keys = R_NEWS0 (ut64, g->graph->last_index);
+	src = R_NEWS0 (ut64, g->graph->last_index);
+	dst = R_NEWS0 (ut64, g->graph->last_index);
+	if (!keys || !src || !dst) {
+		R_FREE (keys);
+		goto beach;
+	}
+	for (i = 0; i < g->n_layers; i++) {
+		for (j = 0; j < g->layers[i].n_nodes; j++) {
+			const RGraphNode *gn = g->layers[i].nodes[j];
+			const RANode *n = get_anode (gn);
+			const RGraphNode *in = r_list_first (gn->in_nodes);
+			if (!n->is_dummy) {
+				src[gn->idx] = dst[gn->idx] = layout_title_key (n);
+			} else if (in) {
+				src[gn->idx] = src[in->idx];
+			}
+		}
+	}
+	for (i = g->n_layers - 1; i >= 0; i--) {
+		for (j = 0; j < g->layers[i].n_nodes; j++) {
+			const RGraphNode *gn = g->layers[i].nodes[j];
+			const RANode *n = get_anode (gn);
+			const RGraphNode *out = r_list_first (gn->out_nodes);
+			if (n->is_dummy) {
+				if (out) {
+					dst[gn->idx] = dst[out->idx];
+				}
+				keys[gn->idx] = layout_mix (src[gn->idx] ^ layout_mix (dst[gn->idx] + i) ^ n->is_reversed);
+			} else {
+				keys[gn->idx] = src[gn->idx];
+			}
+		}
+	}
+beach:
+	free (src);
+	free (dst);
+	return keys;
+}
+
+static int layout_pos_cmp(const void *a, const void *b) {
+	const LayoutPos *pa = a, *pb = b;
+	if (pa->key != pb->key) {
+		return pa->key < pb->key? -1: 1;
+	}
+	return pa->layer != pb->layer? pa->layer - pb->layer: pa->pos - pb->pos;
+}
+
+static void layout_cache_free(LayoutCache *lc) {
+	if (lc) {
+		free (lc->pos);
+		free (lc);
+	}
+}
+
+/* remember the order of the nodes in each layer found by minimize_crossings */
+static void layout_cache_put(RAGraph *g, ut64 hash) {
+	LayoutCache *lc;
+	ut64 *keys;
+	int i, j, n = 0;
+
+	if (!g->layouts) {
+		g->layouts = r_list_newf ((RListFree)layout_cache_free);
+		if (!g->layouts) {
+			return;
+		}
+	}
+	keys = layout_node_keys (g);
+	lc = R_NEW0 (LayoutCache);
+	if (!keys || !lc) {
+		goto fail;
+	}
+	for (i = 0; i < g->n_layers; i++) {
+		n += g->layers[i].n_nodes;
+	}
+	lc->pos = R_NEWS (LayoutPos, R_MAX (n, 1));
+	if (!lc->pos) {
+		goto fail;
+	}
+	for (i = 0; i < g->n_layers; i++) {
+		for (j = 0; j < g->layers[i].n_nodes; j++) {
+			LayoutPos *lp = &lc->pos[lc->n_nodes++];
+			lp->key = keys[g->layers[i].nodes[j]->idx];
+			lp->layer = i;
+			lp->pos = j;
+		}
+	}
+	qsort (lc->pos, lc->n_nodes, sizeof (LayoutPos), layout_pos_cmp);
+	lc->hash = hash;
+	lc->n_layers = g->n_layers;
+	r_list_prepend (g->layouts, lc);
+	if (r_list_length (g->layouts) > LAYOUT_CACHE_SIZE) {
+		layout_cache_free (r_list_pop (g->layouts));
+	}
+	free (keys);
+	return;
+fail:
+	layout_cache_free (lc);
+	free (keys);
+}
+
+static const LayoutPos *layout_cache_find(const LayoutCache *lc, ut64 key, int layer) {
+	size_t lo = 0, hi = lc->n_nodes;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		const LayoutPos *lp = &lc->pos[mid];
+		if (lp->key < key || (lp->key == key && lp->layer < layer)) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo < lc->n_nodes && lc->pos[lo].key == key && lc->pos[lo].layer == layer) {
+		return &lc->pos[lo];
+	}
+	return NULL;
+}
+
+static int layout_node_cmp(const void *a, const void *b) {
+	const RANode *na = get_anode (*(RGraphNode * const *)a);
+	const RANode *nb = get_anode (*(RGraphNode * const *)b);
+	return na->klass != nb->klass? na->klass - nb->klass: na->pos_in_layer - nb->pos_in_layer;
+}
+
+/* restores the order of the nodes in each layer from a previous layout of
+ * the same graph, returns false if there is none */
+static bool layout_cache_get(RAGraph *g, ut64 hash) {
+	LayoutCache *lc = NULL;
+	RListIter *it;
+	ut64 *keys;
+	int i, j, n = 0;
+
+	r_list_foreach (g->layouts, it, lc) {
+		if (lc->hash == hash) {
+			break;
+		}
+		lc = NULL;
+	}
+	if (!lc || lc->n_layers != g->n_layers) {
+		return false;
+	}
+	for (i = 0; i < g->n_layers; i++) {
+		n += g->layers[i].n_nodes;
+	}
+	if (n != lc->n_nodes || !(keys = layout_node_keys (g))) {
+		return false;
+	}
+	/* every node must have its place, the klass is free to use here */
+	for (i = 0; i < g->n_layers; i++) {
+		for (j = 0; j < g->layers[i].n_nodes; j++) {
+			RANode *a = get_anode (g->layers[i].nodes[j]);
+			const LayoutPos *lp = layout_cache_find (lc, keys[a->gnode->idx], i);
+			if (!lp) {
+				free (keys);
+				return false;
+			}
+			a->klass = lp->pos;
+		}
+	}
+	free (keys);
+	for (i = 0; i < g->n_layers; i++) {
+		qsort (g->layers[i].nodes, g->layers[i].n_nodes, sizeof (RGraphNode *), layout_node_cmp);
+		for (j = 0; j < g->layers[i].n_nodes; j++) {
+			RANode *a = get_anode (g->layers[i].nodes[j]);
+			a->pos_in_layer = j;
+			a->klass = -1;
+		}
+	}
+	r_list_split (g->layouts, lc);
+	r_list_prepend (g->layouts, lc);
+	return true;
+}
+
 /* 1) trasform the graph into a DAG
  * 2) partition the nodes in layers
  * 3) split long edges that traverse multiple layers
- * 4) reorder nodes in each layer to reduce the number of edge crossing
+ * 4) reorder nodes in each layer to reduce the number of edge crossing, or
+ *    reuse the order found for the same graph the last time
  * 5) assign x and y coordinates to each node
  * 6) restore the original graph, with long edges and cycles */
 static void set_layout(RAGraph *g) {
+	ut64 hash = layout_graph_hash (g);
 	int i, j, k;
 
 	r_list_free (g->edges);
@@ -1845,7 +2079,12 @@ static void set_layout(RAGraph *g) {
 	assign_layers (g);
 	create_dummy_nodes (g);
 	create_layers (g);
-	minimize_crossings (g);
+	/* the order of the nodes does not depend on their size, so it can be
+	 * reused when only the contents of the nodes changed */
+	if (!layout_cache_get (g, hash)) {
+		minimize_crossings (g);
+		layout_cache_put (g, hash);
+	}
 
 	/* identify row height */
 	for (i = 0; i < g->n_layers; i++) {
@@ -2071,6 +2310,144 @@ static char *get_bb_body(RCore *core, RAnalBlock *b, int opts, RAnalFunction *fc
 	return body;
 }
 
+typedef struct {
+	char *body;
+	ut64 jmps_hash; // shortcut table the body was rendered with
+	ut64 *jmps; // shortcuts added while rendering it
+	int n_jmps;
+} BodyCache;
+
+static void body_cache_free_kv(HtKv *kv) {
+	BodyCache *bc = kv->value;
+	free (kv->key);
+	if (bc) {
+		free (bc->body);
+		free (bc->jmps);
+		free (bc);
+	}
+}
+
+static void body_cache_flush(RAGraph *g) {
+	ht_free (g->bodies);
+	g->bodies = NULL;
+}
+
+/* bodies that depend on the emulation or stack state left by the blocks
+ * rendered before them, or on a live process, are never reused */
+static bool body_cache_enabled(RCore *core) {
+	return !r_config_get_i (core->config, "asm.emu")
+		&& !r_config_get_i (core->config, "asm.stackptr")
+		&& !r_config_get_i (core->config, "cfg.debug");
+}
+
+/* the call/jmp shortcuts shown in a body depend on the ones already taken */
+static ut64 asmqjmps_hash(RCore *core) {
+	ut64 h = layout_mix (((ut64)core->asmqjmps_count << 1) | core->is_asmqjmps_letter);
+	int i;
+	for (i = 1; core->asmqjmps && i <= core->asmqjmps_count; i++) {
+		h = layout_mix (h ^ core->asmqjmps[i]);
+	}
+	return h;
+}
+
+static void body_cache_key(char *key, size_t len, RAnalBlock *b, int opts) {
+	snprintf (key, len, "%"PFMT64x".%d.%d", b->addr, b->size, opts);
+}
+
+/* returns the body rendered before for the same block, mode and shortcut
+ * table. The shortcuts taken by it are added again so 'g' keeps following
+ * the right ones */
+static char *body_cache_get(RAGraph *g, RCore *core, RAnalBlock *b, int opts) {
+	BodyCache *bc;
+	char key[64];
+	int i;
+
+	if (!core->keep_asmqjmps) {
+		/* the disassembler would start a new shortcut table */
+		core->asmqjmps_count = 0;
+	}
+	if (!g->bodies) {
+		return NULL;
+	}
+	body_cache_key (key, sizeof (key), b, opts);
+	bc = ht_find (g->bodies, key, NULL);
+	if (!bc || bc->jmps_hash != asmqjmps_hash (core)) {
+		return NULL;
+	}
+	for (i = 0; i < bc->n_jmps; i++) {
+		free (r_core_add_asmqjmp (core, bc->jmps[i]));
+	}
+	return strdup (bc->body);
+}
+
+/* get_bb_body without emulation, going through the body cache */
+static char *get_bb_body_cached(RAGraph *g, RCore *core, RAnalBlock *b, int opts, RAnalFunction *fcn) {
+	BodyCache *bc;
+	char key[64];
+	char *body = body_cache_get (g, core, b, opts);
+	if (body) {
+		return body;
+	}
+	ut64 hash = asmqjmps_hash (core);
+	int count = core->asmqjmps_count;
+	body = get_bb_body (core, b, opts, fcn, false, 0, NULL);
+	if (!body) {
+		return NULL;
+	}
+	if (g->bodies && g->bodies->count >= BODY_CACHE_SIZE) {
+		body_cache_flush (g);
+	}
+	if (!g->bodies) {
+		g->bodies = ht_new (NULL, body_cache_free_kv, NULL);
+	}
+	bc = R_NEW0 (BodyCache);
+	if (!g->bodies || !bc) {
+		free (bc);
+		return body;
+	}
+	bc->body = strdup (body);
+	bc->jmps_hash = hash;
+	bc->n_jmps = R_MAX (core->asmqjmps_count - count, 0);
+	if (bc->n_jmps) {
+		bc->jmps = R_NEWS (ut64, bc->n_jmps);
+		if (bc->jmps) {
+			memcpy (bc->jmps, core->asmqjmps + count + 1, bc->n_jmps * sizeof (ut64));
+		}
+	}
+	if (!bc->body || (bc->n_jmps && !bc->jmps)) {
+		free (bc->body);
+		free (bc->jmps);
+		free (bc);
+		return body;
+	}
+	body_cache_key (key, sizeof (key), b, opts);
+	ht_update (g->bodies, key, bc);
+	return body;
+}
+
+/* in huge graphs the bodies are only rendered when the nodes get in view */
+static bool lazy_bodies(RAGraph *g, RCore *core, RAnalFunction *fcn) {
+	int lazy = r_config_get_i (core->config, "graph.lazy");
+	return g->is_interactive == 1 && lazy > 0 && r_list_length (fcn->bbs) > lazy
+		&& body_cache_enabled (core);
+}
+
+/* placeholder used to size the nodes not rendered yet, one line per
+ * instruction */
+static char *get_lazy_body(RAnalBlock *b) {
+	int i, lines = R_MAX (b->ninstr, 1);
+	char *body = malloc ((LAZY_BODY_WIDTH + 1) * lines + 1);
+	if (!body) {
+		return NULL;
+	}
+	for (i = 0; i < lines; i++) {
+		memset (body + i * (LAZY_BODY_WIDTH + 1), ' ', LAZY_BODY_WIDTH);
+		body[i * (LAZY_BODY_WIDTH + 1) + LAZY_BODY_WIDTH] = '\n';
+	}
+	body[(LAZY_BODY_WIDTH + 1) * lines] = 0;
+	return body;
+}
+
 static int bbcmp(RAnalBlock *a, RAnalBlock *b) {
 	return a->addr - b->addr;
 }
@@ -2094,13 +2471,25 @@ static void get_bbupdate(RAGraph *g, RCore *core, RAnalFunction *fcn) {
 		return;
 	}
 	r_list_sort (fcn->bbs, (RListComparator) bbcmp);
+	/* something changed, forget about the bodies rendered before */
+	body_cache_flush (g);
+	const bool cache = body_cache_enabled (core);
+	const bool lazy = lazy_bodies (g, core, fcn);
+	if (lazy) {
+		core->asmqjmps_count = 0;
+	}
 
 	shortcuts = r_config_get_i (core->config, "graph.nodejmps");
 	r_list_foreach (fcn->bbs, iter, bb) {
 		if (bb->addr == UT64_MAX) {
 			continue;
 		}
-		char *body = get_bb_body (core, bb, mode2opts (g), fcn, emu, saved_gp, saved_arena);
+		char *body = NULL;
+		if (!lazy) {
+			body = cache
+				? get_bb_body_cached (g, core, bb, mode2opts (g), fcn)
+				: get_bb_body (core, bb, mode2opts (g), fcn, emu, saved_gp, saved_arena);
+		}
 		char *title = get_title (bb->addr);
 
 		if (shortcuts) {
@@ -2111,9 +2500,13 @@ static void get_bbupdate(RAGraph *g, RCore *core, RAnalFunction *fcn) {
 			}
 		}
 		RANode *node = r_agraph_get_node (g, title);
-		if (node) {
+		if (node && lazy) {
+			/* the old body sizes the node until it gets rendered again */
+			node->is_lazy = true;
+		} else if (node) {
 			free (node->body);
 			node->body = body;
+			node->is_lazy = false;
 		} else {
 			free (body);
 		}
@@ -2169,16 +2562,36 @@ static int get_bbnodes(RAGraph *g, RCore *core, RAnalFunction *fcn) {
 		saved_arena = r_reg_arena_peek (core->anal->reg);
 	}
 	r_list_sort (fcn->bbs, (RListComparator) bbcmp);
+	const bool cache = body_cache_enabled (core);
+	const bool lazy = lazy_bodies (g, core, fcn);
+	if (lazy) {
+		core->asmqjmps_count = 0;
+	}
 
 	core->keep_asmqjmps = false;
 	r_list_foreach (fcn->bbs, iter, bb) {
 		if (bb->addr == UT64_MAX) {
 			continue;
 		}
-		char *body = get_bb_body (core, bb, mode2opts (g), fcn, emu, saved_gp, saved_arena);
+		char *body = NULL;
+		bool is_lazy = false;
+		if (lazy) {
+			body = body_cache_get (g, core, bb, mode2opts (g));
+			if (!body) {
+				body = get_lazy_body (bb);
+				is_lazy = true;
+			}
+		} else if (cache) {
+			body = get_bb_body_cached (g, core, bb, mode2opts (g), fcn);
+		} else {
+			body = get_bb_body (core, bb, mode2opts (g), fcn, emu, saved_gp, saved_arena);
+		}
 		char *title = get_title (bb->addr);
 
 		RANode *node = r_agraph_add_node (g, title, body);
+		if (node) {
+			node->is_lazy = is_lazy;
+		}
 		shortcuts = g->is_interactive ? r_config_get_i (core->config, "graph.nodejmps") : false;
 
 		if (shortcuts) {
@@ -2560,6 +2973,14 @@ static void agraph_update_seek(RAGraph *g, RANode *n, int force) {
 	g->force_update_seek = force;
 }
 
+/* does the box of the node intersect the canvas, the title bar included */
+static bool agraph_node_visible(const RAGraph *g, const RANode *n) {
+	const RConsCanvas *can = g->can;
+	const int x = n->x + can->sx;
+	const int y = n->y + can->sy;
+	return x < can->w && x + n->w > 0 && y <= can->h && y + n->h + 1 > 0;
+}
+
 static void agraph_print_node(const RAGraph *g, RANode *n) {
 	if (n->is_dummy) {
 		return;
@@ -2570,7 +2991,7 @@ static void agraph_print_node(const RAGraph *g, RANode *n) {
 		tiny_RANode_print (g, n, cur);
 	} else if (isMini || n->is_mini) {
 		mini_RANode_print (g, n, cur, isMini);
-	} else {
+	} else if (agraph_node_visible (g, n)) {
 		normal_RANode_print (g, n, cur);
 	}
 }
@@ -3140,6 +3561,56 @@ static void agraph_update_title(RAGraph *g, RAnalFunction *fcn) {
 	r_str_free (new_title);
 }
 
+/* render the bodies of the lazy nodes in view, returns true when the size
+ * of any of them changed and the layout must be computed again */
+static bool agraph_render_lazy_nodes(RAGraph *g, RCore *core, RAnalFunction *fcn) {
+	const RList *nodes = r_graph_get_nodes (g->graph);
+	const bool fixed_size = is_mini (g);
+	bool resized = false;
+	RGraphNode *gn;
+	RListIter *it;
+	RANode *n;
+
+	core->keep_asmqjmps = true;
+	graph_foreach_anode (nodes, it, gn, n) {
+		if (!n->is_lazy || (gn != g->curnode && !agraph_node_visible (g, n))) {
+			continue;
+		}
+		n->is_lazy = false;
+		RAnalBlock *bb = r_anal_fcn_bbget_at (fcn, r_num_get (NULL, n->title));
+		char *body = bb? get_bb_body_cached (g, core, bb, mode2opts (g), fcn): NULL;
+		if (!body) {
+			continue;
+		}
+		if (!fixed_size && !n->is_mini) {
+			int h0, h1;
+			int w0 = r_str_bounds (n->body, &h0);
+			int w1 = r_str_bounds (body, &h1);
+			resized |= w0 != w1 || h0 != h1;
+		}
+		free (n->body);
+		n->body = body;
+	}
+	return resized;
+}
+
+/* nodes that grow or shrink when rendered move the ones around them, keep
+ * the current one still on the screen while the layout settles */
+static void agraph_load_lazy_nodes(RAGraph *g, RCore *core, RAnalFunction *fcn) {
+	int i;
+	for (i = 0; i < LAZY_PASSES && agraph_render_lazy_nodes (g, core, fcn); i++) {
+		RANode *cur = get_anode (g->curnode);
+		int x = cur? cur->x + g->can->sx: 0;
+		int y = cur? cur->y + g->can->sy: 0;
+		update_node_dimension (g->graph, is_mini (g), g->zoom, g->edgemode, g->is_callgraph, g->layout);
+		agraph_set_layout (g);
+		if (cur) {
+			g->can->sx = x - cur->x;
+			g->can->sy = y - cur->y;
+		}
+	}
+}
+
 /* look for any change in the state of the graph
  * and update what's necessary */
 static int check_changes(RAGraph *g, int is_interactive,
@@ -3153,6 +3624,12 @@ static int check_changes(RAGraph *g, int is_interactive,
 			oldpos[0] = g->can->sx;
 			oldpos[1] = g->can->sy;
 		}
+		/* reloading the function in the same mode means that it changed */
+		if (fcn && fcn->addr == g->bodies_addr && mode2opts (g) == g->bodies_mode) {
+			body_cache_flush (g);
+		}
+		g->bodies_addr = fcn? fcn->addr: UT64_MAX;
+		g->bodies_mode = mode2opts (g);
 		if (!agraph_reload_nodes (g, core, fcn)) {
 			return false;
 		}
@@ -3194,6 +3671,9 @@ static int check_changes(RAGraph *g, int is_interactive,
 		g->can->sx = oldpos[0];
 		g->can->sy = oldpos[1];
 	}
+	if (core && fcn && is_interactive) {
+		agraph_load_lazy_nodes (g, core, fcn);
+	}
 	g->need_reload_nodes = false;
 	g->need_update_dim = false;
 	g->need_set_layout = false;
@@ -3326,6 +3806,7 @@ static int agraph_refresh(struct agraph_refresh_data *grd) {
 						return 0;
 					}
 					r_core_cmd0 (core, "af");
+					body_cache_flush (g);
 				}
 				f = r_anal_get_fcn_in (core->anal, core->offset, 0);
 				g->need_reload_nodes = true;
@@ -3647,6 +4128,8 @@ R_API void r_agraph_free(RAGraph *g) {
 		agraph_free_nodes (g);
 		r_graph_free (g->graph);
 		r_list_free (g->edges);
+		r_list_free (g->layouts);
+		body_cache_flush (g);
 		r_agraph_set_title (g, NULL);
 		sdb_free (g->db);
 		r_cons_canvas_free (g->can);
@@ -3665,6 +4148,14 @@ R_API RAGraph *r_agraph_new(RConsCanvas *can) {
 	return g;
 }
 
+static void agraph_swap_layouts(RAGraph *a, RAGraph *b) {
+	if (a && b) {
+		RList *layouts = a->layouts;
+		a->layouts = b->layouts;
+		b->layouts = layouts;
+	}
+}
+
 static void visual_offset(RAGraph *g, RCore *core) {
 	char buf[256];
 	int rows;
@@ -3856,6 +4347,8 @@ R_API int r_core_visual_graph(RCore *core, RAGraph *g, RAnalFunction *_fcn, int
 		}
 		g->is_tiny = is_interactive == 2;
 		g->layout = r_config_get_i (core->config, "graph.layout");
+		/* keep the layouts of the functions across sessions */
+		agraph_swap_layouts (g, core->graph);
 	} else {
 		o_can = g->can;
 	}
@@ -4528,6 +5021,7 @@ R_API int r_core_visual_graph(RCore *core, RAGraph *g, RAnalFunction *_fcn, int
 
 	free (grd);
 	if (graph_allocated) {
+		agraph_swap_layouts (g, core->graph);
 		r_agraph_free (g);
 		r_config_set_i (core->config, "scr.interactive", o_scrinteractive);
 	} else {
@@ -54,12 +54,8 @@ R_API void r_core_wait(RCore *core) {
 	r_th_wait (rapthread);
 }
 
-static void http_logf(RCore *core, const char *fmt, ...) {
-	bool http_log_enabled = r_config_get_i (core->config, "http.log");
-	va_list ap;
-	va_start (ap, fmt);
+static void http_vlogf(bool http_log_enabled, const char *http_log_file, const char *fmt, va_list ap) {
 	if (http_log_enabled) {
-		const char *http_log_file = r_config_get (core->config, "http.logfile");
 		if (http_log_file && *http_log_file) {
 			char * msg = calloc (4096, 1);
 			if (msg) {
@@ -71,6 +67,13 @@ static void http_logf(RCore *core, const char *fmt, ...) {
 			vfprintf (stderr, fmt, ap);
 		}
 	}
+}
+
+static void http_logf(RCore *core, const char *fmt, ...) {
+	va_list ap;
+	va_start (ap, fmt);
+	http_vlogf (r_config_get_i (core->config, "http.log"),
+		r_config_get (core->config, "http.logfile"), fmt, ap);
 	va_end (ap);
 }
 
@@ -409,11 +412,359 @@ static void activateDieTime (RCore *core) {
 	}
 }
 
+/* http.* settings read once when the server starts, so the workers can
+ * answer the requests that don't need the core without touching it */
+typedef struct {
+	char *root;
+	char *homeroot;
+	char *allow;
+	char *logfile;
+	char headers[128];
+	bool log;
+	bool verbose;
+	bool dirlist;
+} HttpConf;
+
+static void http_conf_init(HttpConf *hc, RConfig *cfg) {
+	memset (hc, 0, sizeof (HttpConf));
+	hc->root = strdup (r_str_get (r_config_get (cfg, "http.root")));
+	hc->homeroot = strdup (r_str_get (r_config_get (cfg, "http.homeroot")));
+	hc->allow = strdup (r_str_get (r_config_get (cfg, "http.allow")));
+	hc->logfile = strdup (r_str_get (r_config_get (cfg, "http.logfile")));
+	hc->log = r_config_get_i (cfg, "http.log");
+	hc->verbose = r_config_get_i (cfg, "http.verbose");
+	hc->dirlist = r_config_get_i (cfg, "http.dirlist");
+	if (r_config_get_i (cfg, "http.cors")) {
+		strcpy (hc->headers, "Access-Control-Allow-Origin: *\n"
+			"Access-Control-Allow-Headers: Origin, "
+			"X-Requested-With, Content-Type, Accept\n");
+	}
+}
+
+static void http_conf_fini(HttpConf *hc) {
+	free (hc->root);
+	free (hc->homeroot);
+	free (hc->allow);
+	free (hc->logfile);
+}
+
+static void http_conf_logf(HttpConf *hc, const char *fmt, ...) {
+	va_list ap;
+	va_start (ap, fmt);
+	http_vlogf (hc->log, hc->logfile, fmt, ap);
+	va_end (ap);
+}
+
+static bool http_allowed(HttpConf *hc, RSocketHTTPRequest *rs) {
+	bool accepted = false;
+	const char *allows_host;
+	char *p, *peer, *allows;
+	int i, count;
+
+	if (!hc->allow || !*hc->allow) {
+		return true;
+	}
+	peer = r_socket_to_string (rs->s);
+	allows = strdup (hc->allow);
+	//eprintf ("Firewall (%s)\n", allows);
+	count = r_str_split (allows, ',');
+	p = strchr (peer, ':');
+	if (p) {
+		*p = 0;
+	}
+	for (i = 0; i < count; i++) {
+		allows_host = r_str_word_get0 (allows, i);
+		//eprintf ("--- (%s) (%s)\n", host, peer);
+		if (!strcmp (allows_host, peer)) {
+			accepted = true;
+			break;
+		}
+	}
+	free (peer);
+	free (allows);
+	return accepted;
+}
+
+/* OPTIONS and files from http.root, everything else runs on the core */
+static bool http_is_static(RSocketHTTPRequest *rs) {
+	if (!rs->method || !rs->path) {
+		return false;
+	}
+	if (!strcmp (rs->method, "OPTIONS")) {
+		return true;
+	}
+	return !strcmp (rs->method, "GET") && strncmp (rs->path, "/up/", 4)
+		&& strncmp (rs->path, "/cmd/", 5);
+}
+
+static void http_serve_file(HttpConf *hc, RSocketHTTPRequest *rs, const char *dir, const char *headers) {
+	const char *root = hc->root;
+	const char *homeroot = hc->homeroot;
+	char *path;
+	if (!strcmp (rs->path, "/")) {
+		free (rs->path);
+		rs->path = strdup ("/index.html");
+	}
+	if (homeroot && *homeroot) {
+		char *homepath = r_file_abspath (homeroot);
+		path = r_file_root (homepath, rs->path);
+		free (homepath);
+		if (!r_file_exists (path) && !r_file_is_directory (path)) {
+			free (path);
+			path = r_file_root (root, rs->path);
+		}
+	} else {
+		path = r_file_root (root, rs->path);
+	}
+	// FD IS OK HERE
+	if (rs->path [strlen (rs->path) - 1] == '/') {
+		path = r_str_append (path, "index.html");
+		//rs->path = r_str_append (rs->path, "index.html");
+	} else {
+		//snprintf (path, sizeof (path), "%s/%s", root, rs->path);
+		if (r_file_is_directory (path)) {
+			char *res = r_str_newf ("Location: %s/\n%s", rs->path, headers);
+			r_socket_http_response (rs, 302, NULL, 0, res);
+			free (path);
+			free (res);
+			return;
+		}
+	}
+	if (r_file_exists (path)) {
+		int sz = 0;
+		char *f = r_file_slurp (path, &sz);
+		if (f) {
+			const char *ct = NULL;
+			if (strstr (path, ".js")) {
+				ct = "Content-Type: application/javascript\n";
+			}
+			if (strstr (path, ".css")) {
+				ct = "Content-Type: text/css\n";
+			}
+			if (strstr (path, ".html")) {
+				ct = "Content-Type: text/html\n";
+			}
+			char *hdr = r_str_newf ("%s%s", ct, headers);
+			r_socket_http_response (rs, 200, f, sz, hdr);
+			free (hdr);
+			free (f);
+		} else {
+			r_socket_http_response (rs, 403, "Permission denied", 0, headers);
+			http_conf_logf (hc, "http: Cannot open '%s'\n", path);
+		}
+	} else {
+		if (dir) {
+			char *resp = rtr_dir_files (dir);
+			http_conf_logf (hc, "Dirlisting %s\n", dir);
+			r_socket_http_response (rs, 404, resp, 0, headers);
+			free (resp);
+		} else {
+			http_conf_logf (hc, "File '%s' not found\n", path);
+			r_socket_http_response (rs, 404, "File not found\n", 0, headers);
+		}
+	}
+	free (path);
+}
+
+/* answered in the worker, returns whether the connection can be kept */
+static bool http_serve_static(HttpConf *hc, RSocketHTTPRequest *rs) {
+	if (!http_allowed (hc, rs)) {
+		return false;
+	}
+	if (!rs->method || !rs->path) {
+		http_conf_logf (hc, "Invalid http headers received from client\n");
+		return false;
+	}
+	if (hc->verbose) {
+		char *peer = r_socket_to_string (rs->s);
+		http_conf_logf (hc, "[HTTP] %s %s\n", peer, rs->path);
+		free (peer);
+	}
+	if (!strcmp (rs->method, "OPTIONS")) {
+		r_socket_http_response (rs, 200, "", 0, hc->headers);
+	} else {
+		char *dir = (hc->dirlist && r_file_is_directory (rs->path))? strdup (rs->path): NULL;
+		http_serve_file (hc, rs, dir, hc->headers);
+		free (dir);
+	}
+	return true;
+}
+
+/* http workers accept and parse requests concurrently and keep their
+ * connections alive. They answer the static ones themselves, the ones that
+ * need the core are queued and run serialized in the server loop because
+ * RCore and RCons are not thread safe */
+typedef struct http_pool_t HttpPool;
+
+typedef struct {
+	HttpPool *pool;
+	RThread *th;
+	RThreadSemaphore *done;
+	RSocketHTTPRequest *rs;
+	bool keep;
+} HttpWorker;
+
+struct http_pool_t {
+	RSocket *s;
+	HttpConf *conf;
+	RThreadLock *lock;
+	RThreadLock *accept_lock;
+	RThreadCond *queued; // signaled under lock when a request is queued
+	RList *queue;
+	HttpWorker *workers;
+	int count;
+	int timeout;
+	bool stop;
+};
+
+/* wait up to http.timeout seconds for the next request on an idle connection */
+static bool http_worker_idle(HttpPool *pool, RSocket *s) {
+	int i, secs = R_MAX (pool->timeout, 1);
+	for (i = 0; i < secs && !pool->stop; i++) {
+		int r = r_socket_ready (s, 0, 1000 * 1000);
+		if (r < 0) {
+			return false;
+		}
+		if (r > 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static RThreadFunctionRet http_worker_thread(RThread *th) {
+	HttpWorker *w = th->user;
+	HttpPool *pool = w->pool;
+	while (!pool->stop) {
+		r_th_lock_enter (pool->accept_lock);
+		RSocketHTTPRequest *rs = pool->stop? NULL: r_socket_http_accept (pool->s, 1, pool->timeout);
+		r_th_lock_leave (pool->accept_lock);
+		while (rs) {
+			w->rs = rs;
+			w->keep = false;
+			if (!http_allowed (pool->conf, rs) || !rs->method || !rs->path) {
+				http_serve_static (pool->conf, rs);
+				r_socket_http_close (rs);
+				break;
+			}
+			if (http_is_static (rs)) {
+				w->keep = http_serve_static (pool->conf, rs) && rs->keepalive;
+				if (!w->keep || pool->stop || !http_worker_idle (pool, rs->s)) {
+					r_socket_http_close (rs);
+					break;
+				}
+				rs = r_socket_http_next (rs);
+				continue;
+			}
+			r_th_lock_enter (pool->lock);
+			bool queued = !pool->stop;
+			if (queued) {
+				r_list_append (pool->queue, w);
+				r_th_cond_signal (pool->queued);
+			}
+			r_th_lock_leave (pool->lock);
+			if (queued) {
+				r_th_sem_wait (w->done);
+			}
+			if (!w->keep || pool->stop || !http_worker_idle (pool, rs->s)) {
+				r_socket_http_close (rs);
+				break;
+			}
+			rs = r_socket_http_next (rs);
+		}
+		w->rs = NULL;
+	}
+	return R_TH_STOP;
+}
+
+static HttpPool *http_pool_new(RSocket *s, HttpConf *conf, int count, int timeout) {
+	int i;
+	HttpPool *pool = R_NEW0 (HttpPool);
+	if (!pool) {
+		return NULL;
+	}
+	pool->workers = R_NEWS0 (HttpWorker, count);
+	if (!pool->workers) {
+		free (pool);
+		return NULL;
+	}
+	pool->s = s;
+	pool->conf = conf;
+	pool->timeout = timeout;
+	pool->lock = r_th_lock_new (false);
+	pool->accept_lock = r_th_lock_new (false);
+	pool->queued = r_th_cond_new ();
+	pool->queue = r_list_new ();
+	for (i = 0; i < count; i++) {
+		HttpWorker *w = &pool->workers[i];
+		w->pool = pool;
+		w->done = r_th_sem_new (0);
+		w->th = r_th_new (http_worker_thread, w, 0);
+		if (!w->th) {
+			r_th_sem_free (w->done);
+			break;
+		}
+		r_th_start (w->th, true);
+		pool->count++;
+	}
+	return pool;
+}
+
+static void http_pool_free(HttpPool *pool) {
+	int i;
+	if (!pool) {
+		return;
+	}
+	r_th_lock_enter (pool->lock);
+	pool->stop = true;
+	HttpWorker *w;
+	while ((w = r_list_pop_head (pool->queue))) {
+		w->keep = false;
+		r_th_sem_post (w->done);
+	}
+	r_th_lock_leave (pool->lock);
+	for (i = 0; i < pool->count; i++) {
+		r_th_wait (pool->workers[i].th);
+		r_th_free (pool->workers[i].th);
+		r_th_sem_free (pool->workers[i].done);
+	}
+	r_list_free (pool->queue);
+	r_th_lock_free (pool->lock);
+	r_th_lock_free (pool->accept_lock);
+	r_th_cond_free (pool->queued);
+	free (pool->workers);
+	free (pool);
+}
+
+/* next parsed request, or NULL if none arrived within a second */
+static RSocketHTTPRequest *http_pool_next(HttpPool *pool, HttpWorker **w) {
+	r_th_lock_enter (pool->lock);
+	if (r_list_empty (pool->queue)) {
+		r_th_cond_wait_timeout (pool->queued, pool->lock, 1000);
+	}
+	*w = r_list_pop_head (pool->queue);
+	r_th_lock_leave (pool->lock);
+	return *w? (*w)->rs: NULL;
+}
+
+/* hand the connection back to its worker, or close it */
+static void http_release(HttpWorker *w, RSocketHTTPRequest *rs, bool keep) {
+	if (w) {
+		w->keep = keep && rs->keepalive;
+		r_th_sem_post (w->done);
+	} else {
+		r_socket_http_close (rs);
+	}
+}
+
 // return 1 on error
 static int r_core_rtr_http_run(RCore *core, int launch, int browse, const char *path) {
 	RConfig *newcfg = NULL, *origcfg = NULL;
 	char headers[128] = R_EMPTY;
 	RSocketHTTPRequest *rs;
+	HttpPool *pool = NULL;
+	HttpWorker *w = NULL;
+	HttpConf conf;
 	char buf[32];
 	int ret = 0;
 	RSocket *s;
@@ -423,7 +774,6 @@ static int r_core_rtr_http_run(RCore *core, int launch, int browse, const char *
 	const char *root = r_config_get (core->config, "http.root");
 	const char *homeroot = r_config_get (core->config, "http.homeroot");
 	const char *port = r_config_get (core->config, "http.port");
-	const char *allow = r_config_get (core->config, "http.allow");
 	const char *httpui = r_config_get (core->config, "http.ui");
 
 	if (!r_file_is_directory (root)) {
@@ -528,6 +878,11 @@ static int r_core_rtr_http_run(RCore *core, int launch, int browse, const char *
 	memcpy (newblk, core->block, core->blocksize);
 
 	core->block = newblk;
+	http_conf_init (&conf, core->config);
+	int workers = r_config_get_i (core->config, "http.workers");
+	if (workers > 0) {
+		pool = http_pool_new (s, &conf, workers, timeout);
+	}
 // TODO: handle mutex lock/unlock here
 	r_cons_break_push ((RConsBreak)r_core_rtr_http_stop, core);
 	while (!r_cons_is_breaked ()) {
@@ -551,7 +906,15 @@ static int r_core_rtr_http_run(RCore *core, int launch, int browse, const char *
 		/* this is blocking */
 		activateDieTime (core);
 
-		rs = r_socket_http_accept (s, 1, timeout);
+		if (pool) {
+			rs = http_pool_next (pool, &w);
+		} else {
+			w = NULL;
+			rs = r_socket_http_accept (s, 1, timeout);
+			if (rs) {
+				rs->keepalive = false;
+			}
+		}
 
 		origoff = core->offset;
 		origblk = core->block;
@@ -571,35 +934,13 @@ static int r_core_rtr_http_run(RCore *core, int launch, int browse, const char *
 			r_sys_usleep (100);
 			continue;
 		}
-		if (allow && *allow) {
-			bool accepted = false;
-			const char *allows_host;
-			char *p, *peer = r_socket_to_string (rs->s);
-			char *allows = strdup (allow);
-			//eprintf ("Firewall (%s)\n", allows);
-			int i, count = r_str_split (allows, ',');
-			p = strchr (peer, ':');
-			if (p) {
-				*p = 0;
-			}
-			for (i = 0; i < count; i++) {
-				allows_host = r_str_word_get0 (allows, i);
-				//eprintf ("--- (%s) (%s)\n", host, peer);
-				if (!strcmp (allows_host, peer)) {
-					accepted = true;
-					break;
-				}
-			}
-			free (peer);
-			free (allows);
-			if (!accepted) {
-				r_socket_http_close (rs);
-				continue;
-			}
+		if (!http_allowed (&conf, rs)) {
+			http_release (w, rs, false);
+			continue;
 		}
 		if (!rs->method || !rs->path) {
 			http_logf (core, "Invalid http headers received from client\n");
-			r_socket_http_close (rs);
+			http_release (w, rs, false);
 			continue;
 		}
 		dir = NULL;
@@ -720,13 +1061,13 @@ static int r_core_rtr_http_run(RCore *core, int launch, int browse, const char *
 						if (!r_sandbox_enable (0)) {
 							if (!strcmp (cmd, "=h*")) {
 								/* do stuff */
-								r_socket_http_close (rs);
+								http_release (w, rs, false);
 								free (dir);
 								free (refstr);
 								ret = -2;
 								goto the_end;
 							} else if (!strcmp (cmd, "=h--")) {
-								r_socket_http_close (rs);
+								http_release (w, rs, false);
 								ret = 0;
 								goto the_end;
 							}
@@ -735,74 +1076,7 @@ static int r_core_rtr_http_run(RCore *core, int launch, int browse, const char *
 				}
 				free (refstr);
 			} else {
-				const char *root = r_config_get (core->config, "http.root");
-				const char *homeroot = r_config_get (core->config, "http.homeroot");
-				char *path;
-				if (!strcmp (rs->path, "/")) {
-					free (rs->path);
-					rs->path = strdup ("/index.html");
-				}
-				if (homeroot && *homeroot) {
-					char *homepath = r_file_abspath (homeroot);
-					path = r_file_root (homepath, rs->path);
-					free (homepath);
-					if (!r_file_exists (path) && !r_file_is_directory (path)) {
-						free (path);
-						path = r_file_root (root, rs->path);
-					}
-				} else {
-					path = r_file_root (root, rs->path);
-				}
-				// FD IS OK HERE
-				if (rs->path [strlen (rs->path) - 1] == '/') {
-					path = r_str_append (path, "index.html");
-					//rs->path = r_str_append (rs->path, "index.html");
-				} else {
-					//snprintf (path, sizeof (path), "%s/%s", root, rs->path);
-					if (r_file_is_directory (path)) {
-						char *res = r_str_newf ("Location: %s/\n%s", rs->path, headers);
-						r_socket_http_response (rs, 302, NULL, 0, res);
-						r_socket_http_close (rs);
-						free (path);
-						free (res);
-						R_FREE (dir);
-						continue;
-					}
-				}
-				if (r_file_exists (path)) {
-					int sz = 0;
-					char *f = r_file_slurp (path, &sz);
-					if (f) {
-						const char *ct = NULL;
-						if (strstr (path, ".js")) {
-							ct = "Content-Type: application/javascript\n";
-						}
-						if (strstr (path, ".css")) {
-							ct = "Content-Type: text/css\n";
-						}
-						if (strstr (path, ".html")) {
-							ct = "Content-Type: text/html\n";
-						}
-						char *hdr = r_str_newf ("%s%s", ct, headers);
-						r_socket_http_response (rs, 200, f, sz, hdr);
-						free (hdr);
-						free (f);
-					} else {
-						r_socket_http_response (rs, 403, "Permission denied", 0, headers);
-						http_logf (core, "http: Cannot open '%s'\n", path);
-					}
-				} else {
-					if (dir) {
-						char *resp = rtr_dir_files (dir);
-						http_logf (core, "Dirlisting %s\n", dir);
-						r_socket_http_response (rs, 404, resp, 0, headers);
-						free (resp);
-					} else {
-						http_logf (core, "File '%s' not found\n", path);
-						r_socket_http_response (rs, 404, "File not found\n", 0, headers);
-					}
-				}
-				free (path);
+				http_serve_file (&conf, rs, dir, headers);
 			}
 		} else if (!strcmp (rs->method, "POST")) {
 			ut8 *ret;
@@ -833,7 +1107,7 @@ static int r_core_rtr_http_run(RCore *core, int launch, int browse, const char *
 		} else {
 			r_socket_http_response (rs, 404, "Invalid protocol", 0, headers);
 		}
-		r_socket_http_close (rs);
+		http_release (w, rs, true);
 		free (dir);
 	}
 the_end:
@@ -854,6 +1128,8 @@ the_end:
 	}
 	r_cons_break_pop ();
 	core->http_up = false;
+	http_pool_free (pool);
+	http_conf_fini (&conf);
 	r_socket_free (s);
 	r_config_free (newcfg);
 	if (restoreSandbox) {
@@ -1876,6 +1876,10 @@ R_API int r_core_visual_cmd(RCore *core, const char *arg) {
 	if (ch < 2) {
 		return 1;
 	}
+	if (!strchr ("hjklHJKLgGcuU0123456789", ch)) {
+		/* anything else may change what the disassembly shows */
+		r_core_print_disasm_flush (core);
+	}
 	if (r_cons_singleton ()->mouse_event) {
 		wheelspeed = r_config_get_i (core->config, "scr.wheel.speed");
 	} else {
@@ -3181,7 +3185,9 @@ static void visual_refresh(RCore *core) {
 			r_core_cmd0 (core, debugstr);
 		} else {
 			core->print->screen_bounds = 1LL;
+			core->visual.cache_lines = !zoom && r_config_get_i (core->config, "scr.cache");
 			r_core_cmd0 (core, zoom? "pz": printfmt[PIDX]);
+			core->visual.cache_lines = false;
 		}
 	}
 	core->print->cur_enabled = ce;
@@ -3282,6 +3288,7 @@ R_API int r_core_visual(RCore *core, const char *input) {
 
 	static char debugstr[512];
 	core->print->flags |= R_PRINT_FLAGS_ADDRMOD;
+	r_core_print_disasm_flush (core);
 	do {
 dodo:
 		r_core_visual_tab_update (core);
@@ -3384,6 +3391,7 @@ dodo:
 	r_cons_singleton ()->teefile = teefile;
 	r_cons_set_cup (false);
 	r_cons_clear00 ();
+	r_core_print_disasm_flush (core);
 	core->vmode = false;
 	core->cons->event_resize = NULL;
 	core->cons->event_data = NULL;
@@ -39,9 +39,7 @@ R_API void r_debug_session_list(RDebug *dbg) {
 
 R_API RDebugSession *r_debug_session_add(RDebug *dbg, RListIter **tail) {
 	RDebugSession *session;
-	RDebugSnapDiff *diff;
 	RListIter *iter;
-	RDebugMap *map;
 	ut64 addr;
 	int i, perms = R_PERM_RW;
 
@@ -76,15 +74,11 @@ R_API RDebugSession *r_debug_session_add(RDebug *dbg, RListIter **tail) {
 	/* save memory snapshots */
 	session->memlist = r_list_newf ((RListFree)r_debug_diff_free);
 
-	r_debug_map_sync (dbg);
-	r_list_foreach (dbg->maps, iter, map) {
-		if (!perms || (map->perm & perms) == perms) {
-			diff = r_debug_snap_map (dbg, map);
-			if (diff) {
-				/* Add diff history */
-				r_list_append (session->memlist, diff);
-			}
-		}
+	RList *diffs = r_debug_snap_maps (dbg, perms);
+	if (diffs) {
+		/* Add diff history */
+		r_list_join (session->memlist, diffs);
+		r_list_free (diffs);
 	}
 
 	r_list_append (dbg->sessions, session);
@@ -1,24 +1,121 @@
-/* radare - LGPL - Copyright 2015-2017 - pancake, rkx1209 */
+/* radare - LGPL - Copyright 2015-2018 - pancake, rkx1209 */
 
 #include <r_debug.h>
+#if __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* pages are compared with a cheap non-cryptographic hash stored in the
+ * first bytes of the 128 byte slots kept by the session files */
+static void page_hash(ut8 *out, const ut8 *buf, int len) {
+	r_write_le32 (out, r_hash_xxhash (buf, len));
+}
+
+static bool page_hash_eq(const ut8 *a, const ut8 *b) {
+	return !memcmp (a, b, R_HASH_SIZE_XXHASH);
+}
+
+#if __linux__
+#define PM_SOFT_DIRTY (1ULL << 55)
+#define PM_PRESENT (1ULL << 63)
+
+static bool soft_dirty_usable(RDebug *dbg) {
+	return dbg->pid > 0 && dbg->h && !strcmp (dbg->h->name, "native")
+		&& sysconf (_SC_PAGESIZE) == SNAP_PAGE_SIZE;
+}
+
+static ut64 *snap_pagemap(RDebug *dbg, RDebugSnap *snap) {
+	char path[64];
+	size_t len = (size_t)snap->page_num * sizeof (ut64);
+	snprintf (path, sizeof (path), "/proc/%d/pagemap", dbg->pid);
+	int fd = open (path, O_RDONLY);
+	if (fd == -1) {
+		return NULL;
+	}
+	ut64 *pm = malloc (len);
+	off_t off = (off_t)(snap->addr / SNAP_PAGE_SIZE) * sizeof (ut64);
+	if (pm && pread (fd, pm, len, off) != len) {
+		R_FREE (pm);
+	}
+	close (fd);
+	return pm;
+}
+
+static bool snap_clear_refs(RDebug *dbg) {
+	char path[64];
+	snprintf (path, sizeof (path), "/proc/%d/clear_refs", dbg->pid);
+	int fd = open (path, O_WRONLY);
+	if (fd == -1) {
+		return false;
+	}
+	bool ret = write (fd, "4", 1) == 1;
+	close (fd);
+	return ret;
+}
+#endif
+
+/* reset the soft-dirty bits of the process after capturing the snapshots in
+ * the list. the bits are process wide, so any other snapshot loses track of
+ * its changes and must compare all of its pages again the next time */
+static void snap_track(RDebug *dbg, RList *captured) {
+#if __linux__
+	RListIter *iter;
+	RDebugSnap *snap;
+	if (!soft_dirty_usable (dbg) || r_list_empty (captured)) {
+		return;
+	}
+	/* soft-dirty is a kernel build option. the bit is never reported when
+	 * it's missing, so only trust it once a present page has been seen with it */
+	if (!dbg->soft_dirty_seen) {
+		r_list_foreach (captured, iter, snap) {
+			ut64 *pm = snap_pagemap (dbg, snap);
+			ut32 i;
+			for (i = 0; pm && i < snap->page_num; i++) {
+				if ((pm[i] & (PM_PRESENT | PM_SOFT_DIRTY)) == (PM_PRESENT | PM_SOFT_DIRTY)) {
+					dbg->soft_dirty_seen = true;
+					break;
+				}
+			}
+			free (pm);
+		}
+		if (!dbg->soft_dirty_seen) {
+			return;
+		}
+	}
+	bool cleared = snap_clear_refs (dbg);
+	r_list_foreach (dbg->snaps, iter, snap) {
+		snap->soft_dirty = false;
+	}
+	if (cleared) {
+		r_list_foreach (captured, iter, snap) {
+			snap->soft_dirty = true;
+		}
+	}
+#endif
+}
 
 R_API RDebugSnap *r_debug_snap_new() {
 	RDebugSnap *snap = R_NEW0 (RDebugSnap);
-	ut64 algobit = r_hash_name_to_bits ("sha256");
 	if (!snap) {
 		return NULL;
 	}
 	snap->history = r_list_newf (r_debug_diff_free);
-	snap->hash_ctx = r_hash_new (true, algobit);
 	return snap;
 }
 
 R_API void r_debug_snap_free(void *p) {
 	RDebugSnap *snap = (RDebugSnap *) p;
+	ut32 i;
 	r_list_free (snap->history);
 	free (snap->data);
 	free (snap->comment);
-	free (snap->hashes);
+	if (snap->hashes) {
+		for (i = 0; i < snap->page_num; i++) {
+			free (snap->hashes[i]);
+		}
+		free (snap->hashes);
+	}
 	free (snap);
 }
 
@@ -210,16 +307,13 @@ static void print_hash(ut8 *hash, int digest_size) {
 }
 #endif
 
-R_API RDebugSnapDiff *r_debug_snap_map(RDebug *dbg, RDebugMap *map) {
+static RDebugSnapDiff *snap_map(RDebug *dbg, RDebugMap *map, RList *captured) {
 	if (!dbg || !map || map->size < 1) {
 		eprintf ("Invalid map size\n");
 		return NULL;
 	}
-	ut8 *hash;
 	ut64 addr;
-	ut64 algobit = r_hash_name_to_bits ("sha256");
 	ut32 page_num = map->size / SNAP_PAGE_SIZE;
-	ut32 digest_size;
 	/* Get an existing snapshot entry */
 	RDebugSnap *snap = r_debug_snap_get_map (dbg, map);
 	if (!snap) {
@@ -250,36 +344,68 @@ R_API RDebugSnapDiff *r_debug_snap_map(RDebug *dbg, RDebugMap *map) {
 		/* Calculate all hashes of pages */
 		for (addr = snap->addr; addr < snap->addr_end; addr += SNAP_PAGE_SIZE) {
 			ut32 page_off = (addr - snap->addr) / SNAP_PAGE_SIZE;
-			digest_size = r_hash_calculate (snap->hash_ctx, algobit, &snap->data[addr - snap->addr], clust_page);
-			hash = calloc (128, 1);	// Fix hash size to 128 byte
-			memcpy (hash, snap->hash_ctx->digest, digest_size);
+			if (page_off >= page_num) {
+				break;
+			}
+			ut8 *hash = calloc (128, 1);	// Fix hash size to 128 byte
+			if (hash) {
+				page_hash (hash, &snap->data[addr - snap->addr], clust_page);
+			}
 			snap->hashes[page_off] = hash;
-			// eprintf ("0x%08"PFMT64x"(page: %d)...\n",addr, page_off);
-			// print_hash (hash, digest_size);
 		}
 
 		r_list_append (dbg->snaps, snap);
-		goto okay;
-	} else {
-		/* A base snapshot have already been saved. *
-		        So we only need to save different parts. */
-		return r_debug_diff_add (dbg, snap);
+		r_list_append (captured, snap);
+		return NULL;
 	}
+	/* A base snapshot have already been saved. *
+	        So we only need to save different parts. */
+	RDebugSnapDiff *diff = r_debug_diff_add (dbg, snap);
+	r_list_append (captured, snap);
+	return diff;
 error:
 	free (snap);
-okay:
 	return NULL;
 }
 
-R_API int r_debug_snap_all(RDebug *dbg, int perms) {
+R_API RDebugSnapDiff *r_debug_snap_map(RDebug *dbg, RDebugMap *map) {
+	RList *captured = r_list_new ();
+	if (!captured) {
+		return NULL;
+	}
+	RDebugSnapDiff *diff = snap_map (dbg, map, captured);
+	snap_track (dbg, captured);
+	r_list_free (captured);
+	return diff;
+}
+
+/* snapshot all the maps matching perms at once, returns the new diffs */
+R_API RList *r_debug_snap_maps(RDebug *dbg, int perms) {
 	RDebugMap *map;
 	RListIter *iter;
+	RList *diffs = r_list_new ();
+	RList *captured = r_list_new ();
+	if (!diffs || !captured) {
+		r_list_free (diffs);
+		r_list_free (captured);
+		return NULL;
+	}
 	r_debug_map_sync (dbg);
 	r_list_foreach (dbg->maps, iter, map) {
 		if (!perms || (map->perm & perms) == perms) {
-			r_debug_snap_map (dbg, map);
+			RDebugSnapDiff *diff = snap_map (dbg, map, captured);
+			if (diff) {
+				r_list_append (diffs, diff);
+			}
 		}
 	}
+	snap_track (dbg, captured);
+	r_list_free (captured);
+	return diffs;
+}
+
+R_API int r_debug_snap_all(RDebug *dbg, int perms) {
+	r_list_free (r_debug_snap_maps (dbg, perms));
 	return 0;
 }
 
@@ -329,10 +455,9 @@ R_API void r_debug_diff_free(void *p) {
 R_API RDebugSnapDiff *r_debug_diff_add(RDebug *dbg, RDebugSnap *base) {
 	RDebugSnapDiff *prev_diff = NULL, *new_diff;
 	RPageData *new_page, *last_page;
-	ut64 addr;
-	int digest_size;
+	ut64 addr, *pm = NULL;
 	ut32 page_off;
-	ut64 algobit = r_hash_name_to_bits ("sha256");
+	ut8 cur_hash[R_HASH_SIZE_XXHASH];
 	ut32 clust_page = R_MIN (SNAP_PAGE_SIZE, base->size);
 
 	new_diff = R_NEW0 (RDebugSnapDiff);
@@ -347,41 +472,60 @@ R_API RDebugSnapDiff *r_debug_diff_add(RDebug *dbg, RDebugSnap *base) {
 		prev_diff = (RDebugSnapDiff *) r_list_tail (base->history)->data;
 		memcpy (new_diff->last_changes, prev_diff->last_changes, sizeof (RPageData *) * base->page_num);
 	}
+#if __linux__
+	/* Only the pages written since the last capture need to be compared */
+	if (base->soft_dirty && soft_dirty_usable (dbg)) {
+		pm = snap_pagemap (dbg, base);
+	}
+#endif
 
 	/* Compare hash of pages. */
 	for (addr = base->addr; addr < base->addr_end; addr += SNAP_PAGE_SIZE) {
-		ut8 *prev_hash, *cur_hash;
+		ut8 *prev_hash;
+		page_off = (addr - base->addr) / SNAP_PAGE_SIZE;
+		if (page_off >= base->page_num) {
+			break;
+		}
+#if __linux__
+		if (pm && !(pm[page_off] & PM_SOFT_DIRTY)) {
+			continue;
+		}
+#endif
 		ut8 *buf = malloc (clust_page);
+		if (!buf) {
+			break;
+		}
 		/* Copy current memory value to buf and calculate cur_hash from it. */
 		dbg->iob.read_at (dbg->iob.io, addr, buf, clust_page);
-		digest_size = r_hash_calculate (base->hash_ctx, algobit, buf, clust_page);
-		cur_hash = base->hash_ctx->digest;
+		page_hash (cur_hash, buf, clust_page);
 
-		page_off = (addr - base->addr) / SNAP_PAGE_SIZE;
 		/* Check If there is any last change for this page. */
 		if (prev_diff && (last_page = prev_diff->last_changes[page_off])) {
 			/* Use hash of last SnapDiff */
-			// eprintf ("use hash of diff\n");
 			prev_hash = last_page->hash;
 		} else {
 			/* Use hash of base snapshot */
-			// eprintf ("use hash of base\n");
 			prev_hash = base->hashes[page_off];
 		}
 		/* Memory has been changed. So add new diff entry for this addr */
-		if (memcmp (cur_hash, prev_hash, digest_size) != 0) {
-			// print_hash (cur_hash, digest_size);
-			// print_hash (prev_hash, digest_size);
+		if (!prev_hash || !page_hash_eq (cur_hash, prev_hash)) {
 			/* Create new page diff entry, save one page and calculate hash. */
 			new_page = R_NEW0 (RPageData);
+			if (!new_page) {
+				free (buf);
+				break;
+			}
 			new_page->diff = new_diff;
 			new_page->page_off = page_off;
 			new_page->data = buf;
-			memcpy (new_page->hash, cur_hash, digest_size);
+			memcpy (new_page->hash, cur_hash, sizeof (cur_hash));
 			new_diff->last_changes[page_off] = new_page;	// Update last change to new page
 			r_list_append (new_diff->pages, new_page);
+		} else {
+			free (buf);
 		}
 	}
+	free (pm);
 	if (r_list_length (new_diff->pages)) {
 #if 0
 		RPageData *page;
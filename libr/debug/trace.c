@@ -1,4 +1,4 @@
-/* radare - LGPL - Copyright 2008-2016 - pancake */
+/* radare - LGPL - Copyright 2008-2018 - pancake */
 
 #include <r_debug.h>
 
@@ -6,6 +6,20 @@
 
 // DO IT WITH SDB
 
+#define TRACE_BB_MAXOPS 256
+
+/* straight-line code from an entry address to the first branch */
+typedef struct {
+	ut64 end; // address of the instruction leaving the block
+	int ninstr;
+	ut8 sizes[TRACE_BB_MAXOPS];
+} TraceBlock;
+
+static void trace_block_free(HtKv *kv) {
+	free (kv->key);
+	free (kv->value);
+}
+
 R_API RDebugTrace *r_debug_trace_new () {
 	RDebugTrace *t = R_NEW0 (RDebugTrace);
 	if (!t) {
@@ -21,7 +35,11 @@ R_API RDebugTrace *r_debug_trace_new () {
 	}
 	t->traces->free = free;
 	t->db = sdb_new0 ();
-	if (!t->db) {
+	t->log = r_tracelog_new ();
+	t->blocks = r_tracelog_new ();
+	t->bbs = ht_new (NULL, trace_block_free, NULL);
+	t->blocks_stop = UT64_MAX;
+	if (!t->db || !t->log || !t->blocks || !t->bbs) {
 		r_debug_trace_free (t);
 		return NULL;
 	}
@@ -35,6 +53,9 @@ R_API void r_debug_trace_free (RDebugTrace *trace) {
 	r_list_purge (trace->traces);
 	free (trace->traces);
 	sdb_free (trace->db);
+	r_tracelog_free (trace->log);
+	r_tracelog_free (trace->blocks);
+	ht_free (trace->bbs);
 	free (trace);
 	trace = NULL;
 }
@@ -65,6 +86,7 @@ R_API int r_debug_trace_pc(RDebug *dbg, ut64 pc) {
 	if (dbg->anal->esil && dbg->trace->enabled) {
 		r_anal_esil_trace (dbg->anal->esil, &op);
 	}
+	r_tracelog_step (dbg->trace->log, pc);
 	if (oldpc != UT64_MAX) {
 		r_debug_trace_add (dbg, oldpc, op.size); //XXX review what this line really do
 	}
@@ -170,4 +192,164 @@ R_API void r_debug_trace_reset (RDebug *dbg) {
 #endif
 	t->traces = r_list_new ();
 	t->traces->free = free;
+	r_tracelog_reset (t->log);
+	r_tracelog_reset (t->blocks);
+	t->blocks_stop = UT64_MAX;
+	ht_free (t->bbs);
+	t->bbs = ht_new (NULL, trace_block_free, NULL);
+}
+
+static bool is_block_end(RAnalOp *op) {
+	switch (op->type & R_ANAL_OP_TYPE_MASK & ~R_ANAL_OP_TYPE_COND) {
+	case R_ANAL_OP_TYPE_JMP:
+	case R_ANAL_OP_TYPE_UJMP:
+	case R_ANAL_OP_TYPE_CALL:
+	case R_ANAL_OP_TYPE_UCALL:
+	case R_ANAL_OP_TYPE_RET:
+	case R_ANAL_OP_TYPE_ILL:
+	case R_ANAL_OP_TYPE_UNK:
+	case R_ANAL_OP_TYPE_TRAP:
+		return true;
+	}
+	return false;
+}
+
+/* calls are block ends too, unlike in RAnalBlock, so that every instruction
+ * between the entry and the end is known to run once the entry is reached */
+static TraceBlock *trace_block(RDebug *dbg, ut64 addr) {
+	char key[32];
+	ut8 buf[512];
+	ut64 at = addr, buf_addr = 0;
+	int buf_len = 0;
+	snprintf (key, sizeof (key), "0x%"PFMT64x, addr);
+	TraceBlock *bb = ht_find (dbg->trace->bbs, key, NULL);
+	if (bb) {
+		return bb;
+	}
+	if (!dbg->iob.is_valid_offset (dbg->iob.io, addr, 0)) {
+		return NULL;
+	}
+	bb = R_NEW0 (TraceBlock);
+	if (!bb) {
+		return NULL;
+	}
+	while (bb->ninstr < TRACE_BB_MAXOPS) {
+		RAnalOp op = {0};
+		if (!buf_len || at + 32 > buf_addr + buf_len) {
+			buf_addr = at;
+			buf_len = sizeof (buf);
+			(void)dbg->iob.read_at (dbg->iob.io, buf_addr, buf, buf_len);
+		}
+		int delta = at - buf_addr;
+		if (r_anal_op (dbg->anal, &op, at, buf + delta, buf_len - delta, R_ANAL_OP_MASK_BASIC) < 1 || op.size < 1) {
+			r_anal_op_fini (&op);
+			break;
+		}
+		bool end = is_block_end (&op);
+		bb->sizes[bb->ninstr++] = op.size;
+		bb->end = at;
+		r_anal_op_fini (&op);
+		if (end) {
+			break;
+		}
+		at += op.size;
+	}
+	if (!bb->ninstr) {
+		free (bb);
+		return NULL;
+	}
+	ht_insert (dbg->trace->bbs, key, bb);
+	return bb;
+}
+
+static bool trace_continue_to(RDebug *dbg, ut64 addr) {
+	bool has_bp = r_bp_get_in (dbg->bp, addr, R_BP_PROT_EXEC) != NULL;
+	if (!has_bp) {
+		r_bp_add_sw (dbg->bp, addr, dbg->bpsize, R_BP_PROT_EXEC);
+	}
+	r_debug_continue (dbg);
+	if (!has_bp) {
+		r_bp_del (dbg->bp, addr);
+	}
+	if (r_debug_is_dead (dbg) || !r_debug_reg_sync (dbg, R_REG_TYPE_GPR, false)) {
+		return false;
+	}
+	return r_debug_reg_get (dbg, "PC") == addr;
+}
+
+/*
+ * Run the process one basic block at a time: continue to the instruction
+ * that ends the current block and step over it. Only the block entries are
+ * logged, r_debug_trace_blocks_expand rebuilds the instruction trace.
+ * Stops at `until`, on other breakpoints and signals or when the user breaks.
+ */
+R_API int r_debug_trace_blocks(RDebug *dbg, ut64 until) {
+	RDebugTrace *t = dbg->trace;
+	int enabled = t->enabled;
+	int n = 0;
+
+	if (r_debug_is_dead (dbg)) {
+		return 0;
+	}
+	t->enabled = false;
+	t->blocks_stop = UT64_MAX;
+	while (!r_cons_is_breaked ()) {
+		if (r_debug_is_dead (dbg) || !r_debug_reg_sync (dbg, R_REG_TYPE_GPR, false)) {
+			break;
+		}
+		ut64 pc = r_debug_reg_get (dbg, "PC");
+		if (pc == until) {
+			break;
+		}
+		TraceBlock *bb = trace_block (dbg, pc);
+		if (!bb) {
+			break;
+		}
+		r_tracelog_step (t->blocks, pc);
+		n++;
+		if (until > pc && until <= bb->end) {
+			trace_continue_to (dbg, until);
+			t->blocks_stop = until;
+			break;
+		}
+		if (bb->end != pc && !trace_continue_to (dbg, bb->end)) {
+			// stopped inside the block
+			if (!r_debug_is_dead (dbg)) {
+				t->blocks_stop = r_debug_reg_get (dbg, "PC");
+			}
+			break;
+		}
+		if (!r_debug_step (dbg, 1)) {
+			break;
+		}
+	}
+	t->enabled = enabled;
+	return n;
+}
+
+/* append the instructions of the recorded blocks to the step log */
+R_API ut64 r_debug_trace_blocks_expand(RDebug *dbg) {
+	RDebugTrace *t = dbg->trace;
+	ut64 i, n = 0, count = r_tracelog_count (t->blocks);
+	RTraceLogStep st;
+	for (i = 0; i < count && r_tracelog_get (t->blocks, i, &st); i++) {
+		TraceBlock *bb = trace_block (dbg, st.pc);
+		if (!bb) {
+			continue;
+		}
+		ut64 pc = st.pc;
+		int j;
+		for (j = 0; j < bb->ninstr; j++) {
+			if (i + 1 == count && pc == t->blocks_stop) {
+				break;
+			}
+			r_tracelog_step (t->log, pc);
+			r_debug_trace_add (dbg, pc, bb->sizes[j]);
+			pc += bb->sizes[j];
+			n++;
+		}
+	}
+	r_tracelog_reset (t->blocks);
+	t->blocks_stop = UT64_MAX;
+	return n;
 }
@@ -28,8 +28,74 @@ static const char *str_callback(RNum *user, ut64 off, int *ok) {
 	return NULL;
 }
 
-static void flag_free_kv(HtKv *kv) {
-	free (kv->key);
+/* keys are the names owned by the items, the table doesn't copy them */
+static SdbHt *flag_ht_new(void) {
+	SdbHt *ht = ht_new (NULL, NULL, NULL);
+	if (ht) {
+		ht->dupkey = NULL;
+	}
+	return ht;
+}
+
+static int flag_name_cmp(const void *incoming, const RBNode *in_tree) {
+	const RFlagItem *fi = container_of ((RBNode *)in_tree, RFlagItem, rb);
+	return strcmp ((const char *)incoming, fi->name);
+}
+
+static void flag_index_add(RFlag *f, RFlagItem *item) {
+	ht_insert (f->ht_name, item->name, item);
+	r_rbtree_insert (&f->by_name, item->name, &item->rb, flag_name_cmp);
+}
+
+static void flag_index_del(RFlag *f, RFlagItem *item) {
+	r_rbtree_delete (&f->by_name, item->name, flag_name_cmp, NULL);
+	ht_delete (f->ht_name, item->name);
+}
+
+static void space_count_add(RFlag *f, int space, int n) {
+	if (space >= 0 && space < R_FLAG_SPACES_MAX) {
+		f->space_count[space] += n;
+	}
+}
+
+/* length of the literal prefix of the names matched by glob, see r_str_glob */
+static int glob_prefix(const char *glob, const char **prefix) {
+	const char *star = glob? strchr (glob, '*'): NULL;
+	*prefix = "";
+	if (!glob || (!star && *glob != '^')) {
+		return 0;
+	}
+	if (*glob == '^') {
+		glob++;
+	}
+	*prefix = glob;
+	return star? star - glob: strlen (glob);
+}
+
+/* count the items whose name matches glob, appending them to res if given.
+ * only the names sharing the literal prefix of the glob are visited */
+static int flag_glob(RFlag *f, const char *glob, bool inspace, RList *res) {
+	const char *prefix;
+	int count = 0, len = glob_prefix (glob, &prefix);
+	char *key = r_str_ndup (prefix, len);
+	if (!key) {
+		return -1;
+	}
+	RFlagItem *fi;
+	RBIter it = r_rbtree_lower_bound_forward (f->by_name, key, flag_name_cmp);
+	r_rbtree_iter_while (it, fi, RFlagItem, rb) {
+		if (strncmp (fi->name, key, len)) {
+			break;
+		}
+		if ((!inspace || !IS_IN_SPACE (f, fi)) && r_str_glob (fi->name, glob)) {
+			if (res) {
+				r_list_append (res, fi);
+			}
+			count++;
+		}
+	}
+	free (key);
+	return count;
 }
 
 static void flag_skiplist_free(void *data) {
@@ -89,19 +155,27 @@ static void remove_offsetmap(RFlag *f, RFlagItem *item) {
 	}
 }
 
-static bool set_name(RFlagItem *item, const char *name) {
-	r_return_val_if_fail (item && name, false);
-	if (item->name != item->realname) {
-		free (item->name);
+/* the name a flag gets when it is set or renamed to name */
+static char *filter_name(const char *name) {
+	char *res = strdup (name);
+	if (res) {
+		r_str_trim (res);
+		r_name_filter (res, 0); // TODO: name_filter should be chopping already
 	}
-	item->name = strdup (name);
-	if (!item->name) {
+	return res;
+}
+
+/* takes ownership of the filtered name. the item is untouched on failure */
+static bool set_name(RFlagItem *item, char *name) {
+	r_return_val_if_fail (item, false);
+	if (!name) {
 		return false;
 	}
-	r_str_trim (item->name);
-	r_name_filter (item->name, 0); // TODO: name_filter should be chopping already
+	if (item->name != item->realname) {
+		free (item->name);
+	}
 	free (item->realname);
-	item->realname = item->name;
+	item->name = item->realname = name;
 	return true;
 }
 
@@ -136,7 +210,8 @@ R_API RFlag * r_flag_new() {
 		r_flag_free (f);
 		return NULL;
 	}
-	f->ht_name = ht_new (NULL, flag_free_kv, NULL);
+	f->ht_name = flag_ht_new ();
+	f->by_name = NULL;
 	f->by_off = r_skiplist_new (flag_skiplist_free, flag_skiplist_cmp);
 #if R_FLAG_ZONE_USE_SDB
 	sdb_free (f->zones);
@@ -525,8 +600,10 @@ R_API RFlagItem *r_flag_set_next(RFlag *f, const char *name, ut64 off, ut32 size
 R_API RFlagItem *r_flag_set(RFlag *f, const char *name, ut64 off, ut32 size) {
 	r_return_val_if_fail (f && name && *name, NULL);
 
-	RFlagItem *item = r_flag_get (f, name);
+	char *fname = filter_name (name);
+	RFlagItem *item = fname? r_flag_get (f, fname): NULL;
 	if (item) {
+		free (fname);
 		if (item->offset == off) {
 			item->size = size;
 			return item;
@@ -535,19 +612,23 @@ R_API RFlagItem *r_flag_set(RFlag *f, const char *name, ut64 off, ut32 size) {
 	} else {
 		item = R_NEW0 (RFlagItem);
 		if (!item) {
+			free (fname);
 			return NULL;
 		}
-		if (!set_name (item, name)) {
+		if (!set_name (item, fname)) {
 			eprintf ("Invalid flag name '%s'.\n", name);
 			r_flag_item_free (item);
 			return NULL;
 		}
 		//item share ownership prone to uaf, that is why only
 		//f->flags has set up free pointer
-		ht_insert (f->ht_name, item->name, item);
+		flag_index_add (f, item);
 		r_list_append (f->flags, item);
+		item->space = -1;
 	}
 
+	space_count_add (f, item->space, -1);
+	space_count_add (f, f->space_idx, 1);
 	item->space = f->space_idx;
 	item->offset = off + f->base;
 	item->size = size;
@@ -592,7 +673,19 @@ R_API void r_flag_item_set_realname(RFlagItem *item, const char *realname) {
 	if (item->name != item->realname) {
 		free (item->realname);
 	}
-	item->realname = ISNULLSTR (realname) ? NULL : strdup (realname);
+	if (item->name && realname && !strcmp (item->name, realname)) {
+		item->realname = item->name;
+	} else {
+		item->realname = ISNULLSTR (realname) ? NULL : strdup (realname);
+	}
+}
+
+/* move a flag item to another flag space, -1 for none */
+R_API void r_flag_item_set_space(RFlag *f, RFlagItem *item, int space) {
+	r_return_if_fail (f && item);
+	space_count_add (f, item->space, -1);
+	space_count_add (f, space, 1);
+	item->space = space;
 }
 
 /* change the name of a flag item, if the new name is available.
@@ -600,12 +693,19 @@ R_API void r_flag_item_set_realname(RFlagItem *item, const char *realname) {
 R_API int r_flag_rename(RFlag *f, RFlagItem *item, const char *name) {
 	r_return_val_if_fail (f && item && name && *name, false);
 
-	ht_delete (f->ht_name, item->name);
-	if (!set_name (item, name)) {
+	char *fname = filter_name (name);
+	if (!fname) {
 		return false;
 	}
-	ht_insert (f->ht_name, item->name, item);
-	return true;
+	RFlagItem *other = ht_find (f->ht_name, fname, NULL);
+	if (other) {
+		free (fname);
+		return other == item;
+	}
+	flag_index_del (f, item);
+	bool ret = set_name (item, fname);
+	flag_index_add (f, item);
+	return ret;
 }
 
 /* unset the given flag item.
@@ -615,7 +715,8 @@ R_API int r_flag_rename(RFlag *f, RFlagItem *item, const char *name) {
 R_API bool r_flag_unset(RFlag *f, RFlagItem *item) {
 	r_return_val_if_fail (f && item, false);
 	remove_offsetmap (f, item);
-	ht_delete (f->ht_name, item->name);
+	flag_index_del (f, item);
+	space_count_add (f, item->space, -1);
 	r_list_delete_data (f->flags, item);
 	return true;
 }
@@ -633,21 +734,28 @@ R_API bool r_flag_unset_off(RFlag *f, ut64 off) {
 
 /* unset all the flag items that satisfy the given glob.
  * return the number of unset items. -1 on error */
-// XXX This is O(n^n) because unset_globa iterates all flags and unset too.
 R_API int r_flag_unset_glob(RFlag *f, const char *glob) {
 	r_return_val_if_fail (f, -1);
 
 	RListIter *iter, *iter2;
 	RFlagItem *flag;
-	int n = 0;
 
+	RList *list = r_list_new ();
+	int n = list? flag_glob (f, glob, true, list): -1;
+	if (n < 1) {
+		r_list_free (list);
+		return n;
+	}
+	r_list_foreach (list, iter, flag) {
+		remove_offsetmap (f, flag);
+		flag_index_del (f, flag);
+		space_count_add (f, flag->space, -1);
+	}
+	r_list_free (list);
+	/* drop the unindexed items in a single pass */
 	r_list_foreach_safe (f->flags, iter, iter2, flag) {
-		if (IS_IN_SPACE (f, flag)) {
-			continue;
-		}
-		if (r_str_glob (flag->name, glob)) {
-			r_flag_unset (f, flag);
-			n++;
+		if (ht_find (f->ht_name, flag->name, NULL) != flag) {
+			r_list_delete (f->flags, iter);
 		}
 	}
 	return n;
@@ -669,7 +777,9 @@ R_API void r_flag_unset_all(RFlag *f) {
 	f->flags = r_list_newf ((RListFree)r_flag_item_free);
 	ht_free (f->ht_name);
 	//don't set free since f->flags will free up items when needed avoiding uaf
-	f->ht_name = ht_new (NULL, flag_free_kv, NULL);
+	f->ht_name = flag_ht_new ();
+	f->by_name = NULL;
+	memset (f->space_count, 0, sizeof (f->space_count));
 	r_skiplist_purge (f->by_off);
 	r_flag_space_unset (f, NULL);
 }
@@ -728,14 +838,6 @@ R_API void r_flag_bind(RFlag *f, RFlagBind *fb) {
 }
 
 R_API int r_flag_count(RFlag *f, const char *glob) {
-	int count = 0;
-	RFlagItem *flag;
-	RListIter *iter;
 	r_return_val_if_fail (f, -1);
-	r_list_foreach (f->flags, iter, flag) {
-		if (r_str_glob (flag->name, glob)) {
-			count++;
-		}
-	}
-	return count;
+	return flag_glob (f, glob, false, NULL);
 }
@@ -105,10 +105,13 @@ R_API int r_flag_space_unset(RFlag *f, const char *fs) {
 			}
 			R_FREE (f->spaces[i]);
 			// remove all flags space references
-			r_list_foreach (f->flags, iter, fi) {
-				if (fi->space == i) {
-					fi->space = -1;
+			if (f->space_count[i] > 0) {
+				r_list_foreach (f->flags, iter, fi) {
+					if (fi->space == i) {
+						fi->space = -1;
+					}
 				}
+				f->space_count[i] = 0;
 			}
 			count++;
 		}
@@ -117,17 +120,7 @@ R_API int r_flag_space_unset(RFlag *f, const char *fs) {
 }
 
 static int r_flag_space_count(RFlag *f, int n) {
-	RListIter *iter;
-	int count = 0;
-	RFlagItem *fi;
-	if (n != -1) {
-		r_list_foreach (f->flags, iter, fi) {
-			if (fi->space == n) {
-				count++;
-			}
-		}
-	}
-	return count;
+	return (n >= 0 && n < R_FLAG_SPACES_MAX)? f->space_count[n]: 0;
 }
 
 R_API int r_flag_space_list(RFlag *f, int mode) {
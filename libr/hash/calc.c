@@ -1,6 +1,7 @@
 /* radare2 - LGPL - Copyright 2009-2018 pancake */
 
 #include "r_hash.h"
+#include "r_th.h"
 
 
 #define HANDLE_CRC_PRESET(rbits, aname) \
@@ -201,3 +202,137 @@ R_API int r_hash_calculate(RHash *ctx, ut64 algobit, const ut8 *buf, int len) {
 
 	return 0;
 }
+
+typedef struct {
+	RHashPool *pool;
+	RHashJob *jobs;
+	int n;
+	int first;
+	int step;
+	ut64 seen; // last batch taken
+} HashWorker;
+
+/* the workers sleep between batches, the caller thread takes a share of
+ * every batch too */
+struct r_hash_pool_t {
+	RThreadLock *lock;
+	RThreadCond *wake; // signaled under lock when a batch is posted
+	RThreadSemaphore *done; // posted by each worker after its share
+	RThread *th[R_HASH_THREADS];
+	HashWorker w[R_HASH_THREADS];
+	int count;
+	ut64 batch;
+	bool stop;
+};
+
+static void hash_jobs(HashWorker *w) {
+	int i;
+	for (i = w->first; i < w->n; i += w->step) {
+		RHashJob *job = &w->jobs[i];
+		job->dlen = r_hash_calculate (job->ctx, job->algobit, job->buf, job->len);
+	}
+}
+
+static RThreadFunctionRet hash_pool_th(RThread *th) {
+	HashWorker *w = th->user;
+	RHashPool *pool = w->pool;
+	for (;;) {
+		r_th_lock_enter (pool->lock);
+		while (!pool->stop && pool->batch == w->seen) {
+			r_th_cond_wait (pool->wake, pool->lock);
+		}
+		bool stop = pool->stop;
+		w->seen = pool->batch;
+		r_th_lock_leave (pool->lock);
+		if (stop) {
+			break;
+		}
+		hash_jobs (w);
+		r_th_sem_post (pool->done);
+	}
+	return R_TH_STOP;
+}
+
+/* up to threads hashing threads, counting the caller */
+R_API RHashPool *r_hash_pool_new(int threads) {
+	int i;
+	RHashPool *pool = R_NEW0 (RHashPool);
+	if (!pool) {
+		return NULL;
+	}
+	pool->lock = r_th_lock_new (false);
+	pool->wake = r_th_cond_new ();
+	pool->done = r_th_sem_new (0);
+	if (!pool->lock || !pool->wake || !pool->done) {
+		r_hash_pool_free (pool);
+		return NULL;
+	}
+	threads = R_MIN (threads, R_HASH_THREADS);
+	for (i = 0; i < threads - 1; i++) {
+		HashWorker *w = &pool->w[i + 1];
+		w->pool = pool;
+		pool->th[i] = r_th_new (hash_pool_th, w, 0);
+		if (!pool->th[i]) {
+			break;
+		}
+		pool->count++;
+	}
+	return pool;
+}
+
+R_API void r_hash_pool_free(RHashPool *pool) {
+	int i;
+	if (!pool) {
+		return;
+	}
+	if (pool->lock) {
+		r_th_lock_enter (pool->lock);
+		pool->stop = true;
+		r_th_cond_signal_all (pool->wake);
+		r_th_lock_leave (pool->lock);
+	}
+	for (i = 0; i < pool->count; i++) {
+		r_th_wait (pool->th[i]);
+		r_th_free (pool->th[i]);
+	}
+	r_th_sem_free (pool->done);
+	r_th_cond_free (pool->wake);
+	r_th_lock_free (pool->lock);
+	free (pool);
+}
+
+/* run every job on its own context, spread in the pool threads. jobs on
+ * the same context must not be queued in the same call */
+R_API void r_hash_pool_run(RHashPool *pool, RHashJob *jobs, int n) {
+	int i, nth = pool? R_MIN (pool->count, n - 1): 0;
+	HashWorker self = { NULL, jobs, n, 0, nth + 1, 0 };
+
+	if (nth > 0) {
+		r_th_lock_enter (pool->lock);
+		for (i = 1; i <= pool->count; i++) {
+			HashWorker *w = &pool->w[i];
+			w->jobs = jobs;
+			// the workers past the jobs count get an empty share
+			w->n = i <= nth? n: 0;
+			w->first = i;
+			w->step = nth + 1;
+		}
+		pool->batch++;
+		r_th_cond_signal_all (pool->wake);
+		r_th_lock_leave (pool->lock);
+	}
+	hash_jobs (&self);
+	if (nth > 0) {
+		for (i = 0; i < pool->count; i++) {
+			r_th_sem_wait (pool->done);
+		}
+	}
+}
+
+/* one shot version of r_hash_pool_run, keep a pool around when hashing
+ * many batches */
+R_API void r_hash_calculate_jobs(RHashJob *jobs, int n, int threads) {
+	RHashPool *pool = r_hash_pool_new (R_MIN (threads, n));
+	r_hash_pool_run (pool, jobs, n);
+	r_hash_pool_free (pool);
+}
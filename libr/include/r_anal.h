@@ -296,6 +296,9 @@ typedef struct r_anal_type_function_t {
 	RList *fcn_locs; //sorted list of a function *.loc refs
 	//RList *locals; // list of local labels -> moved to anal->sdb_fcns
 	RList *bbs;
+	struct r_anal_bb_index_t *bbs_index; // bbs sorted by address, see r_anal_fcn_bbget_in
+	ut64 bb_gen; // bumped when the blocks change, see r_anal_fcn_bb_touch
+	RBNode **bb_tree; // RAnal.bb_tree once a block of the function is indexed in it
 	RAnalFcnMeta meta;
 	RRangeTiny bbr;
 	RBNode rb;
@@ -629,6 +632,7 @@ typedef struct r_anal_t {
 	ut64 gp; // global pointer. used for mips. but can be used by other arches too in the future
 	RList *fcns;
 	RBNode *fcn_tree;
+	RBNode *bb_tree; // blocks of the functions by address, see r_anal_get_functions_in
 	RListRange *fcnstore;
 	RList *refs;
 	RList *vartypes;
@@ -639,6 +643,7 @@ typedef struct r_anal_t {
 	int diff_ops;
 	double diff_thbb;
 	double diff_thfcn;
+	bool diff_lsh; // prune the candidates of big function diffs, see diff.lsh
 	RIOBind iob;
 	RFlagBind flb;
 	RBinBind binb; // Set only from core when an analysis plugin is called.
@@ -667,6 +672,7 @@ typedef struct r_anal_t {
 	RSpaces meta_spaces;
 	RSpaces zign_spaces;
 	char *zign_path;
+	RList *zign_dbs; // <RSignDb> mmapped zignature databases
 	PrintfCallback cb_printf;
 	//moved from RAnalFcn
 	Sdb *sdb; // root
@@ -686,6 +692,8 @@ typedef struct r_anal_t {
 	RAnalOptions opt;
 	RList *reflines;
 	RList *reflines2;
+	SdbHt *reflines_ops; // flow decoded by r_anal_reflines_get, owned by the caller
+	struct r_anal_refline_sweep_t *reflines_sweep; // reflines by address, see r_anal_reflines_str
 	//RList *noreturn;
 	RList /*RAnalRange*/ *bits_ranges;
 	RListComparator columnSort;
@@ -830,9 +838,7 @@ typedef struct r_anal_bb_t {
 	ut64 fail;
 	int size;
 	int type;
-	int type_ex;
 	int ninstr;
-	int returnbb;
 	int conditional;
 	int traced;
 	ut32 colorize;
@@ -841,12 +847,12 @@ typedef struct r_anal_bb_t {
 	RAnalDiff *diff;
 	RAnalCond *cond;
 	RAnalSwitchOp *switch_op;
-	// offsets of instructions in this block
+	// offsets of instructions in this block, allocated on demand
 	ut16 *op_pos;
 	// size of the op_pos array
 	int op_pos_size;
-	ut8 *op_bytes;
 	ut8 op_sz;
+	ut8 *op_bytes;
 	/* deprecate ??? where is this used? */
 	/* iirc only java. we must use r_anal_bb_from_offset(); instead */
 	RAnalBlock *head;
@@ -860,6 +866,9 @@ typedef struct r_anal_bb_t {
 	ut8 *parent_reg_arena;
 	int stackptr;
 	int parent_stackptr;
+	RBNode rb; // node of RAnal.bb_tree
+	ut64 rb_max_addr; // maximum of addr + size in the subtree
+	RAnalFunction *rb_fcn; // function owning the block, NULL if it is not in the tree
 #undef RAnalBlock
 } RAnalBlock;
 
@@ -1119,7 +1128,7 @@ typedef struct r_anal_esil_t {
 	RAnalEsilInterrupt *intr0;
 	/* deep esil parsing fills this */
 	Sdb *stats;
-	Sdb *db_trace;
+	RTraceLog *trace_log;
 	int trace_idx;
 	RAnalEsilCallbacks cb;
 	RAnalReil *Reil;
@@ -1308,6 +1317,13 @@ R_API const char *r_anal_get_fcnsign(RAnal *anal, const char *sym);
 R_API RAnalBlock *r_anal_bb_new(void);
 R_API RList *r_anal_bb_list_new(void);
 R_API void r_anal_bb_free(RAnalBlock *bb);
+R_API ut64 r_anal_fcn_bb_gen(RAnalFunction *fcn);
+R_API void r_anal_fcn_bb_touch(RAnalFunction *fcn);
+R_API void r_anal_bb_tree_insert(RBNode **root, RAnalFunction *fcn, RAnalBlock *bb);
+R_API void r_anal_bb_tree_delete(RAnalBlock *bb);
+R_API void r_anal_bb_set_addr(RAnalBlock *bb, ut64 addr);
+R_API void r_anal_bb_set_size(RAnalBlock *bb, int size);
+R_API void r_anal_bb_shrink(RAnalBlock *bb);
 R_API int r_anal_bb(RAnal *anal, RAnalBlock *bb, ut64 addr, ut8 *buf, ut64 len, int head);
 R_API RAnalBlock *r_anal_bb_from_offset(RAnal *anal, ut64 off);
 R_API int r_anal_bb_is_in_offset(RAnalBlock *bb, ut64 addr);
@@ -1336,6 +1352,8 @@ R_API RAnalEsil *r_anal_esil_new (int stacksize, int iotrap, unsigned int addrsi
 R_API void r_anal_esil_trace (RAnalEsil *esil, RAnalOp *op);
 R_API void r_anal_esil_trace_list (RAnalEsil *esil);
 R_API void r_anal_esil_trace_show (RAnalEsil *esil, int idx);
+R_API void r_anal_esil_trace_reset(RAnalEsil *esil);
+R_API Sdb *r_anal_esil_trace_sdb(RAnalEsil *esil);
 R_API bool r_anal_esil_set_pc (RAnalEsil *esil, ut64 addr);
 R_API int r_anal_esil_setup (RAnalEsil *esil, RAnal *anal, int romem, int stats, int nonull);
 R_API void r_anal_esil_free (RAnalEsil *esil);
@@ -1393,6 +1411,8 @@ R_API bool r_anal_fcn_in(RAnalFunction *fcn, ut64 addr);
 R_API RAnalFunction *r_anal_get_fcn_at(RAnal *anal, ut64 addr, int type);
 R_API RAnalFunction *r_anal_get_fcn_in(RAnal *anal, ut64 addr, int type);
 R_API RAnalFunction *r_anal_get_fcn_in_bounds(RAnal *anal, ut64 addr, int type);
+R_API RList *r_anal_get_functions_in(RAnal *anal, ut64 addr);
+R_API void r_anal_bb_index_free(struct r_anal_bb_index_t *idx);
 R_API RAnalFunction *r_anal_fcn_find_name(RAnal *anal, const char *name);
 R_API RList *r_anal_fcn_list_new(void);
 R_API int r_anal_fcn_insert(RAnal *anal, RAnalFunction *fcn);
@@ -1452,6 +1472,7 @@ R_API RAnalBlock *r_anal_fcn_bbget_in(const RAnal *anal, RAnalFunction *fcn, ut6
 R_API RAnalBlock *r_anal_fcn_bbget_at(RAnalFunction *fcn, ut64 addr);
 R_API bool r_anal_fcn_contains(RAnalFunction *fcn, ut64 addr);
 R_API bool r_anal_fcn_bbadd(RAnalFunction *fcn, RAnalBlock *bb);
+R_API bool r_anal_fcn_bbadd_in(RAnal *anal, RAnalFunction *fcn, RAnalBlock *bb);
 R_API int r_anal_fcn_resize (const RAnal *anal, RAnalFunction *fcn, int newsize);
 
 typedef bool (* RAnalRefCmp)(RAnalRef *ref, void *data);
@@ -1545,6 +1566,7 @@ R_API RList* /*<RAnalRefline>*/ r_anal_reflines_get(RAnal *anal,
 R_API int r_anal_reflines_middle(RAnal *anal, RList *list, ut64 addr, int len);
 R_API char* r_anal_reflines_str(void *core, ut64 addr, int opts);
 R_API RList *r_anal_reflines_fcn_get(struct r_anal_t *anal, RAnalFunction *fcn, int nlines, int linesout, int linescall);
+R_API void r_anal_reflines_sweep_free(struct r_anal_refline_sweep_t *sw);
 /* TODO move to r_core */
 R_API void r_anal_var_list_show(RAnal *anal, RAnalFunction *fcn, int kind, int mode);
 R_API RList *r_anal_var_list(RAnal *anal, RAnalFunction *fcn, int kind);
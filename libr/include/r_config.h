@@ -44,6 +44,7 @@ typedef struct r_config_t {
 	PrintfCallback cb_printf;
 	RList *nodes;
 	SdbHt *ht;
+	ut64 rev; // bumped whenever a value changes
 } RConfig;
 
 typedef struct r_config_hold_num_t {
@@ -327,6 +327,23 @@ typedef struct r_cons_canvas_t {
 	int linemode; // 0 = diagonal , 1 = square
 } RConsCanvas;
 
+typedef struct r_cons_cell_t {
+	ut32 ch; // utf8 bytes, 0 for the right half of a wide char
+	ut32 fg;
+	ut32 bg;
+	ut32 flags; // bold, underline.. one bit per SGR code
+} RConsCell;
+
+/* what the terminal shows, to only write what changes between frames */
+typedef struct r_cons_screen_t {
+	int w, h;
+	RConsCell *front; // the terminal
+	RConsCell *back; // the frame being drawn
+	ut64 frames;
+	ut64 bytes; // written to the terminal
+	int last_bytes;
+} RConsScreen;
+
 #define RUNECODE_MIN 0xc8 // 200
 #define RUNECODE_LINE_VERT 0xc8
 #define RUNECODE_LINE_CROSS 0xc9
@@ -403,6 +420,9 @@ typedef struct r_cons_context_t {
 	bool lastMode;
 	bool lastEnabled;
 	bool pageable;
+	bool streamed; // part of the output was already written by the streaming flush
+	int grep_stream; // chunk size while the grep is applied by the streaming flush (0 = off)
+	bool grep_stop; // breaked because the streamed grep can't show more lines
 } RConsContext;
 
 typedef struct r_cons_t {
@@ -414,6 +434,7 @@ typedef struct r_cons_t {
 	int rows;
 	int echo; // dump to stdout in realtime
 	int fps;
+	RConsScreen *screen; // damage tracking in visual, NULL when disabled
 	int columns;
 	int force_rows;
 	int force_columns;
@@ -462,6 +483,7 @@ typedef struct r_cons_t {
 	bool ansicon;
 #endif
 	bool flush;
+	int stream; // flush in chunks of this size when not interactive (0 = disabled)
 	bool use_utf8; // use utf8 features
 	bool use_utf8_curvy; // use utf8 curved corners
 	bool dotted_lines;
@@ -654,6 +676,12 @@ R_API void r_cons_canvas_attr(RConsCanvas *c,const char * attr);
 R_API void r_cons_canvas_write(RConsCanvas *c, const char *_s);
 R_API bool r_cons_canvas_gotoxy(RConsCanvas *c, int x, int y);
 R_API void r_cons_canvas_goto_write(RConsCanvas *c,int x,int y, const char * s);
+R_API RConsScreen *r_cons_screen_new(void);
+R_API void r_cons_screen_free(RConsScreen *s);
+R_API void r_cons_screen_damage(RConsScreen *s, int x, int y, int w, int h);
+R_API void r_cons_screen_invalidate(RConsScreen *s);
+R_API void r_cons_screen_feed(RConsScreen *s, const char *buf, int len);
+R_API char *r_cons_screen_diff(RConsScreen *s, const char *buf, int len, int w, int h, int *olen);
 R_API void r_cons_canvas_box(RConsCanvas *c, int x, int y, int w, int h, const char *color);
 R_API void r_cons_canvas_line(RConsCanvas *c, int x, int y, int x2, int y2, RCanvasLineStyle *style);
 R_API void r_cons_canvas_line_diagonal(RConsCanvas *c, int x, int y, int x2, int y2, RCanvasLineStyle *style);
@@ -786,12 +814,15 @@ R_API char *r_cons_hud_string(const char *s);
 R_API char *r_cons_hud_file(const char *f);
 
 R_API const char *r_cons_get_buffer(void);
+R_API int r_cons_get_buffer_len(void);
 R_API void r_cons_grep_help(void);
 R_API void r_cons_grep_parsecmd(char *cmd, const char *quotestr);
 R_API char * r_cons_grep_strip(char *cmd, const char *quotestr);
 R_API void r_cons_grep_process(char * grep);
 R_API int r_cons_grep_line(char *buf, int len); // must be static
 R_API int r_cons_grepbuf(char *buf, int len);
+R_API bool r_cons_grep_stream_begin(const char *str, int stream);
+R_API int r_cons_grep_stream(char *buf, int len, bool *done);
 
 R_API void r_cons_rgb(ut8 r, ut8 g, ut8 b, ut8 a);
 R_API void r_cons_rgb_fgbg(ut8 r, ut8 g, ut8 b, ut8 R, ut8 G, ut8 B);
@@ -942,6 +973,7 @@ typedef struct r_ascii_node_t {
 	int is_reversed;
 	int klass;
 	bool is_mini;
+	bool is_lazy; /* body is a placeholder until the node gets in view */
 } RANode;
 
 #define R_AGRAPH_MODE_NORMAL 0
@@ -992,8 +1024,12 @@ typedef struct r_ascii_graph_t {
 	RList *long_edges;
 	struct layer_t *layers;
 	int n_layers;
-	RList *dists; /* RList<struct dist_t> */
+	struct dist_t *dists; /* indexed by RGraphNode.idx */
 	RList *edges; /* RList<AEdge> */
+	RList *layouts; /* RList<struct layout_cache_t>, most recent first */
+	SdbHt *bodies; /* rendered basic block bodies, see get_bb_body_cached */
+	ut64 bodies_addr; /* function and mode the nodes were loaded for */
+	int bodies_mode; /* body options of the last load */
 } RAGraph;
 
 #ifdef R_API
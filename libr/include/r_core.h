@@ -172,6 +172,12 @@ typedef struct r_core_visual_tab_t {
 typedef struct r_core_visual_t {
 	RList *tabs;
 	int tab;
+	/* disasm lines rendered by previous frames */
+	bool cache_lines; // set while the main view is printed
+	SdbHt *lines;
+	SdbHt *ops; // instruction flow for the reflines
+	ut64 lines_rev; // config revision the lines were rendered with
+	int lines_cols;
 } RCoreVisual;
 // #define RCoreVisual Visual
 
@@ -232,6 +238,9 @@ typedef struct r_core_t {
 	bool is_asmqjmps_letter;
 	bool keep_asmqjmps;
 	RCoreVisual visual;
+	struct r_disasm_state_t *ds_config; // disasm options of ds_config_of at ds_config_rev
+	RConfig *ds_config_of;
+	ut64 ds_config_rev;
 	// visual // TODO: move them into RCoreVisual
 	int http_up;
 	int gdbserver_up;
@@ -537,6 +546,7 @@ R_API RList *r_core_asm_back_disassemble_instr (RCore *core, ut64 addr, int len,
 R_API RList *r_core_asm_back_disassemble_byte (RCore *core, ut64 addr, int len, ut32 hit_count, ut32 extra_padding);
 R_API ut32 r_core_asm_bwdis_len (RCore* core, int* len, ut64* start_addr, ut32 l);
 R_API int r_core_print_disasm(RPrint *p, RCore *core, ut64 addr, ut8 *buf, int len, int lines, int invbreak, int nbytes, bool json, RAnalFunction *pdf);
+R_API void r_core_print_disasm_flush(RCore *core);
 R_API int r_core_print_disasm_json(RCore *core, ut64 addr, ut8 *buf, int len, int lines);
 R_API int r_core_print_disasm_instructions (RCore *core, int len, int l);
 R_API int r_core_print_disasm_all (RCore *core, ut64 addr, int l, int len, int mode);
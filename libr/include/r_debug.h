@@ -183,8 +183,8 @@ typedef struct r_debug_snap_t {
 	ut32 size;
 	ut32 page_num;
 	ut64 timestamp;
-	RHash *hash_ctx;
 	ut8 **hashes; // Hash of each pages
+	bool soft_dirty; // soft-dirty bits of the map are only ours since the last capture
 	RList *history; // <RDebugSnapDiff*>
 	int perm;
 	char *comment;
@@ -233,6 +233,10 @@ typedef struct r_debug_trace_t {
 	char *addresses;
 	// TODO: add range here
 	Sdb *db;
+	RTraceLog *log; // every traced step in execution order
+	RTraceLog *blocks; // block entries recorded by r_debug_trace_blocks
+	ut64 blocks_stop; // pc where block tracing stopped
+	SdbHt *bbs; // decoded blocks by entry address
 } RDebugTrace;
 
 typedef struct r_debug_tracepoint_t {
@@ -311,6 +315,7 @@ typedef struct r_debug_t {
 	RList *maps; // <RDebugMap>
 	RList *maps_user; // <RDebugMap>
 	RList *snaps; // <RDebugSnap>
+	bool soft_dirty_seen; // the kernel reported a soft-dirty page, see snap_track
 	RList *sessions; // <RDebugSession>
 	Sdb *sgnls;
 	RCoreBind corebind;
@@ -548,6 +553,8 @@ R_API RDebugTracepoint *r_debug_trace_add(RDebug *dbg, ut64 addr, int size);
 R_API RDebugTrace *r_debug_trace_new(void);
 R_API void r_debug_trace_free(RDebugTrace *dbg);
 R_API int r_debug_trace_tag(RDebug *dbg, int tag);
+R_API int r_debug_trace_blocks(RDebug *dbg, ut64 until);
+R_API ut64 r_debug_trace_blocks_expand(RDebug *dbg);
 R_API int r_debug_child_fork(RDebug *dbg);
 R_API int r_debug_child_clone(RDebug *dbg);
 
@@ -574,6 +581,7 @@ R_API void r_debug_snap_list(RDebug *dbg, int idx, int mode);
 R_API int r_debug_snap(RDebug *dbg, ut64 addr);
 R_API int r_debug_snap_comment(RDebug *dbg, int idx, const char *msg);
 R_API RDebugSnapDiff *r_debug_snap_map(RDebug *dbg, RDebugMap *map);
+R_API RList *r_debug_snap_maps(RDebug *dbg, int perms);
 R_API int r_debug_snap_all(RDebug *dbg, int perms);
 R_API RDebugSnap *r_debug_snap_get(RDebug *dbg, ut64 addr);
 R_API int r_debug_snap_set_idx(RDebug *dbg, int idx);
@@ -36,6 +36,15 @@ typedef struct r_diff_t {
 
 typedef int (*RDiffCallback)(RDiff *diff, void *user, RDiffOp *op);
 
+/* random access reader for r_diff_stream, returns the amount of bytes read */
+typedef int (*RDiffReadCallback)(void *user, ut64 off, ut8 *buf, int len);
+
+typedef struct r_diff_source_t {
+	RDiffReadCallback read;
+	void *user;
+	ut64 size;
+} RDiffSource;
+
 /* XXX: this api needs to be reviewed , constructor with offa+offb?? */
 #ifdef R_API
 R_API RDiff *r_diff_new(void);
@@ -47,10 +56,12 @@ R_API int r_diff_buffers_static(RDiff *d, const ut8 *a, int la, const ut8 *b, in
 R_API int r_diff_buffers_radiff(RDiff *d, const ut8 *a, int la, const ut8 *b, int lb);
 R_API int r_diff_buffers_delta(RDiff *diff, const ut8 *sa, int la, const ut8 *sb, int lb);
 R_API int r_diff_buffers(RDiff *d, const ut8 *a, ut32 la, const ut8 *b, ut32 lb);
+R_API int r_diff_stream(RDiff *d, RDiffSource *a, RDiffSource *b);
 R_API char *r_diff_buffers_to_string(RDiff *d, const ut8 *a, int la, const ut8 *b, int lb);
 R_API int r_diff_set_callback(RDiff *d, RDiffCallback callback, void *user);
 R_API bool r_diff_buffers_distance(RDiff *d, const ut8 *a, ut32 la, const ut8 *b, ut32 lb, ut32 *distance, double *similarity);
 R_API bool r_diff_buffers_distance_myers(RDiff *diff, const ut8 *a, ut32 la, const ut8 *b, ut32 lb, ut32 *distance, double *similarity);
+R_API bool r_diff_buffers_distance_bounded(RDiff *diff, const ut8 *a, ut32 la, const ut8 *b, ut32 lb, ut32 maxdist, ut32 *distance, double *similarity);
 R_API bool r_diff_buffers_distance_levenstein(RDiff *d, const ut8 *a, ut32 la, const ut8 *b, ut32 lb, ut32 *distance, double *similarity);
 R_API char *r_diff_buffers_unified(RDiff *d, const ut8 *a, int la, const ut8 *b, int lb);
 /* static method !??! */
@@ -46,6 +46,7 @@ typedef struct r_flag_item_t {
 	char *color;    /* item color */
 	char *comment;  /* item comment */
 	char *alias;    /* used to define a flag based on a math expression (e.g. foo + 3) */
+	RBNode rb;      /* node in the name index */
 } RFlagItem;
 
 typedef struct r_flag_t {
@@ -57,8 +58,10 @@ typedef struct r_flag_t {
 	Sdb *tags;
 	RNum *num;
 	RSkipList *by_off; /* flags sorted by offset, value=RFlagsAtOffset */
-	SdbHt *ht_name; /* hashmap key=item name, value=RList of items */
+	SdbHt *ht_name; /* hashmap key=item name (not copied), value=RFlagItem */
+	RBTree by_name; /* flags sorted by name, for prefix queries */
 	RList *flags;   /* list of RFlagItem contained in the flag */
+	int space_count[R_FLAG_SPACES_MAX]; /* number of flags in each space */
 	RList *spacestack;
 	PrintfCallback cb_printf;
 #if R_FLAG_ZONE_USE_SDB
@@ -115,6 +118,7 @@ R_API void r_flag_item_set_alias(RFlagItem *item, const char *alias);
 R_API void r_flag_item_free (RFlagItem *item);
 R_API void r_flag_item_set_comment(RFlagItem *item, const char *comment);
 R_API void r_flag_item_set_realname(RFlagItem *item, const char *realname);
+R_API void r_flag_item_set_space(RFlag *f, RFlagItem *item, int space);
 R_API RFlagItem *r_flag_item_clone(RFlagItem *item);
 R_API int r_flag_unset_glob(RFlag *f, const char *name);
 R_API int r_flag_rename(RFlag *f, RFlagItem *item, const char *name);
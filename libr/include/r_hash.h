@@ -175,6 +175,18 @@ struct r_hash_t {
 	ut8 R_ALIGNED(8) digest[128];
 };
 
+/* one algorithm over one buffer, see r_hash_calculate_jobs */
+typedef struct r_hash_job_t {
+	RHash *ctx;
+	ut64 algobit;
+	const ut8 *buf;
+	int len;
+	int dlen; // digest size returned by r_hash_calculate
+} RHashJob;
+
+/* persistent hashing threads, see r_hash_pool_run */
+typedef struct r_hash_pool_t RHashPool;
+
 typedef struct r_hash_seed_t {
 	int prefix;
 	ut8 *buf;
@@ -460,6 +472,9 @@ enum HASH_INDICES {
 #endif /* #if R_HAVE_CRC64 */
 
 #define R_HASH_ALL ((1ULL << R_MIN(63, R_HASH_NUM_INDICES))-1)
+/* algorithms that can be fed block by block through r_hash_do_begin/end */
+#define R_HASH_STREAMABLE (R_HASH_MD5 | R_HASH_SHA1 | R_HASH_SHA256 | R_HASH_SHA384 | R_HASH_SHA512)
+#define R_HASH_THREADS 4
 
 #ifdef R_API
 /* OO */
@@ -481,6 +496,10 @@ R_API const char *r_hash_name(ut64 bit);
 R_API ut64 r_hash_name_to_bits(const char *name);
 R_API int r_hash_size(ut64 bit);
 R_API int r_hash_calculate(RHash *ctx, ut64 algobit, const ut8 *input, int len);
+R_API void r_hash_calculate_jobs(RHashJob *jobs, int n, int threads);
+R_API RHashPool *r_hash_pool_new(int threads);
+R_API void r_hash_pool_free(RHashPool *pool);
+R_API void r_hash_pool_run(RHashPool *pool, RHashJob *jobs, int n);
 
 /* checksums */
 /* XXX : crc16 should use 0 as arg0 by default */
@@ -12,6 +12,7 @@ R_LIB_VERSION_HEADER(r_lang);
 
 typedef char* (*RCoreCmdStrCallback)(void* core, const char *s);
 typedef int (*RCoreCmdfCallback)(void* core, const char *s, ...);
+typedef ut8* (*RCoreFrameReplyCallback)(void* core, void *frame, int *len);
 
 typedef struct r_lang_t {
 	struct r_lang_plugin_t *cur;
@@ -21,6 +22,7 @@ typedef struct r_lang_t {
 	PrintfCallback cb_printf;
 	RCoreCmdStrCallback cmd_str;
 	RCoreCmdfCallback cmdf;
+	RCoreFrameReplyCallback frame_reply; // r2pipe frames, see r2p_frame_serve
 } RLang;
 
 typedef struct r_lang_plugin_t {
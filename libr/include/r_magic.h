@@ -33,6 +33,20 @@ R_LIB_VERSION_HEADER(r_magic);
 #define r_magic_compile(x,y)        magic_compile(x,y)
 #define r_magic_check(x,y)          magic_check(x,y)
 #define r_magic_errno(x)            magic_errno(x)
+
+/* libmagic has no literal index, the callers fall back to r_magic_buffer */
+typedef void RMagicIndex;
+static inline RMagicIndex *r_magic_index_new(RMagic *ms) {
+	(void)ms;
+	return NULL;
+}
+static inline void r_magic_index_free(RMagicIndex *mi) {
+	(void)mi;
+}
+static inline int r_magic_index_scan(RMagicIndex *mi, RMagic *ms, const ut8 *buf, size_t len, size_t size, ut8 *hits) {
+	(void)mi; (void)ms; (void)buf; (void)len; (void)size; (void)hits;
+	return -1;
+}
 #endif
 
 #else
@@ -293,6 +307,21 @@ struct r_magic_set {
 
 typedef struct r_magic_set RMagic;
 
+/* Prefilter to scan big buffers with the magic database. The literal bytes
+ * of the top-level tests are compiled in a multi-pattern automaton, so only
+ * the offsets where one of them appears (and where one of the few tests
+ * without literal bytes passes) need to go through r_magic_buffer */
+typedef struct r_magic_index_t {
+	ut32 *go; // automaton transitions, 256 per state
+	ut32 *dict; // closest state in the suffix chain where literals end
+	int *first; // first literal ending in each state, -1 if none
+	struct r_magic_index_lit_t *lits;
+	ut32 nstates;
+	ut32 nlits;
+	struct r_magic *tests; // top-level tests without literal bytes
+	ut32 ntests;
+} RMagicIndex;
+
 #ifdef R_API
 R_API RMagic* r_magic_new(int flags);
 R_API void r_magic_free(RMagic*);
@@ -308,6 +337,10 @@ R_API int r_magic_load(RMagic*, const char *);
 R_API int r_magic_compile(RMagic*, const char *);
 R_API int r_magic_check(RMagic*, const char *);
 R_API int r_magic_errno(RMagic*);
+
+R_API RMagicIndex *r_magic_index_new(RMagic *ms);
+R_API void r_magic_index_free(RMagicIndex *mi);
+R_API int r_magic_index_scan(RMagicIndex *mi, RMagic *ms, const ut8 *buf, size_t len, size_t size, ut8 *hits);
 #endif
 
 
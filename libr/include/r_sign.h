@@ -61,13 +61,51 @@ typedef int (*RSignOffsetMatchCallback)(RSignItem *it, RAnalFunction *fcn, void
 typedef int (*RSignHashMatchCallback)(RSignItem *it, RAnalFunction *fcn, void *user);
 typedef int (*RSignRefsMatchCallback)(RSignItem *it, RAnalFunction *fcn, void *user);
 
+typedef struct r_sign_matcher_t RSignMatcher;
+
+/* preferred size of the buffers passed to r_sign_search_update */
+#define R_SIGN_SEARCH_BLOCK (4 * 1024 * 1024)
+
 typedef struct r_sign_search_t {
 	RSearch *search;
 	RList *items;
+	RSignMatcher *matcher; // bytes zignatures, built by r_sign_search_init
+	RList *kws; // keyword data, database items are only read when hit
 	RSignSearchCallback cb;
 	void *user;
 } RSignSearch;
 
+/* zignatures deserialized once and indexed by the metric they match on */
+typedef struct r_sign_index_t {
+	RList *items; // <RSignItem>, owns the items
+	SdbHt *bbhash; // bbhash -> RList<RSignItem>
+	SdbHt *graph; // "cc:nbbs:edges:ebbs" -> RList<RSignItem>
+	RList *graph_any; // graphs with wildcard (-1) metrics
+	SdbHt *refs; // "count:ref,ref,..." -> RList<RSignItem>
+	SdbHt *offset; // "0xaddr" -> RList<RSignItem>
+} RSignIndex;
+
+/* read-only zignature database mapped from a file written by r_sign_db_save */
+typedef struct r_sign_db_t {
+	char *file;
+	RMmap *map;
+	const ut8 *buf;
+	ut32 size;
+	ut32 nitems;
+	ut32 items; // item records
+	ut32 data; // strings, bytes and masks
+	ut32 data_size;
+	ut32 graph, ngraph; // sorted by metrics
+	ut32 graph_any, ngraph_any;
+	ut32 bbhash, nbbhash; // sorted by hash
+	ut32 refs, nrefs; // sorted by refs key
+	ut32 offset, noffset; // sorted by offset
+	ut32 spaces, nspaces; // zignspace names
+	ut32 bytes, nbytes; // bytes items with their search anchors
+	ut32 version;
+	ut8 *deleted; // items removed with z-, NULL until the first one
+} RSignDb;
+
 #ifdef R_API
 R_API bool r_sign_add_bytes(RAnal *a, const char *name, ut64 size, const ut8 *bytes, const ut8 *mask);
 R_API bool r_sign_add_anal(RAnal *a, const char *name, ut64 size, const ut8 *bytes, ut64 at);
@@ -91,10 +129,22 @@ R_API bool r_sign_match_offset(RAnal *a, RAnalFunction *fcn, RSignOffsetMatchCal
 R_API bool r_sign_match_hash(RAnal *a, RAnalFunction *fcn, RSignHashMatchCallback cb, void *user);
 R_API bool r_sign_match_refs(RAnal *a, RAnalFunction *fcn, RSignRefsMatchCallback cb, void *user);
 
+R_API RSignIndex *r_sign_index_new(RAnal *a);
+R_API void r_sign_index_free(RSignIndex *idx);
+R_API bool r_sign_index_match_graph(RAnal *a, RSignIndex *idx, RAnalFunction *fcn, int mincc, RSignGraphMatchCallback cb, void *user);
+R_API bool r_sign_index_match_offset(RAnal *a, RSignIndex *idx, RAnalFunction *fcn, RSignOffsetMatchCallback cb, void *user);
+R_API bool r_sign_index_match_hash(RAnal *a, RSignIndex *idx, RAnalFunction *fcn, RSignHashMatchCallback cb, void *user);
+R_API bool r_sign_index_match_refs(RAnal *a, RSignIndex *idx, RAnalFunction *fcn, RSignRefsMatchCallback cb, void *user);
+
 R_API bool r_sign_load(RAnal *a, const char *file);
 R_API bool r_sign_load_gz(RAnal *a, const char *filename);
 R_API char *r_sign_path(RAnal *a, const char *file);
 R_API bool r_sign_save(RAnal *a, const char *file);
+R_API bool r_sign_db_save(RAnal *a, const char *file);
+R_API bool r_sign_db_load(RAnal *a, const char *file);
+R_API bool r_sign_is_db(const char *file);
+R_API RSignDb *r_sign_db_open(const char *file);
+R_API void r_sign_db_close(RSignDb *db);
 
 R_API RSignItem *r_sign_item_new(void);
 R_API RSignItem *r_sign_item_dup(RSignItem *it);
@@ -8,6 +8,7 @@
 
 #include "r_types.h"
 #include "r_bind.h"
+#include "r_list.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -52,8 +53,38 @@ typedef struct {
 	int output[2];
 #endif
 	RCoreBind coreb;
+	ut32 id;
+	bool framed;
 } R2Pipe;
 
+/* framed r2pipe protocol. the client sends the hello line as a text command
+ * and the server answers the ack before switching, text only servers just
+ * run it. then every message starts with a 12 byte header: a zero byte, the
+ * type, two reserved bytes and the little endian request id and payload
+ * length */
+#define R2P_FRAME_HELLO "?e r2pipe frames"
+#define R2P_FRAME_ACK "r2pipe frames ok\n"
+#define R2P_FRAME_HDRSZ 12
+
+enum {
+	R2P_FRAME_CMD = 'c',   // command, the reply carries its output
+	R2P_FRAME_BATCH = 'b', // newline separated commands, replied as ut32 length prefixed outputs
+	R2P_FRAME_BYTES = 'x', // ut64 addr, ut32 len. replied with the raw bytes (pxj)
+	R2P_FRAME_FCNS = 'f',  // replied as ut64 addr, ut32 size, ut32 nbbs, ut32 namelen, name (aflj)
+	R2P_FRAME_XREFS = 'X', // ut64 addr. replied as the ut64 addresses referencing it (axtj)
+	R2P_FRAME_ERROR = 'e', // reply to unknown or malformed requests
+};
+
+typedef struct {
+	ut8 type;
+	ut32 id;
+	ut32 len;
+	ut8 *data;
+} R2PipeFrame;
+
+/* builds the payload replying to a frame, NULL for an error reply */
+typedef ut8 *(*R2PipeFrameReply)(void *user, R2PipeFrame *frame, int *len);
+
 typedef struct r_socket_t {
 #ifdef _MSC_VER
 	SOCKET fd;
@@ -136,9 +167,11 @@ typedef struct r_socket_http_request {
 	char *referer;
 	ut8 *data;
 	int data_length;
+	bool keepalive;
 } RSocketHTTPRequest;
 
 R_API RSocketHTTPRequest *r_socket_http_accept(RSocket *s, int accept_timeout, int timeout);
+R_API RSocketHTTPRequest *r_socket_http_next(RSocketHTTPRequest *rs);
 R_API void r_socket_http_response(RSocketHTTPRequest *rs, int code, const char *out, int x, const char *headers);
 R_API void r_socket_http_close(RSocketHTTPRequest *rs);
 R_API ut8 *r_socket_http_handle_upload(const ut8 *str, int len, int *olen);
@@ -245,6 +278,14 @@ R_API char *r2p_cmdf(R2Pipe *r2p, const char *fmt, ...);
 
 R_API int r2p_write(R2Pipe *r2p, const char *str);
 R_API char *r2p_read(R2Pipe *r2p);
+
+R_API bool r2p_frame_write(int fd, int type, ut32 id, const ut8 *data, int len);
+R_API void r2p_frame_free(R2PipeFrame *frame);
+R_API int r2p_frame_serve(int in, int out, const ut8 *buf, int len, R2PipeFrameReply reply, void *user);
+R_API bool r2p_frames(R2Pipe *r2p);
+R_API int r2p_send(R2Pipe *r2p, int type, const ut8 *data, int len);
+R_API R2PipeFrame *r2p_recv(R2Pipe *r2p);
+R_API RList *r2p_cmd_batch(R2Pipe *r2p, RList *cmds);
 #endif
 
 #ifdef __cplusplus
@@ -96,6 +96,7 @@ R_API RThreadCond *r_th_cond_new(void);
 R_API void r_th_cond_signal(RThreadCond *cond);
 R_API void r_th_cond_signal_all(RThreadCond *cond);
 R_API void r_th_cond_wait(RThreadCond *cond, RThreadLock *lock);
+R_API bool r_th_cond_wait_timeout(RThreadCond *cond, RThreadLock *lock, int ms);
 R_API void r_th_cond_free(RThreadCond *cond);
 
 #endif
@@ -0,0 +1,97 @@
+#ifndef R_TRACELOG_H
+#define R_TRACELOG_H
+
+#include <r_types.h>
+#include <r_vector.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Append-only execution trace. Steps are stored as delta-encoded program
+ * counters followed by register and memory records, packed in lz4 chunks
+ * that can be located by step number or by the pc they contain. */
+
+#define R_TRACELOG_CHUNK_STEPS 4096
+#define R_TRACELOG_CHUNK_SIZE (256 * 1024)
+#define R_TRACELOG_BLOOM_SIZE 512
+
+enum {
+	R_TRACELOG_REG_READ = 1,
+	R_TRACELOG_REG_WRITE,
+	R_TRACELOG_MEM_READ,
+	R_TRACELOG_MEM_WRITE,
+};
+
+typedef struct r_tracelog_event_t {
+	int type;
+	const char *reg; // register name for REG events
+	ut64 value; // register value
+	ut64 addr; // address of MEM events
+	const ut8 *data; // contents of MEM events
+	int len;
+} RTraceLogEvent;
+
+/* returned by r_tracelog_get, valid until the next call */
+typedef struct r_tracelog_step_t {
+	ut64 step;
+	ut64 pc;
+	int count;
+	const RTraceLogEvent *events;
+} RTraceLogStep;
+
+typedef struct r_tracelog_chunk_t {
+	ut64 step; // first step in the chunk
+	ut32 nsteps;
+	ut32 size; // uncompressed size
+	ut32 csize;
+	ut8 *data;
+	ut8 bloom[R_TRACELOG_BLOOM_SIZE]; // pcs executed in the chunk
+} RTraceLogChunk;
+
+typedef struct r_tracelog_t {
+	RVector chunks; // <RTraceLogChunk>
+	RPVector regs; // <char *> register names by id
+	void *regs_ht; // name -> id + 1
+	ut64 count;
+	ut64 csize;
+	/* chunk being written */
+	ut8 *cur;
+	ut32 cur_len;
+	ut32 cur_size;
+	ut32 cur_steps;
+	ut8 cur_bloom[R_TRACELOG_BLOOM_SIZE];
+	ut64 lastpc;
+	ut64 lastmem;
+	ut64 *regstate;
+	ut32 regstate_len;
+	/* last decoded chunk, its records resolved to absolute values */
+	st64 dec_idx;
+	ut32 dec_len;
+	ut32 dec_valid; // leading steps decoded without errors
+	ut8 *dec;
+	ut32 *dec_evs; // index of the first event of every step
+	ut64 *dec_pcs;
+	ut64 *dec_regs; // register values while decoding
+	ut32 dec_nregs;
+	RVector events; // <RTraceLogEvent> of the whole chunk
+} RTraceLog;
+
+R_API RTraceLog *r_tracelog_new(void);
+R_API void r_tracelog_free(RTraceLog *log);
+R_API void r_tracelog_reset(RTraceLog *log);
+R_API ut64 r_tracelog_step(RTraceLog *log, ut64 pc);
+R_API void r_tracelog_reg(RTraceLog *log, int type, const char *name, ut64 value);
+R_API void r_tracelog_mem(RTraceLog *log, int type, ut64 addr, const ut8 *buf, int len);
+R_API ut64 r_tracelog_count(RTraceLog *log);
+R_API ut64 r_tracelog_size(RTraceLog *log);
+R_API bool r_tracelog_get(RTraceLog *log, ut64 step, RTraceLogStep *out);
+R_API ut64 r_tracelog_find(RTraceLog *log, ut64 addr, ut64 from);
+R_API bool r_tracelog_save(RTraceLog *log, const char *file);
+R_API RTraceLog *r_tracelog_load(const char *file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
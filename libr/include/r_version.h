@@ -0,0 +1,8 @@
+#ifndef R_VERSION_H
+#define R_VERSION_H 1
+#define R2_VERSION_COMMIT 1
+#define R2_VERSION "3.1.0-git"
+#define R2_GITTAP "3.1.0-git"
+#define R2_GITTIP "e343da4507b1ed935f1ba1622df0c091246eda32"
+#define R2_BIRTH "2026-10-19__12:09:48"
+#endif
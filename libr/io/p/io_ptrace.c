@@ -1,4 +1,4 @@
-/* radare - LGPL - Copyright 2008-2017 - pancake */
+/* radare - LGPL - Copyright 2008-2018 - pancake */
 
 #include <r_userconf.h>
 #include <r_util.h>
@@ -13,12 +13,29 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <errno.h>
+#if __linux__
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#if defined(__USE_GNU) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 15))
+#define USE_PROCESS_VM 1
+#elif defined(SYS_process_vm_readv) && defined(SYS_process_vm_writev)
+/* the libc wrappers are missing or hidden without _GNU_SOURCE, the syscalls are 3.2+ */
+#define USE_PROCESS_VM 1
+#define process_vm_readv(p,l,ln,r,rn,f) syscall (SYS_process_vm_readv, (p), (l), (ln), (r), (rn), (f))
+#define process_vm_writev(p,l,ln,r,rn,f) syscall (SYS_process_vm_writev, (p), (l), (ln), (r), (rn), (f))
+#else
+#define USE_PROCESS_VM 0
+#endif
+#else
+#define USE_PROCESS_VM 0
+#endif
 
 typedef struct {
 	int pid;
 	int tid;
 	int fd;
 	int opid;
+	bool use_vm;
 } RIOPtrace;
 #define RIOPTRACE_OPID(x) (((RIOPtrace*)(x)->data)->opid)
 #define RIOPTRACE_PID(x) (((RIOPtrace*)(x)->data)->pid)
@@ -70,6 +87,65 @@ static int debug_os_read_at(RIO *io, int pid, ut32 *buf, int sz, ut64 addr) {
 	return sz;
 }
 
+#if USE_PROCESS_VM
+#define VM_PAGE_SIZE 4096
+#define VM_IOV_MAX 1024
+
+/* transfer up to len bytes in a single syscall using page sized remote
+ * iovecs, so a fault only truncates the transfer at the failing page */
+static ssize_t vm_xfer(int pid, ut8 *buf, size_t len, ut64 addr, bool write, size_t *asked) {
+	struct iovec local, remote[VM_IOV_MAX];
+	size_t done = 0;
+	int n = 0;
+	while (done < len && n < VM_IOV_MAX) {
+		size_t chunk = VM_PAGE_SIZE - ((addr + done) % VM_PAGE_SIZE);
+		chunk = R_MIN (chunk, len - done);
+		remote[n].iov_base = (void *)(size_t)(addr + done);
+		remote[n].iov_len = chunk;
+		done += chunk;
+		n++;
+	}
+	local.iov_base = buf;
+	local.iov_len = done;
+	*asked = done;
+	return write
+		? process_vm_writev (pid, &local, 1, remote, n, 0)
+		: process_vm_readv (pid, &local, 1, remote, n, 0);
+}
+
+/* returns the number of leading bytes transferred. unreadable pages are
+ * skipped (leaving the 0xff filler) like the ptrace path does, writes stop
+ * at the first page the kernel refuses (ie: read-only text) so the caller
+ * can retry the rest with POKEDATA */
+static int vm_rw(RIOPtrace *iop, ut8 *buf, int len, ut64 addr, bool write) {
+	size_t asked;
+	int off = 0;
+	while (off < len) {
+		ssize_t ret = vm_xfer (iop->pid, buf + off, len - off, addr + off, write, &asked);
+		if (ret < 0) {
+			if (errno == ENOSYS || errno == EPERM) {
+				/* seccomp, yama or an old kernel, don't try again */
+				iop->use_vm = false;
+				return off;
+			}
+			if (errno != EFAULT) {
+				return off;
+			}
+			ret = 0;
+		}
+		off += ret;
+		if ((size_t)ret < asked) {
+			if (write) {
+				return off;
+			}
+			/* skip the page that faulted */
+			off += VM_PAGE_SIZE - ((addr + off) % VM_PAGE_SIZE);
+		}
+	}
+	return len;
+}
+#endif
+
 static int __read(RIO *io, RIODesc *desc, ut8 *buf, int len) {
 #if USE_PROC_PID_MEM
 	int ret, fd;
@@ -79,6 +155,15 @@ static int __read(RIO *io, RIODesc *desc, ut8 *buf, int len) {
 		return -1;
 	}
 	memset (buf, '\xff', len); // TODO: only memset the non-readed bytes
+#if USE_PROCESS_VM
+	RIOPtrace *iop = desc->data;
+	if (iop->use_vm && len > 0 && addr != UT64_MAX) {
+		if (vm_rw (iop, buf, len, addr, false) == len) {
+			return len;
+		}
+		memset (buf, '\xff', len);
+	}
+#endif
 	/* reopen procpidmem if necessary */
 #if USE_PROC_PID_MEM
 	fd = RIOPTRACE_FD (desc);
@@ -131,6 +216,17 @@ static int __write(RIO *io, RIODesc *fd, const ut8 *buf, int len) {
 	if (!fd || !fd->data) {
 		return -1;
 	}
+#if USE_PROCESS_VM
+	RIOPtrace *iop = fd->data;
+	if (iop->use_vm && len > 0 && io->off != UT64_MAX) {
+		int done = vm_rw (iop, (ut8 *)buf, len, io->off, true);
+		if (done == len) {
+			return len;
+		}
+		int ret = ptrace_write_at (io, iop->pid, buf + done, len - done, io->off + done);
+		return ret < 0? (done? done: -1): done + ret;
+	}
+#endif
 	return ptrace_write_at (io, RIOPTRACE_PID (fd), buf, len, io->off);
 }
 
@@ -202,6 +298,7 @@ static RIODesc *__open(RIO *io, const char *file, int rw, int mode) {
 				return NULL;
 			}
 			riop->pid = riop->tid = pid;
+			riop->use_vm = USE_PROCESS_VM;
 			open_pidmem (riop);
 			desc = r_io_desc_new (io, &r_io_plugin_ptrace, file, rw | R_PERM_X, mode, riop);
 			desc->name = r_sys_pid_to_path (pid);
@@ -250,11 +347,16 @@ static char *__system(RIO *io, RIODesc *fd, const char *cmd) {
 		eprintf ("Usage: =!cmd args\n"
 			" =!ptrace   - use ptrace io\n"
 			" =!mem      - use /proc/pid/mem io if possible\n"
+			" =!vm       - use process_vm_readv/writev io if possible\n"
 			" =!pid      - show targeted pid\n"
 			" =!pid <#>  - select new pid\n");
 	} else
 	if (!strcmp (cmd, "ptrace")) {
 		close_pidmem (iop);
+		iop->use_vm = false;
+	} else
+	if (!strcmp (cmd, "vm")) {
+		iop->use_vm = USE_PROCESS_VM;
 	} else
 	if (!strcmp (cmd, "mem")) {
 		open_pidmem (iop);
@@ -291,7 +393,7 @@ static int __getpid (RIODesc *fd) {
 // TODO: rename ptrace to io_ptrace .. err io.ptrace ??
 RIOPlugin r_io_plugin_ptrace = {
 	.name = "ptrace",
-	.desc = "ptrace and /proc/pid/mem (if available) io",
+	.desc = "ptrace, process_vm and /proc/pid/mem (if available) io",
 	.license = "LGPL3",
 	.open = __open,
 	.close = __close,
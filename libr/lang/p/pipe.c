@@ -123,6 +123,7 @@ static int lang_pipe_run(RLang *lang, const char *code, int len) {
 		perror ("pipe run");
 	} else if (!child) {
 		/* children */
+		r_sys_setenv ("R2PIPE_FRAMED", "1");
 		r_sandbox_system (code, 1);
 		write (input[1], "", 1);
 		close (input[0]);
@@ -146,6 +147,17 @@ static int lang_pipe_run(RLang *lang, const char *code, int len) {
 			void *bed = r_cons_sleep_begin ();
 			ret = read (output[0], buf, sizeof (buf) - 1);
 			r_cons_sleep_end (bed);
+			if (lang->frame_reply && r_str_startswith (buf, R2P_FRAME_HELLO "\n")) {
+				/* framed clients stay framed until they close the pipe */
+				int hl = strlen (R2P_FRAME_HELLO "\n");
+				int al = strlen (R2P_FRAME_ACK) + 1;
+				if (write (input[1], R2P_FRAME_ACK, al) != al) {
+					break;
+				}
+				r2p_frame_serve (output[0], input[1], (const ut8 *)buf + hl, ret - hl,
+					(R2PipeFrameReply)lang->frame_reply, lang->user);
+				break;
+			}
 			if (ret < 1 || !buf[0]) {
 				break;
 			}
@@ -69,6 +69,8 @@ int file_zmagic(struct r_magic_set *, int, const char *,
 int file_ascmagic(struct r_magic_set *, const unsigned char *, size_t);
 int file_is_tar(struct r_magic_set *, const unsigned char *, size_t);
 int file_softmagic(struct r_magic_set *, const unsigned char *, size_t, int);
+int file_softmagic_test(struct r_magic_set *, struct r_magic *, const unsigned char *, size_t);
+int file_maybe_tar(const unsigned char *, size_t);
 struct mlist *file_apprentice(struct r_magic_set *, const char *, int);
 ut64 file_signextend(RMagic *, struct r_magic *, ut64);
 void file_delmagic(struct r_magic *, int type, size_t entries);
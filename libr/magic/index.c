@@ -0,0 +1,304 @@
+/* radare - LGPL - Copyright 2018 - pancake */
+
+#include <r_userconf.h>
+
+#if !USE_LIB_MAGIC
+
+#include <r_util.h>
+#include "file.h"
+
+/* Every top-level test of the database can only pass at the offsets where
+ * its literal bytes appear, so instead of running softmagic at each offset
+ * the literals are searched all at once with an Aho-Corasick automaton.
+ * Tests with no usable literal (relations other than '=', case-insensitive
+ * strings, indirect offsets...) are kept aside and run one by one. */
+
+typedef struct r_magic_index_lit_t {
+	ut32 back; // distance from the tested offset to the last literal byte
+	int next; // next literal ending in the same state
+} RMagicIndexLit;
+
+typedef struct {
+	ut8 bytes[MAXstring];
+	int len;
+	ut32 back;
+} MagicLiteral;
+
+#define UNKNOWN 0x100
+
+static int test_bytes(struct r_magic *m, ut16 *b) {
+	ut64 mask = UT64_MAX, v = m->value.q;
+	bool be = R_SYS_ENDIAN;
+	int i, w;
+
+	switch (m->type) {
+	case FILE_STRING:
+		if (m->str_flags & ~(STRING_COMPACT_BLANK | STRING_COMPACT_OPTIONAL_BLANK)) {
+			return 0;
+		}
+		w = R_MIN (m->vallen, MAXstring - 1);
+		for (i = 0; i < w; i++) {
+			/* compacted blanks match any number of them */
+			if (m->str_flags && isspace ((ut8)m->value.s[i])) {
+				break;
+			}
+			b[i] = (ut8)m->value.s[i];
+		}
+		return i;
+	case FILE_BYTE:
+		w = 1;
+		break;
+	case FILE_BESHORT:
+		be = true;
+		/* fallthrough */
+	case FILE_SHORT:
+		w = 2;
+		break;
+	case FILE_LESHORT:
+		be = false;
+		w = 2;
+		break;
+	case FILE_BELONG:
+		be = true;
+		/* fallthrough */
+	case FILE_LONG:
+		w = 4;
+		break;
+	case FILE_LELONG:
+		be = false;
+		w = 4;
+		break;
+	case FILE_BEQUAD:
+		be = true;
+		/* fallthrough */
+	case FILE_QUAD:
+		w = 8;
+		break;
+	case FILE_LEQUAD:
+		be = false;
+		w = 8;
+		break;
+	default:
+		return 0;
+	}
+	if (m->mask_op & FILE_OPINVERSE) {
+		return 0;
+	}
+	if (m->num_mask) {
+		if ((m->mask_op & FILE_OPS_MASK) != FILE_OPAND) {
+			return 0;
+		}
+		mask = m->num_mask;
+	}
+	for (i = 0; i < w; i++) {
+		int sh = be? (w - 1 - i) * 8: i * 8;
+		b[i] = (((mask >> sh) & 0xff) == 0xff)? (v >> sh) & 0xff: UNKNOWN;
+	}
+	return w;
+}
+
+/* longest run of known bytes of the test. mcopy pads the data past the end
+ * of the buffer with zeroes, so only the bytes up to the last non-zero one
+ * are sure to come from the buffer */
+static bool test_literal(struct r_magic *m, MagicLiteral *lit) {
+	ut16 b[MAXstring];
+	int i, w, last = -1, start = 0, best = 0, best_len = 0;
+
+	if (m->reln != '=' || (m->flag & (INDIR | OFFADD | INDIROFFADD)) || m->in_op) {
+		return false;
+	}
+	w = test_bytes (m, b);
+	for (i = 0; i < w; i++) {
+		if (b[i] != UNKNOWN && b[i]) {
+			last = i;
+		}
+	}
+	for (i = 0; i <= last; i++) {
+		if (b[i] == UNKNOWN) {
+			start = i + 1;
+		} else if (i - start + 1 > best_len) {
+			best = start;
+			best_len = i - start + 1;
+		}
+	}
+	if (!best_len) {
+		return false;
+	}
+	for (i = 0; i < best_len; i++) {
+		lit->bytes[i] = (ut8)b[best + i];
+	}
+	lit->len = best_len;
+	lit->back = m->offset + best + best_len - 1;
+	return true;
+}
+
+/* string values compare as 0 and '<' is unsigned, these never match */
+static bool test_never(struct r_magic *m) {
+	return m->reln == '<' && MAGIC_IS_STRING (m->type);
+}
+
+static bool index_build(RMagicIndex *mi, MagicLiteral *lits, ut32 nlits) {
+	ut32 i, j, *fail, *queue, head = 0, tail = 0, maxstates = 1;
+
+	for (i = 0; i < nlits; i++) {
+		maxstates += lits[i].len;
+	}
+	mi->go = calloc ((size_t)maxstates * 256, sizeof (ut32));
+	mi->dict = calloc (maxstates, sizeof (ut32));
+	mi->first = malloc (maxstates * sizeof (int));
+	mi->lits = calloc (R_MAX (nlits, 1), sizeof (RMagicIndexLit));
+	fail = calloc (maxstates, sizeof (ut32));
+	queue = malloc (maxstates * sizeof (ut32));
+	if (!mi->go || !mi->dict || !mi->first || !mi->lits || !fail || !queue) {
+		free (fail);
+		free (queue);
+		return false;
+	}
+	memset (mi->first, -1, maxstates * sizeof (int));
+	/* the trie, no edge ever goes back to the root so 0 means none */
+	mi->nstates = 1;
+	for (i = 0; i < nlits; i++) {
+		ut32 s = 0;
+		for (j = 0; j < lits[i].len; j++) {
+			ut32 *next = &mi->go[s * 256 + lits[i].bytes[j]];
+			if (!*next) {
+				*next = mi->nstates++;
+			}
+			s = *next;
+		}
+		mi->lits[i].back = lits[i].back;
+		mi->lits[i].next = mi->first[s];
+		mi->first[s] = i;
+	}
+	mi->nlits = nlits;
+	/* failure links in breadth first order turn the trie in a dfa */
+	for (j = 0; j < 256; j++) {
+		if (mi->go[j]) {
+			queue[tail++] = mi->go[j];
+		}
+	}
+	while (head < tail) {
+		ut32 s = queue[head++];
+		for (j = 0; j < 256; j++) {
+			ut32 *next = &mi->go[s * 256 + j];
+			if (*next) {
+				ut32 u = *next;
+				ut32 f = mi->go[fail[s] * 256 + j];
+				fail[u] = f;
+				mi->dict[u] = (mi->first[f] >= 0)? f: mi->dict[f];
+				queue[tail++] = u;
+			} else {
+				*next = mi->go[fail[s] * 256 + j];
+			}
+		}
+	}
+	free (fail);
+	free (queue);
+	return true;
+}
+
+R_API RMagicIndex *r_magic_index_new(RMagic *ms) {
+	r_return_val_if_fail (ms, NULL);
+	MagicLiteral *lits = NULL;
+	RMagicIndex *mi = NULL;
+	struct mlist *ml;
+	ut32 i, n = 0, nlits = 0;
+
+	if (!ms->mlist) {
+		return NULL;
+	}
+	for (ml = ms->mlist->next; ml != ms->mlist; ml = ml->next) {
+		n += ml->nmagic;
+	}
+	mi = R_NEW0 (RMagicIndex);
+	lits = R_NEWS0 (MagicLiteral, R_MAX (n, 1));
+	if (!mi || !lits) {
+		goto fail;
+	}
+	for (ml = ms->mlist->next; ml != ms->mlist; ml = ml->next) {
+		for (i = 0; i < ml->nmagic; i++) {
+			struct r_magic *m = &ml->magic[i];
+			/* file_buffer only runs the binary tests */
+			if (m->cont_level || !(m->flag & BINTEST) || test_never (m)) {
+				continue;
+			}
+			if (test_literal (m, &lits[nlits])) {
+				nlits++;
+				continue;
+			}
+			if (!(mi->ntests % 16)) {
+				struct r_magic *tests = realloc (mi->tests, (mi->ntests + 16) * sizeof (struct r_magic));
+				if (!tests) {
+					goto fail;
+				}
+				mi->tests = tests;
+			}
+			mi->tests[mi->ntests++] = *m;
+		}
+	}
+	if (!index_build (mi, lits, nlits)) {
+		goto fail;
+	}
+	free (lits);
+	return mi;
+fail:
+	free (lits);
+	r_magic_index_free (mi);
+	return NULL;
+}
+
+R_API void r_magic_index_free(RMagicIndex *mi) {
+	if (mi) {
+		free (mi->go);
+		free (mi->dict);
+		free (mi->first);
+		free (mi->lits);
+		free (mi->tests);
+		free (mi);
+	}
+}
+
+/* Set hits[i] for every offset of buf where r_magic_buffer on the next
+ * R_MIN (size, len - i) bytes may return something other than "data".
+ * The scratch RMagic is used to run the tests without literal, one per
+ * thread. Returns the number of candidate offsets */
+R_API int r_magic_index_scan(RMagicIndex *mi, RMagic *ms, const ut8 *buf, size_t len, size_t size, ut8 *hits) {
+	r_return_val_if_fail (mi && buf && hits && (ms || !mi->ntests), -1);
+	size_t i;
+	ut32 j, s = 0;
+	int count = 0;
+
+	memset (hits, 0, len);
+	for (i = 0; i < len; i++) {
+		ut32 t;
+		s = mi->go[s * 256 + buf[i]];
+		for (t = (mi->first[s] >= 0)? s: mi->dict[s]; t; t = mi->dict[t]) {
+			int l;
+			for (l = mi->first[t]; l >= 0; l = mi->lits[l].next) {
+				ut32 back = mi->lits[l].back;
+				if (back <= i && back < size) {
+					hits[i - back] = 1;
+				}
+			}
+		}
+	}
+	for (i = 0; i < len; i++) {
+		if (!hits[i]) {
+			size_t nb = R_MIN (size, len - i);
+			if (nb < 2 || file_maybe_tar (buf + i, nb)) {
+				hits[i] = 1;
+			} else {
+				for (j = 0; j < mi->ntests; j++) {
+					if (file_softmagic_test (ms, &mi->tests[j], buf + i, nb)) {
+						hits[i] = 1;
+						break;
+					}
+				}
+			}
+		}
+		count += hits[i];
+	}
+	return count;
+}
+
+#endif
@@ -122,6 +122,15 @@ static int is_tar(const ut8 *buf, size_t nbytes) {
 	return 1;			/* Old fashioned tar archive */
 }
 
+/*
+ * Cheap test done before is_tar(), the header checksum always counts the
+ * eight blanks of its own field so it must hold a positive number.
+ */
+int file_maybe_tar(const ut8 *buf, size_t nbytes) {
+	const union record *header = (const union record *)(const void *)buf;
+	return nbytes >= sizeof (union record) && from_oct (8, header->header.chksum) > 0;
+}
+
 int file_is_tar(RMagic *ms, const ut8 *buf, size_t nbytes) {
 	/*
 	 * Do the tar test first, because if the first file in the tar
@@ -78,6 +78,19 @@ int file_softmagic(RMagic *ms, const ut8 *buf, size_t nbytes, int mode) {
 	return 0;
 }
 
+/*
+ * Run the test of a single top-level entry, ignoring its continuations.
+ * Returns non-zero if the entry could match, used by the magic index.
+ */
+int file_softmagic_test(RMagic *ms, struct r_magic *m, const ut8 *buf, size_t nbytes) {
+	ms->offset = m->offset;
+	ms->line = m->lineno;
+	if (!mget (ms, buf, m, nbytes, 0)) {
+		return m->reln == '!';
+	}
+	return magiccheck (ms, m) != 0;
+}
+
 /*
  * Go through the whole list, stopping if you find a match.  Process all
  * the continuations of that match before returning.
@@ -1,6 +1,7 @@
-/* radare - LGPL - Copyright 2012-2016 - pancake */
+/* radare - LGPL - Copyright 2012-2018 - pancake */
 
 #include <r_socket.h>
+#include <r_util.h>
 
 static bool *breaked = NULL;
 
@@ -8,10 +9,103 @@ R_API void r_socket_http_server_set_breaked(bool *b) {
 	breaked = b;
 }
 
-R_API RSocketHTTPRequest *r_socket_http_accept (RSocket *s, int accept_timeout, int timeout) {
-	int content_length = 0, xx, yy;
-	int pxx = 1, first = 0;
+/* read a header line, the trailing \r\n or \n is not included */
+static int http_gets(RSocket *s, char *buf, int size) {
+	int i = 0;
+	while (i < size - 1) {
+		if (r_socket_read (s, (ut8 *)buf + i, 1) != 1) {
+			if (!i) {
+				return -1;
+			}
+			break;
+		}
+		if (buf[i] == '\n') {
+			break;
+		}
+		i++;
+	}
+	if (i > 0 && buf[i - 1] == '\r') {
+		i--;
+	}
+	buf[i] = 0;
+	return i;
+}
+
+static bool http_read_request(RSocketHTTPRequest *hr) {
+	int content_length = 0, len, skip = 0;
+	bool http11 = false, keepalive = false, closing = false;
 	char buf[1500], *p, *q;
+
+	/* pipelined clients may leave an empty line between requests */
+	do {
+		len = http_gets (hr->s, buf, sizeof (buf));
+	} while (!len && skip++ < 2);
+	if (len < 3) {
+		return false;
+	}
+	p = strchr (buf, ' ');
+	if (p) {
+		*p = 0;
+	}
+	hr->method = strdup (buf);
+	if (p) {
+		q = strstr (p + 1, " HTTP");
+		if (q) {
+			http11 = !strncmp (q, " HTTP/1.1", 9);
+			*q = 0;
+		}
+		hr->path = strdup (p + 1);
+	}
+	for (;;) {
+#if __WINDOWS__
+		if (breaked)
+			break;
+#endif
+		if (http_gets (hr->s, buf, sizeof (buf)) < 1) {
+			break;
+		}
+		if (!hr->referer && !strncmp (buf, "Referer: ", 9)) {
+			hr->referer = strdup (buf + 9);
+		} else
+		if (!hr->agent && !strncmp (buf, "User-Agent: ", 12)) {
+			hr->agent = strdup (buf + 12);
+		} else
+		if (!hr->host && !strncmp (buf, "Host: ", 6)) {
+			hr->host = strdup (buf + 6);
+		} else
+		if (!strncmp (buf, "Content-Length: ", 16)) {
+			content_length = atoi (buf + 16);
+		} else
+		if (!r_str_ncasecmp (buf, "Connection: ", 12)) {
+			keepalive = r_str_casestr (buf + 12, "keep-alive");
+			closing = r_str_casestr (buf + 12, "close");
+		}
+	}
+	hr->keepalive = http11? !closing: keepalive;
+	if (content_length > 0) {
+		hr->data = malloc (content_length + 1);
+		if (!hr->data) {
+			return false;
+		}
+		hr->data_length = content_length;
+		if (r_socket_read_block (hr->s, hr->data, hr->data_length) != content_length) {
+			hr->keepalive = false;
+		}
+		hr->data[content_length] = 0;
+	}
+	return true;
+}
+
+static void http_request_fini(RSocketHTTPRequest *rs) {
+	free (rs->path);
+	free (rs->host);
+	free (rs->agent);
+	free (rs->method);
+	free (rs->referer);
+	free (rs->data);
+}
+
+R_API RSocketHTTPRequest *r_socket_http_accept (RSocket *s, int accept_timeout, int timeout) {
 	RSocketHTTPRequest *hr = R_NEW0 (RSocketHTTPRequest);
 	if (!hr) {
 		return NULL;
@@ -28,63 +122,27 @@ R_API RSocketHTTPRequest *r_socket_http_accept (RSocket *s, int accept_timeout,
 	if (timeout > 0) {
 		r_socket_block_time (hr->s, 1, timeout);
 	}
-	for (;;) {
-#if __WINDOWS__
-		if (breaked)
-			break;
-#endif
-		memset (buf, 0, sizeof (buf));
-		xx = r_socket_gets (hr->s, buf, sizeof (buf));
-		yy = r_socket_ready (hr->s, 0, 20 * 1000); //this function uses usecs as argument
-//		eprintf ("READ %d (%s) READY %d\n", xx, buf, yy);
-		if (!yy || (!xx && !pxx)) {
-			break;
-		}
-		pxx = xx;
-
-		if (first==0) {
-			first = 1;
-			if (strlen (buf)<3) {
-				r_socket_http_close (hr);
-				return NULL;
-			}
-			p = strchr (buf, ' ');
-			if (p) {
-				*p = 0;
-			}
-			hr->method = strdup (buf);
-			if (p) {
-				q = strstr (p+1, " HTTP"); //strchr (p+1, ' ');
-				if (q) {
-					*q = 0;
-				}
-				hr->path = strdup (p+1);
-			}
-		} else {
-			if (!hr->referer && !strncmp (buf, "Referer: ", 9)) {
-				hr->referer = strdup (buf + 9);
-			} else
-			if (!hr->agent && !strncmp (buf, "User-Agent: ", 12)) {
-				hr->agent = strdup (buf + 12);
-			} else
-			if (!hr->host && !strncmp (buf, "Host: ", 6)) {
-				hr->host = strdup (buf + 6);
-			} else
-			if (!strncmp (buf, "Content-Length: ", 16)) {
-				content_length = atoi (buf+16);
-			}
-		}
-	}
-	if (content_length>0) {
-		r_socket_read_block (hr->s, (ut8*)buf, 1); // one missing byte wtf
-		hr->data = malloc (content_length+1);
-		hr->data_length = content_length;
-		r_socket_read_block (hr->s, hr->data, hr->data_length);
-		hr->data[content_length] = 0;
+	if (!http_read_request (hr)) {
+		r_socket_http_close (hr);
+		return NULL;
 	}
 	return hr;
 }
 
+/* read the next request from the connection of a kept-alive one, which is
+ * freed. returns NULL and closes the connection on error or end of stream */
+R_API RSocketHTTPRequest *r_socket_http_next (RSocketHTTPRequest *rs) {
+	http_request_fini (rs);
+	RSocket *s = rs->s;
+	memset (rs, 0, sizeof (RSocketHTTPRequest));
+	rs->s = s;
+	if (!http_read_request (rs)) {
+		r_socket_http_close (rs);
+		return NULL;
+	}
+	return rs;
+}
+
 R_API void r_socket_http_response (RSocketHTTPRequest *rs, int code, const char *out, int len, const char *headers) {
 	const char *strcode = \
 		code==200?"ok":
@@ -98,9 +156,15 @@ R_API void r_socket_http_response (RSocketHTTPRequest *rs, int code, const char
 	if (!headers) {
 		headers = "";
 	}
-	r_socket_printf (rs->s, "HTTP/1.0 %d %s\r\n%s"
-		"Connection: close\r\nContent-Length: %d\r\n\r\n",
-		code, strcode, headers, len);
+	if (rs->keepalive) {
+		r_socket_printf (rs->s, "HTTP/1.1 %d %s\r\n%s"
+			"Connection: keep-alive\r\nContent-Length: %d\r\n\r\n",
+			code, strcode, headers, len);
+	} else {
+		r_socket_printf (rs->s, "HTTP/1.0 %d %s\r\n%s"
+			"Connection: close\r\nContent-Length: %d\r\n\r\n",
+			code, strcode, headers, len);
+	}
 	if (out && len > 0) {
 		r_socket_write (rs->s, (void *)out, len);
 	}
@@ -155,11 +219,7 @@ R_API ut8 *r_socket_http_handle_upload(const ut8 *str, int len, int *retlen) {
 /* close client socket and free struct */
 R_API void r_socket_http_close (RSocketHTTPRequest *rs) {
 	r_socket_free (rs->s);
-	free (rs->path);
-	free (rs->host);
-	free (rs->agent);
-	free (rs->method);
-	free (rs->data);
+	http_request_fini (rs);
 	free (rs);
 }
 
@@ -1,4 +1,4 @@
-/* radare - LGPL - Copyright 2015-2016 - pancake */
+/* radare - LGPL - Copyright 2015-2018 - pancake */
 /*
 Usage Example:
 
@@ -315,3 +315,213 @@ R_API char *r2p_cmdf(R2Pipe *r2p, const char *fmt, ...) {
 	return (char*)fmt;
 }
 
+
+/* framed protocol */
+
+#if __WINDOWS__ && !defined(__CYGWIN__)
+R_API bool r2p_frame_write(int fd, int type, ut32 id, const ut8 *data, int len) {
+	return false;
+}
+#else
+static bool write_all(int fd, const ut8 *buf, int len) {
+	while (len > 0) {
+		int rv = write (fd, buf, len);
+		if (rv < 1) {
+			return false;
+		}
+		buf += rv;
+		len -= rv;
+	}
+	return true;
+}
+
+R_API bool r2p_frame_write(int fd, int type, ut32 id, const ut8 *data, int len) {
+	ut8 hdr[R2P_FRAME_HDRSZ] = {0};
+	if (len < 0) {
+		return false;
+	}
+	hdr[1] = type;
+	r_write_le32 (hdr + 4, id);
+	r_write_le32 (hdr + 8, len);
+	return write_all (fd, hdr, sizeof (hdr)) && (!len || write_all (fd, data, len));
+}
+#endif
+
+R_API void r2p_frame_free(R2PipeFrame *frame) {
+	if (frame) {
+		free (frame->data);
+		free (frame);
+	}
+}
+
+#if !__WINDOWS__ || defined(__CYGWIN__)
+/* read len bytes from fd, after the ones left in buf by the text protocol */
+static bool read_all(int fd, const ut8 **buf, int *buflen, ut8 *dst, int len) {
+	if (*buflen > 0) {
+		int n = R_MIN (*buflen, len);
+		memcpy (dst, *buf, n);
+		*buf += n;
+		*buflen -= n;
+		dst += n;
+		len -= n;
+	}
+	while (len > 0) {
+		int rv = read (fd, dst, len);
+		if (rv < 1) {
+			return false;
+		}
+		dst += rv;
+		len -= rv;
+	}
+	return true;
+}
+#endif
+
+static R2PipeFrame *frame_read(int fd, const ut8 **buf, int *buflen) {
+#if __WINDOWS__ && !defined(__CYGWIN__)
+	return NULL;
+#else
+	ut8 hdr[R2P_FRAME_HDRSZ];
+	if (!read_all (fd, buf, buflen, hdr, sizeof (hdr)) || hdr[0]) {
+		return NULL;
+	}
+	ut32 size = r_read_le32 (hdr + 8);
+	if (size > ST32_MAX - R2P_FRAME_HDRSZ) {
+		return NULL;
+	}
+	R2PipeFrame *frame = R_NEW0 (R2PipeFrame);
+	if (!frame) {
+		return NULL;
+	}
+	frame->type = hdr[1];
+	frame->id = r_read_le32 (hdr + 4);
+	frame->len = size;
+	frame->data = malloc (size + 1);
+	if (!frame->data || !read_all (fd, buf, buflen, frame->data, size)) {
+		r2p_frame_free (frame);
+		return NULL;
+	}
+	frame->data[size] = 0;
+	return frame;
+#endif
+}
+
+/* answer frames read from 'in' until the end of the stream. buf holds the
+ * bytes already read by the text protocol loop. returns the frames served */
+R_API int r2p_frame_serve(int in, int out, const ut8 *buf, int len, R2PipeFrameReply reply, void *user) {
+	R2PipeFrame *frame;
+	int count = 0;
+	while ((frame = frame_read (in, &buf, &len))) {
+		int reslen = 0;
+		ut8 *res = reply (user, frame, &reslen);
+		bool ok = res
+			? r2p_frame_write (out, frame->type, frame->id, res, reslen)
+			: r2p_frame_write (out, R2P_FRAME_ERROR, frame->id, NULL, 0);
+		free (res);
+		r2p_frame_free (frame);
+		if (!ok) {
+			break;
+		}
+		count++;
+	}
+	return count;
+}
+
+/* ask the other end to switch to frames. text only peers run the hello as
+ * a command and answer something else, and the pipe stays in text mode */
+R_API bool r2p_frames(R2Pipe *r2p) {
+	if (!r2p || r2p->coreb.core) {
+		return false;
+	}
+	if (!r2p->framed) {
+#if __WINDOWS__ && !defined(__CYGWIN__)
+		return false;
+#else
+		const char *hello = R2P_FRAME_HELLO "\n";
+		if (!write_all (r2p->input[1], (const ut8 *)hello, strlen (hello))) {
+			return false;
+		}
+		char *res = r2p_read (r2p);
+		r2p->framed = res && !strcmp (res, R2P_FRAME_ACK);
+		free (res);
+#endif
+	}
+	return r2p->framed;
+}
+
+/* queue a request without waiting for its reply. returns its id, or -1 if
+ * the pipe is not framed */
+R_API int r2p_send(R2Pipe *r2p, int type, const ut8 *data, int len) {
+	if (!r2p || !r2p->framed) {
+		return -1;
+	}
+	ut32 id = ++r2p->id;
+#if __WINDOWS__ && !defined(__CYGWIN__)
+	return -1;
+#else
+	return r2p_frame_write (r2p->input[1], type, id, data, len)? (int)id: -1;
+#endif
+}
+
+/* replies come in the order of the requests */
+R_API R2PipeFrame *r2p_recv(R2Pipe *r2p) {
+	if (!r2p || !r2p->framed) {
+		return NULL;
+	}
+#if __WINDOWS__ && !defined(__CYGWIN__)
+	return NULL;
+#else
+	const ut8 *buf = NULL;
+	int len = 0;
+	return frame_read (r2p->output[0], &buf, &len);
+#endif
+}
+
+/* run all the commands in a single round trip, or one by one if the pipe
+ * is not framed */
+R_API RList *r2p_cmd_batch(R2Pipe *r2p, RList *cmds) {
+	RListIter *iter;
+	const char *cmd;
+	if (!r2p || !cmds) {
+		return NULL;
+	}
+	if (!r2p->framed) {
+		RList *res = r_list_newf (free);
+		r_list_foreach (cmds, iter, cmd) {
+			char *out = r2p_cmd (r2p, cmd);
+			if (!out) {
+				r_list_free (res);
+				return NULL;
+			}
+			r_list_append (res, out);
+		}
+		return res;
+	}
+	char *req = NULL;
+	r_list_foreach (cmds, iter, cmd) {
+		req = r_str_appendf (req, "%s\n", cmd);
+	}
+	int id = r2p_send (r2p, R2P_FRAME_BATCH, (const ut8 *)req, req? strlen (req): 0);
+	free (req);
+	if (id < 0) {
+		return NULL;
+	}
+	R2PipeFrame *frame = r2p_recv (r2p);
+	if (!frame || frame->type != R2P_FRAME_BATCH || frame->id != id) {
+		r2p_frame_free (frame);
+		return NULL;
+	}
+	RList *res = r_list_newf (free);
+	ut32 off = 0;
+	while (res && off + 4 <= frame->len) {
+		ut32 n = r_read_le32 (frame->data + off);
+		off += 4;
+		if (n > frame->len - off) {
+			break;
+		}
+		r_list_append (res, r_str_ndup ((const char *)frame->data + off, n));
+		off += n;
+	}
+	r2p_frame_free (frame);
+	return res;
+}
@@ -0,0 +1,312 @@
+/* radare - LGPL - Copyright 2018 - pancake */
+
+#include <r_util.h>
+#include <r_diff.h>
+
+/* Streaming delta diff for inputs too big to be loaded in memory.
+ *
+ * Both sources are cut in content-defined chunks with a gear rolling hash,
+ * so chunk boundaries resynchronize right after an insertion or removal.
+ * The chunks of the first source are indexed by content hash, the second
+ * source is then walked in order and the nearest chunk with the same bytes
+ * in the first one, at or after the current position, anchors the alignment.
+ * An anchor farther than CDIFF_MAX_JUMP is only taken once a chunk with other
+ * contents continues its run, so repeated chunks like padding can't skip
+ * over most of the input. Only the windows between anchors are read back and
+ * compared byte by byte, and the changes are reported through the diff
+ * callback in ops of bounded size. */
+
+#define CDIFF_BLOCK (1024 * 1024)
+#define CDIFF_MIN_CHUNK 2048
+#define CDIFF_MAX_CHUNK (64 * 1024)
+#define CDIFF_AVG_BITS 13 // 8K chunks on average
+#define CDIFF_OP_SIZE (64 * 1024) // also fits a whole chunk
+#define CDIFF_MAX_JUMP CDIFF_BLOCK
+
+typedef struct {
+	ut64 hash;
+	ut64 off;
+	ut32 len;
+} CDiffChunk;
+
+typedef struct {
+	ut64 a, b; // start of the run in each source, a is UT64_MAX if none
+	ut64 len;
+	ut64 hash;
+} CDiffRun;
+
+typedef struct {
+	RDiff *d;
+	RDiffSource *a, *b;
+	ut64 gear[256];
+	ut8 *block;
+	ut8 *wa, *wb;
+	RVector chunks; // <CDiffChunk> of a, sorted by hash and offset
+	ut64 pa, pb; // end of the last anchor in each source
+	ut64 wb_off; // chunk of b loaded in wb, UT64_MAX if none
+	CDiffRun jump; // far anchor waiting for a chunk with other contents
+	int ops;
+	bool error;
+} CDiff;
+
+typedef bool (*CDiffChunkCallback)(CDiff *cd, CDiffChunk *chunk);
+
+static inline ut64 cdiff_mix(ut64 x) {
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+static bool cdiff_read(CDiff *cd, RDiffSource *src, ut64 off, ut8 *buf, int len) {
+	if (len > 0 && src->read (src->user, off, buf, len) != len) {
+		eprintf ("r_diff_stream: cannot read %d byte(s) at 0x%08"PFMT64x"\n", len, off);
+		cd->error = true;
+		return false;
+	}
+	return true;
+}
+
+static bool cdiff_chunks(CDiff *cd, RDiffSource *src, CDiffChunkCallback cb) {
+	CDiffChunk chunk = { 0 };
+	ut64 off, g = 0, h = 0;
+	ut32 len = 0;
+
+	for (off = 0; off < src->size; ) {
+		int i, n = (int)R_MIN (CDIFF_BLOCK, src->size - off);
+		if (!cdiff_read (cd, src, off, cd->block, n)) {
+			return false;
+		}
+		for (i = 0; i < n; i++) {
+			const ut8 ch = cd->block[i];
+			g = (g << 1) + cd->gear[ch];
+			h = (h ^ ch) * 0x100000001b3ULL;
+			len++;
+			if ((len >= CDIFF_MIN_CHUNK && !(g >> (64 - CDIFF_AVG_BITS))) || len == CDIFF_MAX_CHUNK) {
+				chunk.hash = cdiff_mix (h ^ len);
+				chunk.len = len;
+				if (!cb (cd, &chunk)) {
+					return false;
+				}
+				chunk.off = off + i + 1;
+				g = h = len = 0;
+			}
+		}
+		off += n;
+	}
+	if (len > 0) {
+		chunk.hash = cdiff_mix (h ^ len);
+		chunk.len = len;
+		return cb (cd, &chunk);
+	}
+	return true;
+}
+
+static bool index_chunk(CDiff *cd, CDiffChunk *chunk) {
+	return r_vector_push (&cd->chunks, chunk) != NULL;
+}
+
+static int chunk_cmp(const void *a, const void *b) {
+	const CDiffChunk *ca = a, *cb = b;
+	if (ca->hash != cb->hash) {
+		return ca->hash < cb->hash? -1: 1;
+	}
+	return ca->off < cb->off? -1: ca->off > cb->off;
+}
+
+// whether the chunk of b has the same bytes at off in a
+static bool chunk_at(CDiff *cd, CDiffChunk *chunk, ut64 at) {
+	if (at > cd->a->size || cd->a->size - at < chunk->len) {
+		return false;
+	}
+	if (cd->wb_off != chunk->off) {
+		if (!cdiff_read (cd, cd->b, chunk->off, cd->wb, chunk->len)) {
+			return false;
+		}
+		cd->wb_off = chunk->off;
+	}
+	return cdiff_read (cd, cd->a, at, cd->wa, chunk->len)
+		&& !memcmp (cd->wa, cd->wb, chunk->len);
+}
+
+// first chunk of a with the same contents at or after from
+static ut64 find_chunk(CDiff *cd, CDiffChunk *chunk, ut64 from) {
+	CDiffChunk *c = cd->chunks.a;
+	size_t lo = 0, hi = cd->chunks.len;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (c[mid].hash < chunk->hash || (c[mid].hash == chunk->hash && c[mid].off < from)) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	for (; lo < cd->chunks.len && c[lo].hash == chunk->hash; lo++) {
+		if (c[lo].len == chunk->len && chunk_at (cd, chunk, c[lo].off)) {
+			return c[lo].off;
+		}
+		if (cd->error) {
+			break;
+		}
+	}
+	return UT64_MAX;
+}
+
+static void emit(CDiff *cd, ut64 a_off, const ut8 *a_buf, ut32 a_len, ut64 b_off, const ut8 *b_buf, ut32 b_len) {
+	RDiffOp op = {
+		.a_off = cd->d->off_a + a_off, .a_buf = a_buf, .a_len = a_len,
+		.b_off = cd->d->off_b + b_off, .b_buf = b_buf, .b_len = b_len
+	};
+	if (cd->d->callback) {
+		cd->d->callback (cd->d, cd->d->user, &op);
+	}
+	cd->ops++;
+}
+
+/* same sized windows are compared in place, like r_diff_buffers_static */
+static void diff_inplace(CDiff *cd, ut64 a, ut64 b, ut64 len) {
+	ut64 off;
+	for (off = 0; off < len; off += CDIFF_OP_SIZE) {
+		int i, n = (int)R_MIN (CDIFF_OP_SIZE, len - off), hit = 0;
+		if (!cdiff_read (cd, cd->a, a + off, cd->wa, n) || !cdiff_read (cd, cd->b, b + off, cd->wb, n)) {
+			return;
+		}
+		for (i = 0; i <= n; i++) {
+			if (i < n && cd->wa[i] != cd->wb[i]) {
+				hit++;
+			} else if (hit > 0) {
+				emit (cd, a + off + i - hit, cd->wa + i - hit, hit,
+					b + off + i - hit, cd->wb + i - hit, hit);
+				hit = 0;
+			}
+		}
+	}
+}
+
+/* anything else becomes a replacement of the bytes left after stripping the
+ * common prefix and suffix, split in ops of at most CDIFF_OP_SIZE bytes */
+static void diff_replace(CDiff *cd, ut64 a, ut64 la, ut64 b, ut64 lb) {
+	ut64 off;
+	int i, n;
+
+	while (la > 0 && lb > 0) {
+		n = (int)R_MIN (CDIFF_OP_SIZE, R_MIN (la, lb));
+		if (!cdiff_read (cd, cd->a, a, cd->wa, n) || !cdiff_read (cd, cd->b, b, cd->wb, n)) {
+			return;
+		}
+		for (i = 0; i < n && cd->wa[i] == cd->wb[i]; i++) {}
+		a += i;
+		b += i;
+		la -= i;
+		lb -= i;
+		if (i < n) {
+			break;
+		}
+	}
+	while (la > 0 && lb > 0) {
+		n = (int)R_MIN (CDIFF_OP_SIZE, R_MIN (la, lb));
+		if (!cdiff_read (cd, cd->a, a + la - n, cd->wa, n) || !cdiff_read (cd, cd->b, b + lb - n, cd->wb, n)) {
+			return;
+		}
+		for (i = 0; i < n && cd->wa[n - i - 1] == cd->wb[n - i - 1]; i++) {}
+		la -= i;
+		lb -= i;
+		if (i < n) {
+			break;
+		}
+	}
+	for (off = 0; off < la || off < lb; off += CDIFF_OP_SIZE) {
+		int na = (int)((off < la)? R_MIN (CDIFF_OP_SIZE, la - off): 0);
+		int nb = (int)((off < lb)? R_MIN (CDIFF_OP_SIZE, lb - off): 0);
+		if (!cdiff_read (cd, cd->a, a + off, cd->wa, na) || !cdiff_read (cd, cd->b, b + off, cd->wb, nb)) {
+			return;
+		}
+		// the side that ran out stays at its end
+		emit (cd, a + R_MIN (off, la), cd->wa, na, b + R_MIN (off, lb), cd->wb, nb);
+	}
+}
+
+static void diff_window(CDiff *cd, ut64 a_end, ut64 b_end) {
+	ut64 la = a_end - cd->pa;
+	ut64 lb = b_end - cd->pb;
+	if (la == lb) {
+		diff_inplace (cd, cd->pa, cd->pb, la);
+	} else {
+		diff_replace (cd, cd->pa, la, cd->pb, lb);
+	}
+}
+
+static void anchor(CDiff *cd, ut64 at, CDiffChunk *chunk) {
+	diff_window (cd, at, chunk->off);
+	cd->pa = at + chunk->len;
+	cd->pb = chunk->off + chunk->len;
+	cd->wb_off = UT64_MAX;
+}
+
+static bool match_chunk(CDiff *cd, CDiffChunk *chunk) {
+	CDiffRun *jump = &cd->jump;
+	ut64 at;
+	if (jump->a != UT64_MAX) {
+		at = jump->a + jump->len;
+		if (chunk_at (cd, chunk, at)) {
+			if (chunk->hash == jump->hash) {
+				jump->len += chunk->len;
+				return !cd->error;
+			}
+			diff_window (cd, jump->a, jump->b);
+			cd->pa = at;
+			cd->pb = chunk->off;
+			jump->a = UT64_MAX;
+			anchor (cd, at, chunk);
+			return !cd->error;
+		}
+		jump->a = UT64_MAX;
+	}
+	at = find_chunk (cd, chunk, cd->pa);
+	if (at == UT64_MAX) {
+		return !cd->error;
+	}
+	if (at - cd->pa > CDIFF_MAX_JUMP) {
+		jump->a = at;
+		jump->b = chunk->off;
+		jump->len = chunk->len;
+		jump->hash = chunk->hash;
+	} else {
+		anchor (cd, at, chunk);
+	}
+	return !cd->error;
+}
+
+R_API int r_diff_stream(RDiff *d, RDiffSource *a, RDiffSource *b) {
+	r_return_val_if_fail (d && a && b && a->read && b->read, -1);
+	CDiff cd = { .d = d, .a = a, .b = b, .wb_off = UT64_MAX, .jump.a = UT64_MAX };
+	int i;
+
+	for (i = 0; i < 256; i++) {
+		cd.gear[i] = cdiff_mix (i + 1);
+	}
+	r_vector_init (&cd.chunks, sizeof (CDiffChunk), NULL, NULL);
+	cd.block = malloc (CDIFF_BLOCK);
+	cd.wa = malloc (CDIFF_OP_SIZE);
+	cd.wb = malloc (CDIFF_OP_SIZE);
+	if (!cd.block || !cd.wa || !cd.wb) {
+		cd.error = true;
+		goto beach;
+	}
+	if (!cdiff_chunks (&cd, a, index_chunk)) {
+		cd.error = true;
+		goto beach;
+	}
+	qsort (cd.chunks.a, cd.chunks.len, sizeof (CDiffChunk), chunk_cmp);
+	if (cdiff_chunks (&cd, b, match_chunk)) {
+		diff_window (&cd, a->size, b->size);
+	}
+beach:
+	r_vector_clear (&cd.chunks);
+	free (cd.block);
+	free (cd.wa);
+	free (cd.wb);
+	return cd.error? -1: cd.ops;
+}
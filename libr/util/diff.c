@@ -479,6 +479,159 @@ R_API bool r_diff_buffers_distance_original(RDiff *diff, const ut8 *a, ut32 la,
 	return true;
 }
 
+/* Bit-parallel Levenshtein distance (Myers 1999, with the multi-word blocks
+ * of Hyyro 2003). The shorter buffer is the pattern and every column of the
+ * dp matrix is kept as bit vectors of +1/-1 vertical deltas, 64 rows per
+ * word, so each byte of the longer buffer costs one pass over the words. */
+
+typedef struct {
+	ut64 pv, mv;
+} DistBlock;
+
+static inline int distance_block(DistBlock *bl, ut64 eq, int hin, ut64 hb) {
+	ut64 pv = bl->pv, mv = bl->mv;
+	ut64 xv = eq | mv;
+	ut64 xh, ph, mh;
+	int hout;
+
+	if (hin < 0) {
+		eq |= 1;
+	}
+	xh = (((eq & pv) + pv) ^ pv) | eq;
+	ph = mv | ~(xh | pv);
+	mh = pv & xh;
+	hout = (ph & hb)? 1: (mh & hb)? -1: 0;
+	ph <<= 1;
+	mh <<= 1;
+	if (hin < 0) {
+		mh |= 1;
+	} else if (hin > 0) {
+		ph |= 1;
+	}
+	bl->pv = mh | ~(xv | ph);
+	bl->mv = ph & xv;
+	return hout;
+}
+
+// lowest distance still reachable from column col of the dp matrix
+static ut32 distance_bound(const DistBlock *bl, ut32 m, ut32 n, ut32 col) {
+	st64 v = col, rest = n - col;
+	st64 best = v + R_ABS ((st64)m - rest);
+	ut32 i;
+	for (i = 0; i < m; i++) {
+		ut64 bit = 1ULL << (i & 63);
+		const DistBlock *b = &bl[i >> 6];
+		v += (b->pv & bit)? 1: (b->mv & bit)? -1: 0;
+		st64 lb = v + R_ABS ((st64)(m - i - 1) - rest);
+		if (lb < best) {
+			best = lb;
+		}
+	}
+	return (ut32)best;
+}
+
+/* Same distance as r_diff_buffers_distance_original. When it is known to be
+ * above maxdist the computation stops and maxdist + 1 is reported instead,
+ * making the similarity an upper bound: callers that only compare it with
+ * a threshold can pass the largest distance that would still pass it. */
+R_API bool r_diff_buffers_distance_bounded(RDiff *diff, const ut8 *a, ut32 la, const ut8 *b, ut32 lb, ut32 maxdist, ut32 *distance, double *similarity) {
+	if (!a || !b) {
+		return false;
+	}
+
+	const bool verbose = diff ? diff->verbose : false;
+	const ut32 length = R_MAX (la, lb);
+	const ut8 *ea = a + la, *eb = b + lb, *t;
+	ut64 peq1[256], *peq = peq1;
+	DistBlock bl1, *bl = &bl1;
+	ut32 i, j, k, m, n, nblocks, dist;
+	ut64 hb;
+	st64 score;
+
+	// Strip prefix
+	for (; a < ea && b < eb && *a == *b; a++, b++) {}
+	// Strip suffix
+	for (; a < ea && b < eb && ea[-1] == eb[-1]; ea--, eb--) {}
+	// the longer buffer is the text, the shorter one the pattern
+	n = ea - a;
+	m = eb - b;
+	if (n < m) {
+		i = n;
+		n = m;
+		m = i;
+		t = a;
+		a = b;
+		b = t;
+	}
+	if (n - m > maxdist) {
+		dist = maxdist + 1;
+		goto out;
+	}
+	if (!m) {
+		dist = n;
+		goto out;
+	}
+	nblocks = (m + 63) / 64;
+	if (nblocks > 1) {
+		if (nblocks > SIZE_MAX / (257 * sizeof (ut64))) {
+			return false;
+		}
+		if (!(peq = calloc (256 * nblocks, sizeof (ut64)))) {
+			return false;
+		}
+		if (!(bl = malloc (nblocks * sizeof (DistBlock)))) {
+			free (peq);
+			return false;
+		}
+	} else {
+		memset (peq1, 0, sizeof (peq1));
+	}
+	for (i = 0; i < m; i++) {
+		peq[b[i] * nblocks + (i >> 6)] |= 1ULL << (i & 63);
+	}
+	for (k = 0; k < nblocks; k++) {
+		bl[k].pv = UT64_MAX;
+		bl[k].mv = 0;
+	}
+	hb = 1ULL << ((m - 1) & 63);
+	score = m;
+	for (j = 0; j < n; j++) {
+		const ut64 *eq = peq + a[j] * nblocks;
+		int h = 1;
+		for (k = 0; k + 1 < nblocks; k++) {
+			h = distance_block (&bl[k], eq[k], h, 1ULL << 63);
+		}
+		score += distance_block (&bl[k], eq[k], h, hb);
+		if (maxdist != UT32_MAX) {
+			// the last row can not drop faster than one per remaining byte
+			if (score - (st64)(n - j - 1) > maxdist
+					|| (!((j + 1) & 63) && distance_bound (bl, m, n, j + 1) > maxdist)) {
+				score = (st64)maxdist + 1;
+				break;
+			}
+		}
+		if (verbose && j % 10000 == 0) {
+			eprintf ("\rProcessing %" PFMT32u " of %" PFMT32u "\r", j, n);
+		}
+	}
+	if (verbose) {
+		eprintf ("\n");
+	}
+	if (nblocks > 1) {
+		free (peq);
+		free (bl);
+	}
+	dist = (score > maxdist)? maxdist + 1: (ut32)score;
+out:
+	if (distance) {
+		*distance = dist;
+	}
+	if (similarity) {
+		*similarity = length ? 1.0 - (double)dist / length : 1.0;
+	}
+	return true;
+}
+
 R_API bool r_diff_buffers_distance(RDiff *d, const ut8 *a, ut32 la, const ut8 *b, ut32 lb, ut32 *distance, double *similarity) {
 	if (d) {
 		switch (d->type) {
@@ -490,5 +643,5 @@ R_API bool r_diff_buffers_distance(RDiff *d, const ut8 *a, ut32 la, const ut8 *b
 			break;
 		}
 	}
-	return r_diff_buffers_distance_original (d, a, la, b, lb, distance, similarity);
+	return r_diff_buffers_distance_bounded (d, a, la, b, lb, UT32_MAX, distance, similarity);
 }
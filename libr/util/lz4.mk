@@ -0,0 +1,4 @@
+LZ4PATH=../../shlr/lz4/
+CFLAGS+=-I$(LZ4PATH)
+
+OBJS+=$(LZ4PATH)lz4.o
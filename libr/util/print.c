@@ -709,7 +709,7 @@ R_API void r_print_hexii(RPrint *rp, ut64 addr, const ut8 *buf, int len, int ste
 R_API void r_print_set_screenbounds(RPrint *p, ut64 addr) {
 	int r, rc;
 
-	if (!p || !p->screen_bounds) {
+	if (!p || p->screen_bounds != 1) {
 		return;
 	}
 	if (!p->consbind.get_size) {
@@ -722,7 +722,7 @@ R_API void r_print_set_screenbounds(RPrint *p, ut64 addr) {
 	(void) p->consbind.get_size (&r);
 	(void) p->consbind.get_cursor (&rc);
 
-	if (rc > r - 1 && p->screen_bounds == 1) {
+	if (rc > r - 1) {
 		p->screen_bounds = addr;
 	}
 }
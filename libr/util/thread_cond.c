@@ -42,6 +42,23 @@ R_API void r_th_cond_wait(RThreadCond *cond, RThreadLock *lock) {
 #endif
 }
 
+/* false if ms milliseconds passed without a signal */
+R_API bool r_th_cond_wait_timeout(RThreadCond *cond, RThreadLock *lock, int ms) {
+#if HAVE_PTHREAD
+	struct timeval now;
+	struct timespec ts;
+	gettimeofday (&now, NULL);
+	ut64 ns = (ut64)now.tv_usec * 1000 + (ut64)ms * 1000000;
+	ts.tv_sec = now.tv_sec + ns / 1000000000;
+	ts.tv_nsec = ns % 1000000000;
+	return pthread_cond_timedwait (&cond->cond, &lock->lock, &ts) == 0;
+#elif __WINDOWS__ && !defined(__CYGWIN__)
+	return SleepConditionVariableCS (&cond->cond, &lock->lock, ms) != 0;
+#else
+	return false;
+#endif
+}
+
 R_API void r_th_cond_free(RThreadCond *cond) {
 	if (!cond) {
 		return;
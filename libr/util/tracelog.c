@@ -0,0 +1,557 @@
+/* radare - LGPL - Copyright 2018 - pancake */
+
+#include <r_util.h>
+#include <r_util/r_tracelog.h>
+#include <lz4.h>
+
+#define TL_MAGIC "R2TL"
+#define TL_VERSION 1
+
+enum {
+	TL_STEP = 0,
+	TL_REG_READ = R_TRACELOG_REG_READ,
+	TL_REG_WRITE = R_TRACELOG_REG_WRITE,
+	TL_MEM_READ = R_TRACELOG_MEM_READ,
+	TL_MEM_WRITE = R_TRACELOG_MEM_WRITE,
+};
+
+static inline ut64 zigzag(st64 v) {
+	return ((ut64)v << 1) ^ (ut64)(v >> 63);
+}
+
+static inline st64 unzigzag(ut64 v) {
+	return (st64)(v >> 1) ^ -(st64)(v & 1);
+}
+
+static void bloom_add(ut8 *bloom, ut64 addr) {
+	ut32 h0 = (ut32)(addr * 0x9E3779B97F4A7C15ULL >> 32);
+	ut32 h1 = (ut32)((addr ^ (addr >> 17)) * 0xC2B2AE3D27D4EB4FULL >> 40);
+	h0 %= R_TRACELOG_BLOOM_SIZE * 8;
+	h1 %= R_TRACELOG_BLOOM_SIZE * 8;
+	bloom[h0 >> 3] |= 1 << (h0 & 7);
+	bloom[h1 >> 3] |= 1 << (h1 & 7);
+}
+
+static bool bloom_has(const ut8 *bloom, ut64 addr) {
+	ut32 h0 = (ut32)(addr * 0x9E3779B97F4A7C15ULL >> 32);
+	ut32 h1 = (ut32)((addr ^ (addr >> 17)) * 0xC2B2AE3D27D4EB4FULL >> 40);
+	h0 %= R_TRACELOG_BLOOM_SIZE * 8;
+	h1 %= R_TRACELOG_BLOOM_SIZE * 8;
+	return (bloom[h0 >> 3] & (1 << (h0 & 7))) && (bloom[h1 >> 3] & (1 << (h1 & 7)));
+}
+
+static bool cur_reserve(RTraceLog *log, ut32 len) {
+	if (log->cur_len + len <= log->cur_size) {
+		return true;
+	}
+	ut32 size = R_MAX (log->cur_size * 2, log->cur_len + len + 1024);
+	ut8 *cur = realloc (log->cur, size);
+	if (!cur) {
+		return false;
+	}
+	log->cur = cur;
+	log->cur_size = size;
+	return true;
+}
+
+static void put_byte(RTraceLog *log, ut8 b) {
+	log->cur[log->cur_len++] = b;
+}
+
+static void put_uleb(RTraceLog *log, ut64 v) {
+	do {
+		ut8 b = v & 0x7f;
+		v >>= 7;
+		log->cur[log->cur_len++] = v? (b | 0x80): b;
+	} while (v);
+}
+
+static const ut8 *get_uleb(const ut8 *p, const ut8 *end, ut64 *v) {
+	ut64 r = 0;
+	int shift = 0;
+	while (p < end && shift < 64) {
+		ut8 b = *p++;
+		r |= (ut64)(b & 0x7f) << shift;
+		if (!(b & 0x80)) {
+			*v = r;
+			return p;
+		}
+		shift += 7;
+	}
+	*v = r;
+	return end;
+}
+
+static void chunk_fini(void *e, void *user) {
+	RTraceLogChunk *c = e;
+	free (c->data);
+}
+
+static void regs_kv_free(HtKv *kv) {
+	free (kv->key);
+}
+
+static void cur_rewind(RTraceLog *log) {
+	log->cur_len = 0;
+	log->cur_steps = 0;
+	log->lastpc = 0;
+	log->lastmem = 0;
+	memset (log->cur_bloom, 0, sizeof (log->cur_bloom));
+	if (log->regstate) {
+		memset (log->regstate, 0, log->regstate_len * sizeof (ut64));
+	}
+}
+
+/* compress the chunk being written, each chunk decodes on its own */
+static bool flush(RTraceLog *log) {
+	RTraceLogChunk c = {0};
+	if (!log->cur_steps) {
+		return true;
+	}
+	int bound = LZ4_compressBound (log->cur_len);
+	ut8 *data = malloc (bound);
+	if (!data) {
+		return false;
+	}
+	int csize = LZ4_compress_default ((const char *)log->cur, (char *)data, log->cur_len, bound);
+	if (csize < 1) {
+		free (data);
+		return false;
+	}
+	c.step = log->count - log->cur_steps;
+	c.nsteps = log->cur_steps;
+	c.size = log->cur_len;
+	c.csize = csize;
+	ut8 *shrunk = realloc (data, csize);
+	c.data = shrunk? shrunk: data;
+	memcpy (c.bloom, log->cur_bloom, sizeof (c.bloom));
+	if (!r_vector_push (&log->chunks, &c)) {
+		free (c.data);
+		return false;
+	}
+	log->csize += csize;
+	if (log->dec_idx == (st64)log->chunks.len - 1) {
+		/* the cached entry was the open chunk */
+		log->dec_idx = -1;
+	}
+	cur_rewind (log);
+	return true;
+}
+
+R_API RTraceLog *r_tracelog_new() {
+	RTraceLog *log = R_NEW0 (RTraceLog);
+	if (!log) {
+		return NULL;
+	}
+	r_vector_init (&log->chunks, sizeof (RTraceLogChunk), chunk_fini, NULL);
+	r_pvector_init (&log->regs, free);
+	r_vector_init (&log->events, sizeof (RTraceLogEvent), NULL, NULL);
+	log->regs_ht = ht_new (NULL, regs_kv_free, NULL);
+	log->dec_idx = -1;
+	if (!log->regs_ht) {
+		r_tracelog_free (log);
+		return NULL;
+	}
+	return log;
+}
+
+R_API void r_tracelog_free(RTraceLog *log) {
+	if (!log) {
+		return;
+	}
+	r_vector_clear (&log->chunks);
+	r_pvector_clear (&log->regs);
+	r_vector_clear (&log->events);
+	ht_free (log->regs_ht);
+	free (log->cur);
+	free (log->regstate);
+	free (log->dec);
+	free (log->dec_evs);
+	free (log->dec_pcs);
+	free (log->dec_regs);
+	free (log);
+}
+
+R_API void r_tracelog_reset(RTraceLog *log) {
+	r_return_if_fail (log);
+	r_vector_clear (&log->chunks);
+	log->count = 0;
+	log->csize = 0;
+	log->dec_idx = -1;
+	cur_rewind (log);
+}
+
+R_API ut64 r_tracelog_count(RTraceLog *log) {
+	r_return_val_if_fail (log, 0);
+	return log->count;
+}
+
+/* bytes used by the compressed chunks plus the one being written */
+R_API ut64 r_tracelog_size(RTraceLog *log) {
+	r_return_val_if_fail (log, 0);
+	return log->csize + log->cur_len + log->chunks.len * sizeof (RTraceLogChunk);
+}
+
+R_API ut64 r_tracelog_step(RTraceLog *log, ut64 pc) {
+	r_return_val_if_fail (log, UT64_MAX);
+	if (log->cur_steps >= R_TRACELOG_CHUNK_STEPS || log->cur_len >= R_TRACELOG_CHUNK_SIZE) {
+		flush (log);
+	}
+	if (!cur_reserve (log, 16)) {
+		return UT64_MAX;
+	}
+	put_byte (log, TL_STEP);
+	put_uleb (log, zigzag ((st64)(pc - log->lastpc)));
+	bloom_add (log->cur_bloom, pc);
+	log->lastpc = pc;
+	log->cur_steps++;
+	return log->count++;
+}
+
+static ut32 reg_id(RTraceLog *log, const char *name) {
+	bool found = false;
+	ut32 id = (ut32)(size_t)ht_find (log->regs_ht, name, &found);
+	if (found) {
+		return id - 1;
+	}
+	char *s = strdup (name);
+	if (!s || !r_pvector_push (&log->regs, s)) {
+		free (s);
+		return UT32_MAX;
+	}
+	id = r_pvector_len (&log->regs);
+	ht_insert (log->regs_ht, name, (void *)(size_t)id);
+	return id - 1;
+}
+
+/* registers are stored xored with the last value seen in the chunk */
+R_API void r_tracelog_reg(RTraceLog *log, int type, const char *name, ut64 value) {
+	r_return_if_fail (log && name);
+	if (!log->cur_steps) {
+		return;
+	}
+	ut32 id = reg_id (log, name);
+	if (id == UT32_MAX) {
+		return;
+	}
+	if (id >= log->regstate_len) {
+		ut32 len = R_MAX (id + 1, log->regstate_len * 2);
+		ut64 *rs = realloc (log->regstate, len * sizeof (ut64));
+		if (!rs) {
+			return;
+		}
+		memset (rs + log->regstate_len, 0, (len - log->regstate_len) * sizeof (ut64));
+		log->regstate = rs;
+		log->regstate_len = len;
+	}
+	if (!cur_reserve (log, 24)) {
+		return;
+	}
+	put_byte (log, type == R_TRACELOG_REG_WRITE? TL_REG_WRITE: TL_REG_READ);
+	put_uleb (log, id);
+	put_uleb (log, value ^ log->regstate[id]);
+	log->regstate[id] = value;
+}
+
+R_API void r_tracelog_mem(RTraceLog *log, int type, ut64 addr, const ut8 *buf, int len) {
+	r_return_if_fail (log && (buf || len < 1));
+	if (!log->cur_steps || len < 0) {
+		return;
+	}
+	if (!cur_reserve (log, 24 + len)) {
+		return;
+	}
+	put_byte (log, type == R_TRACELOG_MEM_WRITE? TL_MEM_WRITE: TL_MEM_READ);
+	put_uleb (log, zigzag ((st64)(addr - log->lastmem)));
+	put_uleb (log, len);
+	memcpy (log->cur + log->cur_len, buf, len);
+	log->cur_len += len;
+	log->lastmem = addr + len;
+}
+
+/* decode chunk idx (the open one when idx == chunks.len). the register
+ * and memory records are relative to the previous ones in the chunk, so
+ * they are all resolved here once and every step reads its own slice */
+static bool decode(RTraceLog *log, size_t idx) {
+	ut32 nsteps, size;
+	const ut8 *raw;
+	if (log->dec_idx == (st64)idx && (idx < log->chunks.len || log->dec_len == log->cur_len)) {
+		return true;
+	}
+	if (idx < log->chunks.len) {
+		RTraceLogChunk *c = r_vector_index_ptr (&log->chunks, idx);
+		ut8 *dec = realloc (log->dec, c->size + 1);
+		if (!dec) {
+			return false;
+		}
+		log->dec = dec;
+		if (LZ4_decompress_safe ((const char *)c->data, (char *)dec, c->csize, c->size) != c->size) {
+			log->dec_idx = -1;
+			return false;
+		}
+		raw = dec;
+		size = c->size;
+		nsteps = c->nsteps;
+	} else {
+		raw = log->cur;
+		size = log->cur_len;
+		nsteps = log->cur_steps;
+	}
+	log->dec_idx = -1;
+	ut32 *evs = realloc (log->dec_evs, (nsteps + 1) * sizeof (ut32));
+	if (evs) {
+		log->dec_evs = evs;
+	}
+	ut64 *pcs = realloc (log->dec_pcs, (nsteps + 1) * sizeof (ut64));
+	if (pcs) {
+		log->dec_pcs = pcs;
+	}
+	size_t nregs = r_pvector_len (&log->regs);
+	if (nregs > log->dec_nregs) {
+		ut64 *regs = realloc (log->dec_regs, nregs * sizeof (ut64));
+		if (!regs) {
+			return false;
+		}
+		log->dec_regs = regs;
+		log->dec_nregs = nregs;
+	}
+	if (!evs || !pcs) {
+		return false;
+	}
+	ut64 *regs = log->dec_regs;
+	if (regs) {
+		memset (regs, 0, log->dec_nregs * sizeof (ut64));
+	}
+	r_vector_clear (&log->events);
+	const ut8 *p = raw, *end = raw + size;
+	ut64 pc = 0, mem = 0, v, id, len;
+	ut32 n = 0;
+	bool ok = true;
+	while (ok && p < end) {
+		RTraceLogEvent ev = {0};
+		ut8 tag = *p++;
+		ev.type = tag;
+		switch (tag) {
+		case TL_STEP:
+			if (n == nsteps) {
+				ok = false;
+				break;
+			}
+			p = get_uleb (p, end, &v);
+			pc += unzigzag (v);
+			evs[n] = log->events.len;
+			pcs[n++] = pc;
+			continue;
+		case TL_REG_READ:
+		case TL_REG_WRITE:
+			p = get_uleb (p, end, &id);
+			p = get_uleb (p, end, &v);
+			if (!n || id >= nregs) {
+				ok = false;
+				break;
+			}
+			regs[id] ^= v;
+			ev.reg = r_pvector_at (&log->regs, id);
+			ev.value = regs[id];
+			break;
+		case TL_MEM_READ:
+		case TL_MEM_WRITE:
+			p = get_uleb (p, end, &v);
+			mem += unzigzag (v);
+			p = get_uleb (p, end, &len);
+			if (!n || len > (ut64)(end - p)) {
+				ok = false;
+				break;
+			}
+			ev.addr = mem;
+			ev.data = p;
+			ev.len = len;
+			p += len;
+			mem += len;
+			break;
+		default:
+			ok = false;
+			break;
+		}
+		if (ok && !r_vector_push (&log->events, &ev)) {
+			r_vector_clear (&log->events);
+			return false;
+		}
+	}
+	/* a broken record invalidates the step holding it and the next ones */
+	log->dec_valid = ok? n: n - (n > 0);
+	evs[n] = log->events.len;
+	log->dec_idx = idx;
+	log->dec_len = size;
+	return true;
+}
+
+static st64 chunk_for_step(RTraceLog *log, ut64 step) {
+	size_t lo = 0, hi = log->chunks.len;
+	if (step >= log->count) {
+		return -1;
+	}
+	if (step >= log->count - log->cur_steps) {
+		return log->chunks.len;
+	}
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		RTraceLogChunk *c = r_vector_index_ptr (&log->chunks, mid);
+		if (step < c->step) {
+			hi = mid;
+		} else if (step >= c->step + c->nsteps) {
+			lo = mid + 1;
+		} else {
+			return mid;
+		}
+	}
+	return -1;
+}
+
+static ut64 chunk_first(RTraceLog *log, size_t idx) {
+	if (idx < log->chunks.len) {
+		return ((RTraceLogChunk *)r_vector_index_ptr (&log->chunks, idx))->step;
+	}
+	return log->count - log->cur_steps;
+}
+
+R_API bool r_tracelog_get(RTraceLog *log, ut64 step, RTraceLogStep *out) {
+	r_return_val_if_fail (log && out, false);
+	st64 idx = chunk_for_step (log, step);
+	if (idx < 0 || !decode (log, idx)) {
+		return false;
+	}
+	ut32 n = step - chunk_first (log, idx);
+	if (n >= log->dec_valid) {
+		return false;
+	}
+	out->step = step;
+	out->pc = log->dec_pcs[n];
+	out->count = log->dec_evs[n + 1] - log->dec_evs[n];
+	out->events = out->count
+		? (const RTraceLogEvent *)r_vector_index_ptr (&log->events, log->dec_evs[n])
+		: NULL;
+	return true;
+}
+
+/* first step at or after from that executed addr */
+R_API ut64 r_tracelog_find(RTraceLog *log, ut64 addr, ut64 from) {
+	r_return_val_if_fail (log, UT64_MAX);
+	st64 idx = chunk_for_step (log, from);
+	if (idx < 0) {
+		return UT64_MAX;
+	}
+	for (; idx <= (st64)log->chunks.len; idx++) {
+		const ut8 *bloom = (idx < log->chunks.len)
+			? ((RTraceLogChunk *)r_vector_index_ptr (&log->chunks, idx))->bloom
+			: log->cur_bloom;
+		if (!bloom_has (bloom, addr) || !decode (log, idx)) {
+			continue;
+		}
+		ut64 first = chunk_first (log, idx);
+		ut32 i = (from > first)? from - first: 0;
+		for (; i < log->dec_valid; i++) {
+			if (log->dec_pcs[i] == addr) {
+				return first + i;
+			}
+		}
+	}
+	return UT64_MAX;
+}
+
+R_API bool r_tracelog_save(RTraceLog *log, const char *file) {
+	RTraceLogChunk *c;
+	ut8 hdr[32];
+	size_t i;
+	r_return_val_if_fail (log && file, false);
+	if (!flush (log)) {
+		return false;
+	}
+	FILE *fd = r_sandbox_fopen (file, "wb");
+	if (!fd) {
+		return false;
+	}
+	bool ok = true;
+	memcpy (hdr, TL_MAGIC, 4);
+	r_write_le32 (hdr + 4, TL_VERSION);
+	r_write_le32 (hdr + 8, r_pvector_len (&log->regs));
+	r_write_le32 (hdr + 12, log->chunks.len);
+	ok &= fwrite (hdr, 16, 1, fd) == 1;
+	for (i = 0; i < r_pvector_len (&log->regs); i++) {
+		const char *name = r_pvector_at (&log->regs, i);
+		ut8 len = R_MIN (strlen (name), 255);
+		ok &= fwrite (&len, 1, 1, fd) == 1;
+		ok &= fwrite (name, len, 1, fd) == 1 || !len;
+	}
+	r_vector_foreach (&log->chunks, c) {
+		r_write_le64 (hdr, c->step);
+		r_write_le32 (hdr + 8, c->nsteps);
+		r_write_le32 (hdr + 12, c->size);
+		r_write_le32 (hdr + 16, c->csize);
+		ok &= fwrite (hdr, 20, 1, fd) == 1;
+		ok &= fwrite (c->bloom, sizeof (c->bloom), 1, fd) == 1;
+		ok &= fwrite (c->data, c->csize, 1, fd) == 1;
+	}
+	fclose (fd);
+	return ok;
+}
+
+R_API RTraceLog *r_tracelog_load(const char *file) {
+	int size = 0;
+	ut32 i;
+	r_return_val_if_fail (file, NULL);
+	ut8 *buf = (ut8 *)r_file_slurp (file, &size);
+	if (!buf) {
+		return NULL;
+	}
+	RTraceLog *log = r_tracelog_new ();
+	const ut8 *p = buf, *end = buf + size;
+	if (!log || size < 16 || memcmp (buf, TL_MAGIC, 4) || r_read_le32 (buf + 4) != TL_VERSION) {
+		goto fail;
+	}
+	ut32 nregs = r_read_le32 (buf + 8);
+	ut32 nchunks = r_read_le32 (buf + 12);
+	p += 16;
+	for (i = 0; i < nregs; i++) {
+		char name[256];
+		if (p >= end || *p > end - p - 1) {
+			goto fail;
+		}
+		memcpy (name, p + 1, *p);
+		name[*p] = 0;
+		p += *p + 1;
+		if (reg_id (log, name) != i) {
+			goto fail;
+		}
+	}
+	for (i = 0; i < nchunks; i++) {
+		RTraceLogChunk c = {0};
+		if (end - p < 20 + R_TRACELOG_BLOOM_SIZE) {
+			goto fail;
+		}
+		c.step = r_read_le64 (p);
+		c.nsteps = r_read_le32 (p + 8);
+		c.size = r_read_le32 (p + 12);
+		c.csize = r_read_le32 (p + 16);
+		p += 20;
+		memcpy (c.bloom, p, sizeof (c.bloom));
+		p += sizeof (c.bloom);
+		if (c.step != log->count || c.csize > end - p) {
+			goto fail;
+		}
+		c.data = r_mem_dup ((void *)p, c.csize);
+		if (!c.data || !r_vector_push (&log->chunks, &c)) {
+			free (c.data);
+			goto fail;
+		}
+		p += c.csize;
+		log->count += c.nsteps;
+		log->csize += c.csize;
+	}
+	free (buf);
+	return log;
+fail:
+	free (buf);
+	r_tracelog_free (log);
+	return NULL;
+}